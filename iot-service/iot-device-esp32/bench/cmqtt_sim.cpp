@@ -0,0 +1,443 @@
+// ============================================================================
+// CMQTT SIM - Host run of the AT+CMQTT backend against a simulated SIM7600
+// ============================================================================
+// Runs ModemAt + CmqttClient (the MQTT_USE_MODEM_STACK backend) on a
+// Linux/macOS host. FakeSim7600 plays the modem side of the UART: it answers
+// the CMQTT command set, ">" data prompts included, and reports broker
+// results as URCs after a simulated round trip (virtual clock, 1 ms ticks).
+//
+// Scenario: connect, subscribe, publish a run of QoS 1 messages while
+//   - an inbound message whose payload contains "\r\nOK\r\n" arrives
+//   - the broker connection drops ("+CMQTTCONNLOST"), client reconnects
+//   - one "+CMQTTPUB" result URC is lost (as if TinyGSM had eaten it)
+//   - the connection drops silently (no URC), found by the state check
+// Every message must reach the broker at least once. Reports UART bytes per
+// message and while idle. With --tls every connect goes through the SSL
+// context setup and the modem's TLS handshake (2 more round trips).
+//
+// Build + run:  make -C bench run-cmqtt        (see bench/Makefile)
+// Options:      --messages N  --payload BYTES  --rtt MS  --tls
+
+#include <Arduino.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "modem_at.h"
+#include "cmqtt_client.h"
+
+#define SIM_KEEP_ALIVE_S        60
+#define SIM_CONNECT_TIMEOUT_MS  25000
+#define SIM_RECONNECT_MS        1000
+#define SIM_LIMIT_MS            3600000
+#define SIM_IDLE_MS             600000  // Idle UART measurement
+
+#define SIM_TOPIC               "sensor/BENCH/telemetry"
+#define SIM_COMMAND_TOPIC       "sensor/BENCH/command"
+#define SIM_INBOUND_PAYLOAD     "{\"action\":\"relay\",\"note\":\"line\r\nOK\r\n>\"}"
+
+static unsigned long simNowMs = 0;
+unsigned long millis() { return simNowMs; }
+unsigned long micros() { return simNowMs * 1000; }
+static unsigned long simMillis() { return simNowMs; }
+
+// ========================================
+// Simulated SIM7600
+// ========================================
+
+class FakeSim7600 : public Stream {
+public:
+    explicit FakeSim7600(uint32_t rttMs) {
+        rtt = rttMs;
+        started = false;
+        acquired = false;
+        connected = false;
+        lastCr = false;
+        expectData = 0;
+        pendingData = DATA_NONE;
+        dropPubResults = 0;
+        bytesFromHost = 0;
+        bytesToHost = 0;
+        publishes = 0;
+        dupPublishes = 0;
+        connects = 0;
+        tlsConnects = 0;
+        sslConfigs = 0;
+        tlsClient = false;
+        sslBound = false;
+    }
+
+    // Broker side results
+    std::vector<uint32_t> deliveries;
+    std::vector<std::string> subscriptions;
+    uint32_t publishes;
+    uint32_t dupPublishes;
+    uint32_t connects;
+    uint32_t tlsConnects;
+    uint32_t sslConfigs;            // AT+CSSLCFG commands
+    uint32_t dropPubResults;        // Swallow the next N "+CMQTTPUB" URCs
+    uint64_t bytesFromHost;
+    uint64_t bytesToHost;
+
+    int available() override {
+        pump();
+        return (int)out.size();
+    }
+
+    int read() override {
+        pump();
+        if (out.empty()) {
+            return -1;
+        }
+        uint8_t c = out.front();
+        out.pop_front();
+        bytesToHost++;
+        return c;
+    }
+
+    size_t write(uint8_t c) override {
+        bytesFromHost++;
+        bool afterCr = lastCr;
+        lastCr = c == '\r';
+        if (c == '\n' && afterCr) {
+            return 1;   // LF ending the command line, not prompt data
+        }
+        if (expectData > 0) {
+            data += (char)c;
+            if (--expectData == 0) {
+                dataDone();
+            }
+        } else if (c == '\r') {
+            handleCommand(line);
+            line.clear();
+        } else {
+            line += (char)c;
+        }
+        return 1;
+    }
+
+    void injectMessage(const char* topic, const char* payload) {
+        char head[128];
+        snprintf(head, sizeof(head), "\r\n+CMQTTRXSTART: 0,%zu,%zu\r\n+CMQTTRXTOPIC: 0,%zu\r\n",
+                 strlen(topic), strlen(payload), strlen(topic));
+        std::string s = head;
+        s += topic;
+        snprintf(head, sizeof(head), "\r\n+CMQTTRXPAYLOAD: 0,%zu\r\n", strlen(payload));
+        s += head;
+        s += payload;
+        s += "\r\n+CMQTTRXEND: 0\r\n";
+        schedule(s, 0);
+    }
+
+    // Broker connection gone; results still in flight are lost
+    void loseConnection(bool withUrc) {
+        connected = false;
+        scheduled.clear();
+        if (withUrc) {
+            schedule("\r\n+CMQTTCONNLOST: 0,1\r\n", 0);
+        }
+    }
+
+private:
+    enum DataTarget {
+        DATA_NONE,
+        DATA_TOPIC,
+        DATA_PAYLOAD,
+        DATA_SUB
+    };
+
+    uint32_t rtt;
+    bool started;
+    bool acquired;
+    bool connected;
+    bool tlsClient;                 // Acquired with server type 1
+    bool sslBound;                  // AT+CMQTTSSLCFG done
+
+    std::string line;
+    std::string data;
+    bool lastCr;
+    size_t expectData;
+    DataTarget pendingData;
+    std::string topic;
+    std::string payload;
+
+    std::deque<uint8_t> out;
+    std::multimap<unsigned long, std::string> scheduled;
+
+    void reply(const std::string& s) {
+        out.insert(out.end(), s.begin(), s.end());
+    }
+
+    void schedule(const std::string& s, uint32_t delayMs) {
+        scheduled.insert(std::make_pair(simNowMs + delayMs, s));
+    }
+
+    void pump() {
+        while (!scheduled.empty() && scheduled.begin()->first <= simNowMs) {
+            reply(scheduled.begin()->second);
+            scheduled.erase(scheduled.begin());
+        }
+    }
+
+    void prompt(DataTarget target, size_t length) {
+        pendingData = target;
+        expectData = length;
+        data.clear();
+        reply("\r\n>");
+    }
+
+    void dataDone() {
+        switch (pendingData) {
+            case DATA_TOPIC:
+                topic = data;
+                reply("\r\nOK\r\n");
+                break;
+            case DATA_PAYLOAD:
+                payload = data;
+                reply("\r\nOK\r\n");
+                break;
+            case DATA_SUB:
+                subscriptions.push_back(data);
+                reply("\r\nOK\r\n");
+                schedule("\r\n+CMQTTSUB: 0,0\r\n", rtt);
+                break;
+            default:
+                break;
+        }
+        pendingData = DATA_NONE;
+    }
+
+    void handleCommand(const std::string& cmd) {
+        unsigned a = 0, b = 0, c = 0, d = 0, e = 0;
+        char buf[64];
+        const char* s = cmd.c_str();
+
+        if (strcmp(s, "AT+CMQTTDISC?") == 0) {
+            snprintf(buf, sizeof(buf), "\r\n+CMQTTDISC: 0,%d\r\n\r\nOK\r\n", connected ? 0 : 1);
+            reply(buf);
+        } else if (sscanf(s, "AT+CMQTTDISC=%u,%u", &a, &b) == 2) {
+            if (connected) {
+                connected = false;
+                reply("\r\nOK\r\n");
+                schedule("\r\n+CMQTTDISC: 0,0\r\n", rtt);
+            } else {
+                reply("\r\n+CMQTTDISC: 0,11\r\n\r\nERROR\r\n");
+            }
+        } else if (sscanf(s, "AT+CMQTTREL=%u", &a) == 1) {
+            reply(acquired ? "\r\nOK\r\n" : "\r\nERROR\r\n");
+            acquired = false;
+            sslBound = false;
+        } else if (strcmp(s, "AT+CMQTTSTART") == 0) {
+            reply(started ? "\r\n+CMQTTSTART: 23\r\n\r\nERROR\r\n" : "\r\nOK\r\n\r\n+CMQTTSTART: 0\r\n");
+            started = true;
+        } else if (strncmp(s, "AT+CMQTTACCQ=", 13) == 0) {
+            reply(started && !acquired ? "\r\nOK\r\n" : "\r\nERROR\r\n");
+            if (started && !acquired) {
+                tlsClient = cmd.size() > 2 && cmd.compare(cmd.size() - 2, 2, ",1") == 0;
+            }
+            acquired = acquired || started;
+        } else if (strncmp(s, "AT+CSSLCFG=", 11) == 0) {
+            sslConfigs++;
+            reply("\r\nOK\r\n");
+        } else if (sscanf(s, "AT+CMQTTSSLCFG=%u,%u", &a, &b) == 2) {
+            sslBound = acquired && tlsClient;
+            reply(sslBound ? "\r\nOK\r\n" : "\r\nERROR\r\n");
+        } else if (strncmp(s, "AT+CMQTTCONNECT=", 16) == 0) {
+            if (!acquired || connected || tlsClient != sslBound) {
+                reply("\r\nERROR\r\n");
+                return;
+            }
+            connected = true;
+            connects++;
+            reply("\r\nOK\r\n");
+            // TCP handshake + CONNACK, plus a full TLS 1.2 handshake
+            if (tlsClient) {
+                tlsConnects++;
+            }
+            schedule("\r\n+CMQTTCONNECT: 0,0\r\n", rtt * (tlsClient ? 4 : 2));
+        } else if (sscanf(s, "AT+CMQTTSUB=%u,%u,%u", &a, &b, &c) == 3) {
+            prompt(DATA_SUB, b);
+        } else if (sscanf(s, "AT+CMQTTTOPIC=%u,%u", &a, &b) == 2) {
+            prompt(DATA_TOPIC, b);
+        } else if (sscanf(s, "AT+CMQTTPAYLOAD=%u,%u", &a, &b) == 2) {
+            prompt(DATA_PAYLOAD, b);
+        } else if (sscanf(s, "AT+CMQTTPUB=%u,%u,%u,%u,%u", &a, &b, &c, &d, &e) == 5) {
+            if (!connected) {
+                reply("\r\n+CMQTTPUB: 0,11\r\n\r\nERROR\r\n");
+                return;
+            }
+            reply("\r\nOK\r\n");
+            publishes++;
+            if (e) {
+                dupPublishes++;
+            }
+            unsigned seq;
+            if (sscanf(payload.c_str(), "seq=%u;", &seq) == 1 && seq < deliveries.size()) {
+                deliveries[seq]++;
+            }
+            if (dropPubResults > 0) {
+                dropPubResults--;
+            } else {
+                schedule("\r\n+CMQTTPUB: 0,0\r\n", rtt);
+            }
+        } else if (!cmd.empty()) {
+            reply("\r\nERROR\r\n");
+        }
+    }
+};
+
+// ========================================
+// Inbound messages
+// ========================================
+
+static uint32_t inboundCount = 0;
+static bool inboundIntact = false;
+
+static void onMessage(void*, char* topic, uint8_t* payload, size_t len) {
+    inboundCount++;
+    inboundIntact = strcmp(topic, SIM_COMMAND_TOPIC) == 0 &&
+                    len == strlen(SIM_INBOUND_PAYLOAD) &&
+                    memcmp(payload, SIM_INBOUND_PAYLOAD, len) == 0;
+}
+
+// ========================================
+// Main
+// ========================================
+
+int main(int argc, char** argv) {
+    uint32_t messages = 100;
+    size_t payloadSize = 300;
+    uint32_t rttMs = 300;
+    bool tls = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--messages") && i + 1 < argc) {
+            messages = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--payload") && i + 1 < argc) {
+            payloadSize = (size_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--rtt") && i + 1 < argc) {
+            rttMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--tls")) {
+            tls = true;
+        } else {
+            fprintf(stderr, "usage: %s [--messages N] [--payload BYTES] [--rtt MS] [--tls]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (messages < 20 || payloadSize < 16 || payloadSize > 4096) {
+        fprintf(stderr, "messages must be >= 20, payload 16..4096 bytes\n");
+        return 2;
+    }
+
+    FakeSim7600 modem(rttMs);
+    modem.deliveries.assign(messages, 0);
+    ModemAt at(modem);
+    CmqttClient client(at);
+
+    std::vector<uint8_t> rxBuffer(8192), arena(16384);
+    std::vector<char> payload(payloadSize);
+    client.setServer("broker.local", tls ? 8883 : 1883);
+    client.setTls(tls, "ca.pem");
+    client.begin(simMillis, rxBuffer.data(), rxBuffer.size(), arena.data(), arena.size(), 8);
+    client.setMessageHandler(onMessage, nullptr);
+
+    simNowMs = 1;
+    client.connect("BENCH", SIM_KEEP_ALIVE_S, false, SIM_CONNECT_TIMEOUT_MS);
+
+    // Events, by number of acknowledged messages
+    uint32_t inboundAt = messages / 5, lostAt = messages * 2 / 5;
+    uint32_t eatenAt = messages * 3 / 5, silentAt = messages * 4 / 5;
+    bool inboundDone = false, lostDone = false, eatenDone = false, silentDone = false;
+
+    uint32_t next = 0, reconnects = 0;
+    bool subscribed = false;
+    unsigned long retryAt = 0;
+    size_t topicLen = strlen(SIM_TOPIC);
+
+    while (simNowMs < SIM_LIMIT_MS) {
+        client.poll();
+        uint32_t acked = client.getStats().acked;
+
+        if (client.isConnected()) {
+            if (!subscribed) {
+                client.subscribe(SIM_COMMAND_TOPIC, 1);
+                subscribed = true;
+            }
+            if (next == messages && client.getInflightCount() == 0) {
+                break;
+            }
+            while (next < messages && client.canPublish(topicLen, payloadSize)) {
+                int n = snprintf(payload.data(), payload.size(), "seq=%u;", next);
+                memset(payload.data() + n, 'x', payload.size() - n);
+                client.publish(SIM_TOPIC, (const uint8_t*)payload.data(), payload.size(), 1, false);
+                next++;
+            }
+
+            if (!inboundDone && acked >= inboundAt) {
+                modem.injectMessage(SIM_COMMAND_TOPIC, SIM_INBOUND_PAYLOAD);
+                inboundDone = true;
+            } else if (!lostDone && acked >= lostAt) {
+                modem.loseConnection(true);
+                lostDone = true;
+            } else if (!eatenDone && acked >= eatenAt) {
+                modem.dropPubResults = 1;
+                eatenDone = true;
+            } else if (!silentDone && acked >= silentAt) {
+                modem.loseConnection(false);
+                silentDone = true;
+            }
+        } else if (client.getState() != MqttClient::MQTT_CONNECTING) {
+            if (retryAt == 0) {
+                retryAt = simNowMs + SIM_RECONNECT_MS;
+            } else if (simNowMs >= retryAt) {
+                retryAt = 0;
+                subscribed = false;
+                reconnects++;
+                client.connect("BENCH", SIM_KEEP_ALIVE_S, false, SIM_CONNECT_TIMEOUT_MS);
+            }
+        }
+        simNowMs++;
+    }
+    unsigned long busyMs = simNowMs;
+    uint64_t busyFromHost = modem.bytesFromHost, busyToHost = modem.bytesToHost;
+
+    // Idle: nothing to send, only the periodic state check
+    for (unsigned long end = simNowMs + SIM_IDLE_MS; simNowMs < end; simNowMs++) {
+        client.poll();
+    }
+    double idlePerMin = (double)(modem.bytesFromHost - busyFromHost + modem.bytesToHost - busyToHost) /
+                        (SIM_IDLE_MS / 60000.0);
+
+    uint32_t missing = 0, duplicates = 0;
+    for (uint32_t count : modem.deliveries) {
+        if (count == 0) {
+            missing++;
+        } else {
+            duplicates += count - 1;
+        }
+    }
+
+    const MqttClient::Stats& stats = client.getStats();
+    bool ok = next == messages && missing == 0 && inboundCount == 1 && inboundIntact &&
+              reconnects == 2 && modem.subscriptions.size() == 3 && stats.resent >= 1 &&
+              modem.tlsConnects == (tls ? modem.connects : 0);
+
+    printf("CMQTT backend, %u messages x %zu B, RTT %u ms\n", messages, payloadSize, rttMs);
+    printf("  finished in       %.1f s (simulated)\n", busyMs / 1000.0);
+    printf("  broker publishes  %u (%u with DUP), missing %u, duplicates %u\n",
+           modem.publishes, modem.dupPublishes, missing, duplicates);
+    printf("  acked %u, resent %u, max ack %u ms, state checks %u\n",
+           stats.acked, stats.resent, stats.maxAckMs, stats.pings);
+    printf("  reconnects        %u (connects %u), subscriptions %zu\n",
+           reconnects, modem.connects, modem.subscriptions.size());
+    if (tls) {
+        printf("  TLS               %u of %u connects, %u AT+CSSLCFG\n",
+               modem.tlsConnects, modem.connects, modem.sslConfigs);
+    }
+    printf("  inbound message   %u received, payload %s\n", inboundCount, inboundIntact ? "intact" : "CORRUPT");
+    printf("  UART per message  %.1f B to modem, %.1f B from modem (payload %zu B)\n",
+           (double)busyFromHost / messages, (double)busyToHost / messages, payloadSize);
+    printf("  UART while idle   %.0f B/min\n", idlePerMin);
+    printf("  result            %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#ifndef BENCH_HOST_ARDUINO_H
+#define BENCH_HOST_ARDUINO_H
+
+// ============================================================================
+// Minimal Arduino surface for host builds of the modem code (ModemAt and
+// what sits on it). Only what those files use; millis() and micros() come
+// from the bench.
+// ============================================================================
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+unsigned long millis();
+unsigned long micros();
+
+class Stream {
+public:
+    virtual ~Stream() {}
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buf, size_t len) {
+        size_t n = 0;
+        while (n < len && write(buf[n])) {
+            n++;
+        }
+        return n;
+    }
+
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+};
+
+#endif // BENCH_HOST_ARDUINO_H
@@ -0,0 +1,10 @@
+#include "metrics.h"
+
+// ============================================================================
+// Host builds record nothing: ScopedMetric and the counters compile to calls
+// into these, the benches measure with their own clocks.
+// ============================================================================
+
+void recordMetric(MetricId, uint32_t) {}
+void countMetric(MetricCounter, uint32_t) {}
+uint32_t metricsMicros() { return 0; }
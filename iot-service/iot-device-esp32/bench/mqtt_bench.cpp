@@ -0,0 +1,679 @@
+// ============================================================================
+// MQTT BENCH - Host benchmark for the QoS 1 in-flight window
+// ============================================================================
+// Runs the portable MqttClient on a Linux/macOS host against an in-process
+// broker stand-in over a simulated cellular link (virtual clock, 1 ms ticks):
+// every byte takes RTT/2 each way, and the uplink is limited to the modem
+// UART rate since every packet is pushed through AT+CIPSEND.
+//
+// For each window size: QoS 1 throughput until the last PUBACK, and PUBLISH
+// -> PUBACK latency. Then a drop run: the link is cut every few seconds
+// (in-flight packets and PUBACKs are lost), the client reconnects with
+// cleanSession=false, and every message must reach the broker at least once.
+// The window-8 and drop runs are repeated with MQTT 5 (topic aliases,
+// message expiry, a user property) to compare uplink bytes per message.
+//
+// With --host the throughput runs go to a real broker (e.g. a local
+// mosquitto) over a TCP socket instead, in real time.
+//
+// Build + run:  make -C bench run-mqtt        (see bench/Makefile)
+// Options:      --messages N  --payload BYTES  --rtt MS  --uplink BYTES_PER_S
+//               --host ADDR  --port N  --v5  --json
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "mqtt_client.h"
+
+// Same values as config.h (which needs Arduino.h)
+#define BENCH_RX_BUFFER_SIZE    8192    // MQTT_MAX_PACKET_SIZE
+#define BENCH_INFLIGHT_BYTES    16384   // MQTT_INFLIGHT_BYTES
+#define BENCH_KEEP_ALIVE_S      60      // MQTT_KEEP_ALIVE
+#define BENCH_CONNACK_MS        5000    // MQTT_CONNACK_TIMEOUT_S
+
+#define BENCH_TOPIC             "sensor/DEMO1-A4CF12EF5D8C/telemetry"
+#define BENCH_SIM_LIMIT_MS      3600000 // Give up after one simulated hour
+#define BENCH_DROP_EVERY_MS     5000    // Drop run: link cut interval
+#define BENCH_RECONNECT_MS      2000    // Drop run: socket re-open time
+
+// ========================================
+// Clocks
+// ========================================
+
+static unsigned long simNowMs = 0;
+static unsigned long simMillis() { return simNowMs; }
+
+static unsigned long realMillis() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)(ts.tv_sec * 1000ull + ts.tv_nsec / 1000000);
+}
+
+// ========================================
+// Simulated link
+// ========================================
+
+struct TimedByte {
+    unsigned long at;
+    uint8_t value;
+};
+
+class SimLink : public MqttTransport {
+public:
+    SimLink(uint32_t rttMs, uint32_t uplinkBytesPerSec) {
+        halfRtt = rttMs / 2;
+        uplinkRate = uplinkBytesPerSec;
+        uplinkFreeAt = 0;
+        up = false;
+        uplinkBytes = 0;
+    }
+
+    uint64_t uplinkBytes;
+
+    bool connected() override { return up; }
+
+    int available() override {
+        int n = 0;
+        for (const TimedByte& b : toClient) {
+            if (b.at > simNowMs) {
+                break;
+            }
+            n++;
+        }
+        return n;
+    }
+
+    int read(uint8_t* buf, size_t len) override {
+        size_t n = 0;
+        while (n < len && !toClient.empty() && toClient.front().at <= simNowMs) {
+            buf[n++] = toClient.front().value;
+            toClient.pop_front();
+        }
+        return (int)n;
+    }
+
+    size_t write(const uint8_t* buf, size_t len) override {
+        if (!up) {
+            return 0;
+        }
+        // Bytes leave one after another at the UART rate
+        unsigned long start = uplinkFreeAt > simNowMs ? uplinkFreeAt : simNowMs;
+        uplinkFreeAt = start + (unsigned long)((uint64_t)len * 1000 / uplinkRate);
+        uplinkBytes += len;
+        for (size_t i = 0; i < len; i++) {
+            toBroker.push_back({ uplinkFreeAt + halfRtt, buf[i] });
+        }
+        return len;
+    }
+
+    // Broker side
+    bool brokerRead(uint8_t& value) {
+        if (toBroker.empty() || toBroker.front().at > simNowMs) {
+            return false;
+        }
+        value = toBroker.front().value;
+        toBroker.pop_front();
+        return true;
+    }
+
+    void brokerWrite(const uint8_t* buf, size_t len) {
+        for (size_t i = 0; i < len && up; i++) {
+            toClient.push_back({ simNowMs + halfRtt, buf[i] });
+        }
+    }
+
+    // Everything on the wire is lost
+    void cut() {
+        up = false;
+        toBroker.clear();
+        toClient.clear();
+        uplinkFreeAt = 0;
+    }
+
+    void restore() { up = true; }
+
+private:
+    uint32_t halfRtt;
+    uint32_t uplinkRate;
+    unsigned long uplinkFreeAt;
+    bool up;
+    std::deque<TimedByte> toBroker;
+    std::deque<TimedByte> toClient;
+};
+
+// ========================================
+// Broker stand-in
+// ========================================
+// Just enough MQTT 3.1.1 / 5: CONNECT (session present after a non-clean
+// session), PUBLISH with PUBACK, SUBSCRIBE, PINGREQ, DISCONNECT. Counts
+// how often each message sequence number arrived; with MQTT 5 it offers
+// topic aliases and checks every PUBLISH resolves to the right topic.
+
+#define BENCH_BROKER_ALIASES    8
+
+class BrokerStandIn {
+public:
+    explicit BrokerStandIn(SimLink& link) : link(link) {
+        sessionKnown = false;
+        level = 4;
+        publishes = 0;
+        dupFlags = 0;
+        topicErrors = 0;
+    }
+
+    std::vector<uint32_t> deliveries;   // Per message sequence number
+    uint32_t publishes;
+    uint32_t dupFlags;
+    uint32_t topicErrors;               // Unknown alias / wrong topic
+
+    void reset(uint32_t messages) {
+        deliveries.assign(messages, 0);
+        rx.clear();
+    }
+
+    // Aliases live as long as the connection
+    void onCut() {
+        rx.clear();
+        aliases.clear();
+    }
+
+    void step() {
+        uint8_t b;
+        while (link.brokerRead(b)) {
+            rx.push_back(b);
+        }
+
+        for (;;) {
+            size_t remaining = 0, pos = 1, multiplier = 1;
+            if (rx.size() < 2) {
+                return;
+            }
+            for (;;) {
+                if (pos >= rx.size()) {
+                    return;
+                }
+                remaining += (rx[pos] & 0x7F) * multiplier;
+                multiplier *= 128;
+                if (!(rx[pos++] & 0x80)) {
+                    break;
+                }
+            }
+            if (rx.size() < pos + remaining) {
+                return;
+            }
+            handle(rx[0], &rx[pos], remaining);
+            rx.erase(rx.begin(), rx.begin() + pos + remaining);
+        }
+    }
+
+private:
+    SimLink& link;
+    std::vector<uint8_t> rx;
+    bool sessionKnown;
+    uint8_t level;
+    std::map<uint16_t, std::string> aliases;
+
+    void handle(uint8_t header, const uint8_t* body, size_t len) {
+        switch (header & 0xF0) {
+            case 0x10: {
+                level = body[6];
+                bool clean = body[7] & 0x02;
+                uint8_t sp = !clean && sessionKnown ? 1 : 0;
+                sessionKnown = !clean;
+                aliases.clear();
+                if (level == 5) {
+                    uint8_t connack[8] = { 0x20, 6, sp, 0, 3, 0x22, 0, BENCH_BROKER_ALIASES };
+                    link.brokerWrite(connack, sizeof(connack));
+                } else {
+                    uint8_t connack[4] = { 0x20, 2, sp, 0 };
+                    link.brokerWrite(connack, sizeof(connack));
+                }
+                break;
+            }
+            case 0x30: {
+                uint8_t qos = (header >> 1) & 0x03;
+                size_t topicLen = (body[0] << 8) | body[1];
+                std::string topic((const char*)body + 2, topicLen);
+                size_t pos = 2 + topicLen;
+                uint8_t idHi = 0, idLo = 0;
+                if (qos > 0) {
+                    idHi = body[pos];
+                    idLo = body[pos + 1];
+                    pos += 2;
+                }
+                if (level == 5) {
+                    // Properties: only a short single-byte length is expected here
+                    size_t end = pos + 1 + body[pos];
+                    uint16_t alias = 0;
+                    for (pos++; pos < end;) {
+                        uint8_t id = body[pos++];
+                        if (id == 0x23) {
+                            alias = (body[pos] << 8) | body[pos + 1];
+                            pos += 2;
+                        } else if (id == 0x02) {
+                            pos += 4;
+                        } else if (id == 0x26) {
+                            pos += 2 + ((body[pos] << 8) | body[pos + 1]);
+                            pos += 2 + ((body[pos] << 8) | body[pos + 1]);
+                        } else {
+                            topicErrors++;
+                            pos = end;
+                        }
+                    }
+                    if (alias > BENCH_BROKER_ALIASES || (alias == 0 && topicLen == 0)) {
+                        topicErrors++;
+                    } else if (alias != 0 && topicLen > 0) {
+                        aliases[alias] = topic;
+                    } else if (alias != 0) {
+                        std::map<uint16_t, std::string>::const_iterator it = aliases.find(alias);
+                        topic = it != aliases.end() ? it->second : std::string();
+                    }
+                }
+                if (topic != BENCH_TOPIC) {
+                    topicErrors++;
+                }
+                publishes++;
+                if (header & 0x08) {
+                    dupFlags++;
+                }
+
+                unsigned seq;
+                if (sscanf((const char*)body + pos, "seq=%u;", &seq) == 1 && seq < deliveries.size()) {
+                    deliveries[seq]++;
+                }
+                if (qos == 1) {
+                    uint8_t puback[4] = { 0x40, 2, idHi, idLo };
+                    link.brokerWrite(puback, sizeof(puback));
+                }
+                (void)len;
+                break;
+            }
+            case 0x80: {
+                uint8_t suback[5] = { 0x90, 3, body[0], body[1], 0x01 };     // v5: reason code 1
+                link.brokerWrite(suback, sizeof(suback));
+                break;
+            }
+            case 0xC0: {
+                uint8_t pingresp[2] = { 0xD0, 0 };
+                link.brokerWrite(pingresp, sizeof(pingresp));
+                break;
+            }
+            default:
+                break;      // DISCONNECT
+        }
+    }
+};
+
+// ========================================
+// Real broker over TCP
+// ========================================
+
+class SocketTransport : public MqttTransport {
+public:
+    SocketTransport() { fd = -1; }
+    ~SocketTransport() { close(); }
+
+    bool open(const char* host, const char* port) {
+        struct addrinfo hints, *res;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host, port, &hints, &res) != 0) {
+            return false;
+        }
+        fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        bool ok = fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) == 0;
+        freeaddrinfo(res);
+        if (!ok) {
+            close();
+            return false;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        return true;
+    }
+
+    void close() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = -1;
+        pending.clear();
+    }
+
+    bool connected() override { return fd >= 0; }
+
+    int available() override {
+        fill();
+        return (int)pending.size();
+    }
+
+    int read(uint8_t* buf, size_t len) override {
+        fill();
+        size_t n = len < pending.size() ? len : pending.size();
+        for (size_t i = 0; i < n; i++) {
+            buf[i] = pending.front();
+            pending.pop_front();
+        }
+        return (int)n;
+    }
+
+    size_t write(const uint8_t* buf, size_t len) override {
+        size_t sent = 0;
+        while (fd >= 0 && sent < len) {
+            ssize_t n = send(fd, buf + sent, len - sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += n;
+            } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                close();
+            }
+        }
+        return sent;
+    }
+
+private:
+    int fd;
+    std::deque<uint8_t> pending;
+
+    void fill() {
+        uint8_t chunk[1024];
+        while (fd >= 0) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n > 0) {
+                pending.insert(pending.end(), chunk, chunk + n);
+            } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                close();
+            } else {
+                return;
+            }
+        }
+    }
+};
+
+// ========================================
+// Runs
+// ========================================
+
+struct Options {
+    uint32_t messages;
+    size_t payloadSize;
+    uint32_t rttMs;
+    uint32_t uplinkBytesPerSec;
+    const char* host;
+    const char* port;
+    uint8_t protocol;               // --host runs
+    bool json;
+};
+
+struct RunResult {
+    const char* name;
+    uint8_t protocol;
+    uint8_t window;
+    uint32_t messages;
+    double seconds;
+    uint32_t lastAckMs;
+    uint32_t maxAckMs;
+    uint32_t resent;
+    uint32_t drops;
+    uint32_t missing;
+    uint32_t duplicates;
+    double uplinkPerMsg;            // Bytes to the broker per message, all packets included
+    bool ok;
+};
+
+static std::vector<RunResult> results;
+
+static size_t buildPayload(char* out, size_t size, uint32_t seq) {
+    int n = snprintf(out, size, "seq=%u;", seq);
+    memset(out + n, 'x', size - n);
+    return size;
+}
+
+// Same settings as MQTTManager::begin() with MQTT_PROTOCOL_VERSION 5
+static void setupProtocol(MqttClient& client, uint8_t protocol) {
+    client.setProtocol(protocol);
+    client.setSessionExpiry(604800);
+    client.setMessageExpiry(3600);
+    client.setUserProperty("v", "2.1");
+}
+
+// Publish `messages` QoS 1 messages as fast as the window allows; with
+// dropEveryMs the link is cut periodically and the client reconnects
+static RunResult runSimulated(const Options& opt, uint8_t window, uint32_t dropEveryMs, uint8_t protocol) {
+    RunResult r;
+    memset(&r, 0, sizeof(r));
+    r.name = dropEveryMs ? (protocol == 5 ? "drop-v5" : "sim-drop") : (protocol == 5 ? "sim-v5" : "sim");
+    r.protocol = protocol;
+    r.window = window;
+    r.messages = opt.messages;
+
+    SimLink link(opt.rttMs, opt.uplinkBytesPerSec);
+    BrokerStandIn broker(link);
+    broker.reset(opt.messages);
+
+    std::vector<uint8_t> rxBuffer(BENCH_RX_BUFFER_SIZE), arena(BENCH_INFLIGHT_BYTES);
+    std::vector<char> payload(opt.payloadSize);
+    MqttClient client;
+    client.begin(&link, simMillis, rxBuffer.data(), rxBuffer.size(), arena.data(), arena.size(), window);
+    setupProtocol(client, protocol);
+
+    simNowMs = 1;
+    link.restore();
+    client.connect("bench", BENCH_KEEP_ALIVE_S, false, BENCH_CONNACK_MS);
+
+    uint32_t next = 0;
+    unsigned long lastDrop = simNowMs;
+    unsigned long reconnectAt = 0;
+    size_t topicLen = strlen(BENCH_TOPIC);
+
+    while (simNowMs < BENCH_SIM_LIMIT_MS) {
+        client.poll();
+        broker.step();
+
+        MqttClient::State state = client.getState();
+        if (state == MqttClient::MQTT_CONNECTED) {
+            if (next == opt.messages && client.getInflightCount() == 0) {
+                break;
+            }
+            while (next < opt.messages && client.canPublish(topicLen, opt.payloadSize)) {
+                buildPayload(payload.data(), payload.size(), next);
+                client.publish(BENCH_TOPIC, (const uint8_t*)payload.data(), payload.size(), 1, false);
+                next++;
+            }
+            if (dropEveryMs && simNowMs - lastDrop >= dropEveryMs) {
+                link.cut();
+                broker.onCut();
+                lastDrop = simNowMs;
+                reconnectAt = simNowMs + BENCH_RECONNECT_MS;
+                r.drops++;
+            }
+        } else if (state != MqttClient::MQTT_CONNECTING && simNowMs >= reconnectAt) {
+            link.cut();
+            broker.onCut();
+            link.restore();
+            client.connect("bench", BENCH_KEEP_ALIVE_S, false, BENCH_CONNACK_MS);
+        }
+        simNowMs++;
+    }
+
+    const MqttClient::Stats& stats = client.getStats();
+    r.seconds = simNowMs / 1000.0;
+    r.lastAckMs = stats.lastAckMs;
+    r.maxAckMs = stats.maxAckMs;
+    r.resent = stats.resent;
+    for (uint32_t count : broker.deliveries) {
+        if (count == 0) {
+            r.missing++;
+        } else {
+            r.duplicates += count - 1;
+        }
+    }
+    r.uplinkPerMsg = (double)link.uplinkBytes / opt.messages;
+    r.ok = next == opt.messages && r.missing == 0 && client.getInflightCount() == 0 &&
+           broker.topicErrors == 0;
+    return r;
+}
+
+static RunResult runBroker(const Options& opt, uint8_t window) {
+    RunResult r;
+    memset(&r, 0, sizeof(r));
+    r.name = "broker";
+    r.protocol = opt.protocol;
+    r.window = window;
+    r.messages = opt.messages;
+
+    SocketTransport socket;
+    if (!socket.open(opt.host, opt.port)) {
+        fprintf(stderr, "cannot connect to %s:%s\n", opt.host, opt.port);
+        return r;
+    }
+
+    std::vector<uint8_t> rxBuffer(BENCH_RX_BUFFER_SIZE), arena(BENCH_INFLIGHT_BYTES);
+    std::vector<char> payload(opt.payloadSize);
+    MqttClient client;
+    client.begin(&socket, realMillis, rxBuffer.data(), rxBuffer.size(), arena.data(), arena.size(), window);
+    setupProtocol(client, opt.protocol);
+    client.connect("bench", BENCH_KEEP_ALIVE_S, true, BENCH_CONNACK_MS);
+
+    unsigned long start = realMillis();
+    uint32_t next = 0;
+    size_t topicLen = strlen(BENCH_TOPIC);
+    for (;;) {
+        client.poll();
+        MqttClient::State state = client.getState();
+        if (state != MqttClient::MQTT_CONNECTING && state != MqttClient::MQTT_CONNECTED) {
+            fprintf(stderr, "broker connection failed (state %d, rc %u)\n", state, client.getReturnCode());
+            return r;
+        }
+        if (next == opt.messages && client.getInflightCount() == 0) {
+            break;
+        }
+        while (state == MqttClient::MQTT_CONNECTED && next < opt.messages &&
+               client.canPublish(topicLen, opt.payloadSize)) {
+            buildPayload(payload.data(), payload.size(), next);
+            client.publish(BENCH_TOPIC, (const uint8_t*)payload.data(), payload.size(), 1, false);
+            next++;
+        }
+    }
+    client.disconnect();
+
+    const MqttClient::Stats& stats = client.getStats();
+    r.seconds = (realMillis() - start) / 1000.0;
+    r.lastAckMs = stats.lastAckMs;
+    r.maxAckMs = stats.maxAckMs;
+    r.ok = true;
+    return r;
+}
+
+// ========================================
+// Report
+// ========================================
+
+static void printText(const Options& opt) {
+    printf("MQTT QoS 1 window, %u messages x %zu B, RTT %u ms, uplink %u B/s\n",
+           opt.messages, opt.payloadSize, opt.rttMs, opt.uplinkBytesPerSec);
+    printf("%-9s %5s %6s %9s %9s %9s %7s %6s %8s %5s %7s %4s\n",
+           "run", "mqtt", "window", "seconds", "msg/s", "max ack", "resent", "drops", "missing", "dups",
+           "B/msg", "ok");
+    for (const RunResult& r : results) {
+        printf("%-9s %5s %6u %9.2f %9.1f %6u ms %7u %6u %8u %5u %7.1f %4s\n",
+               r.name, r.protocol == 5 ? "5" : "3.1.1", r.window, r.seconds,
+               r.seconds > 0 ? r.messages / r.seconds : 0.0, r.maxAckMs, r.resent, r.drops,
+               r.missing, r.duplicates, r.uplinkPerMsg, r.ok ? "yes" : "NO");
+    }
+}
+
+static void printJson(const Options& opt) {
+    printf("{\"messages\":%u,\"payload\":%zu,\"rtt_ms\":%u,\"uplink_bps\":%u,\"runs\":[",
+           opt.messages, opt.payloadSize, opt.rttMs, opt.uplinkBytesPerSec);
+    for (size_t i = 0; i < results.size(); i++) {
+        const RunResult& r = results[i];
+        printf("%s{\"run\":\"%s\",\"protocol\":%u,\"window\":%u,\"seconds\":%.3f,\"msg_per_s\":%.2f,"
+               "\"max_ack_ms\":%u,\"resent\":%u,\"drops\":%u,\"missing\":%u,\"duplicates\":%u,"
+               "\"uplink_per_msg\":%.1f,\"ok\":%s}",
+               i ? "," : "", r.name, r.protocol, r.window, r.seconds,
+               r.seconds > 0 ? r.messages / r.seconds : 0.0, r.maxAckMs, r.resent, r.drops,
+               r.missing, r.duplicates, r.uplinkPerMsg, r.ok ? "true" : "false");
+    }
+    printf("]}\n");
+}
+
+// ========================================
+// Main
+// ========================================
+
+int main(int argc, char** argv) {
+    Options opt;
+    opt.messages = 200;
+    opt.payloadSize = 300;              // Typical telemetry JSON
+    opt.rttMs = 300;                    // LTE Cat-1 with a distant broker
+    opt.uplinkBytesPerSec = 11520;      // 115200 baud modem UART
+    opt.host = nullptr;
+    opt.port = "1883";
+    opt.protocol = 4;
+    opt.json = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--messages") && i + 1 < argc) {
+            opt.messages = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--payload") && i + 1 < argc) {
+            opt.payloadSize = (size_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--rtt") && i + 1 < argc) {
+            opt.rttMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--uplink") && i + 1 < argc) {
+            opt.uplinkBytesPerSec = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--host") && i + 1 < argc) {
+            opt.host = argv[++i];
+        } else if (!strcmp(argv[i], "--port") && i + 1 < argc) {
+            opt.port = argv[++i];
+        } else if (!strcmp(argv[i], "--v5")) {
+            opt.protocol = 5;
+        } else if (!strcmp(argv[i], "--json")) {
+            opt.json = true;
+        } else {
+            fprintf(stderr, "usage: %s [--messages N] [--payload BYTES] [--rtt MS] [--uplink BYTES_PER_S]"
+                            " [--host ADDR] [--port N] [--v5] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (opt.messages == 0 || opt.payloadSize < 16 || opt.payloadSize > BENCH_INFLIGHT_BYTES / 2 ||
+        opt.uplinkBytesPerSec == 0) {
+        fprintf(stderr, "messages and uplink must be > 0, payload 16..%u bytes\n", BENCH_INFLIGHT_BYTES / 2);
+        return 2;
+    }
+
+    const uint8_t windows[] = { 1, 4, 8 };
+    bool ok = true;
+    for (uint8_t window : windows) {
+        RunResult r = opt.host ? runBroker(opt, window) : runSimulated(opt, window, 0, 4);
+        ok = r.ok && ok;
+        results.push_back(r);
+    }
+    if (!opt.host) {
+        const RunResult extra[] = {
+            runSimulated(opt, 8, BENCH_DROP_EVERY_MS, 4),
+            runSimulated(opt, 8, 0, 5),
+            runSimulated(opt, 8, BENCH_DROP_EVERY_MS, 5)
+        };
+        for (const RunResult& r : extra) {
+            ok = r.ok && ok;
+            results.push_back(r);
+        }
+    }
+
+    if (opt.json) {
+        printJson(opt);
+    } else {
+        printText(opt);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,725 @@
+// ============================================================================
+// PIPELINE BENCH - Host benchmark for the per-cycle telemetry work
+// ============================================================================
+// Links the firmware sources (minus main.cpp and the mbedTLS transport)
+// against the native simulation HAL and runs the CPU side of one telemetry
+// cycle on fixed inputs, outside the simulation scheduler:
+//   config      parseConfig() of the two sample device maps
+//   acquire     acquireSample() with 1, 5 and 10 RS485 devices: sensor JSON
+//               built and serialized (Modbus answers are recorded frames)
+//   encode      encodeTelemetry(): both telemetry messages of that sample
+//   crc         queue record CRC-32 and Modbus CRC-16 over fixed buffers
+//   decode      queue record header + CRC check, Modbus response decode
+//   queue       outbox records (spill layout) through StorageEngine, RAM
+//               and posix-sd backends
+//
+// Every stage reports per-op latency, allocations per op and the heap
+// high-water mark above the level before the stage (glibc only; the
+// numbers are host sizes, ArduinoJson slots are larger on 64 bit).
+// record-pipeline keeps the JSON report per commit in bench/results/.
+//
+// Build + run:  make -C bench run-pipeline        (see bench/Makefile)
+// Options:      --iterations N  --maps DIR  --dir PATH  --commit SHA  --json
+
+#define TINY_GSM_MODEM_SIM7600
+
+#include <Arduino.h>
+#include <TinyGsmClient.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "config.h"
+#include "modem_at.h"
+#include "async_gsm_client.h"
+#include "lte_manager.h"
+#include "mqtt_manager.h"
+#include "connection_manager.h"
+#include "telemetry.h"
+#include "time_manager.h"
+#include "generic_io.h"
+#include "rs485_config_manager.h"
+#include "history_archive.h"
+#include "data_budget.h"
+#include "task_monitor.h"
+#include "boot_profiler.h"
+#include "modbus_rtu.h"
+#include "queue_record.h"
+#include "queue_backend.h"
+#include "storage_engine.h"
+#include "sim_kernel.h"
+#include "sim_plant.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define BENCH_HEAP_TRACKING 1
+#else
+#define BENCH_HEAP_TRACKING 0
+#endif
+
+#define BENCH_EPOCH                 1767225600UL    // 2026-01-01 00:00:00 UTC
+#define BENCH_DEVICE_ID             "DEMO1-A4CF12EF5D8C"
+#define BENCH_CRC_BLOCK             4096
+#define BENCH_DECODE_BATCH          64      // Frames / records per decode op
+#define BENCH_QUEUE_BATCH           200     // Records per enqueue + drain round
+
+// Same values as config.h / storage_bench.cpp
+#define BENCH_QUEUE_SEGMENT_SIZE     32768
+#define BENCH_SD_QUEUE_MAX_SEGMENTS  256
+#define BENCH_WRITE_BLOCK_SIZE       4096
+#define BENCH_STAGING_SIZE           8192
+#define BENCH_DURABILITY_MS          60000
+#define BENCH_RAM_QUEUE_BYTES        524288
+#define BENCH_RAM_QUEUE_SLAB_SIZE    256
+#define BENCH_RETRY_MS               60000
+
+// ========================================
+// Firmware globals (main.cpp is not linked)
+// ========================================
+
+HardwareSerial simSerial(1);
+TinyGsm modem(simSerial);
+ModemAt modemAt(simSerial);
+AsyncGsmClient diagClient(modem, 1, modemAt);
+LTEManager lteManager;
+MQTTManager mqttManager(modemAt);
+ConnectionManager connectionManager(lteManager, mqttManager);
+TimeManager timeManager;
+GenericIOManager ioManager;
+HistoryArchive historyArchive;
+DataBudget dataBudget;
+TaskMonitor acqMonitor("acq");
+TaskMonitor commsMonitor("comms");
+BootProfiler bootProfiler;
+String DEVICE_ID = BENCH_DEVICE_ID;
+
+// ========================================
+// Heap accounting (malloc family wrapped, glibc)
+// ========================================
+
+struct HeapCounters {
+    uint64_t allocs;
+    int64_t live;
+    int64_t peak;
+};
+
+static HeapCounters heap = { 0, 0, 0 };
+
+#if BENCH_HEAP_TRACKING
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+static void heapAdd(void* ptr) {
+    heap.allocs++;
+    heap.live += malloc_usable_size(ptr);
+    if (heap.live > heap.peak) {
+        heap.peak = heap.live;
+    }
+}
+
+void* malloc(size_t size) {
+    void* ptr = __libc_malloc(size);
+    if (ptr) heapAdd(ptr);
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size) {
+    void* ptr = __libc_calloc(count, size);
+    if (ptr) heapAdd(ptr);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) {
+    size_t old = ptr ? malloc_usable_size(ptr) : 0;
+    void* next = __libc_realloc(ptr, size);
+    if (next) {
+        heap.live -= old;
+        heapAdd(next);
+    }
+    return next;
+}
+
+void free(void* ptr) {
+    if (ptr) heap.live -= malloc_usable_size(ptr);
+    __libc_free(ptr);
+}
+}
+#endif
+
+// ========================================
+// Recorded Modbus answers
+// ========================================
+// One response frame per (slave, register, count), made on first use and
+// decoded by the same code as main.cpp. Values are fixed per register.
+
+enum RecordedKind { RECORDED_WORDS, RECORDED_FLOAT, RECORDED_UINT32 };
+
+static std::map<uint32_t, std::vector<uint8_t>> recordedFrames;
+
+static const std::vector<uint8_t>& recordedFrame(uint8_t slaveId, uint16_t regAddr, uint16_t count,
+                                                 RecordedKind kind) {
+    uint32_t key = ((uint32_t)slaveId << 24) | ((uint32_t)regAddr << 8) | (count & 0xFF);
+    auto it = recordedFrames.find(key);
+    if (it != recordedFrames.end()) {
+        return it->second;
+    }
+
+    std::vector<uint16_t> regs(count);
+    if (kind == RECORDED_FLOAT && count == 2) {
+        float value = 200.0f + (regAddr % 50) * 0.5f + slaveId;
+        uint8_t bytes[4];
+        memcpy(bytes, &value, 4);
+        regs[0] = bytes[0] | (bytes[1] << 8);   // BADC
+        regs[1] = bytes[2] | (bytes[3] << 8);
+    } else if (kind == RECORDED_UINT32 && count == 2) {
+        uint32_t value = 1000000UL + regAddr * 13UL + slaveId;
+        regs[0] = value & 0xFFFF;               // Low word first
+        regs[1] = value >> 16;
+    } else {
+        for (uint16_t i = 0; i < count; i++) {
+            regs[i] = 1000 + (regAddr + i) % 1000 + slaveId;
+        }
+    }
+
+    std::vector<uint8_t> frame;
+    frame.push_back(slaveId);
+    frame.push_back(MODBUS_FN_READ_HOLDING);
+    frame.push_back((uint8_t)(count * 2));
+    for (uint16_t i = 0; i < count; i++) {
+        frame.push_back(regs[i] >> 8);
+        frame.push_back(regs[i] & 0xFF);
+    }
+    uint16_t crc = modbusCRC(frame.data(), frame.size());
+    frame.push_back(crc & 0xFF);
+    frame.push_back(crc >> 8);
+    return recordedFrames[key] = frame;
+}
+
+static bool readRecorded(uint8_t slaveId, uint16_t regAddr, uint16_t count, uint16_t* output,
+                         RecordedKind kind) {
+    const std::vector<uint8_t>& frame = recordedFrame(slaveId, regAddr, count, kind);
+    return modbusDecodeReadResponse(frame.data(), frame.size(), slaveId, count, output);
+}
+
+bool readRS485Register(uint8_t slaveId, uint16_t regAddr, uint16_t count, uint16_t* output) {
+    return readRecorded(slaveId, regAddr, count, output, RECORDED_WORDS);
+}
+
+float readRS485Float32(uint8_t slaveId, uint16_t regAddr) {
+    uint16_t regs[2];
+    if (!readRecorded(slaveId, regAddr, 2, regs, RECORDED_FLOAT)) {
+        return NAN;
+    }
+    return modbusFloat32BADC(regs);
+}
+
+uint32_t readRS485Uint32(uint8_t slaveId, uint16_t regAddr) {
+    uint16_t regs[2];
+    if (!readRecorded(slaveId, regAddr, 2, regs, RECORDED_UINT32)) {
+        return 0;
+    }
+    return modbusUint32LowFirst(regs);
+}
+
+// ========================================
+// Clock
+// ========================================
+
+static uint64_t nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static unsigned long benchMillis() { return (unsigned long)(nowNanos() / 1000000); }
+static unsigned long benchMicros() { return (unsigned long)(nowNanos() / 1000); }
+
+// ========================================
+// Results
+// ========================================
+
+struct Latency {
+    double p50, p99, max;           // microseconds
+};
+
+struct Result {
+    std::string stage;
+    std::string variant;
+    uint32_t ops;
+    uint64_t items;                 // Frames / records; = ops for single-item ops
+    double seconds;
+    uint64_t bytes;                 // Output (acquire, encode) or input bytes
+    Latency latency;
+    double allocsPerOp;
+    int64_t heapPeak;               // Above the level before the stage, -1 = not tracked
+    std::string note;
+};
+
+static std::vector<Result> results;
+static std::vector<std::string> failures;
+
+static Latency percentiles(std::vector<uint64_t>& samples) {
+    Latency l = { 0, 0, 0 };
+    if (samples.empty()) {
+        return l;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    l.p50 = samples[n * 50 / 100] / 1000.0;
+    l.p99 = samples[n * 99 / 100] / 1000.0;
+    l.max = samples[n - 1] / 1000.0;
+    return l;
+}
+
+static void fail(const std::string& stage, const std::string& variant, const char* why) {
+    failures.push_back(stage + " " + variant + ": " + why);
+    fprintf(stderr, "%s %s: %s\n", stage.c_str(), variant.c_str(), why);
+}
+
+// Time and heap spent in a stage, over one or more runs of ops. The
+// sample buffer is reserved up front so it does not show in the heap
+struct Meter {
+    std::vector<uint64_t> samples;
+    uint64_t nanos;
+    uint64_t bytes;
+    uint64_t allocs;
+    int64_t heapPeak;
+    int64_t heapBase;
+    uint64_t allocsBase;
+
+    explicit Meter(uint32_t ops) : nanos(0), bytes(0), allocs(0), heapPeak(0), heapBase(0), allocsBase(0) {
+        samples.reserve(ops);
+    }
+
+    // Calls op() `ops` times; op returns the bytes it handled, < 0 = failed
+    template <typename Op>
+    bool run(uint32_t ops, Op op) {
+        heapBase = heap.live;
+        heap.peak = heap.live;
+        allocsBase = heap.allocs;
+
+        bool ok = true;
+        uint64_t start = nowNanos();
+        for (uint32_t i = 0; i < ops; i++) {
+            uint64_t t0 = nowNanos();
+            long n = op();
+            samples.push_back(nowNanos() - t0);
+            if (n < 0) {
+                ok = false;
+                break;
+            }
+            bytes += n;
+        }
+        nanos += nowNanos() - start;
+
+        heapPeak = std::max(heapPeak, heap.peak - heapBase);
+        allocs += heap.allocs - allocsBase;
+        return ok;
+    }
+
+    void report(const std::string& stage, const std::string& variant, uint32_t itemsPerOp) {
+        Result r;
+        r.stage = stage;
+        r.variant = variant;
+        r.ops = samples.size();
+        r.items = (uint64_t)r.ops * itemsPerOp;
+        r.seconds = nanos / 1e9;
+        r.bytes = bytes;
+        r.latency = percentiles(samples);
+        r.allocsPerOp = BENCH_HEAP_TRACKING && r.ops ? (double)allocs / r.ops : -1;
+        r.heapPeak = BENCH_HEAP_TRACKING ? heapPeak : -1;
+        results.push_back(r);
+    }
+};
+
+// One untimed call first, so first-use allocations are not counted
+template <typename Op>
+static bool measure(const std::string& stage, const std::string& variant, uint32_t ops,
+                    uint32_t itemsPerOp, Op op) {
+    Meter meter(ops);
+    if (op() < 0 || !meter.run(ops, op)) {
+        fail(stage, variant, "failed");
+        return false;
+    }
+    meter.report(stage, variant, itemsPerOp);
+    return true;
+}
+
+// ========================================
+// Inputs
+// ========================================
+
+static bool readFile(const std::string& path, std::string& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    char buf[4096];
+    size_t n;
+    out.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.append(buf, n);
+    }
+    fclose(f);
+    return true;
+}
+
+// N devices on addresses 1..N, power meters and flow meters alternating
+static std::string deviceConfig(uint8_t devices) {
+    std::string json = "[";
+    char device[128];
+    for (uint8_t i = 1; i <= devices; i++) {
+        snprintf(device, sizeof(device), "%s{\"profile\":\"%s\",\"version\":1,\"modbus_address\":%u}",
+                 i > 1 ? "," : "", i % 2 ? "3Phase-PowerMeter-V2305" : "TUF-2000-FlowMeter", i);
+        json += device;
+    }
+    return json + "]";
+}
+
+static void removeTree(const char* path) {
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", path);
+    if (system(cmd) != 0) {
+        fprintf(stderr, "cannot remove %s\n", path);
+    }
+}
+
+// ========================================
+// Stages
+// ========================================
+
+static void benchConfigParse(const char* mapsDir, uint32_t iterations) {
+    static const char* maps[][2] = {
+        { "power-meter-3phase", "power-meter-3phase-modbus-config.json" },
+        { "tuf2000-flowmeter",  "tuf2000-flowmeter-modbus-config.json" },
+    };
+    for (auto& map : maps) {
+        std::string json;
+        if (!readFile(std::string(mapsDir) + "/" + map[1], json)) {
+            fail("config", map[0], "cannot read the sample map (--maps)");
+            continue;
+        }
+        measure("config", map[0], iterations, 1, [&]() -> long {
+            return rs485ConfigMgr.parseConfig((const uint8_t*)json.data(), json.size()) ? json.size() : -1;
+        });
+    }
+}
+
+// acquire + encode for one device count; keeps the encoded messages for
+// the queue stages
+static void benchTelemetry(uint8_t devices, uint32_t iterations, std::vector<std::string>& messages) {
+    char variant[16];
+    snprintf(variant, sizeof(variant), "%u dev", devices);
+
+    std::string config = deviceConfig(devices);
+    if (!rs485ConfigMgr.parseConfig((const uint8_t*)config.data(), config.size())) {
+        fail("acquire", variant, "config rejected");
+        return;
+    }
+    rs485ConfigMgr.commitStaged();
+    if (rs485ConfigMgr.getOnlineCount() != devices) {
+        fail("acquire", variant, "devices not online");
+        return;
+    }
+
+    // A pass over SAMPLE_JSON_BYTES loses its RS485 readings: that is a
+    // failure here, not a smaller sample to time
+    static SensorSample sample;
+    if (!acquireSample(sample) || strstr(sample.json, "\"rs485\"") == nullptr) {
+        fail("acquire", variant, "sample over SAMPLE_JSON_BYTES, RS485 readings dropped");
+        return;
+    }
+    if (!measure("acquire", variant, iterations, 1, [&]() -> long {
+            return acquireSample(sample) ? sample.length : -1;
+        })) {
+        return;
+    }
+
+    String basic;
+    String rs485;
+    measure("encode", variant, iterations, 1, [&]() -> long {
+        size_t length = encodeTelemetry(sample, BENCH_EPOCH, basic, rs485);
+        return length > 0 && rs485.length() > 0 ? (long)length : -1;
+    });
+
+    messages.clear();
+    messages.push_back(basic.c_str());
+    if (rs485.length() > 0) {
+        messages.push_back(rs485.c_str());
+    }
+}
+
+static void benchCrc(uint32_t iterations) {
+    std::vector<uint8_t> block(BENCH_CRC_BLOCK);
+    for (size_t i = 0; i < block.size(); i++) {
+        block[i] = (uint8_t)(i * 31 + 7);
+    }
+    volatile uint32_t sink = 0;
+
+    measure("crc", "queue crc32", iterations, 1, [&]() -> long {
+        sink = sink + queueCrc32(0, block.data(), block.size());
+        return block.size();
+    });
+    measure("crc", "modbus crc16", iterations, 1, [&]() -> long {
+        sink = sink + modbusCRC(block.data(), block.size());
+        return block.size();
+    });
+}
+
+static void benchDecode(uint32_t iterations, const std::vector<std::string>& messages) {
+    // Queue records as RecordLog writes them: header + telemetry payload
+    std::vector<std::vector<uint8_t>> records;
+    for (uint32_t seq = 0; seq < BENCH_DECODE_BATCH && !messages.empty(); seq++) {
+        const std::string& payload = messages[seq % messages.size()];
+        std::vector<uint8_t> record(QUEUE_RECORD_HEADER_SIZE + payload.size());
+        memcpy(record.data() + QUEUE_RECORD_HEADER_SIZE, payload.data(), payload.size());
+        queueRecordEncodeHeader(record.data(), (uint16_t)payload.size(), seq,
+                                record.data() + QUEUE_RECORD_HEADER_SIZE);
+        records.push_back(record);
+    }
+    if (!records.empty()) {
+        measure("decode", "queue record", iterations, BENCH_DECODE_BATCH, [&]() -> long {
+            size_t bytes = 0;
+            for (const auto& record : records) {
+                QueueRecordHeader header;
+                if (!queueRecordDecodeHeader(record.data(), header) ||
+                    queueCrc32(queueRecordHeaderCrc(header.length, header.seq),
+                               record.data() + QUEUE_RECORD_HEADER_SIZE, header.length) != header.crc) {
+                    return -1;
+                }
+                bytes += record.size();
+            }
+            return bytes;
+        });
+    }
+
+    // Modbus responses recorded by the acquire stages
+    std::vector<const std::vector<uint8_t>*> frames;
+    for (auto it = recordedFrames.begin(); it != recordedFrames.end() && frames.size() < BENCH_DECODE_BATCH; ++it) {
+        frames.push_back(&it->second);
+    }
+    if (frames.empty()) {
+        return;
+    }
+    volatile uint16_t sink = 0;
+    measure("decode", "modbus response", iterations, frames.size(), [&]() -> long {
+        size_t bytes = 0;
+        uint16_t regs[125];
+        for (const auto* frame : frames) {
+            const uint8_t* f = frame->data();
+            if (!modbusDecodeReadResponse(f, frame->size(), f[0], f[2] / 2, regs)) {
+                return -1;
+            }
+            sink = sink + regs[0];
+            bytes += frame->size();
+        }
+        return bytes;
+    });
+}
+
+// Outbox records as MQTTManager::spill() lays them out: [flags][topic\0][payload]
+static void benchQueue(QueueBackend& backend, uint32_t iterations, const std::vector<std::string>& messages) {
+    static const char* topic = "sensor/" BENCH_DEVICE_ID "/telemetry";
+    std::vector<uint8_t> buffer(QUEUE_RECORD_MAX_PAYLOAD);
+    std::vector<uint8_t> scratch(QUEUE_RECORD_MAX_PAYLOAD);
+
+    StorageEngine engine;
+    engine.addBackend(&backend);
+    if (messages.empty() || !engine.begin(BENCH_RETRY_MS, benchMillis, scratch.data(), scratch.size())) {
+        fail("queue", backend.getName(), "engine begin failed");
+        return;
+    }
+    engine.clear();
+
+    // Rounds of BENCH_QUEUE_BATCH records, enqueued then drained, so the
+    // RAM arena never fills
+    uint32_t rounds = iterations / BENCH_QUEUE_BATCH > 0 ? iterations / BENCH_QUEUE_BATCH : 1;
+    uint32_t next = 0;
+    std::string enqueueName = std::string(backend.getName()) + " enqueue";
+    std::string drainName = std::string(backend.getName()) + " drain";
+
+    auto enqueue = [&]() -> long {
+        const std::string& payload = messages[next++ % messages.size()];
+        size_t topicLen = strlen(topic);
+        size_t len = 1 + topicLen + 1 + payload.size();
+        buffer[0] = 0;
+        memcpy(buffer.data() + 1, topic, topicLen + 1);
+        memcpy(buffer.data() + 1 + topicLen + 1, payload.data(), payload.size());
+        return engine.push(buffer.data(), len) ? len : -1;
+    };
+    auto drain = [&]() -> long {
+        size_t len;
+        if (!engine.pop(buffer.data(), buffer.size(), len) ||
+            memchr(buffer.data() + 1, '\0', len - 1) == nullptr) {
+            return -1;
+        }
+        return len;
+    };
+
+    // Untimed round: segment files and arena slabs exist before timing
+    for (uint32_t i = 0; i < BENCH_QUEUE_BATCH; i++) enqueue();
+    engine.flush();
+    while (engine.count() > 0) drain();
+
+    Meter pushed(rounds * BENCH_QUEUE_BATCH);
+    Meter drained(rounds * BENCH_QUEUE_BATCH);
+    for (uint32_t round = 0; round < rounds; round++) {
+        if (!pushed.run(BENCH_QUEUE_BATCH, enqueue)) {
+            fail("queue", enqueueName, "push failed");
+            return;
+        }
+        engine.flush();     // Part of the enqueue cost, untimed per op
+        if (!drained.run(BENCH_QUEUE_BATCH, drain)) {
+            fail("queue", drainName, "pop failed");
+            return;
+        }
+    }
+    pushed.report("queue", enqueueName, 1);
+    drained.report("queue", drainName, 1);
+}
+
+static FileQueueBackend::Config fileConfig(const char* name, const char* dir) {
+    FileQueueBackend::Config config;
+    config.name = name;
+    config.dir = dir;
+    config.segmentSize = BENCH_QUEUE_SEGMENT_SIZE;
+    config.maxSegments = BENCH_SD_QUEUE_MAX_SEGMENTS;
+    config.blockSize = BENCH_WRITE_BLOCK_SIZE;
+    config.stagingSize = BENCH_STAGING_SIZE;
+    config.durabilityMs = BENCH_DURABILITY_MS;
+    config.millisFn = benchMillis;
+    config.microsFn = benchMicros;
+    return config;
+}
+
+// ========================================
+// Output
+// ========================================
+
+static void printText() {
+    printf("%-7s %-18s %7s %11s %8s %8s %9s %9s %9s %9s %10s\n",
+           "stage", "variant", "ops", "items/s", "MB/s", "B/op", "p50 us", "p99 us", "max us",
+           "allocs/op", "heap peak");
+    for (const Result& r : results) {
+        printf("%-7s %-18s %7u %11.0f %8.2f %8.0f %9.2f %9.2f %9.2f %9.1f %10lld  %s\n",
+               r.stage.c_str(), r.variant.c_str(), r.ops, r.items / r.seconds, r.bytes / r.seconds / 1e6,
+               (double)r.bytes / r.ops, r.latency.p50, r.latency.p99, r.latency.max, r.allocsPerOp,
+               (long long)r.heapPeak, r.note.c_str());
+    }
+    if (!BENCH_HEAP_TRACKING) {
+        printf("\n(heap columns need glibc: -1 = not tracked)\n");
+    }
+    for (const std::string& failure : failures) {
+        printf("FAIL %s\n", failure.c_str());
+    }
+}
+
+static void printJson(const char* commit, uint32_t iterations) {
+    printf("{\"commit\":\"%s\",\"iterations\":%u,\"heap_tracking\":%s,\"results\":[",
+           commit, iterations, BENCH_HEAP_TRACKING ? "true" : "false");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        printf("%s{\"stage\":\"%s\",\"variant\":\"%s\",\"ops\":%u,\"items_per_s\":%.0f,\"mb_per_s\":%.3f,"
+               "\"bytes_per_op\":%.0f,\"p50_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f,"
+               "\"allocs_per_op\":%.2f,\"heap_peak_bytes\":%lld,\"note\":\"%s\"}",
+               i ? "," : "", r.stage.c_str(), r.variant.c_str(), r.ops, r.items / r.seconds,
+               r.bytes / r.seconds / 1e6, (double)r.bytes / r.ops, r.latency.p50, r.latency.p99,
+               r.latency.max, r.allocsPerOp, (long long)r.heapPeak, r.note.c_str());
+    }
+    printf("],\"failures\":[");
+    for (size_t i = 0; i < failures.size(); i++) {
+        printf("%s\"%s\"", i ? "," : "", failures[i].c_str());
+    }
+    printf("]}\n");
+}
+
+// ========================================
+// Main
+// ========================================
+
+int main(int argc, char** argv) {
+    uint32_t iterations = 2000;
+    const char* mapsDir = "..";     // make -C bench runs from bench/
+    const char* root = "/tmp/pipeline_bench";
+    const char* commit = "unknown";
+    bool json = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            iterations = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--maps") && i + 1 < argc) {
+            mapsDir = argv[++i];
+        } else if (!strcmp(argv[i], "--dir") && i + 1 < argc) {
+            root = argv[++i];
+        } else if (!strcmp(argv[i], "--commit") && i + 1 < argc) {
+            commit = argv[++i];
+        } else if (!strcmp(argv[i], "--json")) {
+            json = true;
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [--maps DIR] [--dir PATH] [--commit SHA] [--json]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (iterations == 0) {
+        fprintf(stderr, "iterations must be > 0\n");
+        return 2;
+    }
+
+    // Firmware logs go nowhere; they are still formatted, as on the device
+    sim::setConsoleSink(nullptr);
+    setenv("TZ", "UTC", 1);
+    tzset();
+    sim::PlantOptions plant = { BENCH_EPOCH, true, true };
+    sim::attachPlant(plant);
+    ioManager.begin();
+
+    benchConfigParse(mapsDir, iterations);
+
+    std::vector<std::string> messages;
+    static const uint8_t deviceCounts[] = { 1, 5, 10 };
+    for (uint8_t devices : deviceCounts) {
+        std::vector<std::string> encoded;
+        benchTelemetry(devices, iterations, encoded);
+        if (!encoded.empty()) {
+            messages = encoded;     // Largest set that fit feeds the queue stages
+        }
+    }
+
+    benchCrc(iterations);
+    benchDecode(iterations, messages);
+
+    removeTree(root);
+    char sdDir[256];
+    snprintf(sdDir, sizeof(sdDir), "%s/bench-sd", root);
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "mkdir -p '%s'", root);
+    if (system(cmd) != 0) {
+        fprintf(stderr, "cannot create %s\n", root);
+        return 1;
+    }
+    {
+        RamQueueBackend ram(BENCH_RAM_QUEUE_BYTES, BENCH_RAM_QUEUE_BYTES, BENCH_RAM_QUEUE_SLAB_SIZE);
+        benchQueue(ram, iterations, messages);
+    }
+    {
+        FileQueueBackend sd(fileConfig("posix-sd", sdDir));
+        benchQueue(sd, iterations, messages);
+    }
+    removeTree(root);
+
+    if (json) {
+        printJson(commit, iterations);
+    } else {
+        printText();
+    }
+    return failures.empty() ? 0 : 1;
+}
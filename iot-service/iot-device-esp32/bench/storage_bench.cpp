@@ -0,0 +1,402 @@
+// ============================================================================
+// STORAGE BENCH - Host benchmark for the offline queue backends
+// ============================================================================
+// Runs the portable storage code (RecordLog, SlabRing, StorageEngine) on a
+// Linux/macOS host against plain directories:
+//   posix-sd    FileQueueBackend with the SD Card settings from config.h
+//   posix-lfs   FileQueueBackend with the LittleFS settings
+//   ram         RamQueueBackend with the PSRAM arena size
+//
+// For each backend: enqueue / dequeue throughput and per-call latency
+// percentiles. Then a failover run through StorageEngine: the "SD" directory
+// is renamed away mid-stream (card pulled) and restored later, and every
+// record is checked to come back out exactly once.
+//
+// Build + run:  make -C bench run        (see bench/Makefile)
+// Options:      --records N  --payload BYTES  --dir PATH  --json
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+#include "queue_backend.h"
+#include "storage_engine.h"
+
+// Same values as config.h (which needs Arduino.h)
+#define BENCH_QUEUE_SEGMENT_SIZE     32768
+#define BENCH_SD_QUEUE_MAX_SEGMENTS  256
+#define BENCH_LFS_QUEUE_MAX_SEGMENTS 32
+#define BENCH_WRITE_BLOCK_SIZE       4096
+#define BENCH_STAGING_SIZE           8192
+#define BENCH_DURABILITY_MS          60000
+#define BENCH_RAM_QUEUE_BYTES        524288
+#define BENCH_RAM_QUEUE_SLAB_SIZE    256
+#define BENCH_RETRY_MS               60000
+
+// ========================================
+// Clock (real time + skew, so the failover run can jump ahead)
+// ========================================
+
+static unsigned long clockSkewMs = 0;
+
+static uint64_t nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static unsigned long benchMillis() { return (unsigned long)(nowNanos() / 1000000) + clockSkewMs; }
+static unsigned long benchMicros() { return (unsigned long)(nowNanos() / 1000); }
+
+// ========================================
+// Results
+// ========================================
+
+struct Latency {
+    double p50, p90, p99, max;     // microseconds
+};
+
+struct Result {
+    const char* backend;
+    const char* op;
+    uint32_t records;
+    double seconds;
+    uint64_t bytes;
+    Latency latency;
+};
+
+static std::vector<Result> results;
+
+static Latency percentiles(std::vector<uint64_t>& samples) {
+    Latency l = { 0, 0, 0, 0 };
+    if (samples.empty()) {
+        return l;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    l.p50 = samples[n * 50 / 100] / 1000.0;
+    l.p90 = samples[n * 90 / 100] / 1000.0;
+    l.p99 = samples[n * 99 / 100] / 1000.0;
+    l.max = samples[n - 1] / 1000.0;
+    return l;
+}
+
+// ========================================
+// Helpers
+// ========================================
+
+static void removeTree(const char* path) {
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", path);
+    if (system(cmd) != 0) {
+        fprintf(stderr, "cannot remove %s\n", path);
+    }
+}
+
+// Telemetry-like payload carrying its sequence number
+static size_t makePayload(uint8_t* buf, size_t size, uint32_t seq) {
+    int n = snprintf((char*)buf, size, "{\"seq\":%u,\"data\":\"", seq);
+    size_t len = (size_t)n;
+    while (len + 2 < size) {
+        buf[len] = 'a' + (seq + len) % 26;
+        len++;
+    }
+    buf[len++] = '"';
+    buf[len++] = '}';
+    return len;
+}
+
+static bool payloadSeq(const uint8_t* data, size_t len, uint32_t& seq) {
+    return len > 8 && sscanf((const char*)data, "{\"seq\":%u", &seq) == 1;
+}
+
+static FileQueueBackend::Config fileConfig(const char* name, const char* dir, uint16_t maxSegments) {
+    FileQueueBackend::Config config;
+    config.name = name;
+    config.dir = dir;
+    config.segmentSize = BENCH_QUEUE_SEGMENT_SIZE;
+    config.maxSegments = maxSegments;
+    config.blockSize = BENCH_WRITE_BLOCK_SIZE;
+    config.stagingSize = BENCH_STAGING_SIZE;
+    config.durabilityMs = BENCH_DURABILITY_MS;
+    config.millisFn = benchMillis;
+    config.microsFn = benchMicros;
+    return config;
+}
+
+// ========================================
+// Throughput / latency per backend
+// ========================================
+
+static bool benchBackend(QueueBackend& backend, uint32_t records, size_t payloadSize) {
+    if (!backend.mount()) {
+        fprintf(stderr, "%s: mount failed\n", backend.getName());
+        return false;
+    }
+    backend.clear();
+
+    std::vector<uint8_t> payload(payloadSize + 1);
+    std::vector<uint8_t> readBuf(payloadSize + 1);
+    std::vector<uint64_t> samples;
+    samples.reserve(records);
+
+    // Enqueue (flush at the end is part of the run: it is when bytes hit the disk)
+    uint64_t bytes = 0;
+    uint64_t start = nowNanos();
+    for (uint32_t i = 0; i < records; i++) {
+        size_t len = makePayload(payload.data(), payloadSize, i);
+        uint64_t t0 = nowNanos();
+        if (!backend.push(payload.data(), len)) {
+            fprintf(stderr, "%s: push %u failed\n", backend.getName(), i);
+            return false;
+        }
+        samples.push_back(nowNanos() - t0);
+        bytes += len;
+    }
+    backend.flush();
+    Result enq = { backend.getName(), "enqueue", records, (nowNanos() - start) / 1e9, bytes,
+                   percentiles(samples) };
+    results.push_back(enq);
+
+    // Dequeue, checking order
+    samples.clear();
+    bytes = 0;
+    uint32_t expected = 0;
+    uint32_t available = backend.count();
+    if (available != records) {
+        fprintf(stderr, "%s: %u of %u records kept (capacity)\n", backend.getName(), available, records);
+        expected = records - available;
+    }
+    start = nowNanos();
+    for (uint32_t i = 0; i < available; i++) {
+        size_t len;
+        uint32_t seq;
+        uint64_t t0 = nowNanos();
+        if (!backend.pop(readBuf.data(), readBuf.size(), len)) {
+            fprintf(stderr, "%s: pop %u failed\n", backend.getName(), i);
+            return false;
+        }
+        samples.push_back(nowNanos() - t0);
+        bytes += len;
+        if (!payloadSeq(readBuf.data(), len, seq) || seq != expected) {
+            fprintf(stderr, "%s: record %u out of order\n", backend.getName(), i);
+            return false;
+        }
+        expected++;
+    }
+    Result deq = { backend.getName(), "dequeue", available, (nowNanos() - start) / 1e9, bytes,
+                   percentiles(samples) };
+    results.push_back(deq);
+
+    backend.unmount(nullptr, nullptr);
+    return true;
+}
+
+// ========================================
+// Failover: SD pulled mid-stream, LittleFS takes over, SD comes back
+// ========================================
+
+struct FailoverReport {
+    uint32_t written;
+    uint32_t read;
+    uint32_t missing;
+    uint32_t duplicates;
+    uint32_t outOfOrder;
+    StorageEngine::Stats stats;
+    bool ok;
+};
+
+static bool runFailover(const char* root, uint32_t records, size_t payloadSize, FailoverReport& report) {
+    char sdDir[256], sdGone[256], lfsDir[256];
+    snprintf(sdDir, sizeof(sdDir), "%s/sd", root);
+    snprintf(sdGone, sizeof(sdGone), "%s/sd.pulled", root);
+    snprintf(lfsDir, sizeof(lfsDir), "%s/lfs", root);
+    removeTree(sdDir);
+    removeTree(sdGone);
+    removeTree(lfsDir);
+
+    FileQueueBackend sd(fileConfig("posix-sd", sdDir, BENCH_SD_QUEUE_MAX_SEGMENTS));
+    FileQueueBackend lfs(fileConfig("posix-lfs", lfsDir, BENCH_LFS_QUEUE_MAX_SEGMENTS));
+    RamQueueBackend ram(BENCH_RAM_QUEUE_BYTES, BENCH_RAM_QUEUE_BYTES, BENCH_RAM_QUEUE_SLAB_SIZE);
+
+    std::vector<uint8_t> scratch(payloadSize + 1);
+    StorageEngine engine;
+    engine.addBackend(&sd);
+    engine.addBackend(&lfs);
+    engine.addBackend(&ram);
+    if (!engine.begin(BENCH_RETRY_MS, benchMillis, scratch.data(), scratch.size())) {
+        fprintf(stderr, "failover: engine begin failed\n");
+        return false;
+    }
+
+    memset(&report, 0, sizeof(report));
+    std::vector<uint8_t> payload(payloadSize + 1);
+    uint32_t pullAt = records / 3;
+    uint32_t restoreAt = records * 2 / 3;
+
+    for (uint32_t i = 0; i < records; i++) {
+        if (i == pullAt && rename(sdDir, sdGone) != 0) {
+            fprintf(stderr, "failover: cannot pull %s\n", sdDir);
+            return false;
+        }
+        if (i == restoreAt) {
+            if (rename(sdGone, sdDir) != 0) {
+                fprintf(stderr, "failover: cannot restore %s\n", sdDir);
+                return false;
+            }
+            clockSkewMs += BENCH_RETRY_MS;   // Next poll() retries the mount
+        }
+
+        size_t len = makePayload(payload.data(), payloadSize, i);
+        if (engine.push(payload.data(), len)) {
+            report.written++;
+        }
+        engine.poll();
+    }
+
+    // Let migration finish, then drain everything
+    while (engine.isMigrating()) {
+        engine.poll();
+    }
+    engine.flush();
+
+    std::vector<uint8_t> seen(records, 0);
+    std::vector<uint8_t> readBuf(payloadSize + 1);
+    uint32_t last = 0;
+    size_t len;
+    while (engine.count() > 0 && engine.pop(readBuf.data(), readBuf.size(), len)) {
+        uint32_t seq;
+        if (!payloadSeq(readBuf.data(), len, seq) || seq >= records) {
+            continue;
+        }
+        if (seen[seq]++) {
+            report.duplicates++;
+        }
+        if (report.read > 0 && seq < last) {
+            report.outOfOrder++;
+        }
+        last = seq;
+        report.read++;
+    }
+
+    for (uint32_t i = 0; i < records; i++) {
+        if (!seen[i]) {
+            report.missing++;
+        }
+    }
+
+    report.stats = engine.getStats();
+    report.ok = report.written == records && report.missing == 0 && report.duplicates == 0 &&
+                engine.getActiveIndex() == 0;
+    return report.ok;
+}
+
+// ========================================
+// Output
+// ========================================
+
+static void printText(const FailoverReport& failover) {
+    printf("%-10s %-8s %8s %10s %9s %9s %9s %9s %9s\n",
+           "backend", "op", "records", "rec/s", "MB/s", "p50 us", "p90 us", "p99 us", "max us");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        printf("%-10s %-8s %8u %10.0f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+               r.backend, r.op, r.records, r.records / r.seconds, r.bytes / r.seconds / 1e6,
+               r.latency.p50, r.latency.p90, r.latency.p99, r.latency.max);
+    }
+
+    printf("\nfailover (sd pulled at 1/3, restored at 2/3): %s\n", failover.ok ? "PASS" : "FAIL");
+    printf("  written %u, read %u, missing %u, duplicates %u, out of order %u\n",
+           failover.written, failover.read, failover.missing, failover.duplicates, failover.outOfOrder);
+    printf("  failovers %u, recoveries %u, salvaged %u, migrated %u, lost %u\n",
+           failover.stats.failovers, failover.stats.recoveries, failover.stats.salvagedRecords,
+           failover.stats.migratedRecords, failover.stats.lostRecords);
+}
+
+static void printJson(const FailoverReport& failover) {
+    printf("{\"results\":[");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        printf("%s{\"backend\":\"%s\",\"op\":\"%s\",\"records\":%u,\"records_per_s\":%.0f,"
+               "\"mb_per_s\":%.3f,\"p50_us\":%.3f,\"p90_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}",
+               i ? "," : "", r.backend, r.op, r.records, r.records / r.seconds,
+               r.bytes / r.seconds / 1e6, r.latency.p50, r.latency.p90, r.latency.p99, r.latency.max);
+    }
+    printf("],\"failover\":{\"pass\":%s,\"written\":%u,\"read\":%u,\"missing\":%u,\"duplicates\":%u,"
+           "\"out_of_order\":%u,\"failovers\":%u,\"recoveries\":%u,\"salvaged\":%u,\"migrated\":%u,"
+           "\"lost\":%u}}\n",
+           failover.ok ? "true" : "false", failover.written, failover.read, failover.missing,
+           failover.duplicates, failover.outOfOrder, failover.stats.failovers, failover.stats.recoveries,
+           failover.stats.salvagedRecords, failover.stats.migratedRecords, failover.stats.lostRecords);
+}
+
+// ========================================
+// Main
+// ========================================
+
+int main(int argc, char** argv) {
+    uint32_t records = 2000;        // Fits the LittleFS and RAM limits at 200 B
+    size_t payloadSize = 200;
+    const char* root = "/tmp/storage_bench";
+    bool json = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--records") && i + 1 < argc) {
+            records = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--payload") && i + 1 < argc) {
+            payloadSize = (size_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--dir") && i + 1 < argc) {
+            root = argv[++i];
+        } else if (!strcmp(argv[i], "--json")) {
+            json = true;
+        } else {
+            fprintf(stderr, "usage: %s [--records N] [--payload BYTES] [--dir PATH] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (records == 0 || payloadSize < 32 || payloadSize > QUEUE_RECORD_MAX_PAYLOAD) {
+        fprintf(stderr, "records must be > 0, payload 32..%u bytes\n", QUEUE_RECORD_MAX_PAYLOAD);
+        return 2;
+    }
+
+    removeTree(root);
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "mkdir -p '%s'", root);
+    if (system(cmd) != 0) {
+        fprintf(stderr, "cannot create %s\n", root);
+        return 1;
+    }
+
+    char sdDir[256], lfsDir[256];
+    snprintf(sdDir, sizeof(sdDir), "%s/bench-sd", root);
+    snprintf(lfsDir, sizeof(lfsDir), "%s/bench-lfs", root);
+
+    bool ok = true;
+    {
+        FileQueueBackend sd(fileConfig("posix-sd", sdDir, BENCH_SD_QUEUE_MAX_SEGMENTS));
+        ok = benchBackend(sd, records, payloadSize) && ok;
+    }
+    {
+        FileQueueBackend lfs(fileConfig("posix-lfs", lfsDir, BENCH_LFS_QUEUE_MAX_SEGMENTS));
+        ok = benchBackend(lfs, records, payloadSize) && ok;
+    }
+    {
+        // Host has no PSRAM: give the internal arena the PSRAM size
+        RamQueueBackend ram(BENCH_RAM_QUEUE_BYTES, BENCH_RAM_QUEUE_BYTES, BENCH_RAM_QUEUE_SLAB_SIZE);
+        ok = benchBackend(ram, records, payloadSize) && ok;
+    }
+
+    FailoverReport failover;
+    ok = runFailover(root, records, payloadSize, failover) && ok;
+
+    if (json) {
+        printJson(failover);
+    } else {
+        printText(failover);
+    }
+
+    removeTree(root);
+    return ok ? 0 : 1;
+}
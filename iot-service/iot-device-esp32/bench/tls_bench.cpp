@@ -0,0 +1,488 @@
+// ============================================================================
+// TLS BENCH - Reconnect cost of MQTT over TLS, full vs resumed handshakes
+// ============================================================================
+// Runs MqttClient over TLS 1.2 against a local broker stand-in (OpenSSL on
+// both ends, memory BIOs, no sockets) and counts what one reconnect puts on
+// the LTE link: bytes each way, flights (one-way trips; a round trip is two)
+// and the time that takes at a given RTT and bandwidth.
+//
+// The broker presents a chain like a public CA issues it (EC P-256 leaf +
+// RSA-2048 intermediate, root known to the client). Scenarios:
+//   plain       TCP + MQTT CONNECT / CONNACK, no TLS (today)
+//   full        full handshake, no cached session
+//   session-id  resumed by session ID from the broker's cache
+//   ticket      resumed by session ticket (RFC 5077), broker keeps no state
+//   reboot      ticket session serialized and loaded back, as from flash
+//   rejected    stale session offered, broker falls back to a full handshake
+//
+// The device uses mbedTLS (TlsTransport), the bench OpenSSL: the protocol
+// bytes and round trips are the same, client CPU time is host time and only
+// a ratio between scenarios.
+//
+// Build + run:  make -C bench run-tls          (see bench/Makefile)
+// Options:      --rtt MS  --kbps KBIT  (defaults 300 ms, 1000 kbit/s)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+#include "mqtt_client.h"
+
+#define BENCH_SERVER_NAME   "broker.local"
+#define BENCH_CLIENT_ID     "DEMO1-A4CF12EF5D8C"
+#define BENCH_CIPHERS       "ECDHE-ECDSA-AES128-GCM-SHA256"
+#define BENCH_TCP_HEADER    40          // IPv4 + TCP per segment
+#define BENCH_MSS           1360
+#define BENCH_STEP_LIMIT    64
+
+static unsigned long benchNowMs = 0;
+static unsigned long benchMillis() { return benchNowMs; }
+
+static void fail(const char* what) {
+    fprintf(stderr, "tls_bench: %s\n", what);
+    ERR_print_errors_fp(stderr);
+    exit(1);
+}
+
+static double cpuUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// ========================================
+// Certificates
+// ========================================
+
+struct Chain {
+    EVP_PKEY* rootKey;
+    X509* root;
+    EVP_PKEY* interKey;
+    X509* inter;
+    EVP_PKEY* leafKey;
+    X509* leaf;
+};
+
+static void addExtension(X509* cert, X509* issuer, int nid, const char* value) {
+    X509V3_CTX ctx;
+    X509V3_set_ctx_nodb(&ctx);
+    X509V3_set_ctx(&ctx, issuer, cert, nullptr, nullptr, 0);
+    X509_EXTENSION* ext = X509V3_EXT_conf_nid(nullptr, &ctx, nid, value);
+    if (ext == nullptr || !X509_add_ext(cert, ext, -1)) {
+        fail("certificate extension");
+    }
+    X509_EXTENSION_free(ext);
+}
+
+static X509* makeCert(EVP_PKEY* key, const char* cn, X509* issuer, EVP_PKEY* issuerKey, bool ca) {
+    static long serial = 1;
+    X509* cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), serial++);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 90L * 86400);
+    X509_set_pubkey(cert, key);
+
+    X509_NAME* name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "O", MBSTRING_ASC, (const unsigned char*)"Bench CA Ltd", -1, -1, 0);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)cn, -1, -1, 0);
+    X509_set_issuer_name(cert, issuer ? X509_get_subject_name(issuer) : name);
+
+    X509* signer = issuer ? issuer : cert;
+    addExtension(cert, signer, NID_basic_constraints, ca ? "critical,CA:TRUE" : "critical,CA:FALSE");
+    addExtension(cert, signer, NID_key_usage, ca ? "critical,keyCertSign,cRLSign" : "critical,digitalSignature");
+    addExtension(cert, signer, NID_subject_key_identifier, "hash");
+    if (issuer != nullptr) {
+        addExtension(cert, signer, NID_authority_key_identifier, "keyid:always");
+    }
+    if (!ca) {
+        addExtension(cert, signer, NID_ext_key_usage, "serverAuth");
+        addExtension(cert, signer, NID_subject_alt_name, "DNS:" BENCH_SERVER_NAME);
+    }
+
+    if (!X509_sign(cert, issuerKey ? issuerKey : key, EVP_sha256())) {
+        fail("certificate signature");
+    }
+    return cert;
+}
+
+static Chain makeChain() {
+    Chain c;
+    c.rootKey = EVP_RSA_gen(2048);
+    c.root = makeCert(c.rootKey, "Bench Root", nullptr, nullptr, true);
+    c.interKey = EVP_RSA_gen(2048);
+    c.inter = makeCert(c.interKey, "Bench Issuing CA R1", c.root, c.rootKey, true);
+    c.leafKey = EVP_EC_gen("P-256");
+    c.leaf = makeCert(c.leafKey, BENCH_SERVER_NAME, c.inter, c.interKey, false);
+    return c;
+}
+
+// ========================================
+// Link: memory BIOs, bytes and flights
+// ========================================
+
+struct Link {
+    SSL* client;
+    SSL* server;
+    BIO* clientOut;         // Client writes here
+    BIO* serverOut;
+    uint32_t bytesUp;
+    uint32_t bytesDown;
+    uint32_t segmentsUp;
+    uint32_t segmentsDown;
+    uint32_t flights;
+    int lastDirection;      // 0 none, 1 up, 2 down
+};
+
+// Move whatever one side wrote to the other; a change of direction is a new flight
+static bool carry(Link& link, bool up) {
+    BIO* from = up ? link.clientOut : link.serverOut;
+    SSL* to = up ? link.server : link.client;
+
+    size_t pending = BIO_ctrl_pending(from);
+    if (pending == 0) {
+        return false;
+    }
+
+    std::vector<uint8_t> buf(pending);
+    BIO_read(from, buf.data(), (int)pending);
+    BIO_write(SSL_get_rbio(to), buf.data(), (int)pending);
+
+    uint32_t segments = (pending + BENCH_MSS - 1) / BENCH_MSS;
+    int direction = up ? 1 : 2;
+    if (direction != link.lastDirection) {
+        link.flights++;
+        link.lastDirection = direction;
+    }
+    if (up) {
+        link.bytesUp += pending;
+        link.segmentsUp += segments;
+    } else {
+        link.bytesDown += pending;
+        link.segmentsDown += segments;
+    }
+    return true;
+}
+
+static SSL* makeSsl(SSL_CTX* ctx, BIO** out) {
+    SSL* ssl = SSL_new(ctx);
+    BIO* in = BIO_new(BIO_s_mem());
+    *out = BIO_new(BIO_s_mem());
+    BIO_set_mem_eof_return(in, -1);
+    SSL_set_bio(ssl, in, *out);
+    return ssl;
+}
+
+// ========================================
+// MqttClient over the client SSL
+// ========================================
+
+class BenchTlsTransport : public MqttTransport {
+public:
+    explicit BenchTlsTransport(SSL* ssl) : ssl(ssl) {}
+
+    bool connected() override { return true; }
+
+    int available() override {
+        uint8_t c;
+        SSL_peek(ssl, &c, 1);
+        return SSL_pending(ssl);
+    }
+
+    int read(uint8_t* buf, size_t len) override {
+        int n = SSL_read(ssl, buf, (int)len);
+        return n > 0 ? n : 0;
+    }
+
+    size_t write(const uint8_t* buf, size_t len) override {
+        int n = SSL_write(ssl, buf, (int)len);
+        return n > 0 ? (size_t)n : 0;
+    }
+
+private:
+    SSL* ssl;
+};
+
+class PlainTransport : public MqttTransport {
+public:
+    std::vector<uint8_t> toBroker;
+    std::vector<uint8_t> toClient;
+
+    bool connected() override { return true; }
+    int available() override { return (int)toClient.size(); }
+
+    int read(uint8_t* buf, size_t len) override {
+        size_t n = len < toClient.size() ? len : toClient.size();
+        memcpy(buf, toClient.data(), n);
+        toClient.erase(toClient.begin(), toClient.begin() + n);
+        return (int)n;
+    }
+
+    size_t write(const uint8_t* buf, size_t len) override {
+        toBroker.insert(toBroker.end(), buf, buf + len);
+        return len;
+    }
+};
+
+static const uint8_t CONNACK_V5[] = { 0x20, 0x03, 0x00, 0x00, 0x00 };
+
+static void beginClient(MqttClient& mqtt, MqttTransport* transport, std::vector<uint8_t>& rx,
+                        std::vector<uint8_t>& arena) {
+    mqtt.begin(transport, benchMillis, rx.data(), rx.size(), arena.data(), arena.size(), 8);
+    mqtt.setProtocol(5);
+    mqtt.setSessionExpiry(604800);
+}
+
+// ========================================
+// Scenarios
+// ========================================
+
+struct Result {
+    const char* name;
+    bool tls;
+    bool resumed;
+    bool connected;
+    uint32_t flights;           // Including the TCP handshake (SYN / SYN-ACK)
+    uint32_t bytesUp;
+    uint32_t bytesDown;
+    uint32_t wireBytes;         // Plus IP / TCP headers, handshake and ACK segments
+    double clientCpuUs;
+    size_t sessionBytes;
+};
+
+static void addTcp(Result& r, uint32_t segmentsUp, uint32_t segmentsDown) {
+    // SYN, SYN-ACK, ACK; every data segment acknowledged
+    r.flights += 2;
+    r.wireBytes = r.bytesUp + r.bytesDown + 3 * BENCH_TCP_HEADER +
+                  2 * (segmentsUp + segmentsDown) * BENCH_TCP_HEADER;
+}
+
+static Result runPlain() {
+    Result r = {};
+    r.name = "plain";
+
+    PlainTransport transport;
+    std::vector<uint8_t> rx(2048), arena(4096);
+    MqttClient mqtt;
+    beginClient(mqtt, &transport, rx, arena);
+
+    double cpu = cpuUs();
+    mqtt.connect(BENCH_CLIENT_ID, 60, false, 10000);
+    r.clientCpuUs = cpuUs() - cpu;
+    r.bytesUp = transport.toBroker.size();
+    transport.toClient.assign(CONNACK_V5, CONNACK_V5 + sizeof(CONNACK_V5));
+    r.bytesDown = sizeof(CONNACK_V5);
+    mqtt.poll();
+
+    r.connected = mqtt.isConnected();
+    r.flights = 2;
+    addTcp(r, 1, 1);
+    return r;
+}
+
+// One connection: handshake, CONNECT, CONNACK. `offer` is the session to
+// resume (nullptr = none); the new session is returned in `*session`.
+static Result runTls(const char* name, SSL_CTX* clientCtx, SSL_CTX* serverCtx,
+                     SSL_SESSION* offer, SSL_SESSION** session) {
+    Result r = {};
+    r.name = name;
+    r.tls = true;
+
+    Link link = {};
+    link.client = makeSsl(clientCtx, &link.clientOut);
+    link.server = makeSsl(serverCtx, &link.serverOut);
+    SSL_set_connect_state(link.client);
+    SSL_set_accept_state(link.server);
+    SSL_set_tlsext_host_name(link.client, BENCH_SERVER_NAME);
+    SSL_set1_host(link.client, BENCH_SERVER_NAME);
+    if (offer != nullptr) {
+        SSL_set_session(link.client, offer);
+    }
+
+    BenchTlsTransport transport(link.client);
+    std::vector<uint8_t> rx(2048), arena(4096);
+    MqttClient mqtt;
+    beginClient(mqtt, &transport, rx, arena);
+
+    bool connectSent = false, connackSent = false;
+    double cpu = 0;
+
+    for (int step = 0; step < BENCH_STEP_LIMIT && !mqtt.isConnected(); step++) {
+        // Client side: handshake, then CONNECT right behind its Finished
+        double t = cpuUs();
+        if (!SSL_is_init_finished(link.client)) {
+            SSL_do_handshake(link.client);
+        }
+        if (SSL_is_init_finished(link.client)) {
+            if (!connectSent) {
+                connectSent = mqtt.connect(BENCH_CLIENT_ID, 60, false, 10000);
+            } else {
+                mqtt.poll();
+            }
+        }
+        cpu += cpuUs() - t;
+        carry(link, true);
+
+        // Broker side: handshake, then CONNACK for the CONNECT
+        if (!SSL_is_init_finished(link.server)) {
+            SSL_do_handshake(link.server);
+        }
+        if (SSL_is_init_finished(link.server) && !connackSent) {
+            uint8_t buf[512];
+            if (SSL_read(link.server, buf, sizeof(buf)) > 0 && buf[0] == 0x10) {
+                SSL_write(link.server, CONNACK_V5, sizeof(CONNACK_V5));
+                connackSent = true;
+            }
+        }
+        carry(link, false);
+        benchNowMs += 1;
+    }
+
+    r.connected = mqtt.isConnected();
+    r.resumed = SSL_session_reused(link.client);
+    r.flights = link.flights;
+    r.bytesUp = link.bytesUp;
+    r.bytesDown = link.bytesDown;
+    r.clientCpuUs = cpu;
+    addTcp(r, link.segmentsUp, link.segmentsDown);
+
+    if (session != nullptr) {
+        *session = SSL_get1_session(link.client);
+    }
+    // Dropped like the device drops a link (no close_notify); without this
+    // OpenSSL marks the session not resumable
+    SSL_set_quiet_shutdown(link.client, 1);
+    SSL_set_quiet_shutdown(link.server, 1);
+    SSL_shutdown(link.client);
+    SSL_shutdown(link.server);
+    SSL_free(link.client);
+    SSL_free(link.server);
+    return r;
+}
+
+static SSL_CTX* serverContext(const Chain& chain, bool tickets, bool cache) {
+    SSL_CTX* ctx = SSL_CTX_new(TLS_server_method());
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_cipher_list(ctx, BENCH_CIPHERS);
+    if (!SSL_CTX_use_certificate(ctx, chain.leaf) || !SSL_CTX_use_PrivateKey(ctx, chain.leafKey) ||
+        !SSL_CTX_add1_chain_cert(ctx, chain.inter)) {
+        fail("server certificate");
+    }
+    SSL_CTX_set_session_id_context(ctx, (const unsigned char*)"mqtt", 4);
+    SSL_CTX_set_session_cache_mode(ctx, cache ? SSL_SESS_CACHE_SERVER : SSL_SESS_CACHE_OFF);
+    if (!tickets) {
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    }
+    return ctx;
+}
+
+static SSL_CTX* clientContext(const Chain& chain) {
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_cipher_list(ctx, BENCH_CIPHERS);
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+    X509_STORE_add_cert(SSL_CTX_get_cert_store(ctx), chain.root);
+    return ctx;
+}
+
+// ========================================
+// Main
+// ========================================
+
+int main(int argc, char** argv) {
+    uint32_t rttMs = 300;
+    uint32_t kbps = 1000;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rtt") && i + 1 < argc) {
+            rttMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--kbps") && i + 1 < argc) {
+            kbps = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--rtt MS] [--kbps KBIT]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (kbps == 0) {
+        fprintf(stderr, "kbps must be > 0\n");
+        return 2;
+    }
+
+    Chain chain = makeChain();
+    SSL_CTX* client = clientContext(chain);
+    SSL_CTX* idServer = serverContext(chain, false, true);
+    SSL_CTX* ticketServer = serverContext(chain, true, false);
+
+    std::vector<Result> results;
+    results.push_back(runPlain());
+
+    SSL_SESSION* session = nullptr;
+    results.push_back(runTls("full", client, ticketServer, nullptr, &session));
+    SSL_SESSION_free(session);
+
+    // Session ID: the broker keeps the session in its cache
+    runTls("", client, idServer, nullptr, &session);
+    results.push_back(runTls("session-id", client, idServer, session, nullptr));
+    SSL_SESSION_free(session);
+
+    // Ticket: the broker keeps nothing, the ticket carries the state
+    SSL_SESSION* ticket = nullptr;
+    runTls("", client, ticketServer, nullptr, &ticket);
+    results.push_back(runTls("ticket", client, ticketServer, ticket, nullptr));
+
+    // Reboot: the ticket session goes through its serialized form
+    int blobLen = i2d_SSL_SESSION(ticket, nullptr);
+    std::vector<unsigned char> blob(blobLen);
+    unsigned char* p = blob.data();
+    i2d_SSL_SESSION(ticket, &p);
+    const unsigned char* q = blob.data();
+    SSL_SESSION* restored = d2i_SSL_SESSION(nullptr, &q, blobLen);
+    if (restored == nullptr) {
+        fail("session reload");
+    }
+    results.push_back(runTls("reboot", client, ticketServer, restored, nullptr));
+    results.back().sessionBytes = blobLen;
+    SSL_SESSION_free(restored);
+
+    // Rejected: broker restarted with new ticket keys and an empty cache
+    SSL_CTX* restartedServer = serverContext(chain, true, false);
+    results.push_back(runTls("rejected", client, restartedServer, ticket, nullptr));
+    SSL_SESSION_free(ticket);
+
+    // Expected outcome per scenario
+    const bool expectResumed[] = { false, false, true, true, true, false };
+
+    double bytesPerMs = kbps / 8.0;
+    printf("MQTT reconnect cost, TLS 1.2 %s, RTT %u ms, %u kbit/s\n", BENCH_CIPHERS, rttMs, kbps);
+    printf("%-11s %-9s %8s %8s %8s %8s %9s %10s\n",
+           "scenario", "handshake", "flights", "up B", "down B", "wire B", "time ms", "client CPU");
+
+    bool ok = true;
+    const Result& full = results[1];
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        double timeMs = r.flights * rttMs / 2.0 + (r.bytesUp + r.bytesDown) / bytesPerMs;
+        printf("%-11s %-9s %8u %8u %8u %8u %9.0f %8.2fx\n", r.name,
+               !r.tls ? "-" : (r.resumed ? "resumed" : "full"), r.flights, r.bytesUp, r.bytesDown,
+               r.wireBytes, timeMs, r.clientCpuUs / full.clientCpuUs);
+        ok = ok && r.connected && r.resumed == expectResumed[i];
+    }
+
+    const Result& ticketRun = results[3];
+    printf("ticket vs full: %.0f%% of the bytes, %u fewer flights; serialized session %zu B\n",
+           100.0 * ticketRun.wireBytes / full.wireBytes, full.flights - ticketRun.flights,
+           results[4].sessionBytes);
+    printf("result: %s\n", ok ? "ok" : "FAILED");
+
+    SSL_CTX_free(client);
+    SSL_CTX_free(idServer);
+    SSL_CTX_free(ticketServer);
+    SSL_CTX_free(restartedServer);
+    return ok ? 0 : 1;
+}
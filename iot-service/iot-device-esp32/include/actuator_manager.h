@@ -0,0 +1,132 @@
+#ifndef ACTUATOR_MANAGER_H
+#define ACTUATOR_MANAGER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// ACTUATOR MANAGER - Timed relay sequences without blocking the loop
+// ============================================================================
+// A command ("on", "off", "restart") becomes a short list of steps (set the
+// output, wait N ms). loop() advances every output's current step from
+// millis(), so a 5 s restart no longer stalls MQTT, sampling and telemetry,
+// and several outputs can run their sequences at the same time.
+//
+// Each output has a small FIFO: a command for a busy output waits until the
+// running sequence is done. Commands may carry an id; an id seen recently
+// (queued, running or finished) is not executed again, so a QoS 1 redelivery
+// does not restart a pump twice.
+//
+// The completion handler runs from loop() when a sequence has actually
+// finished, and from submit() when a command is rejected - for the
+// relay_status reply.
+
+#define ACTUATOR_MAX_OUTPUTS    4
+#define ACTUATOR_QUEUE_LEN      4       // Commands per output incl. the running one
+#define ACTUATOR_MAX_STEPS      4
+#define ACTUATOR_NAME_LEN       8       // Output name incl. terminator ("out1")
+#define ACTUATOR_ID_LEN         24      // Command id incl. terminator (longer ids are cut)
+#define ACTUATOR_RECENT_IDS     16      // Ids remembered for duplicate detection
+#define ACTUATOR_RESTART_OFF_MS 5000    // "restart" off time when the command gives none
+#define ACTUATOR_MAX_WAIT_MS    600000  // Longest off time a command may ask for
+#define ACTUATOR_IDLE           0xFFFFFFFFUL // msUntilNext(): nothing queued
+
+enum ActuatorResult {
+    ACTUATOR_QUEUED,
+    ACTUATOR_DONE,                  // Sequence ran to the end
+    ACTUATOR_DUPLICATE,
+    ACTUATOR_UNKNOWN_TARGET,
+    ACTUATOR_UNKNOWN_STATE,
+    ACTUATOR_BAD_DURATION,
+    ACTUATOR_QUEUE_FULL
+};
+
+class ActuatorManager {
+public:
+    struct Completion {
+        const char* id;             // "" when the command had none
+        const char* target;
+        const char* state;
+        ActuatorResult result;
+        uint32_t queuedMs;          // Waiting behind earlier commands
+        uint32_t runMs;             // First step to last
+    };
+
+    typedef void (*CompletionFn)(const Completion& done);
+
+    ActuatorManager();
+
+    // `activeLow`: the output is "on" at GPIO LOW. The pin starts in `initialOn`.
+    bool addOutput(const char* name, int8_t pin, bool activeLow, bool initialOn);
+    void setCompletionHandler(CompletionFn handler) { completionHandler = handler; }
+
+    // `durationMs` is the off time of "restart" (0 = default). Rejections
+    // are also reported through the completion handler.
+    ActuatorResult submit(const char* id, const char* target, const char* state,
+                          uint32_t durationMs, unsigned long nowMs);
+
+    // Advance running sequences
+    void loop(unsigned long nowMs);
+    // When loop() has work again: 0 = now, ACTUATOR_IDLE = never
+    unsigned long msUntilNext(unsigned long nowMs) const;
+
+    bool isBusy() const;
+    uint8_t getOutputCount() const { return outputCount; }
+    static const char* resultName(ActuatorResult result);
+
+private:
+    enum StepType {
+        STEP_ON,
+        STEP_OFF,
+        STEP_WAIT
+    };
+
+    struct Step {
+        uint8_t type;
+        uint32_t durationMs;
+    };
+
+    struct Command {
+        char id[ACTUATOR_ID_LEN];
+        char state[ACTUATOR_NAME_LEN];
+        Step steps[ACTUATOR_MAX_STEPS];
+        uint8_t stepCount;
+        unsigned long queuedAt;
+    };
+
+    struct Output {
+        char name[ACTUATOR_NAME_LEN];
+        int8_t pin;
+        bool activeLow;
+        bool on;
+
+        Command queue[ACTUATOR_QUEUE_LEN];
+        uint8_t head;
+        uint8_t count;
+
+        bool running;
+        uint8_t step;
+        unsigned long startedAt;    // Sequence
+        unsigned long stepAt;       // Current step
+    };
+
+    Output outputs[ACTUATOR_MAX_OUTPUTS];
+    uint8_t outputCount;
+
+    char recentIds[ACTUATOR_RECENT_IDS][ACTUATOR_ID_LEN];
+    uint8_t recentNext;
+
+    CompletionFn completionHandler;
+
+    Output* findOutput(const char* name);
+    bool buildSequence(Command& cmd, const char* state, uint32_t durationMs) const;
+    bool isKnownId(const char* id) const;
+    void rememberId(const char* id);
+    void setOutput(Output& out, bool on);
+    void startNext(Output& out, unsigned long nowMs);
+    void finish(Output& out, unsigned long nowMs);
+    void report(const char* id, const char* target, const char* state, ActuatorResult result,
+                uint32_t queuedMs, uint32_t runMs);
+};
+
+#endif // ACTUATOR_MANAGER_H
@@ -0,0 +1,67 @@
+#ifndef ASYNC_GSM_CLIENT_H
+#define ASYNC_GSM_CLIENT_H
+
+#ifndef TINY_GSM_MODEM_SIM7600
+#define TINY_GSM_MODEM_SIM7600
+#endif
+
+#include <Arduino.h>
+#include <TinyGsmClient.h>
+#include "modem_at.h"
+
+// ============================================================================
+// ASYNC GSM CLIENT - TinyGsmClient with a non-blocking open / close
+// ============================================================================
+// TinyGsmClient::connect() waits up to 75 s for "+CIPOPEN". This opens the
+// socket through ModemAt one step per poll instead, then marks the TinyGSM
+// client connected so reads / writes go through TinyGSM as before.
+
+class AsyncGsmClient : public TinyGsmClient {
+public:
+    enum OpResult {
+        OP_IDLE,
+        OP_PENDING,
+        OP_DONE,
+        OP_FAILED
+    };
+
+    AsyncGsmClient(TinyGsm& modem, uint8_t mux, ModemAt& at);
+
+    // Open a TCP socket to host:port (closes a stale one on this mux first)
+    bool startOpen(const char* host, uint16_t port, uint32_t timeoutMs);
+
+    // Close the socket ("+CIPCLOSE"); already closed counts as done
+    bool startClose();
+
+    // Advance the running open / close; returns the outcome once
+    OpResult pollOp();
+
+    bool isOpBusy() const { return op != OP_NONE; }
+
+    // Forget the socket locally without any AT traffic (link presumed gone)
+    void abandon();
+
+    uint8_t getMux() const { return muxId; }
+
+private:
+    enum Op {
+        OP_NONE,
+        OP_OPEN_CLOSE_STALE,
+        OP_OPEN_RX_MODE,
+        OP_OPEN_CONNECT,
+        OP_CLOSE
+    };
+
+    ModemAt& at;
+    uint8_t muxId;
+
+    Op op;
+    char host[64];
+    uint16_t port;
+    uint32_t timeoutMs;
+    char command[96];
+
+    OpResult finish(bool ok);
+};
+
+#endif // ASYNC_GSM_CLIENT_H
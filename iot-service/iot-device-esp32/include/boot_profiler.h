@@ -0,0 +1,81 @@
+#ifndef BOOT_PROFILER_H
+#define BOOT_PROFILER_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// BOOT PROFILER - Boot phase timeline, reset reason, previous boot summary
+// ============================================================================
+// Every phase from reset to the first telemetry publish is kept as
+// [start, end] in ms since reset. setup() brackets its own phases with
+// start() / end(); the phases that finish later in the tasks (modem,
+// network, MQTT, first config, first telemetry) are closed from there.
+// Only the first occurrence counts: a later reconnect is recovery, not boot.
+//
+// The timeline, the reset reason and the uptime (refreshed by noteAlive())
+// are mirrored into RTC memory that survives software, panic and watchdog
+// resets. After such a reset getPrevious() holds the previous boot - how
+// far it got and how long it ran. A power-on reset clears it.
+
+enum BootPhase : uint8_t {
+    BOOT_TIME,              // Time manager / RTC
+    BOOT_RS485,             // Modbus UART
+    BOOT_IO,                // Sensors, relays
+    BOOT_STORAGE,           // SD / LittleFS, data budget, config cache, archive
+    BOOT_POST_INIT,         // I2C scan, RS485 ping
+    BOOT_MODEM,             // Power-on to modem ready
+    BOOT_NETWORK,           // Modem ready to data session up
+    BOOT_MQTT,              // Data session to MQTT connected
+    BOOT_CONFIG,            // Config request to config applied / confirmed
+    BOOT_TELEMETRY,         // Tasks started to first telemetry published
+    BOOT_PHASE_COUNT
+};
+
+class BootProfiler {
+public:
+    struct Phase {
+        uint32_t startMs;
+        uint32_t endMs;         // 0 = not reached
+    };
+
+    struct Summary {
+        bool valid;             // false after power-on or with a bad record
+        uint8_t resetReason;    // What started that boot (esp_reset_reason_t)
+        uint32_t uptimeS;       // Last noteAlive()
+        Phase phases[BOOT_PHASE_COUNT];
+    };
+
+    BootProfiler();
+
+    // First thing in setup(): reset reason, previous boot from RTC memory
+    void begin();
+
+    // First occurrence only
+    void start(BootPhase phase);
+    void end(BootPhase phase);
+    void span(BootPhase phase, unsigned long startMs, unsigned long endMs);
+    bool isDone(BootPhase phase) const { return current.phases[phase].endMs != 0; }
+
+    // Keep the uptime in RTC memory current for the next boot's summary
+    void noteAlive(unsigned long nowMs);
+
+    const Phase& getPhase(BootPhase phase) const { return current.phases[phase]; }
+    uint8_t getResetReason() const { return current.resetReason; }
+    uint32_t getBootCount() const { return bootCount; }
+    const Summary& getPrevious() const { return previous; }
+
+    void printTimeline() const;
+
+    static const char* phaseName(uint8_t phase);
+    static const char* resetReasonName(uint8_t reason);
+
+private:
+    Summary current;
+    Summary previous;
+    uint32_t bootCount;         // Boots since the last power-on
+    portMUX_TYPE lock;
+
+    void save();
+};
+
+#endif // BOOT_PROFILER_H
@@ -0,0 +1,201 @@
+#ifndef CMQTT_CLIENT_H
+#define CMQTT_CLIENT_H
+
+#include <Arduino.h>
+#include "modem_at.h"
+#include "mqtt_client.h"
+
+// ============================================================================
+// CMQTT CLIENT - MQTT through the SIM7600's own AT+CMQTT stack
+// ============================================================================
+// Same interface as MqttClient, but the modem does the MQTT framing, the TCP
+// socket, keepalive and PUBACK handling. The ESP32 only sends topic and
+// payload (AT+CMQTTTOPIC / AT+CMQTTPAYLOAD / AT+CMQTTPUB) and reads result
+// and inbound-message URCs, all through the non-blocking ModemAt runner.
+//
+// The modem has one topic / payload buffer per client, so messages go out
+// one at a time: each waits in the arena until its "+CMQTTPUB: 0,0" (sent
+// after the broker's PUBACK for QoS 1). Up to `window` messages can be queued.
+//
+// With setTls() the modem's SSL engine runs TLS under the session (SSL
+// context configured with AT+CSSLCFG before every connect). The handshake
+// and its session state stay in the modem; AT+CSSLCFG has no setting for
+// session resumption.
+//
+// URCs that arrive while TinyGSM runs a blocking command are lost to us.
+// A publish result that never comes is treated as unconfirmed and the
+// message is sent again; a lost "+CMQTTCONNLOST" is caught by the periodic
+// AT+CMQTTDISC? state check.
+
+#define CMQTT_CLIENT_INDEX      0
+#define CMQTT_SUB_QUEUE         4       // Subscriptions waiting for the AT runner
+#define CMQTT_TOPIC_MAX         64
+#define CMQTT_PUB_TIMEOUT_S     60      // Modem-side PUBACK wait (60..180 s)
+#define CMQTT_PUB_RETRIES       3       // Failed publishes in a row before the session is dropped
+#define CMQTT_SSL_CONTEXT       0       // AT+CSSLCFG context used for the broker
+#define CMQTT_CA_FILE_MAX       32
+
+class CmqttClient {
+public:
+    typedef MqttClient::State State;
+    typedef MqttClient::Stats Stats;
+    typedef MqttClient::ClockFn ClockFn;
+    typedef MqttClient::MessageFn MessageFn;
+
+    explicit CmqttClient(ModemAt& at);
+
+    void setServer(const char* host, uint16_t port);
+
+    // TLS in the modem from the next connect(). `caFile` is a name in the
+    // modem's certificate store ("" = broker certificate not verified).
+    void setTls(bool enabled, const char* caFile);
+
+    // Buffers stay owned by the caller. `window` is capped at MQTT_INFLIGHT_MAX.
+    void begin(ClockFn clock, uint8_t* rxBuffer, size_t rxSize,
+               uint8_t* arena, size_t arenaSize, uint8_t window);
+
+    void setMessageHandler(MessageFn handler, void* context);
+
+    // Start / acquire / connect in the modem; poll() advances the steps
+    bool connect(const char* clientId, uint16_t keepAliveS, bool cleanSession, uint32_t timeoutMs);
+
+    // AT results, queued publishes / subscriptions, state check
+    void poll();
+
+    // Clean DISCONNECT in the modem; queued messages stay for the next session
+    void disconnect();
+
+    // Forget the connection locally; the next connect() resets the modem client
+    void drop();
+
+    // Discard queued messages
+    void clearInflight();
+
+    // Run the session state check now. The modem answers it, not the
+    // broker, so an echo message is the stronger liveness proof here.
+    bool ping();
+
+    State getState() const { return state; }
+    bool isConnected() const { return state == MqttClient::MQTT_CONNECTED; }
+    bool isSessionPresent() const { return false; }     // Not reported by the modem
+    uint8_t getReturnCode() const { return returnCode; }
+
+    bool canPublish(size_t topicLen, size_t payloadLen) const;
+    bool publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos, bool retained);
+    bool subscribe(const char* topic, uint8_t qos);
+
+    // millis() of the last URC carrying a broker answer (CONNACK, PUB
+    // result, inbound message)
+    unsigned long getLastInboundAt() const { return lastInAt; }
+
+    // How long the message on the air has waited for its result (0 = none)
+    uint32_t getAckWaitMs() const;
+
+    uint8_t getInflightCount() const { return inflightCount; }
+    size_t getInflightBytes() const { return arenaUsed; }
+    uint8_t getWindow() const { return window; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    enum Op {
+        OP_NONE,
+        OP_DISC,            // Connect: drop whatever the modem still holds
+        OP_RELEASE,
+        OP_START,
+        OP_SSL_CONFIG,      // AT+CSSLCFG, one per sslStep
+        OP_ACQUIRE,
+        OP_SSL_BIND,        // AT+CMQTTSSLCFG
+        OP_CONNECT,
+        OP_SUBSCRIBE,
+        OP_TOPIC,
+        OP_PAYLOAD,
+        OP_PUBLISH,
+        OP_CHECK,           // AT+CMQTTDISC? liveness check
+        OP_CLOSE            // disconnect()
+    };
+
+    struct Entry {
+        uint32_t offset;        // Topic, then payload, in the arena
+        uint16_t topicLen;
+        uint32_t payloadLen;
+        uint8_t qos;
+        bool retained;
+        bool dup;
+    };
+
+    struct Subscription {
+        char topic[CMQTT_TOPIC_MAX];
+        uint8_t qos;
+    };
+
+    ModemAt& at;
+    ClockFn clock;
+
+    char host[64];
+    uint16_t port;
+    bool tls;
+    char caFile[CMQTT_CA_FILE_MAX];
+    uint8_t sslStep;
+    char clientId[MQTT_CLIENT_ID_MAX + 1];
+    uint16_t keepAliveS;
+    bool cleanSession;
+    uint32_t connectTimeoutMs;
+    unsigned long connectStartedAt;
+
+    uint8_t* rxBuffer;
+    size_t rxSize;
+    uint8_t* arena;
+    size_t arenaSize;
+    size_t arenaUsed;
+    uint8_t window;
+
+    Entry entries[MQTT_INFLIGHT_MAX];
+    uint8_t inflightHead;
+    uint8_t inflightCount;
+    bool pubOutstanding;        // Head sent, waiting for "+CMQTTPUB:"
+    unsigned long pubSentAt;
+    uint8_t pubFailures;
+
+    Subscription subscriptions[CMQTT_SUB_QUEUE];
+    uint8_t subscriptionCount;
+
+    State state;
+    uint8_t returnCode;
+    Op op;
+    unsigned long opStartedAt;
+    unsigned long lastCheckAt;
+    bool checkRequested;
+    unsigned long lastInAt;
+    char command[160];
+
+    // Inbound message, assembled from RXSTART / RXTOPIC / RXPAYLOAD / RXEND
+    size_t rxTopicLen;
+    size_t rxPayloadLen;
+    size_t rxTopicGot;
+    size_t rxPayloadGot;
+    bool rxSkip;
+
+    MessageFn messageHandler;
+    void* messageContext;
+
+    Stats stats;
+
+    unsigned long now() const { return clock ? clock() : 0; }
+    Entry& slot(uint8_t index) { return entries[(inflightHead + index) % MQTT_INFLIGHT_MAX]; }
+    void startOp(Op next, uint32_t timeoutMs, const char* capturePrefix = nullptr, bool untilCapture = false);
+    void startDataOp(Op next, const uint8_t* data, size_t length, uint32_t timeoutMs,
+                     const char* capturePrefix = nullptr, bool untilCapture = false);
+    void finishOp(ModemAt::Result result);
+    bool nextSslConfig();
+    void startAcquire();
+    void startConnect();
+    void startNext();
+    void publishFailed();
+    void releaseHead();
+    void lose(State reason);
+
+    static void onUrc(void* context, const char* line);
+    void handleUrc(const char* line);
+};
+
+#endif // CMQTT_CLIENT_H
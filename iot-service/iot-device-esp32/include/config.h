@@ -46,6 +46,12 @@
 // NE555 Relay Module (GPIO14) - Controlled via MQTT
 #define RELAY_NE555_PIN         14      // GPIO14 - NE555 Relay Module (active LOW)
 
+// Relay outputs for MQTT "relay" commands (target "out1" / "out2")
+#define ACTUATOR_OUT1_PIN       RELAY_NE555_PIN
+#ifndef ACTUATOR_OUT2_PIN
+#define ACTUATOR_OUT2_PIN       -1      // RELAY_PIN where GPIO15 is not RS485 TX (-1 = no out2)
+#endif
+
 // Digital Input 1: Pump Status Monitor (Changed to GPIO38)
 #define IO_DIGITAL_IN_1_PIN     38      // GPIO38 - Digital Input for pump status (HIGH=ON, LOW=OFF)
 
@@ -63,6 +69,16 @@
 #define SD_SCK_PIN              12      // SCK (Serial Clock)
 #define SD_MISO_PIN             13      // MISO (Master In Slave Out)
 
+// --- Filesystem mount points (VFS) ---
+// Every file path below starts with one of these. The native simulation
+// build sets them to directories under its working directory.
+#ifndef SD_MOUNT_POINT
+#define SD_MOUNT_POINT          "/sd"           // SD.begin() default mountpoint
+#endif
+#ifndef LITTLEFS_MOUNT_POINT
+#define LITTLEFS_MOUNT_POINT    "/littlefs"     // LittleFS.begin() default basePath
+#endif
+
 // --- Built-in Components ---
 // LED_BUILTIN already defined by board variant, don't redefine
 // #define LED_BUILTIN             48      // Built-in LED (if available)
@@ -106,6 +122,43 @@
 #define MQTT_QOS                1       // QoS level 1 (at least once)
 #define MQTT_KEEP_ALIVE         60      // Keep alive interval (seconds)
 #define MQTT_RECONNECT_DELAY    5000    // Reconnect delay (ms)
+#define MQTT_CONNACK_TIMEOUT_S  5       // Max wait for CONNACK once the socket is open (s)
+#ifndef MQTT_USE_MODEM_STACK
+#define MQTT_USE_MODEM_STACK    0       // 1: SIM7600 AT+CMQTT (keepalive / PUBACK in the modem), 0: MqttClient over a TCP socket
+#endif
+#define MQTT_CLEAN_SESSION      false   // false: broker keeps subscriptions + QoS 1 state across reconnects
+#define MQTT_INFLIGHT_WINDOW    8       // Unacknowledged QoS 1 publishes at once
+#define MQTT_INFLIGHT_BYTES     16384   // Arena holding them until PUBACK (>= one max packet)
+#define MQTT_OUTBOX_BATCH       4       // Outbox records moved into the window per loop()
+
+// --- MQTT 5 (socket backend only; the modem's CMQTT stack speaks 3.1.1) ---
+#define MQTT_PROTOCOL_VERSION   5       // 5: topic aliases, message expiry, user properties; 4: 3.1.1
+#define MQTT_PROTOCOL_FALLBACK  true    // Broker refuses MQTT 5 -> reconnect with 3.1.1
+#define MQTT_SESSION_EXPIRY_S   604800  // v5: broker keeps the non-clean session 7 days offline
+#define MQTT_MESSAGE_EXPIRY_S   3600    // v5: broker drops undelivered messages after 1 h (0 = never)
+#define MQTT_SCHEMA_VERSION     "2.1"   // v5: user property "v" on every publish ("" = none)
+
+// --- Broker liveness (replaces the periodic TCP probe while MQTT is up) ---
+#define MQTT_LIVENESS_IDLE_MS   90000   // Nothing heard from the broker this long -> PINGREQ + echo
+#define MQTT_LIVENESS_TIMEOUT_MS 15000  // No answer to that in time -> reconnect MQTT
+#define MQTT_ACK_STALL_MS       20000   // Oldest QoS 1 message unacked this long -> check at once
+#define MQTT_ECHO_ENABLED       true    // QoS 0 round trip through sensor/<id>/echo
+
+// --- MQTT over TLS ---
+// Socket backend: mbedTLS on the ESP32, the TLS session cached in RAM and
+// LittleFS so reconnects and reboots resume it (1 round trip, no
+// certificate) instead of a full handshake. Modem backend: the SIM7600's
+// SSL engine, CA file in the modem's certificate store (AT+CCERTDOWN).
+#ifndef MQTT_TLS_ENABLED
+#define MQTT_TLS_ENABLED        0       // 1: connect to MQTT_TLS_PORT over TLS
+#endif
+#define MQTT_TLS_PORT           8883
+#define MQTT_TLS_VERIFY         true    // false: encrypt without checking the broker certificate
+#define MQTT_TLS_SERVER_NAME    ""      // Name in the broker certificate, also sent as SNI ("" = not checked)
+#define MQTT_TLS_CA_FILE        LITTLEFS_MOUNT_POINT "/broker_ca.pem"   // Socket backend: CA chain (PEM)
+#define MQTT_TLS_MODEM_CA_FILE  "broker_ca.pem"             // Modem backend: name in the modem's store
+#define MQTT_TLS_SESSION_FILE   LITTLEFS_MOUNT_POINT "/tls_session.bin"
+#define MQTT_TLS_HANDSHAKE_TIMEOUT_MS 30000
 
 // ============================================================================
 // 4G LTE CONFIGURATION
@@ -116,6 +169,24 @@
 #define APN_USER                ""              // Usually empty
 #define APN_PASS                ""              // Usually empty
 
+// Modem boot: wait for the readiness URCs ("RDY", "+CPIN: READY", "PB DONE")
+// or a responsive AT + ready SIM instead of a fixed delay
+#define MODEM_READY_TIMEOUT_MS  20000   // Hard upper bound for modem boot
+#define MODEM_AT_POLL_MS        500     // testAT() interval while waiting
+#define MODEM_AT_TIMEOUT_MS     150     // Timeout of each AT probe
+#define MODEM_POWER_OFF_TIMEOUT_MS 4000 // Max wait for the modem to go silent
+
+// Network attach / sockets, driven step by step from loop()
+#define MODEM_NETWORK_TIMEOUT_MS 30000  // Max wait for network registration
+#define MODEM_NETOPEN_TIMEOUT_MS 75000  // Max wait for "+NETOPEN: 0"
+#define MODEM_GPRS_ATTEMPTS     3       // Data session attempts per attach
+#define MODEM_GPRS_RETRY_MS     2000    // Pause between data session attempts
+#define MODEM_SOCKET_OPEN_TIMEOUT_MS 20000 // Max wait for "+CIPOPEN: <mux>,0"
+
+// Last-resort TCP reachability probe, only after MQTT reconnects keep failing
+#define INTERNET_PROBE_HOST     "google.com"
+#define INTERNET_PROBE_PORT     80
+
 // ============================================================================
 // APPLICATION CONFIGURATION
 // ============================================================================
@@ -124,9 +195,83 @@
 #define TELEMETRY_INTERVAL_MS   30000   // Send data every 30 seconds
 #define MAX_OFFLINE_RECORDS     1000    // Max records to store when offline
 
+// --- Task Layout (dual core) ---
+// Acquisition (RS485, ADC, I2C) samples every TELEMETRY_INTERVAL_MS on
+// core 1; comms (modem, MQTT, storage, history archive) runs on core 0.
+// Samples cross over through a lock-free ring, so an LTE stall does not
+// move the sampling schedule.
+#define ACQ_TASK_CORE           1
+#define ACQ_TASK_STACK          8192    // Bytes
+#define ACQ_TASK_PRIORITY       3
+#define COMMS_TASK_CORE         0
+#define COMMS_TASK_STACK        16384   // Bytes (TLS handshake, JSON documents)
+#define COMMS_TASK_PRIORITY     2
+#define TASK_REPORT_INTERVAL_MS 300000  // Stack / load / job report (log + node info)
+
+// --- Scheduled Jobs ---
+// Each task sleeps until its next job deadline; modem bytes and new samples
+// wake the comms task at once.
+#define COMMS_TICK_MS           250     // Connection state machine between modem events
+#define STORAGE_POLL_MS         1000    // Storage engine (mount retries, durability flush)
+#define HEALTH_CHECK_INTERVAL_MS 300000 // LTE + MQTT status summary in the log
+#define TIME_RESYNC_INTERVAL_MS 86400000 // Server time (cek_waktu) once a day
+#define TIME_SYNC_RETRY_MS      60000   // ...and every minute until it answers
+#define METRICS_INTERVAL_MS     900000  // Stage latency snapshot on <MQTT_TOPIC>/<id>/metrics
+
+// --- Storage Write Coalescing ---
+// Records are staged in RAM and written in whole blocks instead of
+// open/append/close per record. Anything staged longer than the
+// durability window is flushed even if the block is not full.
+#define SD_WRITE_BLOCK_SIZE     4096    // FAT cluster-aligned write unit (8 x 512B sectors)
+#define LFS_WRITE_BLOCK_SIZE    4096    // LittleFS block size on ESP32 flash
+#define STORAGE_STAGING_SIZE    8192    // RAM staging buffer per queue file (>= 2 blocks)
+#define LOG_STAGING_SIZE        8192    // RAM staging buffer for SD log lines
+#define STORAGE_DURABILITY_MS   60000   // Max time a record may sit in RAM before flush
+
+// --- Offline Queue Log ---
+// CRC-framed records in fixed-size segments; boot recovery only scans the
+// last segment. Oldest segment is dropped when the limit is reached.
+#define QUEUE_SEGMENT_SIZE      32768   // Max bytes per segment file
+#define SD_QUEUE_MAX_SEGMENTS   256     // 8 MB of backlog on SD
+#define LFS_QUEUE_MAX_SEGMENTS  32      // 1 MB of backlog on internal flash
+
+// --- RAM Queue (no filesystem) ---
+// Fixed slab arena allocated once, in PSRAM when the module has it.
+// Records move to SD / LittleFS as soon as one of them mounts again.
+#define RAM_QUEUE_PSRAM_BYTES   524288  // 512 KB arena in PSRAM
+#define RAM_QUEUE_INTERNAL_BYTES 16384  // 16 KB arena in internal RAM (no PSRAM)
+#define RAM_QUEUE_SLAB_SIZE     256     // Slab size (records take whole slabs)
+#define STORAGE_RETRY_MS        60000   // Retry mounting higher-priority storage after a failover
+
+// --- History Archive (SD) ---
+// Raw samples kept 24 h, 1-minute aggregates 30 days, hourly aggregates
+// 1 year. Queried with {"action":"history"} on sensor/{id}/command,
+// answered in batches on sensor/{id}/history.
+#define HISTORY_DIR             SD_MOUNT_POINT "/history"
+#define HISTORY_BATCH_RECORDS   50      // Rows per MQTT batch (~3 KB payload)
+
+// --- Cellular Data Budget ---
+// Bytes over the SIM per billing month, counted on the device and kept in
+// LittleFS. When the projected month-end use nears the budget, telemetry
+// goes out 2x / 4x / 8x less often, then compact and without backlog
+// replay; the history archive keeps sampling at TELEMETRY_INTERVAL_MS.
+#define DATA_BUDGET_MB          50      // SIM plan per month, 0 = count only
+#define DATA_BUDGET_FILE        LITTLEFS_MOUNT_POINT "/data_budget.bin"
+#define DATA_BUDGET_TZ_OFFSET_S 25200   // Month starts at local midnight (UTC+7)
+#define DATA_TCP_OVERHEAD_BYTES 40      // IPv4 + TCP header per segment (estimate)
+#define DATA_PROBE_BYTES        600     // DNS + TCP open/close of one internet probe (estimate)
+#define DATA_COMPACT_NODE_INFO_MS 3600000 // Compact telemetry carries node info once an hour
+
 // --- RS485 Device Monitoring ---
 #define RS485_SCAN_INTERVAL_MS  120000  // Scan RS485 devices every 2 minutes (120 seconds)
 
+// --- RS485 Config Cache ---
+// The last stream_config JSON is kept on LittleFS and applied at boot before
+// LTE is up. get_config then carries its CRC-32; the server answers
+// "unchanged" instead of the full JSON when it still matches.
+#define RS485_CONFIG_CACHE_FILE LITTLEFS_MOUNT_POINT "/rs485_config.bin"
+#define RS485_CONFIG_CACHE_MAX  16384   // Largest config JSON kept (bytes)
+
 // --- Watchdog ---
 #define WATCHDOG_TIMEOUT_MS     300000  // 5 minutes - restart if no MQTT connection
 #define HARD_RESTART_TIMEOUT_MS 600000  // 10 minutes - hard restart via relay
@@ -175,6 +320,7 @@
 // ============================================================================
 
 #define ENABLE_SD_CARD          1       // Enable SD card logging
+#define ENABLE_HISTORY          1       // Enable on-device history archive (needs SD)
 #define ENABLE_OTA              0       // Enable OTA updates (future feature)
 #define ENABLE_WATCHDOG         1       // Enable watchdog timer
 #define ENABLE_HARD_RESTART     1       // Enable hard restart via relay
@@ -9,6 +9,8 @@
 // ============================================================================
 // CONNECTION MANAGER - Hierarchical Auto-Reconnect State Machine
 // ============================================================================
+// loop() only polls / starts the non-blocking LTE and MQTT operations, so it
+// returns within a few ms even while the modem reboots.
 
 class ConnectionManager {
 public:
@@ -25,9 +27,13 @@ public:
     // Initialize connection manager
     void begin();
 
-    // Main state machine loop (call in main loop)
+    // Main state machine loop (call on every modem event and at least every
+    // COMMS_TICK_MS)
     void loop();
 
+    // LTE + MQTT status summary (HEALTH_CHECK_INTERVAL_MS job)
+    void printHealth();
+
     // Status checks
     bool isLTEReady();
     bool isInternetReady();
@@ -41,6 +47,7 @@ public:
     uint32_t getLteHardRebootCount() const { return lteHardReboots; }
     uint32_t getLteReconnectAttempts() const { return lteReconnectAttempts; }
     uint32_t getInternetFailCount() const { return internetFailCount; }
+    uint32_t getLivenessFailures() const { return livenessFailures; }
     uint32_t getMqttReconnectAttempts() const { return mqttReconnectAttempts; }
     uint32_t getMqttTotalFailures() const { return mqttTotalFailures; }
     uint32_t getPublishFailureCount() const { return mqttPublishFailures; }
@@ -62,26 +69,27 @@ private:
     unsigned long lastLTERetry;
     unsigned long lastInternetTest;
     unsigned long lastMQTTRetry;
-    unsigned long lastHealthCheck;
     unsigned long lastPublishSuccess;
+    unsigned long connectedSince;
+    unsigned long livenessCheckAt;          // Ping + echo outstanding since (0 = none)
+    unsigned long internetRetryInterval;
 
     int mqttFailCount;
     int lteFailCount;
     uint32_t lteReconnectAttempts;
     uint32_t lteHardReboots;
     uint32_t internetFailCount;
+    uint32_t livenessFailures;
     uint32_t mqttReconnectAttempts;
     uint32_t mqttTotalFailures;
     uint32_t mqttPublishFailures;
+    bool lteRebooting;
 
     // State machine handlers
     void handleLTEDown();
     void handleInternetDown();
     void handleMQTTDown();
     void handleConnected();
-
-    // Internet test
-    bool testInternet();
 };
 
 #endif // CONNECTION_MANAGER_H
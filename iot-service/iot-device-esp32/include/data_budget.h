@@ -0,0 +1,135 @@
+#ifndef DATA_BUDGET_H
+#define DATA_BUDGET_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// DATA BUDGET - Cellular bytes per billing month and the telemetry governor
+// ============================================================================
+// Counts what goes over the SIM per transport and direction:
+//   mqtt    MQTT packets as written to / read from the session
+//   tcp     IP + TCP headers and bare ACKs under them (estimated)
+//   probe   internet probes, DNS + TCP open/close (estimated)
+// and per topic (topic + payload bytes), keyed by the topic with the device
+// id taken out ("sensor/telemetry", "get_config", ...).
+//
+// Counters are kept in a small file (POSIX stdio, e.g. on "/littlefs") so a
+// reboot does not reset the month. The month rolls over in local time
+// (DATA_BUDGET_TZ_OFFSET_S); the previous month stays readable.
+//
+// From the bytes used so far the governor projects the month-end total and
+// picks a level; the application stretches the telemetry interval by
+// getIntervalFactor(), drops to compact payloads and pauses backlog replay
+// as the projection passes the budget.
+
+#define DATA_BUDGET_TOPICS      10      // Topic counters per month
+#define DATA_BUDGET_TOPIC_LEN   24      // Key incl. terminator (longer keys are cut)
+#define DATA_BUDGET_PATH_MAX    48
+#define DATA_BUDGET_SAVE_MS     600000  // Counters to the file every 10 min (and at rollover)
+#define DATA_BUDGET_MIN_ELAPSED 86400   // Project from at least a day, boot traffic is bursty
+
+// Projected month-end use in % of the budget that enters each level; a
+// level is left again 5 points below its threshold
+#define DATA_BUDGET_STRETCH_PCT 90
+#define DATA_BUDGET_COMPACT_PCT 100
+#define DATA_BUDGET_MINIMAL_PCT 125
+
+enum DataTransport {
+    DATA_MQTT,
+    DATA_TCP,
+    DATA_PROBE,
+    DATA_TRANSPORT_COUNT
+};
+
+enum DataDirection {
+    DATA_UP,
+    DATA_DOWN
+};
+
+enum DataBudgetLevel {
+    BUDGET_NORMAL,      // On track
+    BUDGET_STRETCH,     // Projection near the budget: longer telemetry interval
+    BUDGET_COMPACT,     // Over: compact payloads, no backlog replay
+    BUDGET_MINIMAL      // Far over or budget used up: keep-alive telemetry only
+};
+
+class DataBudget {
+public:
+    struct TopicUsage {
+        char key[DATA_BUDGET_TOPIC_LEN];
+        uint32_t bytes[2];          // Up, down
+        uint32_t messages[2];
+    };
+
+    struct Month {
+        uint32_t period;            // yyyymm, 0 = not known yet (clock not set)
+        uint32_t since;             // Unix time counting started in this month
+        uint32_t bytes[DATA_TRANSPORT_COUNT][2];
+        TopicUsage topics[DATA_BUDGET_TOPICS];
+        uint32_t otherBytes[2];     // Topics that did not get a counter
+    };
+
+    DataBudget();
+
+    // Load the counters from `path` (nullptr = RAM only). `budgetBytes` 0
+    // counts without ever leaving BUDGET_NORMAL. `deviceId` is cut out of
+    // topic keys; months start at local midnight, UTC + `tzOffset` seconds.
+    bool begin(const char* path, uint32_t budgetBytes, const char* deviceId, int32_t tzOffset);
+
+    // ========================================
+    // Counting
+    // ========================================
+
+    void count(DataTransport transport, DataDirection dir, uint32_t bytes);
+    void countTopic(const char* topic, DataDirection dir, uint32_t bytes);
+
+    // Month rollover, projection and periodic save. `unixTime` 0 = clock
+    // not set yet (bytes still count, against the month found later).
+    void update(uint32_t unixTime, unsigned long nowMs);
+
+    // Write the counters now (also done by update() every DATA_BUDGET_SAVE_MS)
+    bool save();
+
+    // ========================================
+    // Governor
+    // ========================================
+
+    DataBudgetLevel getLevel() const { return level; }
+    uint8_t getIntervalFactor() const;      // 1, 2, 4, 8
+    bool isCompact() const { return level >= BUDGET_COMPACT; }
+    bool isReplayPaused() const { return level >= BUDGET_COMPACT; }
+    static const char* levelName(DataBudgetLevel level);
+
+    // ========================================
+    // Readout
+    // ========================================
+
+    uint32_t getBudget() const { return budget; }
+    uint32_t getUsed() const { return total(current); }
+    uint32_t getProjected() const { return projected; }
+    const Month& getMonth() const { return current; }
+    const Month& getPreviousMonth() const { return previous; }
+    static uint32_t total(const Month& month);
+
+private:
+    char path[DATA_BUDGET_PATH_MAX];
+    char deviceId[DATA_BUDGET_TOPIC_LEN];
+    uint32_t budget;
+    int32_t tzOffset;
+    Month current;
+    Month previous;
+    uint32_t projected;
+    DataBudgetLevel level;
+    bool dirty;
+    unsigned long lastSaveMs;
+    unsigned long lastEvalMs;
+
+    bool load();
+    void rollover(uint32_t period, uint32_t monthStart);
+    void evaluate(uint32_t unixTime, uint32_t monthStart, uint32_t monthEnd);
+    TopicUsage* topicSlot(const char* key);
+    void topicKey(const char* topic, char* key) const;
+};
+
+#endif // DATA_BUDGET_H
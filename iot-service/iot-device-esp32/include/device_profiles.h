@@ -0,0 +1,35 @@
+#ifndef DEVICE_PROFILES_H
+#define DEVICE_PROFILES_H
+
+#include "rs485_config_manager.h"
+
+// ============================================================================
+// DEVICE PROFILES - Built-in RS485 register maps
+// ============================================================================
+// The register maps of devices deployed in numbers (*-modbus-config.json in
+// the project root) are compiled into constexpr tables in flash by
+// scripts/gen_device_profiles.py (PlatformIO pre-script, writes
+// device_profiles_gen.h). The server then only sends
+//   {"profile":"TUF-2000-FlowMeter","version":1,"modbus_address":2}
+// instead of the full JSON map, and nothing is parsed or copied to the heap
+// for the registers. Devices without a built-in profile keep the JSON path.
+//
+// get_config lists the profiles as "device_type@version" and the gateway
+// matches on that: a map that changes needs a new "version".
+
+struct RS485Profile {
+    const char* deviceType;
+    uint16_t version;
+    uint32_t baudRate;
+    uint8_t modbusAddress;      // Default when the server gives none
+    const RS485Register* registers;
+    uint8_t registerCount;
+};
+
+// nullptr if this firmware has no such profile (version 0 = any)
+const RS485Profile* findDeviceProfile(const char* deviceType, uint16_t version);
+
+uint8_t getDeviceProfileCount();
+const RS485Profile& getDeviceProfile(uint8_t index);
+
+#endif // DEVICE_PROFILES_H
@@ -0,0 +1,47 @@
+// ============================================================================
+// GENERATED by scripts/gen_device_profiles.py from *-modbus-config.json - do not edit
+// ============================================================================
+
+#ifndef DEVICE_PROFILES_GEN_H
+#define DEVICE_PROFILES_GEN_H
+
+#include "device_profiles.h"
+
+// 3Phase-PowerMeter-V2305 v1 (power-meter-3phase-modbus-config.json)
+constexpr RS485Register PROFILE_3PHASE_POWERMETER_V2305_V1[] = {
+    { 66, RS485_UINT32, 2, true, "voltage_l1" },
+    { 68, RS485_UINT32, 2, true, "voltage_l2" },
+    { 70, RS485_UINT32, 2, true, "voltage_l3" },
+    { 88, RS485_UINT32, 2, true, "current_l1" },
+    { 90, RS485_UINT32, 2, true, "current_l2" },
+    { 92, RS485_UINT32, 2, true, "current_l3" },
+    { 100, RS485_INT32, 2, true, "active_power_l1" },
+    { 102, RS485_INT32, 2, true, "active_power_l2" },
+    { 104, RS485_INT32, 2, true, "active_power_l3" },
+    { 106, RS485_INT32, 2, true, "total_active_power" },
+    { 124, RS485_INT16, 1, false, "power_factor_l1" },
+    { 125, RS485_INT16, 1, false, "power_factor_l2" },
+    { 126, RS485_INT16, 1, false, "power_factor_l3" },
+    { 127, RS485_INT16, 1, false, "total_power_factor" },
+    { 128, RS485_UINT16, 1, false, "frequency" },
+    { 130, RS485_UINT32, 2, true, "total_positive_active_energy" },
+};
+
+// TUF-2000-FlowMeter v1 (tuf2000-flowmeter-modbus-config.json)
+constexpr RS485Register PROFILE_TUF_2000_FLOWMETER_V1[] = {
+    { 1, RS485_FLOAT32, 2, true, "flow_rate" },
+    { 5, RS485_FLOAT32, 2, true, "flow_velocity" },
+    { 9, RS485_UINT32, 2, true, "positive_totalizer" },
+    { 25, RS485_UINT32, 2, true, "net_totalizer" },
+    { 72, RS485_HEX16, 1, false, "error_code" },
+    { 92, RS485_UINT16, 1, false, "signal_quality" },
+    { 33, RS485_FLOAT32, 2, true, "temperature_t1" },
+    { 35, RS485_FLOAT32, 2, true, "temperature_t2" },
+};
+
+constexpr RS485Profile DEVICE_PROFILE_TABLE[] = {
+    { "3Phase-PowerMeter-V2305", 1, 9600, 1, PROFILE_3PHASE_POWERMETER_V2305_V1, 16 },
+    { "TUF-2000-FlowMeter", 1, 9600, 2, PROFILE_TUF_2000_FLOWMETER_V1, 8 },
+};
+
+#endif // DEVICE_PROFILES_GEN_H
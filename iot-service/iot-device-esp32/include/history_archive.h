@@ -0,0 +1,173 @@
+#ifndef HISTORY_ARCHIVE_H
+#define HISTORY_ARCHIVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// HISTORY ARCHIVE - Downsampled sensor history on a mounted filesystem
+// ============================================================================
+// Three tiers, each rolled up from the samples as they arrive:
+//   raw     every sample            1 file per hour     kept 24 h
+//   minute  1-minute aggregates     1 file per day      kept 30 days
+//   hour    1-hour aggregates       1 file per 30 days  kept 1 year
+//
+// Layout under `dir` (VFS path, e.g. "/sd/history"):
+//   channels            channel names, one per line (line number = id)
+//   raw/XXXXXXXX.dat    fixed-size records, XXXXXXXX = bucket start (unix, hex)
+//   raw/XXXXXXXX.idx    first timestamp of every data block in the .dat
+//   minute/..., hour/...
+//
+// Records are appended in time order, so a range query opens only the
+// buckets overlapping the range, binary-searches the .idx for the first
+// block and reads data blocks until it passes the end of the range.
+//
+// Uses POSIX stdio so the same code runs on ESP32 VFS mounts and on a host.
+
+#define HISTORY_MAX_CHANNELS      32
+#define HISTORY_CHANNEL_NAME_MAX  32
+#define HISTORY_BLOCK_RECORDS     32      // Records per indexed data block
+#define HISTORY_DIR_MAX           48
+#define HISTORY_PATH_MAX          (HISTORY_DIR_MAX + 24)   // dir + "/minute/XXXXXXXX.dat"
+
+enum HistoryTier {
+    HISTORY_RAW,
+    HISTORY_MINUTE,
+    HISTORY_HOUR,
+    HISTORY_TIER_COUNT
+};
+
+// On-disk record (little-endian, same layout for every tier; raw samples
+// have count 1 and mean == min == max)
+struct HistoryRecord {
+    uint32_t timestamp;     // Sample time / start of the minute or hour (unix)
+    uint16_t channel;
+    uint16_t count;         // Samples aggregated
+    float mean;
+    float min;
+    float max;
+};
+
+class HistoryArchive {
+public:
+    struct Query {
+        HistoryTier tier;
+        uint32_t from;
+        uint32_t to;
+        uint32_t channelMask;   // Bit per channel id, 0 = all
+    };
+
+    struct Stats {
+        uint32_t recordsWritten[HISTORY_TIER_COUNT];
+        uint32_t filesPruned;
+        uint32_t indexReads;    // .idx entries read by queries
+        uint32_t blocksRead;    // Data blocks read by queries
+        uint32_t writeErrors;
+    };
+
+    HistoryArchive();
+
+    // Mount the archive in `dir` (created if missing)
+    bool begin(const char* dir);
+    void end();
+    bool isOpen() const { return open; }
+
+    // ========================================
+    // Recording (one cycle per telemetry interval)
+    // ========================================
+
+    // Start a cycle at `timestamp`; samples before the last cycle are refused
+    bool beginCycle(uint32_t timestamp);
+
+    // Add one sample to the current cycle
+    bool record(const char* channel, float value);
+
+    // Write raw samples and any closed minute / hour aggregates
+    bool commit();
+
+    // ========================================
+    // Queries (resumable, one batch at a time)
+    // ========================================
+
+    bool startQuery(const Query& query);
+    bool isQueryActive() const { return queryActive; }
+    void cancelQuery() { queryActive = false; }
+
+    // Next matching records in time order; returns count, 0 when finished
+    size_t nextBatch(HistoryRecord* out, size_t capacity);
+
+    // Finest tier whose retention still covers `from`
+    HistoryTier tierFor(uint32_t from, uint32_t now) const;
+
+    // ========================================
+    // Channels / Info
+    // ========================================
+
+    int findChannel(const char* name) const;
+    const char* getChannelName(uint16_t id) const;
+    uint16_t getChannelCount() const { return channelCount; }
+
+    const Stats& getStats() const { return stats; }
+
+    static const char* tierName(HistoryTier tier);
+    static bool parseTier(const char* name, HistoryTier& tier);
+    static uint32_t bucketWidth(HistoryTier tier);
+    static uint32_t retention(HistoryTier tier);
+
+private:
+    struct Accumulator {
+        uint32_t period;        // Start of the minute / hour being aggregated
+        uint16_t count;
+        float sum;
+        float min;
+        float max;
+    };
+
+    struct QueryState {
+        Query query;
+        uint32_t bucket;        // Bucket file being read
+        uint32_t position;      // Record index in it, UINT32_MAX = not located yet
+    };
+
+    bool open;
+    char dir[HISTORY_DIR_MAX];
+
+    char channels[HISTORY_MAX_CHANNELS][HISTORY_CHANNEL_NAME_MAX];
+    uint16_t channelCount;
+
+    // Recording
+    uint32_t cycleTime;
+    uint32_t lastCycleTime;
+    HistoryRecord pendingRaw[HISTORY_MAX_CHANNELS];
+    uint16_t pendingRawCount;
+    Accumulator minuteAcc[HISTORY_MAX_CHANNELS];
+    Accumulator hourAcc[HISTORY_MAX_CHANNELS];
+
+    // Bucket each tier is appending to (0 = none yet)
+    uint32_t writeBucket[HISTORY_TIER_COUNT];
+    uint32_t writeRecords[HISTORY_TIER_COUNT];
+
+    bool queryActive;
+    QueryState queryState;
+
+    Stats stats;
+
+    // Helpers: paths
+    void tierPath(HistoryTier tier, char* out) const;
+    void bucketPath(HistoryTier tier, uint32_t bucket, const char* suffix, char* out) const;
+
+    // Helpers: channels
+    bool loadChannels();
+    int addChannel(const char* name);
+
+    // Helpers: writing
+    void closeAccumulators(Accumulator* acc, HistoryTier tier, uint32_t now);
+    bool appendRecords(HistoryTier tier, const HistoryRecord* records, size_t count);
+    bool openBucket(HistoryTier tier, uint32_t bucket);
+    void prune(HistoryTier tier, uint32_t now);
+
+    // Helpers: reading
+    uint32_t locate(HistoryTier tier, uint32_t bucket, uint32_t from);
+};
+
+#endif // HISTORY_ARCHIVE_H
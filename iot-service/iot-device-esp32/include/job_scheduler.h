@@ -0,0 +1,71 @@
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// JOB SCHEDULER - Deadline list of one task's periodic and one-shot work
+// ============================================================================
+// Jobs are registered once with a name; run() calls every job whose
+// deadline has passed and returns the time to the next one, which the task
+// sleeps on (or less, when an I/O event wakes it first). This replaces
+// "poll millis() against lastX, then delay(100)" - nothing runs and nothing
+// wakes up unless a deadline or an event asks for it.
+//
+// Periodic jobs stay on a fixed grid: a late run does not shift the next
+// deadline, and missed ones are skipped rather than run back to back.
+// One-shot jobs are registered disarmed and run once per runIn(); a job may
+// re-arm itself from its own callback. Not thread-safe: one scheduler per
+// task.
+
+#define SCHEDULER_MAX_JOBS      16
+#define SCHEDULER_NAME_LEN      12      // Job name incl. terminator
+#define SCHEDULER_IDLE_MS       60000   // Longest sleep when nothing is armed
+
+class JobScheduler {
+public:
+    typedef void (*JobFn)(unsigned long nowMs);
+
+    explicit JobScheduler(const char* name);
+
+    // First run `firstDelayMs` after `nowMs`, then every `periodMs`.
+    // Returns the job id, -1 when full.
+    int8_t every(const char* name, unsigned long periodMs, JobFn fn,
+                 unsigned long nowMs, unsigned long firstDelayMs = 0);
+    int8_t once(const char* name, JobFn fn);
+
+    // (Re)arm: run `delayMs` from `nowMs`; a periodic job continues its
+    // grid from there
+    void runIn(int8_t id, unsigned long delayMs, unsigned long nowMs);
+    void cancel(int8_t id);
+    bool isArmed(int8_t id) const;
+
+    // Run due jobs; ms until the next deadline (0 = something is due again)
+    unsigned long run(unsigned long nowMs);
+    uint32_t getLastLateMs() const { return lastLateMs; }
+
+    void printJobs(unsigned long nowMs) const;
+
+private:
+    struct Job {
+        char name[SCHEDULER_NAME_LEN];
+        JobFn fn;
+        unsigned long periodMs;     // 0 = one-shot
+        unsigned long dueAt;
+        bool armed;
+
+        uint32_t runs;
+        uint32_t maxLateMs;
+        uint32_t maxRunMs;
+    };
+
+    const char* name;
+    Job jobs[SCHEDULER_MAX_JOBS];
+    uint8_t jobCount;
+    uint32_t lastLateMs;            // Worst start delay in the last run()
+
+    int8_t add(const char* name, JobFn fn, unsigned long periodMs);
+};
+
+#endif // JOB_SCHEDULER_H
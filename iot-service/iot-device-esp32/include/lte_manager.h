@@ -11,28 +11,58 @@
 // ============================================================================
 // LTE MANAGER - Clean SIM7600 LTE Management
 // ============================================================================
+// Power-up, attach, reboot and the internet probe run as tasks of short
+// steps advanced from poll(), so the main loop keeps sampling while the
+// modem boots or registers. One task at a time; start*() returns false while
+// another one is still running.
+
+// Boot phase timestamps, millis() since ESP32 boot (0 = not reached)
+struct ModemBootTimes {
+    unsigned long powerOn;      // PWRKEY released (or modem found already on)
+    unsigned long rdy;          // "RDY" URC
+    unsigned long cpinReady;    // "+CPIN: READY" URC or AT+CPIN? answer
+    unsigned long pbDone;       // "PB DONE" URC
+    unsigned long atReady;      // First answered AT
+    unsigned long ready;        // Readiness accepted
+    unsigned long network;      // Registered on the network
+    unsigned long gprs;         // Data session up with a valid IP
+};
 
 class LTEManager {
 public:
+    // Outcome of the running task, see poll()
+    enum LinkStatus {
+        LINK_IDLE,      // No task running
+        LINK_BUSY,      // Task in progress
+        LINK_UP,        // Task succeeded
+        LINK_FAILED,    // Task failed (probe: network open but no internet)
+        LINK_DOWN       // Probe found the data session closed
+    };
+
     LTEManager();
 
-    // Initialize LTE modem
+    // Open the modem serial and start power-up + attach
     bool begin();
 
-    // Connect to network and GPRS
-    bool connect();
+    // Start network registration + data session
+    bool startConnect();
 
-    // Disconnect from network
-    bool disconnect();
+    // Start a full modem power cycle + attach
+    bool startReboot();
+
+    // Start a TCP test connection to INTERNET_PROBE_HOST (diagnostic socket)
+    bool startInternetProbe();
 
-    // Check if GPRS connected
-    bool isConnected();
+    // Advance the running task; reports its outcome once, then LINK_IDLE
+    LinkStatus poll();
 
-    // Test internet connectivity (HTTP to Google)
-    bool testInternet();
+    bool isBusy() const { return task != TASK_NONE; }
 
-    // Perform a full modem power cycle + reinitialization
-    bool rebootModem();
+    // Disconnect from network (blocking, outside of tasks only)
+    bool disconnect();
+
+    // Data session state as of the last task (no AT traffic)
+    bool isConnected() const { return gprsConnected; }
 
     // Get signal quality (CSQ)
     int getSignalQuality();
@@ -46,17 +76,86 @@ public:
     // Print status
     void printStatus();
 
+    // Timestamps of the last modem power-up / attach
+    const ModemBootTimes& getBootTimes() const { return bootTimes; }
+
 private:
+    enum Task {
+        TASK_NONE,
+        TASK_POWER_ON,
+        TASK_ATTACH,
+        TASK_REBOOT,
+        TASK_PROBE
+    };
+
+    enum Step {
+        STEP_PULSE,             // Timed PWRKEY / RESET pulse
+        STEP_WAIT_POWER_OFF,
+        STEP_PROBE_ON,          // Modem already running?
+        STEP_POWER_ON,
+        STEP_WAIT_READY,
+        STEP_ECHO_OFF,
+        STEP_WAIT_NETWORK,
+        STEP_DATA_SETUP,
+        STEP_NET_OPEN,
+        STEP_CHECK_IP,
+        STEP_ATTACH_RETRY,
+        STEP_PROBE_OPEN,
+        STEP_PROBE_CLOSE,
+        STEP_PROBE_NET_CHECK
+    };
+
     bool gprsConnected;
-    unsigned long lastCheck;
-
-    // Internal helpers
-    bool powerOnModem();
-    void powerOffModem();
-    void pulsePowerKey(uint32_t durationMs);
-    void hardwareReset();
-    bool initModem();
-    bool connectGPRS();
+    ModemBootTimes bootTimes;
+
+    Task task;
+    Step step;
+    LinkStatus result;
+    unsigned long stepStart;
+    unsigned long lastAt;
+    uint8_t setupIndex;
+    uint8_t attempt;
+    bool commandSent;
+    bool awaitingCpin;
+    bool powerDown;
+    char command[96];
+
+    // Pin pulse: LOW for preMs, HIGH for holdMs, LOW for settleMs, then `pulseNext`
+    int8_t pulsePin;
+    uint8_t pulsePhase;
+    uint32_t pulseTimes[3];
+    Step pulseNext;
+
+    // Task plumbing
+    bool startTask(Task next);
+    void enter(Step next);
+    void finishTask(LinkStatus status);
+    void startPulse(int8_t pin, uint32_t preMs, uint32_t holdMs, uint32_t settleMs, Step next);
+    bool sendOnce(const char* cmd, uint32_t timeoutMs,
+                  const char* capturePrefix = nullptr, bool untilCapture = false);
+    bool atDue(uint32_t intervalMs) const;
+
+    // Steps
+    void stepPulse();
+    void stepWaitPowerOff();
+    void stepProbeOn();
+    void stepPowerOn();
+    void stepWaitReady();
+    void stepEchoOff();
+    void stepWaitNetwork();
+    void stepDataSetup();
+    void stepNetOpen();
+    void stepCheckIp();
+    void stepAttachRetry();
+    void stepProbeOpen();
+    void stepProbeClose();
+    void stepProbeNetCheck();
+
+    void attemptFailed(const char* reason);
+    const char* setupCommand(uint8_t index);
+
+    // Boot / power URCs seen by ModemAt
+    static void onUrc(void* context, const char* line);
 };
 
 #endif // LTE_MANAGER_H
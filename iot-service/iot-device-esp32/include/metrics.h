@@ -0,0 +1,76 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+// ============================================================================
+// METRICS - Hot-path latency histograms and counters
+// ============================================================================
+// A fixed table of stages, each with a count, sum, max and a log2 histogram
+// of durations in microseconds, plus a few event counters. Time a block
+// with a ScopedMetric:
+//
+//     ScopedMetric timer(METRIC_RS485_READ);
+//
+// Recording is two micros() reads, a count-leading-zeros and a handful of
+// adds. Both cores record, so the table sits behind a spinlock.
+//
+// Recording only needs this header, so the portable storage / modem code
+// keeps building on the host (bench/host/metrics_stub.cpp). Reporting is in
+// metrics_snapshot.h.
+//
+// snapshotMetrics() writes everything recorded since the previous snapshot
+// in compact form and starts the next window:
+//   {"w":900,"b":256,"t":{"rs485":[n,sum_ms,max_ms,[buckets]]},"c":{"at_timeout":2}}
+// Bucket 0 is < b us, bucket i (i > 0) is [b << (i-1), b << i), the last one
+// is open-ended. Trailing empty buckets, idle stages and zero counters are
+// left out.
+
+#define METRIC_BUCKETS          16
+#define METRIC_BUCKET_SHIFT     8       // First bucket bound: 256 us (last: >= 4.2 s)
+
+enum MetricId : uint8_t {
+    METRIC_ACQ_PASS,            // acquireSample(): one pass over every sensor
+    METRIC_RS485_READ,          // readRS485Register(): request to checked reply
+    METRIC_JSON_ENCODE,         // Sample into the ring, JsonDocument publishes
+    METRIC_TELEMETRY,           // publishTelemetry(): both messages
+    METRIC_NODE_INFO,           // appendNodeInfo(): blocking TinyGSM queries
+    METRIC_MQTT_PUBLISH,        // MQTTManager::publish(): into the window or outbox
+    METRIC_MODEM_AT,            // ModemAt command, sent to final result
+    METRIC_STORAGE_PUSH,
+    METRIC_STORAGE_READ,        // peek / pop
+    METRIC_STORAGE_POLL,        // Flushes, health probe, migration
+    METRIC_HISTORY_WRITE,       // History archive commit
+    METRIC_TIMER_COUNT
+};
+
+enum MetricCounter : uint8_t {
+    COUNTER_RS485_FAIL,         // Timeout, exception or bad length (scan probes too)
+    COUNTER_AT_ERROR,
+    COUNTER_AT_TIMEOUT,
+    COUNTER_PUBLISH_SPILL,      // Window full / offline: into the outbox for a retry
+    COUNTER_PUBLISH_REPLAY,     // Outbox record sent
+    COUNTER_PUBLISH_FAIL,       // Dropped
+    COUNTER_SAMPLE_RS485_DROP,  // Sample over SAMPLE_JSON_BYTES, sent without RS485
+    COUNTER_COUNT
+};
+
+void recordMetric(MetricId id, uint32_t us);
+void countMetric(MetricCounter counter, uint32_t n = 1);
+uint32_t metricsMicros();       // micros() on the device
+
+
+class ScopedMetric {
+public:
+    explicit ScopedMetric(MetricId id) {
+        this->id = id;
+        startUs = metricsMicros();
+    }
+    ~ScopedMetric() { recordMetric(id, metricsMicros() - startUs); }
+
+private:
+    MetricId id;
+    uint32_t startUs;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,11 @@
+#ifndef METRICS_SNAPSHOT_H
+#define METRICS_SNAPSHOT_H
+
+#include <ArduinoJson.h>
+#include "metrics.h"
+
+// Compact window (see metrics.h) into `out`; returns false if nothing was
+// recorded. Firmware only: the host benches record, they never report.
+bool snapshotMetrics(JsonObject out, unsigned long nowMs);
+
+#endif // METRICS_SNAPSHOT_H
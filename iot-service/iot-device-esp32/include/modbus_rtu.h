@@ -0,0 +1,86 @@
+#ifndef MODBUS_RTU_H
+#define MODBUS_RTU_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ============================================================================
+// MODBUS RTU FRAMING - Read Holding Registers (function 03)
+// ============================================================================
+// Request:   [addr][0x03][start hi][start lo][count hi][count lo][crc lo][crc hi]
+// Response:  [addr][0x03][byte count][data hi, lo ...][crc lo][crc hi]
+// Exception: [addr][0x83][code][crc lo][crc hi]
+//
+// Bytes only, no UART: main.cpp does the bus I/O, the host bench
+// (bench/pipeline_bench.cpp) runs the same code on recorded frames.
+
+#define MODBUS_FN_READ_HOLDING  0x03
+#define MODBUS_REQUEST_SIZE     8
+#define MODBUS_RESPONSE_MIN     5       // Exception frame
+
+inline uint16_t modbusCRC(const uint8_t* buffer, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= buffer[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            if (crc & 0x0001) {
+                crc >>= 1;
+                crc ^= 0xA001;
+            } else {
+                crc >>= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+inline void modbusBuildReadRequest(uint8_t* frame, uint8_t address, uint16_t startRegister, uint16_t count) {
+    frame[0] = address;
+    frame[1] = MODBUS_FN_READ_HOLDING;
+    frame[2] = startRegister >> 8;
+    frame[3] = startRegister & 0xFF;
+    frame[4] = count >> 8;
+    frame[5] = count & 0xFF;
+
+    uint16_t crc = modbusCRC(frame, 6);
+    frame[6] = crc & 0xFF;
+    frame[7] = (crc >> 8) & 0xFF;
+}
+
+// Registers of a function 03 response; false for a short frame, another
+// slave, an exception or a byte count other than `count` registers
+inline bool modbusDecodeReadResponse(const uint8_t* frame, size_t length, uint8_t address,
+                                     uint16_t count, uint16_t* output) {
+    if (length < MODBUS_RESPONSE_MIN) return false;
+    if (frame[0] != address) return false;
+    if (frame[1] & 0x80) return false;  // Exception
+
+    uint8_t dataBytes = frame[2];
+    if (dataBytes != count * 2) return false;
+
+    for (uint16_t i = 0; i < count; i++) {
+        output[i] = (frame[3 + i * 2] << 8) | frame[4 + i * 2];
+    }
+    return true;
+}
+
+// Float32 from 2 registers (BADC byte order, TUF-2000M)
+inline float modbusFloat32BADC(const uint16_t* regs) {
+    uint8_t bytes[4];
+    bytes[0] = regs[0] & 0xFF;          // B
+    bytes[1] = (regs[0] >> 8) & 0xFF;   // A
+    bytes[2] = regs[1] & 0xFF;          // D
+    bytes[3] = (regs[1] >> 8) & 0xFF;   // C
+
+    float value;
+    memcpy(&value, bytes, 4);
+    return value;
+}
+
+// Uint32 from 2 registers, low word first
+inline uint32_t modbusUint32LowFirst(const uint16_t* regs) {
+    return ((uint32_t)regs[1] << 16) | regs[0];
+}
+
+#endif // MODBUS_RTU_H
@@ -0,0 +1,100 @@
+#ifndef MODEM_AT_H
+#define MODEM_AT_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// MODEM AT - Non-blocking AT command runner
+// ============================================================================
+// Sends one command and collects the reply a few bytes at a time from
+// poll(), so the main loop never waits on the modem. Used for everything the
+// connection state machine does while no socket is open (power-up, network
+// attach, opening sockets), and for the whole MQTT session with the modem's
+// AT+CMQTT stack. Once a TinyGSM socket is up TinyGSM owns the serial port
+// again - never run both at the same time.
+//
+// Every line read is also handed to the URC handlers, so boot / power URCs
+// ("RDY", "PB DONE", "NORMAL POWER DOWN") are seen between commands too.
+
+#define MODEM_AT_LINE_MAX 64
+#define MODEM_AT_URC_HANDLERS 2
+
+class ModemAt {
+public:
+    enum Result {
+        AT_IDLE,        // No command outstanding
+        AT_PENDING,     // Waiting for the reply
+        AT_OK,
+        AT_ERROR,
+        AT_TIMEOUT
+    };
+
+    typedef void (*UrcHandler)(void* context, const char* line);
+
+    explicit ModemAt(Stream& stream);
+
+    bool addUrcHandler(UrcHandler handler, void* context);
+
+    // Send "AT<command>". Finished by OK / ERROR; with `untilCapture` an OK
+    // also needs a line starting with `capturePrefix` (result URCs that come
+    // after OK, e.g. "+NETOPEN: 0"). Matching lines are kept in getLine().
+    bool start(const char* command, uint32_t timeoutMs,
+               const char* capturePrefix = nullptr, bool untilCapture = false);
+
+    // Like start(), for commands that answer with a ">" prompt: `data` is
+    // written after the prompt and must stay valid until the command ends
+    bool startWithData(const char* command, const uint8_t* data, size_t length, uint32_t timeoutMs,
+                       const char* capturePrefix = nullptr, bool untilCapture = false);
+
+    // From a URC handler: the next `length` bytes are binary data (e.g. an
+    // inbound MQTT payload) and go to `dest` instead of the line parser.
+    // nullptr discards them.
+    void readRaw(uint8_t* dest, size_t length);
+
+    // Read what has arrived; returns the outcome once, then AT_IDLE
+    Result poll();
+
+    // Forget the outstanding command (its reply is read as URCs)
+    void cancel() { pending = false; }
+
+    bool isBusy() const { return pending; }
+
+    // Last line that matched `capturePrefix` ("" if none)
+    const char* getLine() const { return captured; }
+
+private:
+    Stream& stream;
+
+    UrcHandler urcHandlers[MODEM_AT_URC_HANDLERS];
+    void* urcContexts[MODEM_AT_URC_HANDLERS];
+    uint8_t urcHandlerCount;
+
+    bool pending;
+    unsigned long startedAt;
+    uint32_t startedUs;         // Round-trip metric
+    uint32_t timeoutMs;
+    char prefix[24];
+    bool untilCapture;
+    bool okSeen;
+    char captured[MODEM_AT_LINE_MAX];
+
+    char line[MODEM_AT_LINE_MAX];
+    uint8_t lineLength;
+    bool lastEndedCr;
+
+    // Data waiting for the ">" prompt
+    const uint8_t* promptData;
+    size_t promptLength;
+
+    // Binary read armed by readRaw()
+    uint8_t* rawDest;
+    size_t rawRemaining;
+    bool rawSkipLf;
+
+    // Helper: next complete line from the stream into `line`
+    bool readLine();
+    // Helper: end the outstanding command with `result`
+    Result finish(Result result);
+};
+
+#endif // MODEM_AT_H
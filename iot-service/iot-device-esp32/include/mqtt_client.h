@@ -0,0 +1,237 @@
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// MQTT CLIENT - MQTT 3.1.1 / 5 with a QoS 1 in-flight window
+// ============================================================================
+// Portable (no Arduino): runs over an MqttTransport and a millis() clock, so
+// the host bench can drive it against a broker stand-in.
+//
+// QoS 1 publishes are copied into an in-flight arena and stay there until
+// their PUBACK; up to `window` of them can be outstanding at once instead of
+// one publish / wait / retry at a time. With cleanSession=false the broker
+// keeps the session across reconnects, and whatever is still in flight is
+// resent with DUP set after the next CONNACK.
+//
+// Nothing here waits: poll() parses CONNACK, PUBACK, SUBACK, PINGRESP and
+// inbound PUBLISH from the bytes that have arrived and handles keepalive.
+//
+// With protocol level 5 each topic gets a topic alias (as many as the broker
+// allows in CONNACK): the first PUBLISH on a connection carries the topic
+// and the alias, later ones only the 2-byte alias. Packets waiting in the
+// window keep the short form; a resend on a new connection, where the alias
+// is not known yet, writes the topic back in. Message expiry and one user
+// property can be attached to every PUBLISH.
+
+class MqttTransport {
+public:
+    virtual ~MqttTransport() {}
+
+    virtual bool connected() = 0;
+    virtual int available() = 0;
+    virtual int read(uint8_t* buf, size_t len) = 0;
+
+    // Whole packets are written in one call (one CIPSEND on the modem)
+    virtual size_t write(const uint8_t* buf, size_t len) = 0;
+};
+
+#define MQTT_INFLIGHT_MAX       16      // Upper bound for the window
+#define MQTT_CLIENT_ID_MAX      64
+#define MQTT_TOPIC_ALIAS_MAX    8       // MQTT 5 aliases we hand out
+#define MQTT_TOPIC_ALIAS_LEN    64      // Longer topics are always sent in full
+#define MQTT_USER_PROPERTY_MAX  32      // Key + value bytes
+
+class MqttClient {
+public:
+    enum State {
+        MQTT_IDLE,          // Never connected / dropped locally
+        MQTT_CONNECTING,    // CONNECT sent, waiting for CONNACK
+        MQTT_CONNECTED,
+        MQTT_REFUSED,       // CONNACK with a non-zero return / reason code
+        MQTT_TIMEOUT,       // No CONNACK / PINGRESP in time
+        MQTT_LOST           // Transport closed, write failed or broker DISCONNECT
+    };
+
+    typedef unsigned long (*ClockFn)();
+    typedef void (*MessageFn)(void* context, char* topic, uint8_t* payload, size_t len);
+
+    struct Stats {
+        uint32_t published;         // QoS 1 messages accepted into the window
+        uint32_t acked;             // PUBACKs received
+        uint32_t resent;            // Resent with DUP after a reconnect
+        uint32_t qos0;              // QoS 0 messages written
+        uint32_t received;          // Inbound PUBLISH
+        uint32_t dropped;           // Inbound packets too large for the rx buffer
+        uint32_t pings;             // PINGREQ sent
+        uint32_t rejected;          // MQTT 5 PUBACK with a failure reason code
+        unsigned long lastAckAt;    // millis() of the last PUBACK (0 = none)
+        uint32_t lastAckMs;         // PUBLISH -> PUBACK of the last ack
+        uint32_t maxAckMs;
+        uint32_t lastPingMs;        // PINGREQ -> PINGRESP
+    };
+
+    MqttClient();
+
+    // Buffers stay owned by the caller. `window` is capped at MQTT_INFLIGHT_MAX.
+    void begin(MqttTransport* transport, ClockFn clock,
+               uint8_t* rxBuffer, size_t rxSize,
+               uint8_t* arena, size_t arenaSize, uint8_t window);
+
+    void setMessageHandler(MessageFn handler, void* context);
+
+    // 4 = MQTT 3.1.1 (default), 5 = MQTT 5; used from the next connect()
+    void setProtocol(uint8_t level);
+    uint8_t getProtocol() const { return protocol; }
+
+    // MQTT 5 only. Session Expiry sent with cleanSession=false (the broker
+    // drops a persistent v5 session at disconnect without it), Message
+    // Expiry and one User Property on every PUBLISH (0 / nullptr = none).
+    void setSessionExpiry(uint32_t seconds) { sessionExpiryS = seconds; }
+    void setMessageExpiry(uint32_t seconds) { messageExpiryS = seconds; }
+    bool setUserProperty(const char* key, const char* value);
+
+    // Send CONNECT over an already open transport; poll() collects CONNACK
+    bool connect(const char* clientId, uint16_t keepAliveS, bool cleanSession, uint32_t timeoutMs);
+
+    // Read / handle whatever arrived, keepalive, timeouts
+    void poll();
+
+    // Clean DISCONNECT; in-flight messages stay for the next session
+    void disconnect();
+
+    // Forget the connection locally (no packet, link presumed dead)
+    void drop();
+
+    // PINGREQ now instead of on the keepalive schedule (liveness probe);
+    // a missing PINGRESP still times out after one keepalive
+    bool ping();
+
+    // Discard unacknowledged messages (new clean session)
+    void clearInflight();
+
+    State getState() const { return state; }
+    bool isConnected() const { return state == MQTT_CONNECTED; }
+    bool isSessionPresent() const { return sessionPresent; }
+    uint8_t getReturnCode() const { return returnCode; }
+
+    // Room in the window and arena for one more QoS 1 message
+    bool canPublish(size_t topicLen, size_t payloadLen) const;
+
+    // QoS 0 is written straight out; QoS 1 goes through the window
+    bool publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos, bool retained);
+
+    bool subscribe(const char* topic, uint8_t qos);
+
+    // millis() of the last packet from the broker, of any type
+    unsigned long getLastInboundAt() const { return lastInAt; }
+
+    // How long the oldest unacknowledged QoS 1 message has waited (0 = none)
+    uint32_t getAckWaitMs() const;
+
+    // Aliases the broker accepts on this connection (0 = 3.1.1 / none)
+    uint8_t getTopicAliasLimit() const { return aliasLimit; }
+
+    uint8_t getInflightCount() const { return inflightCount; }
+    size_t getInflightBytes() const { return arenaUsed; }
+    uint8_t getWindow() const { return window; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Inflight {
+        uint16_t packetId;
+        bool acked;
+        uint32_t offset;        // Packet bytes in the arena
+        uint32_t length;
+        unsigned long sentAt;
+        uint8_t alias;          // Topic alias in the packet (0 = none)
+        bool aliasOnly;         // Packet has an empty topic, only the alias
+    };
+
+    enum RxState {
+        RX_HEADER,
+        RX_LENGTH,
+        RX_BODY
+    };
+
+    MqttTransport* transport;
+    ClockFn clock;
+
+    uint8_t* rxBuffer;
+    size_t rxSize;
+    uint8_t* arena;
+    size_t arenaSize;
+    size_t arenaUsed;
+    uint8_t window;
+    uint8_t receiveMax;         // Broker's Receive Maximum (caps the window)
+
+    uint8_t protocol;
+    uint32_t sessionExpiryS;
+    uint32_t messageExpiryS;
+    char userProperty[MQTT_USER_PROPERTY_MAX];     // Key bytes, then value bytes
+    uint8_t userKeyLen;
+    uint8_t userValueLen;
+
+    // Topic aliases: ours survive reconnects, which ones the broker knows
+    // is per connection
+    char aliasTopics[MQTT_TOPIC_ALIAS_MAX][MQTT_TOPIC_ALIAS_LEN + 1];
+    uint8_t aliasCount;
+    uint8_t aliasLimit;
+    uint16_t aliasSent;         // Bit per alias sent with its topic on this connection
+
+    Inflight inflight[MQTT_INFLIGHT_MAX];
+    uint8_t inflightHead;
+    uint8_t inflightCount;
+    uint16_t nextPacketId;
+
+    State state;
+    bool sessionPresent;
+    uint8_t returnCode;
+    uint32_t keepAliveMs;
+    uint32_t connectTimeoutMs;
+    unsigned long connectStartedAt;
+    unsigned long lastInAt;
+    unsigned long lastOutAt;
+    unsigned long pingSentAt;
+    bool pingOutstanding;
+
+    // Incremental packet parser
+    RxState rxState;
+    uint8_t rxHeader;
+    uint32_t rxRemaining;
+    uint32_t rxLength;
+    uint32_t rxMultiplier;
+    bool rxSkip;
+
+    MessageFn messageHandler;
+    void* messageContext;
+
+    Stats stats;
+
+    // Helpers
+    unsigned long now() const { return clock ? clock() : 0; }
+    bool sendPacket(const uint8_t* data, size_t len);
+    static size_t encodeLength(uint8_t* out, uint32_t length);
+    size_t propertiesSize() const;
+    size_t packetSize(size_t topicLen, size_t payloadLen, uint8_t qos) const;
+    size_t buildPublish(uint8_t* out, const char* topic, size_t topicLen,
+                        const uint8_t* payload, size_t len, uint8_t qos, bool retained,
+                        uint16_t packetId, uint8_t alias);
+    uint8_t aliasFor(const char* topic, size_t topicLen, bool& known);
+    bool resendExpanded(const Inflight& entry);
+    uint16_t allocatePacketId();
+    Inflight& slot(uint8_t index) { return inflight[(inflightHead + index) % MQTT_INFLIGHT_MAX]; }
+    void releaseAcked();
+    void resendInflight();
+    void lose(State reason);
+
+    bool readPacket();
+    void handlePacket();
+    void handleConnack();
+    void handlePublish();
+    void handleAck(uint16_t packetId);
+};
+
+#endif // MQTT_CLIENT_H
@@ -3,63 +3,185 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <Client.h>
-
-// MQTT_MAX_PACKET_SIZE and MQTT_SOCKET_TIMEOUT are now set via platformio.ini build_flags
-// This ensures the library is compiled with the correct limits from the start
-
-#include <PubSubClient.h>
+#include "config.h"
+#include "async_gsm_client.h"
+#include "mqtt_client.h"
+#include "storage_engine.h"
+#include "data_budget.h"
+
+#if MQTT_USE_MODEM_STACK
+#include "cmqtt_client.h"
+typedef CmqttClient MqttSession;
+#else
+typedef MqttClient MqttSession;
+#if MQTT_TLS_ENABLED
+#include "tls_transport.h"
+#endif
+#endif
+
+// MQTT_MAX_PACKET_SIZE is set via platformio.ini build_flags (rx buffer size)
 
 // ============================================================================
-// MQTT MANAGER - TinyGSM + PubSubClient wrapper
+// MQTT MANAGER - TinyGSM + MqttClient wrapper
 // ============================================================================
+// QoS 1 publishes go into MqttClient's in-flight window and are confirmed by
+// PUBACK in the background. When the window is full or the session is down
+// they spill into the outbox (the offline queue) and loop() feeds them back
+// into the window, oldest first, once there is room again.
+//
+// With MQTT_USE_MODEM_STACK the session runs in the SIM7600 (CmqttClient)
+// instead of over a TinyGSM socket; everything above it stays the same.
+//
+// MQTT_TLS_ENABLED puts TLS under the session: TlsTransport between
+// MqttClient and the socket (handshake in pollConnect(), resumed from the
+// cached session where the broker allows), or the modem's SSL engine.
+
+#define MQTT_MAX_SUBSCRIPTIONS  4       // Topics re-subscribed when the broker lost the session
 
 class MQTTManager {
 public:
-    explicit MQTTManager(Client& networkClient);
-
-    // Initialize MQTT client
+    enum ConnectResult {
+        CONNECT_IDLE,
+        CONNECT_PENDING,
+        CONNECT_OK,
+        CONNECT_FAILED
+    };
+
+#if MQTT_USE_MODEM_STACK
+    explicit MQTTManager(ModemAt& modemAt);
+#else
+    explicit MQTTManager(AsyncGsmClient& networkClient);
+#endif
+
+    // Initialize MQTT client (allocates rx buffer + in-flight arena)
     bool begin(const char* broker, uint16_t port, const char* clientId);
 
-    // Connect / disconnect
-    bool connect();
+    // Connect: socket open (or the modem's connect steps), CONNECT and
+    // CONNACK all advance from pollConnect()
+    bool startConnect();
+    ConnectResult pollConnect();
+
+    // Disconnect cleanly / drop a session whose link is presumed dead
     bool disconnect();
+    void drop();
 
     // Status helpers
     bool isConnected();
 
-    // Publish helpers
-    bool publish(const char* topic, const char* payload, bool retained = false);
-    bool publish(const char* topic, JsonDocument& doc, bool retained = false);
+    // Where QoS 1 messages go when the window cannot take them (nullptr = drop)
+    void setOutbox(StorageEngine* outbox);
+
+    // Bytes per topic / transport are counted here (nullptr = not counted)
+    void setDataBudget(DataBudget* budget);
+
+    // Paused: the outbox is kept for later and new messages skip past it
+    void setReplayPaused(bool paused) { replayPaused = paused; }
+    bool isReplayPaused() const { return replayPaused; }
+
+    // Publish helpers. QoS 1 returns true once the message is in the window
+    // or the outbox; false only if it was dropped.
+    bool publish(const char* topic, const char* payload, bool retained = false, uint8_t qos = MQTT_QOS);
+    bool publish(const char* topic, JsonDocument& doc, bool retained = false, uint8_t qos = MQTT_QOS);
+
+    // Connected, nothing waiting in the outbox and a free window slot
+    bool canPublish(size_t payloadLen = 0);
 
     // Subscriptions
     bool subscribe(const char* topic);
     void setCallback(void (*callback)(char*, uint8_t*, unsigned int));
 
-    // Keepalive
+    // Keepalive, PUBACKs, inbound messages, outbox drain
     void loop();
 
     // Stats
     unsigned long getPublishCount() const { return publishCount; }
     unsigned long getFailedCount() const { return failedCount; }
+    unsigned long getSpilledCount() const { return spilledCount; }
+
+    // millis() of the last PUBACK or QoS 0 write (0 = none yet)
+    unsigned long getLastDeliveryAt() const;
+
+    // Liveness from the session itself: PINGREQ, plus a QoS 0 message to
+    // our own echo topic when MQTT_ECHO_ENABLED. Any answer moves
+    // getLastInboundAt(); ConnectionManager times out the check.
+    void startLivenessCheck();
+    unsigned long getLastInboundAt() const { return mqtt.getLastInboundAt(); }
+    uint32_t getAckWaitMs() const { return mqtt.getAckWaitMs(); }
+    uint32_t getLastPingMs() const { return mqtt.getStats().lastPingMs; }
+    uint32_t getLastEchoMs() const { return lastEchoMs; }
+
+    const MqttSession& getClient() const { return mqtt; }
 
     // Diagnostics
     void printStatus();
 
 private:
-    Client& networkClient;
-    PubSubClient mqttClient;
+#if MQTT_USE_MODEM_STACK
+    MqttSession mqtt;
+#else
+    // MqttClient bytes over the modem socket, counted into the data budget
+    class Transport : public MqttTransport {
+    public:
+        explicit Transport(AsyncGsmClient& client) : budget(nullptr), client(client) {}
+
+        bool connected() override { return client.connected(); }
+        int available() override { return client.available(); }
+        int read(uint8_t* buf, size_t len) override;
+        size_t write(const uint8_t* buf, size_t len) override;
+
+        DataBudget* budget;
+
+    private:
+        AsyncGsmClient& client;
+    };
+
+    AsyncGsmClient& networkClient;
+    Transport transport;
+#if MQTT_TLS_ENABLED
+    TlsTransport tls;
+    bool tlsPending;            // Socket open, handshake running
+    bool beginTls();
+#endif
+    MqttSession mqtt;
+#endif
 
     String brokerHost;
     uint16_t brokerPort;
     String clientId;
+    String telemetryTopic;      // Topic of outbox records queued before the topic was stored
+    String echoTopic;
+    bool echoSubscribed;
+    unsigned long echoSentAt;   // Also the echo payload; 0 = none outstanding
+    uint32_t lastEchoMs;
+
+    uint8_t* rxBuffer;
+    uint8_t* arena;
+    StorageEngine* outbox;
+    uint8_t* outboxBuffer;      // One outbox record, built or read back
+    DataBudget* dataBudget;
+    bool replayPaused;
+
+    String subscriptions[MQTT_MAX_SUBSCRIPTIONS];
+    uint8_t subscriptionCount;
+    void (*messageCallback)(char*, uint8_t*, unsigned int);
 
     bool connected;
+    bool connecting;
+    bool socketOpen;
     unsigned long publishCount;
     unsigned long failedCount;
-
-    bool reconnect();
+    unsigned long spilledCount;
+    unsigned long lastQos0At;
+
+    bool outboxEmpty();
+    bool spill(const char* topic, const char* payload, size_t len, bool retained);
+    void drainOutbox();
+    void publishRecord(const uint8_t* record, size_t len);
+    void resubscribe();
+    void countTopic(const char* topic, DataDirection dir, size_t payloadLen);
     void logConnectionState(bool result);
+
+    static void onMessage(void* context, char* topic, uint8_t* payload, size_t len);
 };
 
 #endif // MQTT_MANAGER_H
@@ -0,0 +1,151 @@
+#ifndef QUEUE_BACKEND_H
+#define QUEUE_BACKEND_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "record_log.h"
+#include "slab_ring.h"
+
+// ============================================================================
+// QUEUE BACKEND - One place to keep offline records
+// ============================================================================
+// Common interface for the offline queue storage, so StorageEngine can fail
+// over between them at runtime and the host benchmark can drive them:
+//   FileQueueBackend   RecordLog in a directory (plain POSIX files on a host)
+//   SdQueueBackend / LittleFsQueueBackend (storage_manager.h) - same, plus
+//                      mounting the Arduino filesystem
+//   RamQueueBackend    SlabRing in PSRAM / internal RAM
+//
+// A backend that fails is unmounted; records it still held in RAM are
+// handed to a SalvageFn so they can be pushed to the next backend.
+
+class QueueBackend {
+public:
+    typedef RecordLog::SalvageFn SalvageFn;
+
+    virtual ~QueueBackend() {}
+
+    virtual const char* getName() const = 0;
+
+    // Survives a reboot
+    virtual bool isPersistent() const = 0;
+
+    // Attach the storage and run recovery. Called again to retry after a failure.
+    virtual bool mount() = 0;
+
+    // Storage failed: hand records that never reached it to `salvage`, detach
+    virtual void unmount(SalvageFn salvage, void* context) = 0;
+
+    virtual bool isMounted() const = 0;
+
+    // Cheap check that the storage is still usable
+    virtual bool probe() = 0;
+
+    virtual bool push(const uint8_t* data, size_t len) = 0;
+
+    // Payload length of the oldest record, 0 if empty
+    virtual size_t peekLength() = 0;
+
+    // Oldest record in place, nullptr if empty or not supported
+    virtual const uint8_t* peek(size_t& len) { len = 0; return nullptr; }
+
+    // Copy out and remove the oldest record. On false, len > capacity means
+    // the record is larger than `buf` and still queued; otherwise retry later.
+    virtual bool pop(uint8_t* buf, size_t capacity, size_t& len) = 0;
+
+    // Remove the oldest record without reading it
+    virtual bool skip() = 0;
+
+    virtual uint32_t count() const = 0;
+    virtual bool clear() = 0;
+
+    // Age-based flush (main loop) / flush now
+    virtual void poll() {}
+    virtual void flush() {}
+};
+
+// ============================================================================
+// FILE BACKEND (RecordLog)
+// ============================================================================
+
+class FileQueueBackend : public QueueBackend {
+public:
+    struct Config {
+        const char* name;
+        const char* dir;
+        uint32_t segmentSize;
+        uint16_t maxSegments;
+        size_t blockSize;
+        size_t stagingSize;
+        uint32_t durabilityMs;
+        WriteCoalescer::ClockFn millisFn;
+        WriteCoalescer::ClockFn microsFn;
+    };
+
+    explicit FileQueueBackend(const Config& config);
+
+    const char* getName() const override { return config.name; }
+    bool isPersistent() const override { return true; }
+
+    bool mount() override;
+    void unmount(SalvageFn salvage, void* context) override;
+    bool isMounted() const override { return log.isOpen(); }
+    bool probe() override;
+
+    bool push(const uint8_t* data, size_t len) override;
+    size_t peekLength() override { return log.peekLength(); }
+    bool pop(uint8_t* buf, size_t capacity, size_t& len) override { return log.pop(buf, capacity, len); }
+    bool skip() override { return log.skip(); }
+    uint32_t count() const override { return log.isOpen() ? log.count() : 0; }
+    bool clear() override { return log.clear(); }
+
+    void poll() override { log.poll(); }
+    void flush() override { log.flush(); }
+
+    const RecordLog& getLog() const { return log; }
+
+protected:
+    // Make `dir` reachable: SD.begin(), LittleFS.begin(), nothing on a host
+    virtual bool mountFilesystem() { return true; }
+
+private:
+    Config config;
+    RecordLog log;
+    uint32_t sinkFailures;      // Writer failures at mount time
+};
+
+// ============================================================================
+// RAM BACKEND (SlabRing)
+// ============================================================================
+
+class RamQueueBackend : public QueueBackend {
+public:
+    // Arena of `psramBytes` when the module has PSRAM, else `internalBytes`
+    RamQueueBackend(size_t psramBytes, size_t internalBytes, size_t slabSize);
+
+    const char* getName() const override { return "RAM"; }
+    bool isPersistent() const override { return false; }
+
+    bool mount() override;
+    void unmount(SalvageFn salvage, void* context) override;
+    bool isMounted() const override { return ring.isReady(); }
+    bool probe() override { return ring.isReady(); }
+
+    bool push(const uint8_t* data, size_t len) override { return ring.push(data, len); }
+    size_t peekLength() override;
+    const uint8_t* peek(size_t& len) override { return ring.peek(len); }
+    bool pop(uint8_t* buf, size_t capacity, size_t& len) override;
+    bool skip() override { return ring.pop(); }
+    uint32_t count() const override { return ring.count(); }
+    bool clear() override { ring.clear(); return true; }
+
+    const SlabRing& getRing() const { return ring; }
+
+private:
+    size_t psramBytes;
+    size_t internalBytes;
+    size_t slabSize;
+    SlabRing ring;
+};
+
+#endif // QUEUE_BACKEND_H
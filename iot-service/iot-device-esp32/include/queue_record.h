@@ -0,0 +1,90 @@
+#ifndef QUEUE_RECORD_H
+#define QUEUE_RECORD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// QUEUE RECORD FRAMING - Length-prefixed, CRC-protected records
+// ============================================================================
+// On-disk layout of one record (little-endian, 12 byte header):
+//
+//   [0]     magic   0xA5
+//   [1]     flags   reserved, 0
+//   [2..3]  length  payload bytes
+//   [4..7]  seq     monotonically increasing record number
+//   [8..11] crc32   over length + seq + payload
+//   [12..]  payload (JSON, no terminator)
+//
+// A record whose header or CRC does not check out is a torn write (power
+// lost mid-append) or media corruption; readers never return it.
+
+#define QUEUE_RECORD_MAGIC        0xA5
+#define QUEUE_RECORD_HEADER_SIZE  12
+#define QUEUE_RECORD_MAX_PAYLOAD  8192    // Matches MQTT_MAX_PACKET_SIZE
+
+struct QueueRecordHeader {
+    uint8_t flags;
+    uint16_t length;
+    uint32_t seq;
+    uint32_t crc;
+};
+
+// Incremental CRC-32 (IEEE 802.3). Start with crc = 0.
+inline uint32_t queueCrc32(uint32_t crc, const uint8_t* data, size_t len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+// CRC of the header fields that precede the payload
+inline uint32_t queueRecordHeaderCrc(uint16_t length, uint32_t seq) {
+    uint8_t fields[6] = {
+        (uint8_t)(length & 0xFF), (uint8_t)(length >> 8),
+        (uint8_t)(seq & 0xFF), (uint8_t)(seq >> 8),
+        (uint8_t)(seq >> 16), (uint8_t)(seq >> 24)
+    };
+    return queueCrc32(0, fields, sizeof(fields));
+}
+
+inline void queueRecordEncodeHeader(uint8_t* out, uint16_t length, uint32_t seq,
+                                    const uint8_t* payload) {
+    uint32_t crc = queueCrc32(queueRecordHeaderCrc(length, seq), payload, length);
+    out[0] = QUEUE_RECORD_MAGIC;
+    out[1] = 0;
+    out[2] = length & 0xFF;
+    out[3] = length >> 8;
+    out[4] = seq & 0xFF;
+    out[5] = (seq >> 8) & 0xFF;
+    out[6] = (seq >> 16) & 0xFF;
+    out[7] = (seq >> 24) & 0xFF;
+    out[8] = crc & 0xFF;
+    out[9] = (crc >> 8) & 0xFF;
+    out[10] = (crc >> 16) & 0xFF;
+    out[11] = (crc >> 24) & 0xFF;
+}
+
+// Structural check only - the payload CRC still has to be verified
+inline bool queueRecordDecodeHeader(const uint8_t* in, QueueRecordHeader& header) {
+    if (in[0] != QUEUE_RECORD_MAGIC || in[1] != 0) {
+        return false;
+    }
+    header.flags = in[1];
+    header.length = (uint16_t)in[2] | ((uint16_t)in[3] << 8);
+    header.seq = (uint32_t)in[4] | ((uint32_t)in[5] << 8) |
+                 ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+    header.crc = (uint32_t)in[8] | ((uint32_t)in[9] << 8) |
+                 ((uint32_t)in[10] << 16) | ((uint32_t)in[11] << 24);
+    return header.length > 0 && header.length <= QUEUE_RECORD_MAX_PAYLOAD;
+}
+
+#endif // QUEUE_RECORD_H
@@ -0,0 +1,158 @@
+#ifndef RECORD_LOG_H
+#define RECORD_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "queue_record.h"
+#include "write_coalescer.h"
+
+// ============================================================================
+// RECORD LOG - Crash-consistent segmented FIFO on a mounted filesystem
+// ============================================================================
+// Replaces "JSON lines + rewrite the whole file to drop the first line".
+//
+// Layout under `dir` (VFS path, e.g. "/sd/queue" or "/littlefs/queue"):
+//   XXXXXXXX.seg   segment files, named by the seq of their first record
+//   cursor         read position, two CRC-protected slots written alternately
+//
+// - Appends only ever go to the tail segment (through a WriteCoalescer).
+//   Reads of tail bytes still staged are served from the staging buffer,
+//   so draining never forces a partial-block write.
+// - Dequeue advances the cursor; a fully consumed segment is deleted.
+//   Nothing is ever rewritten, so power loss cannot truncate the backlog.
+// - The cursor is written when a segment is deleted, when the log drains
+//   empty and otherwise after the durability window, not per record. A
+//   crash replays at most that window's dequeues (at-least-once anyway).
+// - begin() only scans the tail segment (bounded by segmentSize), truncates
+//   a torn record at its end and derives the queue length from sequence
+//   numbers - no need to read the whole backlog at boot.
+//
+// Uses POSIX stdio so the same code runs on ESP32 VFS mounts and on a host.
+
+#define RECORD_LOG_DIR_MAX  48
+#define RECORD_LOG_PATH_MAX (RECORD_LOG_DIR_MAX + 16)   // dir + "/XXXXXXXX.seg"
+
+class RecordLog {
+public:
+    // Receives payloads recovered from RAM by abandon()
+    typedef void (*SalvageFn)(void* context, const uint8_t* data, size_t len);
+
+    struct RecoveryInfo {
+        uint32_t segments;          // Segment files found
+        uint32_t scannedBytes;      // Bytes read from the tail segment
+        uint32_t truncatedBytes;    // Torn bytes cut from the tail
+        uint32_t orphansRemoved;    // Segments already consumed before reset
+        uint32_t recoveryMicros;    // Time spent in begin()
+        bool cursorValid;           // Cursor file was readable
+    };
+
+    RecordLog();
+    ~RecordLog();
+
+    // Mount the log in `dir` (created if missing) and run recovery
+    bool begin(const char* dir, uint32_t segmentSize, uint16_t maxSegments,
+               size_t blockSize, size_t stagingSize, uint32_t durabilityMs,
+               WriteCoalescer::ClockFn millisFn, WriteCoalescer::ClockFn microsFn = nullptr);
+    void end();
+    bool isOpen() const { return open; }
+
+    // Append one record (staged, see WriteCoalescer). On failure nothing of
+    // the record stays staged.
+    bool append(const uint8_t* data, size_t len);
+
+    // Payload length of the oldest record, 0 if empty
+    size_t peekLength();
+
+    // Copy the oldest record into `buf` and remove it from the log. False
+    // with length = 0: empty, or a read error (nothing consumed, retry
+    // later). False with length > capacity: the record needs that much.
+    bool pop(uint8_t* buf, size_t capacity, size_t& length);
+
+    // Remove the oldest record without reading its payload
+    bool skip();
+
+    // Number of records not yet dequeued
+    uint32_t count() const { return nextSeq - readSeq; }
+
+    // Remove all records
+    bool clear();
+
+    // The filesystem is gone (card pulled, I/O errors): hand every record
+    // that did not reach the file whole to `salvage`, close without writing.
+    // Records already on disk stay there for the next begin().
+    uint32_t abandon(SalvageFn salvage, void* context);
+
+    // Age-based flush of appends and cursor (call in main loop) / flush now
+    void poll();
+    void flush();
+
+    const WriteCoalescer& getWriter() const { return writer; }
+    const RecoveryInfo& getRecoveryInfo() const { return recovery; }
+    uint32_t getDroppedRecords() const { return droppedRecords; }
+    uint32_t getCorruptRecords() const { return corruptRecords; }
+    uint32_t getReadErrors() const { return readErrors; }
+    uint32_t getBytesOnDisk() const { return bytesOnDisk; }
+
+private:
+    bool open;
+    char dir[RECORD_LOG_DIR_MAX];
+    uint32_t segmentSize;
+    uint16_t maxSegments;
+    uint16_t segmentCount;
+
+    // Tail (append side)
+    uint32_t tailSegment;           // First seq of the tail segment
+    uint32_t tailSize;              // Bytes in tail segment incl. staged
+    uint32_t nextSeq;               // Seq of the next appended record
+
+    // Head (read side)
+    uint32_t headSegment;           // First seq of the segment being read
+    uint32_t readOffset;            // Byte offset of the next record in it
+    uint32_t readSeq;               // Seq of the next record to read
+    uint8_t cursorSlot;             // Slot to write next
+    bool cursorDirty;               // Moved since the last saveCursor()
+    unsigned long cursorMovedAt;    // millis() of the first unsaved move
+    WriteCoalescer::ClockFn millisFn;
+
+    uint32_t bytesOnDisk;
+    uint32_t droppedRecords;
+    uint32_t corruptRecords;
+    uint32_t readErrors;            // Failed fopen / fread, retried later
+
+    WriteCoalescer writer;
+    RecoveryInfo recovery;
+
+    // Helpers: paths
+    void segmentPath(uint32_t firstSeq, char* out) const;
+    void cursorPath(char* out) const;
+
+    // Helpers: segment directory
+    bool listSegments(uint32_t& first, uint32_t& last, uint16_t& count);
+    bool findNextSegment(uint32_t after, uint32_t& next, bool* listed = nullptr);
+    void removeSegment(uint32_t firstSeq);
+    bool rollSegment();
+    void dropOldestSegment();
+
+    // Helpers: recovery
+    bool scanTail();
+    bool loadCursor();
+    bool saveCursor();
+    void cursorMoved();
+
+    // Helpers: reading. Only READ_CORRUPT (bad framing, CRC mismatch) may
+    // move the cursor past data; READ_IO_ERROR leaves everything in place.
+    enum ReadResult {
+        READ_OK,
+        READ_EMPTY,
+        READ_CORRUPT,
+        READ_IO_ERROR
+    };
+    ReadResult advanceToReadableRecord(QueueRecordHeader& header);
+    bool readSegment(uint32_t firstSeq, uint32_t offset, uint8_t* out, size_t len);
+    ReadResult readRecordAt(uint32_t firstSeq, uint32_t offset, const QueueRecordHeader& header,
+                            uint8_t* payload);
+
+    static size_t appendToTail(void* context, const uint8_t* data, size_t len);
+};
+
+#endif // RECORD_LOG_H
@@ -4,18 +4,43 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <vector>
+#include <mutex>
+#include <atomic>
+
+#define RS485_KEY_LEN           32      // Telemetry key incl. terminator (longer labels are cut)
+#define RS485_TYPE_LEN          32      // device_type incl. terminator
 
 // ============================
 // RS485 Register Configuration
 // ============================
+// Only what the device reads and reports: unit, category, scale and
+// description stay on the server and are filtered out while parsing.
+enum RS485RegisterType : uint8_t {
+    RS485_UINT16,
+    RS485_INT16,
+    RS485_UINT32,
+    RS485_INT32,
+    RS485_FLOAT32,
+    RS485_HEX16,
+    RS485_TYPE_UNKNOWN
+};
+
 struct RS485Register {
-    uint16_t reg;           // Register address
-    String type;            // "float32", "uint32", "uint16", "int16", "hex16"
-    String label;           // Human-readable label
-    String unit;            // Unit of measurement
-    uint8_t words;          // Number of Modbus words (1 or 2)
-    bool swap;              // Byte swap for multi-word values
-    String category;        // "sensor_data", "system_status", "configuration", etc.
+    uint16_t reg;               // Register address
+    uint8_t type;               // RS485RegisterType
+    uint8_t words;              // Number of Modbus words (1 or 2)
+    bool swap;                  // Byte swap for multi-word values
+    char key[RS485_KEY_LEN];    // Label as telemetry key ("Flow Rate" -> "flow_rate")
+};
+
+// Registers of one device, from the JSON map or a built-in profile
+struct RS485RegisterRange {
+    const RS485Register* first;
+    size_t count;
+
+    const RS485Register* begin() const { return first; }
+    const RS485Register* end() const { return first + count; }
+    size_t size() const { return count; }
 };
 
 // ============================
@@ -23,15 +48,29 @@ struct RS485Register {
 // ============================
 struct RS485DeviceConfig {
     uint8_t modbus_address;     // 1-10
-    String device_type;         // "TUF-2000M", "Generic", etc.
+    char device_type[RS485_TYPE_LEN]; // "TUF-2000M", "Generic", etc.
     uint32_t baud_rate;         // 9600, 19200, etc.
-    String description;
     uint16_t version;
-    std::vector<RS485Register> registers;
+    std::vector<RS485Register> registers;       // Custom map sent as JSON
+    const RS485Register* profileRegisters;      // Built-in profile in flash (registers empty)
+    uint8_t profileRegisterCount;
     
-    // Runtime status
+    // Runtime status (follows the address across config updates)
     bool is_online;             // Device responding?
     unsigned long last_seen;    // Last successful read (millis)
+
+    RS485RegisterRange getRegisters() const {
+        return profileRegisters ? RS485RegisterRange{ profileRegisters, profileRegisterCount }
+                                : RS485RegisterRange{ registers.data(), registers.size() };
+    }
+};
+
+// Heap used by the last parseConfig(); logged on every config applied
+struct RS485ParseStats {
+    uint32_t jsonBytes;         // Payload
+    uint32_t docPeakBytes;      // Filtered JsonDocument, high-water mark
+    uint32_t configBytes;       // Resulting devices + registers
+    uint16_t registers;
 };
 
 // ============================
@@ -41,13 +80,31 @@ class RS485ConfigManager {
 public:
     RS485ConfigManager();
     
-    // Config Management (RAM only)
-    bool parseConfig(const String& jsonPayload);
+    // Config Management; parses straight from the MQTT rx buffer.
+    // A full config (array/object) or a delta ({"delta":[ops],"hash":".."})
+    // builds the next plan next to the running one; commitStaged() swaps it
+    // in between acquisition cycles. Nothing is staged when any part fails.
+    // The comms task stages, the acquisition task commits and is the only
+    // one to touch the running plan otherwise.
+    bool parseConfig(const uint8_t* json, size_t length);
+    bool hasStaged() const { return stagedPending; }
+    void commitStaged();
     void clearConfig();
     bool hasConfig() const { return !devices.empty(); }
+
+    // Config Cache (LittleFS): the running plan as compact JSON plus the
+    // server's hash of the config it came from, applied at boot and
+    // revalidated in the get_config request. loadCache() also sets the
+    // file commitStaged() writes.
+    bool loadCache(const char* path);
+    bool saveCache();
+    void clearCache();
+    bool hasConfigHash() const { return configHashValid; }
+    uint32_t getConfigHash() const { return configHash; }
     
     // Device Management
     const std::vector<RS485DeviceConfig>& getDevices() const { return devices; }
+    const RS485ParseStats& getParseStats() const { return parseStats; }
     RS485DeviceConfig* getDevice(uint8_t address);
     
     // Device Scanner
@@ -60,10 +117,23 @@ public:
     
 private:
     std::vector<RS485DeviceConfig> devices;
+    std::vector<RS485DeviceConfig> staged;      // Next plan, until commitStaged()
+    std::atomic<bool> stagedPending;
+    bool stagedFromCache;       // Already on flash, no need to write it back
+    uint32_t stagedHash;
+    bool stagedHashValid;
+    char cachePath[40];
+    uint32_t configHash;        // Server's CRC-32 of the full config JSON
+    bool configHashValid;
+    std::mutex planLock;        // staged*, the plan swap, status updates
+    RS485ParseStats parseStats;
     
     // Helpers
     bool parseDeviceObject(JsonObject deviceObj, RS485DeviceConfig& device);
+    bool applyProfile(JsonObject deviceObj, const char* profileName, RS485DeviceConfig& device);
     bool parseRegister(JsonObject regObj, RS485Register& reg);
+    bool applyDelta(JsonArray ops, std::vector<RS485DeviceConfig>& plan);
+    void stage(std::vector<RS485DeviceConfig>& plan, uint32_t hash, bool hashValid);
     bool testDevice(uint8_t address);
 };
 
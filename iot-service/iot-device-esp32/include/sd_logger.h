@@ -4,14 +4,14 @@
 #include <Arduino.h>
 #include <SD.h>
 #include <FS.h>
-#include <ArduinoJson.h>
+#include "write_coalescer.h"
 
 // ============================================================================
 // SD CARD LOGGER
 // ============================================================================
-// Handles offline data storage when MQTT connection is lost
+// Device log on the SD card. The offline telemetry queue lives in
+// StorageManager (SD / LittleFS / RAM with failover).
 
-#define QUEUE_FILE "/offline_queue.jsonl"  // JSON Lines format
 #define LOG_FILE "/device_log.txt"
 
 class SDLogger {
@@ -24,18 +24,6 @@ public:
     // Check if SD card is available
     bool isAvailable() { return initialized; }
 
-    // Queue telemetry data when offline
-    bool queueTelemetry(JsonDocument& doc);
-
-    // Get number of queued records
-    uint16_t getQueueSize();
-
-    // Read and remove oldest queued record
-    bool dequeueOldest(JsonDocument& doc);
-
-    // Clear all queued records
-    bool clearQueue();
-
     // Log text message to file
     bool logMessage(const char* message);
 
@@ -45,17 +33,26 @@ public:
     // Print SD card info
     void printInfo();
 
+    // Age-based flush of staged log lines (call in main loop)
+    void loop();
+
+    // Write everything staged to the card now
+    void flush();
+
+    // Write coalescing counters
+    const WriteCoalescer& getLogWriter() const { return logWriter; }
+
 private:
     bool initialized;
 
-    // Helper: count lines in file
-    uint16_t countLines(const char* filename);
+    // RAM staging in front of the log file
+    WriteCoalescer logWriter;
 
-    // Helper: read specific line from file
-    bool readLine(const char* filename, uint16_t lineNumber, String& output);
+    // Helper: WriteCoalescer sink - context is the file path
+    static size_t appendToFile(void* context, const uint8_t* data, size_t len);
 
-    // Helper: remove first line from file
-    bool removeFirstLine(const char* filename);
+    // Helper: current file size (0 if missing)
+    uint32_t fileSize(const char* filename);
 };
 
 #endif // SD_LOGGER_H
@@ -0,0 +1,82 @@
+#ifndef SLAB_RING_H
+#define SLAB_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// SLAB RING - Allocation-free FIFO of variable-size records
+// ============================================================================
+// One arena allocated at begin() (PSRAM when the module has it), split into
+// fixed-size slabs. A record takes one or more consecutive slabs and is never
+// split across the end of the arena - if it does not fit before the end, the
+// remaining slabs are padded and the record starts at slab 0. Every record
+// is therefore contiguous and can be read in place (peek) or serialized
+// straight into the arena (reserve / commit).
+//
+// When full, the oldest records are dropped to make room.
+
+#define SLAB_RECORD_HEADER_SIZE 4
+
+class SlabRing {
+public:
+    SlabRing();
+    ~SlabRing();
+
+    // Allocate `bytes` of arena. preferPsram: use external RAM if present.
+    bool begin(size_t bytes, size_t slabSize, bool preferPsram = true);
+    void end();
+    bool isReady() const { return arena != nullptr; }
+    bool isInPsram() const { return inPsram; }
+
+    // Copy one record in
+    bool push(const uint8_t* data, size_t len);
+
+    // Zero-copy write: get `len` writable bytes, fill them, then commit the
+    // actual length (<= reserved). Only one reservation at a time.
+    uint8_t* reserve(size_t len);
+    bool commit(size_t len);
+
+    // Oldest record in place (nullptr if empty). Valid until the next push/pop.
+    const uint8_t* peek(size_t& len);
+
+    // Remove the oldest record
+    bool pop();
+
+    void clear();
+
+    uint32_t count() const { return records; }
+    size_t capacityBytes() const { return slabCount * slabSize; }
+    size_t usedBytes() const { return usedSlabs * slabSize; }
+    size_t maxRecordSize() const;
+    uint32_t getDroppedRecords() const { return droppedRecords; }
+    uint32_t getHighWaterRecords() const { return highWaterRecords; }
+
+private:
+    uint8_t* arena;
+    bool inPsram;
+    size_t slabSize;
+    size_t slabCount;
+
+    size_t head;            // Slab of the oldest record
+    size_t tail;            // Next free slab
+    size_t usedSlabs;       // Including end-of-arena padding
+    uint32_t records;
+
+    size_t reservedSlabs;   // Pending reservation (0 = none)
+
+    uint32_t droppedRecords;
+    uint32_t highWaterRecords;
+
+    size_t slabsFor(size_t len) const;
+    uint8_t* slabAt(size_t index) const { return arena + index * slabSize; }
+
+    // Make `slabs` contiguous slabs available at tail (may pad + wrap)
+    bool makeRoom(size_t slabs);
+
+    // Skip a padding marker at head, if any
+    void skipPadding();
+    void dropOldest();
+};
+
+#endif // SLAB_RING_H
@@ -0,0 +1,72 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// ============================================================================
+// SPSC RING - Lock-free FIFO between exactly one producer and one consumer
+// ============================================================================
+// N fixed slots, filled in place by the producer (reserve / publish) and read
+// in place by the consumer (peek / release). `head` is only written by the
+// producer and `tail` only by the consumer, so one release store and one
+// acquire load per side are the whole synchronisation - also between the two
+// ESP32-S3 cores. Neither side ever blocks or takes a lock.
+//
+// When full, reserve() fails and the producer drops its newest item: the
+// slot the consumer may be reading is never overwritten.
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    SpscRing() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        dropped.store(0, std::memory_order_relaxed);
+    }
+
+    // Producer: free slot to fill (nullptr when full), then publish() it
+    T* reserve() {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= N) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &slots[h & (N - 1)];
+    }
+
+    void publish() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: oldest item in place (nullptr when empty), then release() it
+    const T* peek() const {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[t & (N - 1)];
+    }
+
+    void release() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Either side; a snapshot, the other side may have moved on
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    static constexpr size_t capacity() { return N; }
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    T slots[N];
+    std::atomic<uint32_t> head;     // Next slot to publish (producer)
+    std::atomic<uint32_t> tail;     // Next slot to release (consumer)
+    std::atomic<uint32_t> dropped;  // reserve() calls that found the ring full
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,109 @@
+#ifndef STORAGE_ENGINE_H
+#define STORAGE_ENGINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "queue_backend.h"
+
+// ============================================================================
+// STORAGE ENGINE - Offline queue over prioritized backends with live failover
+// ============================================================================
+// Backends are added highest priority first (SD, LittleFS, RAM). Writes go
+// to the highest-priority backend that works:
+// - A failed push or probe unmounts that backend; records it still held in
+//   RAM staging are pushed to the next one, then the write is retried there.
+// - Every `retryMs` higher-priority backends are remounted. When one comes
+//   back the records that piled up in lower backends are moved into it, a
+//   few per poll() so the main loop is never stalled. Writes keep going to
+//   the lower backend until it is drained, so records stay in FIFO order;
+//   then the recovered backend becomes active.
+// - Reads take the highest-priority backend that has records, so the oldest
+//   records (written before the failure) go out first.
+
+#define STORAGE_ENGINE_MAX_BACKENDS   4
+#define STORAGE_ENGINE_MIGRATE_BATCH  16    // Records moved per poll()
+#define STORAGE_ENGINE_PROBE_MS       1000  // Health probe of the active backend
+
+class StorageEngine {
+public:
+    typedef unsigned long (*ClockFn)();
+
+    struct Stats {
+        uint32_t failovers;         // Active backend lost
+        uint32_t recoveries;        // Higher-priority backend back in use
+        uint32_t salvagedRecords;   // Staged records moved off a failed backend
+        uint32_t migratedRecords;   // Records moved up after a recovery
+        uint32_t lostRecords;       // Salvaged / migrated records nobody could take
+    };
+
+    StorageEngine();
+
+    // Highest priority first. Backends must outlive the engine.
+    bool addBackend(QueueBackend* backend);
+
+    // Mount every backend. `scratch` holds one record while it is moved
+    // between backends that cannot be read in place.
+    bool begin(uint32_t retryMs, ClockFn millisFn, uint8_t* scratch, size_t scratchSize);
+
+    bool push(const uint8_t* data, size_t len);
+
+    size_t peekLength();
+    const uint8_t* peek(size_t& len);
+    bool pop(uint8_t* buf, size_t capacity, size_t& len);
+    bool skip();
+
+    uint32_t count() const;
+    bool clear();
+
+    // Backend flushes, health probe, remount + migration (call in main loop)
+    void poll();
+    void flush();
+
+    QueueBackend* getActive() const { return active >= 0 ? backends[active] : nullptr; }
+    int8_t getActiveIndex() const { return active; }
+    QueueBackend* getBackend(uint8_t index) const { return index < backendCount ? backends[index] : nullptr; }
+    uint8_t getBackendCount() const { return backendCount; }
+
+    // A recovered backend is taking over, or lower backends still hold records
+    bool isMigrating() const;
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    QueueBackend* backends[STORAGE_ENGINE_MAX_BACKENDS];
+    uint8_t backendCount;
+    int8_t active;
+    int8_t recovered;           // Remounted backend waiting for migration, -1 if none
+
+    uint32_t retryMs;
+    ClockFn millisFn;
+    unsigned long lastRetry;
+    unsigned long lastProbe;
+
+    uint8_t* scratch;
+    size_t scratchSize;
+
+    QueueBackend* salvageTarget;
+    Stats stats;
+
+    // Unmount backend `index`, salvage into the next one, make it active
+    // if it was the write target
+    void failover(uint8_t index);
+
+    // Remount higher-priority backends
+    void retryMounts();
+
+    // Move records from lower backends into the recovered one
+    void migrateStep();
+
+    // Backend records are migrated into / taken from (-1 if none)
+    int8_t migrationTarget() const { return recovered >= 0 ? recovered : active; }
+    int8_t migrationSource() const;
+
+    // Highest-priority mounted backend holding records
+    QueueBackend* readBackend() const;
+
+    static void salvageInto(void* context, const uint8_t* data, size_t len);
+};
+
+#endif // STORAGE_ENGINE_H
@@ -6,18 +6,30 @@
 #include <SD.h>
 #include <FS.h>
 #include <LittleFS.h>
+#include "storage_engine.h"
+#include "config.h"
 
 // ============================================================================
 // STORAGE MANAGER - Unified Storage with Fallback
 // ============================================================================
-// Provides automatic fallback:
+// Offline telemetry queue over a StorageEngine with three backends, in
+// priority order:
 // 1. SD Card (primary, large capacity)
 // 2. LittleFS (fallback, ESP32 internal flash ~4MB)
 // 3. RAM buffer (last resort, lost on restart)
+//
+// Failover is live: if the SD card disappears, records move to LittleFS
+// (including those still staged in RAM), and back to SD once it remounts.
+// File queues are CRC-framed segmented logs (see record_log.h), accessed
+// through the VFS mount points of the Arduino SD / LittleFS drivers.
 
+#define SD_QUEUE_DIR SD_MOUNT_POINT "/queue"
+#define LITTLEFS_QUEUE_DIR LITTLEFS_MOUNT_POINT "/queue"
+
+// Pre-framing JSON Lines queues, imported once at boot then removed
 #define SD_QUEUE_FILE "/sd_queue.jsonl"
 #define LITTLEFS_QUEUE_FILE "/lfs_queue.jsonl"
-#define MAX_RAM_QUEUE_SIZE 10  // Max records in RAM
+#define SD_LOGGER_QUEUE_FILE "/offline_queue.jsonl"   // Old SDLogger queue
 
 enum StorageType {
     STORAGE_SD_CARD,
@@ -26,18 +38,47 @@ enum StorageType {
     STORAGE_NONE
 };
 
+// ============================================================================
+// ARDUINO FILESYSTEM BACKENDS
+// ============================================================================
+
+class SdQueueBackend : public FileQueueBackend {
+public:
+    explicit SdQueueBackend(const Config& config) : FileQueueBackend(config) {}
+
+protected:
+    // Mount the card on the board's SPI pins, reusing a live mount
+    bool mountFilesystem() override;
+};
+
+class LittleFsQueueBackend : public FileQueueBackend {
+public:
+    explicit LittleFsQueueBackend(const Config& config) : FileQueueBackend(config) {}
+
+protected:
+    bool mountFilesystem() override;
+};
+
+// ============================================================================
+// STORAGE MANAGER
+// ============================================================================
+
 class StorageManager {
 public:
     StorageManager();
 
-    // Initialize storage (tries SD first, then LittleFS)
+    // Initialize storage (mounts every backend, SD first)
     bool begin();
 
     // Check if any storage is available
     bool isAvailable();
 
-    // Get current active storage type
-    StorageType getActiveStorage() { return activeStorage; }
+    // SD card for other users (history archive): same mount as the SD queue,
+    // on the configured SPI pins
+    bool mountSd();
+
+    // Get current active storage type (where new records go)
+    StorageType getActiveStorage();
 
     // Queue telemetry data when offline
     bool queueTelemetry(JsonDocument& doc);
@@ -60,46 +101,41 @@ public:
     // Get storage type name
     String getStorageTypeName();
 
-private:
-    bool sdAvailable;
-    bool littlefsAvailable;
-    StorageType activeStorage;
-
-    // RAM queue (fallback when no filesystem available)
-    String ramQueue[MAX_RAM_QUEUE_SIZE];
-    uint8_t ramQueueCount;
-    uint8_t ramQueueHead;  // Index for dequeue
-    uint8_t ramQueueTail;  // Index for enqueue
+    // Flushes, failover probe, remount + migration (call in main loop)
+    void loop();
 
-    // Helper: Try to initialize SD card
-    bool initSD();
+    // Write all staged records to flash/SD now
+    void flush();
 
-    // Helper: Try to initialize LittleFS
-    bool initLittleFS();
+    // Write coalescing counters for the active file queue
+    const WriteCoalescer* getActiveWriter() const;
 
-    // Helper: Queue to SD card
-    bool queueToSD(JsonDocument& doc);
+    // Boot recovery / corruption counters for the active file queue
+    const RecordLog* getActiveLog() const;
 
-    // Helper: Queue to LittleFS
-    bool queueToLittleFS(JsonDocument& doc);
+    StorageEngine& getEngine() { return engine; }
 
-    // Helper: Queue to RAM
-    bool queueToRAM(JsonDocument& doc);
+private:
+    SdQueueBackend sdQueue;
+    LittleFsQueueBackend lfsQueue;
+    RamQueueBackend ramQueue;
+    StorageEngine engine;
 
-    // Helper: Dequeue from SD card
-    bool dequeueFromSD(JsonDocument& doc);
+    // One record, serialized or read back (allocated once in begin)
+    uint8_t* recordBuffer;
 
-    // Helper: Dequeue from LittleFS
-    bool dequeueFromLittleFS(JsonDocument& doc);
+    // Last reported active backend, to log failover / recovery
+    int8_t lastActive;
+    uint32_t lostReported;
 
-    // Helper: Dequeue from RAM
-    bool dequeueFromRAM(JsonDocument& doc);
+    // Helper: Report recovery of a file queue after mount
+    void reportRecovery(const FileQueueBackend& backend);
 
-    // Helper: Get queue size from file
-    uint16_t getFileQueueSize(const char* filename, fs::FS& filesystem);
+    // Helper: Log changes of the active backend
+    void reportActiveChange();
 
-    // Helper: Remove first line from file
-    bool removeFirstLine(const char* filename, fs::FS& filesystem);
+    // Helper: Move records of an old JSON Lines queue file into a backend
+    void importLegacyQueue(const char* filename, fs::FS& filesystem, QueueBackend& backend);
 };
 
 #endif // STORAGE_MANAGER_H
@@ -0,0 +1,59 @@
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// TASK MONITOR - Stack headroom, load and schedule slip of one task
+// ============================================================================
+// The task brackets every pass with beginWork() / endWork() and reports how
+// late the pass started with noteLate(). Load is the
+// share of wall time inside the bracket over the last report window, timed
+// with esp_timer (FreeRTOS run-time stats are not enabled in the Arduino
+// core's sdkconfig). Blocking inside the bracket - AT command waits, Modbus
+// timeouts - counts as busy: the figure says how much of the time the task
+// was not free to start its next pass.
+//
+// The task writes the counters, another task rolls and reads them, so they
+// sit behind a spinlock.
+
+class TaskMonitor {
+public:
+    struct Report {
+        uint32_t stackFree;     // Bytes never touched since the task started
+        uint8_t loadPct;        // Busy share of the window
+        uint32_t passes;
+        uint32_t maxPassMs;     // Longest single pass
+        uint32_t maxLateMs;     // Worst start after the scheduled time
+    };
+
+    explicit TaskMonitor(const char* name);
+
+    // Starts the first window
+    void attach(TaskHandle_t handle, uint8_t core);
+    void beginWork();
+    void noteLate(uint32_t lateMs);
+    void endWork();
+
+    // Close the window; getLast() then holds its figures
+    void roll();
+    const Report& getLast() const { return last; }
+    const char* getName() const { return name; }
+    uint8_t getCore() const { return core; }
+
+private:
+    const char* name;
+    TaskHandle_t task;
+    uint8_t core;
+    portMUX_TYPE lock;
+
+    int64_t windowStart;
+    int64_t workStart;          // 0 = between passes
+    int64_t busyUs;
+    uint32_t passes;
+    uint32_t maxPassMs;
+    uint32_t maxLateMs;
+    Report last;
+};
+
+#endif // TASK_MONITOR_H
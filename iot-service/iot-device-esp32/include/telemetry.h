@@ -2,9 +2,38 @@
 #define TELEMETRY_H
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
+#include "spsc_ring.h"
+
+// One acquisition pass, handed from core 1 to core 0 as compact JSON:
+// {"basic":{sensors},"rs485":{sensors}} ("rs485" only with devices online).
+// Sized for the worst case, 10 RS485 devices (the scan range, ~4.7 KB): the
+// RS485 part is published as one MQTT packet, so it never needs more.
+#define SAMPLE_JSON_BYTES       MQTT_MAX_PACKET_SIZE
+#define SAMPLE_RING_SLOTS       4       // Passes the comms task may fall behind
+
+struct SensorSample {
+    unsigned long takenAt;                  // millis() at the start of the pass
+    uint16_t length;
+    char json[SAMPLE_JSON_BYTES];
+};
+
+typedef SpscRing<SensorSample, SAMPLE_RING_SLOTS> SampleRing;
 
 // Functions
-void sendFullTelemetry();
+bool acquireSample(SensorSample& sample);   // Acquisition task: read every sensor
+void processSample(const SensorSample& sample, bool publish); // Comms task: archive, publish
+void requestNodeInfo();                     // Compact telemetry: next publish carries node info
 void sendBootNotification();
+void sendBootTimeline();                    // Once the first telemetry is out
+void sendDataUsage();                       // {"action":"data_usage"} command
+void sendMetrics();                         // Stage latency snapshot (metrics job)
+
+// Host bench: both telemetry messages of a sample, serialized, no I/O
+size_t encodeTelemetry(const SensorSample& sample, unsigned long unixTime, String& basicOut, String& rs485Out);
+
+// History archive
+void startHistoryQuery(JsonDocument& cmd);  // {"action":"history", ...} command
+void serviceHistoryQuery();                 // Publish next batch (call every comms pass)
 
 #endif // TELEMETRY_H
@@ -88,6 +88,7 @@ public:
 
     // Get human-readable timestamp: "2025-11-21 10:30:45"
     String getTimestamp();
+    String getTimestamp(unsigned long unixTime);
 
     // Get date: "2025-11-21"
     String getDate();
@@ -0,0 +1,125 @@
+#ifndef TLS_TRANSPORT_H
+#define TLS_TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+#include "mqtt_client.h"
+
+// ============================================================================
+// TLS TRANSPORT - mbedTLS between MqttClient and the modem socket
+// ============================================================================
+// Wraps another MqttTransport (the raw socket). The handshake runs step by
+// step from pollHandshake(), like everything else on the modem link.
+//
+// A full handshake costs two round trips and the broker's certificate chain
+// (3-5 KB down) plus an ECDHE + signature check on the ESP32. After each
+// handshake the session (master secret, session ID, ticket) is kept in RAM
+// and written to `sessionPath`. The next connect - also the first one after
+// a reboot - offers it, and a broker that still knows it resumes in one
+// round trip with a few hundred bytes and no public-key work. A broker that
+// does not know it falls back to a full handshake.
+//
+// The session file holds the master secret: keep it on flash that is not
+// readable from outside (flash encryption) if that matters for the device.
+//
+// Written against mbedTLS 2.28 (Arduino-ESP32 2.x). Uses POSIX stdio for the
+// session file.
+
+#define TLS_SESSION_MAX         4096    // Serialized session (ticket + peer certificate)
+#define TLS_PATH_MAX            48
+#define TLS_SERVER_NAME_MAX     64
+
+class TlsTransport : public MqttTransport {
+public:
+    typedef unsigned long (*ClockFn)();
+
+    enum HandshakeResult {
+        TLS_PENDING,
+        TLS_DONE,
+        TLS_FAILED
+    };
+
+    struct Stats {
+        uint32_t handshakes;        // Completed, full or resumed
+        uint32_t resumed;
+        uint32_t failed;
+        uint32_t lastHandshakeMs;
+        uint32_t lastBytesUp;       // Handshake bytes of the last handshake
+        uint32_t lastBytesDown;
+        int lastError;              // mbedTLS error code, 0 = none
+    };
+
+    explicit TlsTransport(MqttTransport& lower);
+    ~TlsTransport();
+
+    // `caPem` NUL-terminated CA chain (nullptr = encrypt without verifying
+    // the broker). `serverName` is checked against the certificate and sent
+    // as SNI (nullptr = neither). `sessionPath` nullptr = RAM cache only.
+    bool begin(const char* caPem, const char* serverName, const char* sessionPath,
+               ClockFn clock, uint32_t handshakeTimeoutMs);
+
+    // Socket just opened: ClientHello, with the cached session if any
+    bool startHandshake();
+    HandshakeResult pollHandshake();
+
+    // Connection gone (no close_notify); the cached session is kept
+    void reset();
+
+    // Start over with a full handshake next time
+    void forgetSession();
+
+    bool isEstablished() const { return established; }
+    bool wasResumed() const { return resumed; }
+    bool hasSession() const { return sessionLen > 0; }
+    const Stats& getStats() const { return stats; }
+
+    // MqttTransport: application data once the handshake is done
+    bool connected() override;
+    int available() override;
+    int read(uint8_t* buf, size_t len) override;
+    size_t write(const uint8_t* buf, size_t len) override;
+
+private:
+    MqttTransport& lower;
+    ClockFn clock;
+    uint32_t handshakeTimeoutMs;
+
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_x509_crt ca;
+    mbedtls_ssl_config conf;
+    mbedtls_ssl_context ssl;
+
+    bool configured;
+    bool active;                // ssl set up for the current socket
+    bool established;
+    bool resumed;
+    bool broken;                // Fatal error on an established connection
+    bool offered;               // Cached session offered in this handshake
+    unsigned long handshakeStart;
+    uint32_t bytesUp;
+    uint32_t bytesDown;
+
+    char serverName[TLS_SERVER_NAME_MAX];
+    char sessionPath[TLS_PATH_MAX];
+    uint8_t* session;           // Serialized session, TLS_SESSION_MAX bytes
+    size_t sessionLen;
+
+    Stats stats;
+
+    unsigned long now() const { return clock ? clock() : 0; }
+    void finishHandshake();
+    void keepSession();
+    bool loadSession();
+    bool saveSession();
+
+    static int sendCallback(void* context, const unsigned char* buf, size_t len);
+    static int recvCallback(void* context, unsigned char* buf, size_t len);
+    static int verifyCallback(void* context, mbedtls_x509_crt* crt, int depth, uint32_t* flags);
+};
+
+#endif // TLS_TRANSPORT_H
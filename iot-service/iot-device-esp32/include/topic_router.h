@@ -0,0 +1,48 @@
+#ifndef TOPIC_ROUTER_H
+#define TOPIC_ROUTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// TOPIC ROUTER - Inbound MQTT messages to their handler by exact topic
+// ============================================================================
+// Topics are registered once their full name is known ("stream_config/<id>",
+// "sensor/<id>/command") and matched by length + memcmp, so a topic that only
+// contains a registered one ("x/sensor/<id>/command/y") does not match.
+//
+// Handlers get the payload where the MQTT client received it (its rx buffer,
+// valid until the handler returns) and parse it from there - no String copy.
+
+#define TOPIC_ROUTER_MAX_ROUTES 8
+#define TOPIC_ROUTER_TOPIC_LEN  64      // Topic incl. terminator
+
+class TopicRouter {
+public:
+    typedef void (*Handler)(const uint8_t* payload, size_t length);
+
+    TopicRouter();
+
+    // Registers or replaces the handler for `topic`; false if the table is
+    // full or the topic too long
+    bool add(const char* topic, Handler handler);
+
+    // False if no route matches
+    bool dispatch(const char* topic, const uint8_t* payload, size_t length) const;
+
+    uint8_t getRouteCount() const { return routeCount; }
+
+private:
+    struct Route {
+        char topic[TOPIC_ROUTER_TOPIC_LEN];
+        uint8_t length;
+        Handler handler;
+    };
+
+    Route routes[TOPIC_ROUTER_MAX_ROUTES];
+    uint8_t routeCount;
+
+    const Route* find(const char* topic, size_t length) const;
+};
+
+#endif // TOPIC_ROUTER_H
@@ -0,0 +1,147 @@
+#ifndef WRITE_COALESCER_H
+#define WRITE_COALESCER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// WRITE COALESCER - RAM staging buffer for SD / LittleFS appends
+// ============================================================================
+// Collects small appends (queue records, log lines) in RAM and hands them to
+// the filesystem in whole blocks aligned to the page / cluster size, instead
+// of open + append one line + close for every record.
+//
+// Staged bytes are flushed when:
+// 1. At least one full aligned block is staged (size trigger)
+// 2. The oldest staged byte is older than the durability window (age trigger)
+// 3. flush() is called (segment roll, explicit)
+// 4. flushAllInstances() runs from the restart / brown-out warning hook
+//
+// Data still staged when power is lost without warning is lost, so the
+// durability window is the upper bound on how much telemetry can disappear.
+
+#define COALESCER_MAX_INSTANCES 4   // SD queue, LittleFS queue, SD log, spare
+
+class WriteCoalescer {
+public:
+    // Appends `len` bytes at the end of the backing file. Returns bytes written.
+    typedef size_t (*FlushSink)(void* context, const uint8_t* data, size_t len);
+
+    // Same signature as Arduino millis()/micros(), so they can be passed directly
+    typedef unsigned long (*ClockFn)();
+
+    enum FlushReason {
+        FLUSH_SIZE,
+        FLUSH_AGE,
+        FLUSH_EXPLICIT,
+        FLUSH_SHUTDOWN,
+        FLUSH_REASON_COUNT
+    };
+
+    struct Stats {
+        uint32_t recordsStaged;         // append() calls accepted
+        uint64_t bytesStaged;           // Logical bytes handed to append()
+        uint64_t bytesWritten;          // Bytes handed to the sink
+        uint64_t bytesProgrammed;       // Whole blocks touched by sink writes (flash/SD cost)
+        uint32_t sinkWrites;            // Number of sink calls (open/append/close cycles)
+        uint32_t sinkFailures;          // Short or failed sink writes
+        uint32_t flushes[FLUSH_REASON_COUNT];
+        uint64_t flushMicros;           // Time spent inside the sink
+        uint32_t maxFlushMicros;        // Slowest single sink write
+    };
+
+    WriteCoalescer();
+    ~WriteCoalescer();
+
+    // Allocate the staging buffer. `fileSize` is the current size of the
+    // backing file so flushes can be aligned to absolute block boundaries.
+    bool begin(size_t blockSize, size_t capacity, uint32_t maxAgeMs,
+               FlushSink sink, void* sinkContext,
+               ClockFn millisFn, ClockFn microsFn = nullptr,
+               uint32_t fileSize = 0);
+    void end();
+
+    // Stage bytes. May trigger a size flush; never drops data silently.
+    bool append(const uint8_t* data, size_t len);
+
+    // Stage a header + payload pair as one record
+    bool append(const uint8_t* head, size_t headLen, const uint8_t* data, size_t len);
+
+    // Age trigger - call from the main loop
+    void poll();
+
+    // Write everything staged, regardless of alignment
+    bool flush(FlushReason reason = FLUSH_EXPLICIT);
+
+    // Drop staged bytes (queue cleared) and restart at `fileSize`
+    void discard(uint32_t fileSize = 0);
+
+    // Backing file was removed / truncated externally
+    void resetFileSize(uint32_t fileSize);
+
+    size_t getStagedBytes() const { return staged; }
+
+    // Staged bytes, oldest first: the newest getStagedBytes() bytes of the
+    // backing file. Readers copy them from here instead of forcing a flush.
+    const uint8_t* getStagedData() const { return buffer + retained; }
+
+    // Records not completely in the file, oldest first: the written head of
+    // a record straddling the last flush (getRetainedBytes()), then the
+    // staged bytes. Lets a caller recover whole records if the sink dies.
+    const uint8_t* getPendingData() const { return buffer; }
+    size_t getRetainedBytes() const { return retained; }
+
+    // Un-stage the newest `len` bytes (record rolled back after a failed write)
+    void dropStagedTail(size_t len);
+    uint32_t getMaxAgeMs() const { return maxAgeMs; }
+    void setMaxAgeMs(uint32_t ms) { maxAgeMs = ms; }
+    const Stats& getStats() const { return stats; }
+
+    // bytesProgrammed / bytesWritten, x100 (100 = no amplification)
+    uint32_t getWriteAmplificationX100() const;
+
+    // Sustained sink throughput in bytes per second (0 without micros clock)
+    uint32_t getThroughputBps() const;
+
+    // Restart / brown-out hook: flush every live coalescer
+    static void flushAllInstances();
+
+private:
+    uint8_t* buffer;
+    size_t capacity;
+    size_t staged;
+    size_t retained;                // Written head of the straddling record, before `staged`
+    size_t recordStart;             // Buffer offset of the last appended record
+    size_t blockSize;
+    uint32_t maxAgeMs;
+    uint32_t fileSize;              // Bytes already in the backing file
+    unsigned long oldestStagedAt;   // millis() of the first staged byte
+
+    FlushSink sink;
+    void* sinkContext;
+    ClockFn millisFn;
+    ClockFn microsFn;
+
+    Stats stats;
+
+    // Copy bytes into the buffer, flushing aligned blocks as it fills
+    bool stage(const uint8_t* data, size_t len);
+
+    // Write the first `len` staged bytes to the sink
+    bool writeOut(size_t len, FlushReason reason);
+
+    // Begin a new record at the end of the buffer
+    void startRecord();
+
+    // Give up the retained head to make room for staging
+    void dropRetained();
+
+    // Bytes that end exactly on a block boundary (0 if less than one block)
+    size_t alignedFlushLength() const;
+
+    static WriteCoalescer* instances[COALESCER_MAX_INSTANCES];
+    void registerInstance();
+    void unregisterInstance();
+};
+
+#endif // WRITE_COALESCER_H
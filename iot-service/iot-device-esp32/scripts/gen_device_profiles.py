@@ -0,0 +1,153 @@
+"""Compile the RS485 register maps (*-modbus-config.json) into flash tables.
+
+Writes include/device_profiles_gen.h: one constexpr RS485Register array per
+map and the DEVICE_PROFILE_TABLE that findDeviceProfile() searches. Runs
+before every PlatformIO build (extra_scripts = pre:...) and rewrites the
+header only when a map changed; also runs standalone:
+
+    python3 scripts/gen_device_profiles.py
+"""
+
+import glob
+import json
+import os
+import re
+import sys
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO / SCons
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(sys.argv[0])))
+
+MAP_PATTERN = "*-modbus-config.json"
+OUTPUT = os.path.join("include", "device_profiles_gen.h")
+
+KEY_LEN = 32    # RS485_KEY_LEN
+TYPE_LEN = 32   # RS485_TYPE_LEN
+
+REGISTER_TYPES = {
+    "uint16": "RS485_UINT16",
+    "int16": "RS485_INT16",
+    "uint32": "RS485_UINT32",
+    "int32": "RS485_INT32",
+    "float32": "RS485_FLOAT32",
+    "hex16": "RS485_HEX16",
+}
+
+
+def c_string(text):
+    out = []
+    for byte in text.encode("utf-8"):
+        ch = chr(byte)
+        if ch in '"\\':
+            out.append("\\" + ch)
+        elif 32 <= byte < 127:
+            out.append(ch)
+        else:
+            out.append("\\%03o" % byte)
+    return '"' + "".join(out) + '"'
+
+
+def telemetry_key(label):
+    """Same as labelToKey() in rs485_config_manager.cpp"""
+    raw = label.encode("utf-8")[:KEY_LEN - 1]
+    key = bytes(ord("_") if b == ord(" ") else (b + 32 if 65 <= b <= 90 else b) for b in raw)
+    return key.decode("utf-8", errors="ignore")
+
+
+def identifier(device_type, version):
+    return "PROFILE_%s_V%d" % (re.sub(r"[^A-Za-z0-9]", "_", device_type).upper(), version)
+
+
+def load_profiles(project_dir):
+    profiles = []
+    for path in sorted(glob.glob(os.path.join(project_dir, MAP_PATTERN))):
+        with open(path, encoding="utf-8") as f:
+            device = json.load(f)
+
+        name = os.path.basename(path)
+        device_type = device["device_type"]
+        if len(device_type.encode("utf-8")) >= TYPE_LEN:
+            raise ValueError("%s: device_type longer than %d bytes" % (name, TYPE_LEN - 1))
+
+        registers = []
+        for reg in device["registers"]:
+            reg_type = reg.get("type", "uint16")
+            if reg_type not in REGISTER_TYPES:
+                print("gen_device_profiles: %s: unknown type %r at reg %s" % (name, reg_type, reg["reg"]))
+            registers.append((
+                int(reg["reg"]),
+                REGISTER_TYPES.get(reg_type, "RS485_TYPE_UNKNOWN"),
+                int(reg.get("words", 1)),
+                bool(reg.get("swap", False)),
+                telemetry_key(reg.get("label", "Unknown")),
+            ))
+
+        if not 0 < len(registers) < 256:
+            raise ValueError("%s: %d registers (1-255 supported)" % (name, len(registers)))
+
+        profiles.append({
+            "file": name,
+            "device_type": device_type,
+            "version": int(device.get("version", 1)),
+            "baud_rate": int(device.get("baud_rate", 9600)),
+            "modbus_address": int(device.get("modbus_address", 1)),
+            "registers": registers,
+        })
+    return profiles
+
+
+def render(profiles):
+    lines = [
+        "// ============================================================================",
+        "// GENERATED by scripts/gen_device_profiles.py from %s - do not edit" % MAP_PATTERN,
+        "// ============================================================================",
+        "",
+        "#ifndef DEVICE_PROFILES_GEN_H",
+        "#define DEVICE_PROFILES_GEN_H",
+        "",
+        '#include "device_profiles.h"',
+        "",
+    ]
+
+    for p in profiles:
+        lines.append("// %s v%d (%s)" % (p["device_type"], p["version"], p["file"]))
+        lines.append("constexpr RS485Register %s[] = {" % identifier(p["device_type"], p["version"]))
+        for reg, reg_type, words, swap, key in p["registers"]:
+            lines.append("    { %d, %s, %d, %s, %s }," % (reg, reg_type, words, "true" if swap else "false", c_string(key)))
+        lines.append("};")
+        lines.append("")
+
+    lines.append("constexpr RS485Profile DEVICE_PROFILE_TABLE[] = {")
+    for p in profiles:
+        ident = identifier(p["device_type"], p["version"])
+        lines.append("    { %s, %d, %d, %d, %s, %d }," % (
+            c_string(p["device_type"]), p["version"], p["baud_rate"], p["modbus_address"],
+            ident, len(p["registers"])))
+    lines.append("};")
+    lines.append("")
+    lines.append("#endif // DEVICE_PROFILES_GEN_H")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def main():
+    profiles = load_profiles(PROJECT_DIR)
+    if not profiles:
+        raise SystemExit("gen_device_profiles: no %s in %s" % (MAP_PATTERN, PROJECT_DIR))
+
+    output = os.path.join(PROJECT_DIR, OUTPUT)
+    text = render(profiles)
+
+    current = None
+    if os.path.exists(output):
+        with open(output, encoding="utf-8") as f:
+            current = f.read()
+    if current != text:
+        with open(output, "w", encoding="utf-8") as f:
+            f.write(text)
+        print("gen_device_profiles: %s (%d profiles)" % (OUTPUT, len(profiles)))
+
+
+main()
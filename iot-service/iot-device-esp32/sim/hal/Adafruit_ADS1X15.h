@@ -0,0 +1,33 @@
+#ifndef SIM_ADAFRUIT_ADS1X15_H
+#define SIM_ADAFRUIT_ADS1X15_H
+
+#include <stdint.h>
+#include "Wire.h"
+
+typedef enum {
+    GAIN_TWOTHIRDS = 0x0000,    // +/-6.144 V
+    GAIN_ONE = 0x0200,          // +/-4.096 V
+    GAIN_TWO = 0x0400,          // +/-2.048 V
+    GAIN_FOUR = 0x0600,         // +/-1.024 V
+    GAIN_EIGHT = 0x0800,        // +/-0.512 V
+    GAIN_SIXTEEN = 0x0A00       // +/-0.256 V
+} adsGain_t;
+
+// Reads the sim::I2cDevice at its address (volts per input). A single-shot
+// conversion takes 9 ms at the default 128 SPS.
+class Adafruit_ADS1115 {
+public:
+    bool begin(uint8_t address = 0x48, TwoWire* wire = &Wire);
+    void setGain(adsGain_t gain) { this->gain = gain; }
+    adsGain_t getGain() const { return gain; }
+    int16_t readADC_SingleEnded(uint8_t channel);
+    float computeVolts(int16_t counts) const;
+
+private:
+    uint8_t address = 0x48;
+    adsGain_t gain = GAIN_TWOTHIRDS;
+
+    float fullScale() const;
+};
+
+#endif // SIM_ADAFRUIT_ADS1X15_H
@@ -0,0 +1,27 @@
+#ifndef SIM_ADAFRUIT_INA219_H
+#define SIM_ADAFRUIT_INA219_H
+
+#include <stdint.h>
+#include "Wire.h"
+
+// Reads the sim::I2cDevice at its address: channel 0 bus volts, 1 mA
+class Adafruit_INA219 {
+public:
+    explicit Adafruit_INA219(uint8_t address = 0x40) : address(address) {}
+
+    bool begin(TwoWire* wire = &Wire) { (void)wire; return sim::findI2c(address) != nullptr; }
+    float getBusVoltage_V() { return read(0); }
+    float getShuntVoltage_mV() { return read(1) * 0.1f; }   // 0.1 ohm shunt
+    float getCurrent_mA() { return read(1); }
+    float getPower_mW() { return read(0) * read(1); }
+
+private:
+    uint8_t address;
+
+    float read(uint8_t channel) {
+        sim::I2cDevice* device = sim::findI2c(address);
+        return device ? (float)device->read(channel) : 0.0f;
+    }
+};
+
+#endif // SIM_ADAFRUIT_INA219_H
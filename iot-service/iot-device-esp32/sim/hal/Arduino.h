@@ -0,0 +1,78 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// ============================================================================
+// Arduino core stand-in for the native simulation build (env:native)
+// ============================================================================
+// Same names and signatures as the ESP32 Arduino core, as far as the
+// firmware uses them. Time is the sim kernel's virtual clock; pins, ADC
+// and I2C are wired to the simulated parts in sim/src (see sim_hw.h).
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include "HardwareSerial.h"
+
+using std::min;
+using std::max;
+
+#define HIGH                    0x1
+#define LOW                     0x0
+
+#define INPUT                   0x01
+#define OUTPUT                  0x03
+#define INPUT_PULLUP            0x05
+#define INPUT_PULLDOWN          0x09
+
+#define LED_BUILTIN             48
+
+#define F(string_literal)       (string_literal)
+#define PSTR(string_literal)    (string_literal)
+
+#define constrain(amt, low, high)((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// ---- Time (virtual) ----
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// SNTP is not simulated: the clock only moves by settimeofday()
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+// ---- GPIO / ADC ----
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// ---- Chip ----
+class EspClass {
+public:
+    uint64_t getEfuseMac();
+    uint32_t getFreeHeap();
+    [[noreturn]] void restart();
+};
+
+extern EspClass ESP;
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,77 @@
+#ifndef SIM_FS_H
+#define SIM_FS_H
+
+#include <stdio.h>
+#include <string>
+#include "Stream.h"
+
+// ============================================================================
+// Arduino FS on the host filesystem (native simulation build)
+// ============================================================================
+// A mounted FS is a directory under the runner's working directory ("sd",
+// "littlefs"); the firmware's POSIX calls on SD_MOUNT_POINT /
+// LITTLEFS_MOUNT_POINT paths land in the same place. Capacity is reported,
+// not enforced.
+
+#define FILE_READ               "r"
+#define FILE_WRITE              "w"
+#define FILE_APPEND             "a"
+
+namespace fs {
+
+class File : public Stream {
+public:
+    File() : file(nullptr) {}
+    File(FILE* f, const std::string& path) : file(f), path(path) {}
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+    File(File&& other) noexcept : file(other.file), path(std::move(other.path)) { other.file = nullptr; }
+    File& operator=(File&& other) noexcept;
+    ~File() override { close(); }
+
+    explicit operator bool() const { return file != nullptr; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    void flush() override;
+
+    size_t size() const;
+    const char* name() const;
+    void close();
+
+private:
+    FILE* file;
+    std::string path;
+};
+
+class FS {
+public:
+    explicit FS(const char* defaultMount) : mountPoint(defaultMount), mounted(false) {}
+
+    bool exists(const char* path) const;
+    bool exists(const String& path) const { return exists(path.c_str()); }
+    File open(const char* path, const char* mode = FILE_READ);
+    File open(const String& path, const char* mode = FILE_READ) { return open(path.c_str(), mode); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+
+protected:
+    std::string mountPoint;     // Host directory, relative to the working directory
+    bool mounted;
+
+    bool mount(const char* vfsPath);    // "/sd" -> "sd"
+    std::string hostPath(const char* path) const;
+    uint64_t usedBytesOnHost() const;
+};
+
+} // namespace fs
+
+using fs::File;
+
+#endif // SIM_FS_H
@@ -0,0 +1,70 @@
+#ifndef SIM_HARDWARE_SERIAL_H
+#define SIM_HARDWARE_SERIAL_H
+
+#include <stdint.h>
+#include <deque>
+#include <functional>
+#include "Stream.h"
+#include "sim_hw.h"
+
+#define SERIAL_8N1              0x800001c
+
+// ============================================================================
+// HardwareSerial on a simulated wire
+// ============================================================================
+// Bytes take 10 bit times each way. Received bytes become readable at the
+// virtual time their stop bit arrives; onReceive() fires once the line has
+// been idle for 2 byte times, like the RX timeout of the ESP32 UART driver.
+// write() returns at once (TX buffer), flush() waits for the wire. UART0 is
+// the console.
+
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(uint8_t uartNum);
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1,
+               bool invert = false, unsigned long timeoutMs = 20000UL, uint8_t rxfifoFullThreshold = 112);
+    void end() {}
+    void onReceive(std::function<void()> callback, bool onlyOnTimeout = false);
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    void flush() override;
+    operator bool() const { return true; }
+
+    // ---- Simulation side ----
+    void attach(sim::UartPeer* peer) { this->peer = peer; }
+    // Bytes from the peer, first start bit at `atUs` (queued behind bytes still on the line)
+    void deliver(const uint8_t* data, size_t len, uint64_t atUs);
+    uint64_t getTxBytes() const { return txBytes; }
+    uint64_t getRxBytes() const { return rxBytes; }
+
+    static HardwareSerial* byNumber(uint8_t uartNum);
+
+private:
+    struct RxByte {
+        uint64_t atUs;
+        uint8_t value;
+    };
+
+    uint8_t uartNum;
+    uint32_t byteUs;
+    sim::UartPeer* peer;
+    std::function<void()> receiveCallback;
+
+    std::deque<RxByte> rx;
+    uint64_t rxLineFreeUs;      // Last queued byte fully received
+    uint64_t txDoneUs;          // Last written byte fully sent
+    uint64_t txBytes;
+    uint64_t rxBytes;
+
+    bool rxReady();
+};
+
+extern HardwareSerial Serial;
+
+#endif // SIM_HARDWARE_SERIAL_H
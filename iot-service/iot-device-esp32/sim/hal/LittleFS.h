@@ -0,0 +1,21 @@
+#ifndef SIM_LITTLEFS_H
+#define SIM_LITTLEFS_H
+
+#include "FS.h"
+
+#define SIM_LITTLEFS_BYTES      1441792     // Default "spiffs" partition
+
+class LittleFSFS : public fs::FS {
+public:
+    LittleFSFS() : fs::FS("littlefs") {}
+
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = "spiffs");
+    void end() { mounted = false; }
+    size_t totalBytes() { return SIM_LITTLEFS_BYTES; }
+    size_t usedBytes() { return (size_t)usedBytesOnHost(); }
+};
+
+extern LittleFSFS LittleFS;
+
+#endif // SIM_LITTLEFS_H
@@ -0,0 +1,47 @@
+#ifndef SIM_RTCLIB_H
+#define SIM_RTCLIB_H
+
+#include <stdint.h>
+#include <time.h>
+#include "Wire.h"
+
+class DateTime {
+public:
+    DateTime(uint32_t t = 946684800) : t(t) {}
+
+    uint16_t year() const { return (uint16_t)(fields().tm_year + 1900); }
+    uint8_t month() const { return (uint8_t)(fields().tm_mon + 1); }
+    uint8_t day() const { return (uint8_t)fields().tm_mday; }
+    uint8_t hour() const { return (uint8_t)fields().tm_hour; }
+    uint8_t minute() const { return (uint8_t)fields().tm_min; }
+    uint8_t second() const { return (uint8_t)fields().tm_sec; }
+    uint32_t unixtime() const { return t; }
+
+private:
+    uint32_t t;
+
+    struct tm fields() const {
+        time_t at = (time_t)t;
+        struct tm out;
+        gmtime_r(&at, &out);
+        return out;
+    }
+};
+
+// sim::I2cDevice at 0x68: channel 0 is the unix time
+class RTC_DS3231 {
+public:
+    bool begin(TwoWire* wire = &Wire) { (void)wire; return device() != nullptr; }
+    DateTime now() { return DateTime(device() ? (uint32_t)device()->read(0) : 0); }
+    bool lostPower() { return false; }
+    void adjust(const DateTime& dt) {
+        if (device()) {
+            device()->write(0, dt.unixtime());
+        }
+    }
+
+private:
+    static sim::I2cDevice* device() { return sim::findI2c(0x68); }
+};
+
+#endif // SIM_RTCLIB_H
@@ -0,0 +1,31 @@
+#ifndef SIM_SD_H
+#define SIM_SD_H
+
+#include "FS.h"
+#include "SPI.h"
+
+typedef enum {
+    CARD_NONE,
+    CARD_MMC,
+    CARD_SD,
+    CARD_SDHC,
+    CARD_UNKNOWN
+} sdcard_type_t;
+
+// Card presence is a runner option (--no-sd)
+class SDFS : public fs::FS {
+public:
+    SDFS() : fs::FS("sd") {}
+
+    bool begin(uint8_t ssPin = 10, SPIClass& spi = SPI, uint32_t frequency = 4000000,
+               const char* mountpoint = "/sd", uint8_t maxFiles = 5, bool formatIfEmpty = false);
+    void end() { mounted = false; }
+    sdcard_type_t cardType();
+    uint64_t cardSize();
+    uint64_t totalBytes();
+    uint64_t usedBytes();
+};
+
+extern SDFS SD;
+
+#endif // SIM_SD_H
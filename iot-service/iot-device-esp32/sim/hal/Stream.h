@@ -0,0 +1,27 @@
+#ifndef SIM_STREAM_H
+#define SIM_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeoutMs) { timeout = timeoutMs; }
+    unsigned long getTimeout() const { return timeout; }
+
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    String readString();
+    String readStringUntil(char terminator);
+
+protected:
+    unsigned long timeout = 1000;
+
+    // Next byte or -1 after `timeout` ms (virtual time)
+    int timedRead();
+};
+
+#endif // SIM_STREAM_H
@@ -0,0 +1,92 @@
+#ifndef SIM_TINY_GSM_CLIENT_H
+#define SIM_TINY_GSM_CLIENT_H
+
+#include <stdint.h>
+#include "Arduino.h"
+
+// ============================================================================
+// TinyGSM stand-in (SIM7600) for the native simulation build
+// ============================================================================
+// TinyGsm keeps the library's blocking query calls: send the AT command,
+// wait for the answer line and the final OK / ERROR, and throw away every
+// other line on the way, URCs included, as the library does. The socket
+// data path of TinyGsmClient is not simulated (the modem stack backend
+// does not use it); AsyncGsmClient only flips its connection state.
+
+class IPAddress {
+public:
+    IPAddress() { octets[0] = octets[1] = octets[2] = octets[3] = 0; }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        octets[0] = a; octets[1] = b; octets[2] = c; octets[3] = d;
+    }
+    uint8_t operator[](int index) const { return octets[index]; }
+    String toString() const;
+
+private:
+    uint8_t octets[4];
+};
+
+class Client : public Stream {
+public:
+    virtual int connect(const char* host, uint16_t port) = 0;
+    virtual int read(uint8_t* buf, size_t size) = 0;
+    virtual void stop() = 0;
+    virtual uint8_t connected() = 0;
+    virtual operator bool() = 0;
+    using Stream::read;
+};
+
+class TinyGsm {
+public:
+    explicit TinyGsm(Stream& stream) : stream(stream) {}
+
+    bool gprsDisconnect();
+    int16_t getSignalQuality();
+    String getOperator();
+    IPAddress localIP();
+
+private:
+    Stream& stream;
+
+    void sendAT(const char* command);
+    // 1 = OK, 2 = ERROR, 0 = timeout; a line starting with `capture` is kept in `line`
+    int8_t waitResponse(uint32_t timeoutMs, const char* capture = nullptr, String* line = nullptr);
+    bool readLine(String& out, uint32_t deadlineMs);
+};
+
+class TinyGsmClient : public Client {
+public:
+    TinyGsmClient(TinyGsm& modem, uint8_t mux = 0) : modem(&modem), mux(mux) {
+        sock_connected = false;
+        sock_available = 0;
+        got_data = false;
+    }
+
+    int connect(const char* host, uint16_t port) override { (void)host; (void)port; return 0; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int read(uint8_t* buf, size_t size) override { (void)buf; (void)size; return 0; }
+    int peek() override { return -1; }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override { (void)buf; (void)size; return 0; }
+    using Print::write;
+    void stop() override { sock_connected = false; }
+    uint8_t connected() override { return sock_connected; }
+    operator bool() override { return sock_connected; }
+
+protected:
+    // Received bytes (TinyGSM's ring buffer)
+    class RxFifo {
+    public:
+        void clear() {}
+    };
+
+    TinyGsm* modem;
+    uint8_t mux;
+    bool sock_connected;
+    uint16_t sock_available;
+    bool got_data;
+    RxFifo rx;
+};
+
+#endif // SIM_TINY_GSM_CLIENT_H
@@ -0,0 +1,145 @@
+#ifndef SIM_WSTRING_H
+#define SIM_WSTRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string>
+
+// ============================================================================
+// Arduino String on std::string (native simulation build)
+// ============================================================================
+
+class StringSumHelper;
+
+class String {
+public:
+    String() {}
+    String(const char* cstr) { if (cstr) value = cstr; }
+    String(const char* cstr, unsigned int length) { if (cstr) value.assign(cstr, length); }
+    String(const String& other) : value(other.value) {}
+    String(String&& other) noexcept : value(std::move(other.value)) {}
+    explicit String(char c) : value(1, c) {}
+    explicit String(unsigned char num, unsigned char base = 10);
+    explicit String(int num, unsigned char base = 10);
+    explicit String(unsigned int num, unsigned char base = 10);
+    explicit String(long num, unsigned char base = 10);
+    explicit String(unsigned long num, unsigned char base = 10);
+    explicit String(long long num, unsigned char base = 10);
+    explicit String(unsigned long long num, unsigned char base = 10);
+    explicit String(float num, unsigned int decimalPlaces = 2);
+    explicit String(double num, unsigned int decimalPlaces = 2);
+
+    String& operator=(const String& rhs) { value = rhs.value; return *this; }
+    String& operator=(String&& rhs) noexcept { value = std::move(rhs.value); return *this; }
+    String& operator=(const char* cstr) { value = cstr ? cstr : ""; return *this; }
+
+    bool reserve(unsigned int size) { value.reserve(size); return true; }
+    unsigned int length() const { return (unsigned int)value.size(); }
+    bool isEmpty() const { return value.empty(); }
+    const char* c_str() const { return value.c_str(); }
+    char* begin() { return &value[0]; }
+    char* end() { return &value[0] + value.size(); }
+
+    bool concat(const String& str) { value += str.value; return true; }
+    bool concat(const char* cstr) { if (cstr) value += cstr; return cstr != nullptr; }
+    bool concat(const char* cstr, unsigned int length) { if (cstr) value.append(cstr, length); return cstr != nullptr; }
+    bool concat(char c) { value += c; return true; }
+    bool concat(unsigned char num) { return concat(String(num)); }
+    bool concat(int num) { return concat(String(num)); }
+    bool concat(unsigned int num) { return concat(String(num)); }
+    bool concat(long num) { return concat(String(num)); }
+    bool concat(unsigned long num) { return concat(String(num)); }
+    bool concat(long long num) { return concat(String(num)); }
+    bool concat(unsigned long long num) { return concat(String(num)); }
+    bool concat(float num) { return concat(String(num)); }
+    bool concat(double num) { return concat(String(num)); }
+
+    template <typename T>
+    String& operator+=(const T& rhs) { concat(rhs); return *this; }
+
+    int compareTo(const String& s) const { return value.compare(s.value); }
+    bool equals(const String& s) const { return value == s.value; }
+    bool equals(const char* cstr) const { return value == (cstr ? cstr : ""); }
+    bool equalsIgnoreCase(const String& s) const;
+    bool operator==(const String& rhs) const { return equals(rhs); }
+    bool operator==(const char* cstr) const { return equals(cstr); }
+    bool operator!=(const String& rhs) const { return !equals(rhs); }
+    bool operator!=(const char* cstr) const { return !equals(cstr); }
+    bool operator<(const String& rhs) const { return value < rhs.value; }
+    bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+    bool endsWith(const String& suffix) const;
+
+    char charAt(unsigned int index) const { return index < value.size() ? value[index] : 0; }
+    void setCharAt(unsigned int index, char c) { if (index < value.size()) value[index] = c; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return value[index]; }
+    void getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index = 0) const;
+    void toCharArray(char* buf, unsigned int bufsize, unsigned int index = 0) const {
+        getBytes((unsigned char*)buf, bufsize, index);
+    }
+
+    int indexOf(char ch, unsigned int fromIndex = 0) const;
+    int indexOf(const String& str, unsigned int fromIndex = 0) const;
+    int lastIndexOf(char ch) const;
+    int lastIndexOf(const String& str) const;
+    String substring(unsigned int beginIndex) const;
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void replace(char find, char replace);
+    void replace(const String& find, const String& replace);
+    void remove(unsigned int index);
+    void remove(unsigned int index, unsigned int count);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const { return strtol(value.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(value.c_str(), nullptr); }
+    double toDouble() const { return strtod(value.c_str(), nullptr); }
+
+private:
+    std::string value;
+};
+
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& s) : String(s) {}
+    StringSumHelper(const char* p) : String(p) {}
+    StringSumHelper(char c) : String(c) {}
+    StringSumHelper(unsigned char num) : String(num) {}
+    StringSumHelper(int num) : String(num) {}
+    StringSumHelper(unsigned int num) : String(num) {}
+    StringSumHelper(long num) : String(num) {}
+    StringSumHelper(unsigned long num) : String(num) {}
+    StringSumHelper(long long num) : String(num) {}
+    StringSumHelper(unsigned long long num) : String(num) {}
+    StringSumHelper(float num) : String(num) {}
+    StringSumHelper(double num) : String(num) {}
+};
+
+template <typename T>
+inline StringSumHelper operator+(const StringSumHelper& lhs, const T& rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+template <typename T>
+inline StringSumHelper operator+(const String& lhs, const T& rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+inline StringSumHelper operator+(const char* lhs, const String& rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+inline bool operator==(const char* lhs, const String& rhs) {
+    return rhs.equals(lhs);
+}
+
+#endif // SIM_WSTRING_H
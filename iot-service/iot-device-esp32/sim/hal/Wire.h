@@ -0,0 +1,28 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include <stdint.h>
+#include "sim_hw.h"
+
+// Only address probes go over the bus; the sensor drivers read the
+// attached sim::I2cDevice directly
+class TwoWire {
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+        (void)sda; (void)scl; (void)frequency;
+        return true;
+    }
+    void beginTransmission(uint8_t address) { this->address = address; }
+    // 0 = ACK, 2 = NACK on address
+    uint8_t endTransmission(bool sendStop = true) {
+        (void)sendStop;
+        return sim::findI2c(address) != nullptr ? 0 : 2;
+    }
+
+private:
+    uint8_t address = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
@@ -0,0 +1,11 @@
+#ifndef SIM_ESP_ATTR_H
+#define SIM_ESP_ATTR_H
+
+// Placement attributes mean nothing on the host. RTC_NOINIT_ATTR data
+// starts zeroed, as after a power-on.
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif // SIM_ESP_ATTR_H
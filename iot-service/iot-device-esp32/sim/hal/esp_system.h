@@ -0,0 +1,33 @@
+#ifndef SIM_ESP_SYSTEM_H
+#define SIM_ESP_SYSTEM_H
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+
+typedef enum {
+    ESP_RST_UNKNOWN,
+    ESP_RST_POWERON,
+    ESP_RST_EXT,
+    ESP_RST_SW,
+    ESP_RST_PANIC,
+    ESP_RST_INT_WDT,
+    ESP_RST_TASK_WDT,
+    ESP_RST_WDT,
+    ESP_RST_DEEPSLEEP,
+    ESP_RST_BROWNOUT,
+    ESP_RST_SDIO,
+} esp_reset_reason_t;
+
+typedef void (*shutdown_handler_t)(void);
+
+// A restart ends the run; the runner boots the firmware again in a new
+// process (same clock and files) that reports ESP_RST_SW
+esp_reset_reason_t esp_reset_reason(void);
+[[noreturn]] void esp_restart(void);
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler);
+uint32_t esp_get_free_heap_size(void);
+
+#endif // SIM_ESP_SYSTEM_H
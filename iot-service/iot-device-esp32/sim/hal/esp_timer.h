@@ -0,0 +1,12 @@
+#ifndef SIM_ESP_TIMER_H
+#define SIM_ESP_TIMER_H
+
+#include <stdint.h>
+#include "sim_kernel.h"
+
+// Microseconds since boot, virtual
+inline int64_t esp_timer_get_time() {
+    return (int64_t)sim::nowUs();
+}
+
+#endif // SIM_ESP_TIMER_H
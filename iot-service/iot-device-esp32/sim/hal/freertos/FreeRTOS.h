@@ -0,0 +1,38 @@
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+#include <stdint.h>
+
+// ============================================================================
+// FreeRTOS stand-in for the native simulation build (1 tick = 1 ms)
+// ============================================================================
+// Tasks are sim kernel coroutines and nothing runs in parallel, so the
+// critical section macros only have to compile.
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define configTICK_RATE_HZ      1000
+#define portTICK_PERIOD_MS      1
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFFUL)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0, 0 }
+#define portMUX_INITIALIZE(mux)         do { (mux)->owner = 0; (mux)->count = 0; } while (0)
+#define portENTER_CRITICAL(mux)         do { (void)(mux); } while (0)
+#define portEXIT_CRITICAL(mux)          do { (void)(mux); } while (0)
+#define portENTER_CRITICAL_ISR(mux)     portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)      portEXIT_CRITICAL(mux)
+
+#endif // SIM_FREERTOS_H
@@ -0,0 +1,82 @@
+#ifndef SIM_FREERTOS_TASK_H
+#define SIM_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+#include "sim_kernel.h"
+
+typedef sim::Task* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+typedef enum {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
+} eNotifyAction;
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                          void* arg, UBaseType_t priority, TaskHandle_t* handle,
+                                          BaseType_t core) {
+    (void)priority;
+    sim::Task* task = sim::createTask(fn, arg, name, stackDepth, core);
+    if (handle != nullptr) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg,
+                              UBaseType_t priority, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, arg, priority, handle, 0);
+}
+
+inline void vTaskDelete(TaskHandle_t task) {
+    sim::deleteTask(task);
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    sim::sleepFor((uint64_t)ticks * 1000);
+}
+
+inline TickType_t xTaskGetTickCount() {
+    return (TickType_t)(sim::nowUs() / 1000);
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return sim::currentTask();
+}
+
+inline BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    sim::notify(task, value, (int)action);
+    return pdPASS;
+}
+
+inline BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action,
+                                     BaseType_t* higherPriorityTaskWoken) {
+    if (higherPriorityTaskWoken != nullptr) {
+        *higherPriorityTaskWoken = pdFALSE;
+    }
+    return xTaskNotify(task, value, action);
+}
+
+inline BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value,
+                                  TickType_t ticksToWait) {
+    uint64_t timeoutUs = ticksToWait == portMAX_DELAY ? SIM_NEVER : (uint64_t)ticksToWait * 1000;
+    return sim::waitNotify(clearOnEntry, clearOnExit, value, timeoutUs) ? pdTRUE : pdFALSE;
+}
+
+// Host stacks are not measured: reports the size the task was created with
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return sim::taskStackBytes(task != nullptr ? task : sim::currentTask());
+}
+
+inline const char* pcTaskGetName(TaskHandle_t task) {
+    return sim::taskName(task != nullptr ? task : sim::currentTask());
+}
+
+inline BaseType_t xPortGetCoreID() {
+    return sim::taskCore(sim::currentTask());
+}
+
+#endif // SIM_FREERTOS_TASK_H
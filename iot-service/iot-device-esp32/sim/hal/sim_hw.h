@@ -0,0 +1,59 @@
+#ifndef SIM_HW_H
+#define SIM_HW_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+// ============================================================================
+// SIM HW - Where the HAL meets the simulated parts
+// ============================================================================
+// The Arduino stand-ins (HardwareSerial, pins, I2C drivers) only know these
+// interfaces; the models in sim/src implement them and the runner wires
+// them up before setup() runs.
+
+namespace sim {
+
+// Far end of a UART: gets the firmware's bytes once they are on the wire
+// (`doneUs` = last stop bit). Answers go back through
+// HardwareSerial::deliver().
+class UartPeer {
+public:
+    virtual ~UartPeer() {}
+    virtual void onHostBytes(const uint8_t* data, size_t len, uint64_t doneUs) = 0;
+};
+
+// ---- GPIO ----
+typedef std::function<void(uint8_t pin, uint8_t level)> PinListener;
+typedef std::function<int()> PinSource;
+
+void onPinWrite(uint8_t pin, PinListener listener);      // digitalWrite() on `pin`
+void setDigitalSource(uint8_t pin, PinSource source);    // digitalRead()
+void setAnalogSource(uint8_t pin, PinSource source);     // analogRead(), 12-bit counts
+
+// ---- I2C ----
+// One value per channel: ADS1115 = volts per input, INA219 = 0 bus V /
+// 1 mA, DS3231 = 0 unix time (write() sets it)
+class I2cDevice {
+public:
+    virtual ~I2cDevice() {}
+    virtual double read(uint8_t channel) = 0;
+    virtual void write(uint8_t channel, double value) { (void)channel; (void)value; }
+};
+
+void attachI2c(uint8_t address, I2cDevice* device);
+I2cDevice* findI2c(uint8_t address);
+
+// ---- Console (UART0) ----
+typedef void (*ConsoleSink)(const uint8_t* data, size_t len);
+void setConsoleSink(ConsoleSink sink);
+void consoleWrite(const uint8_t* data, size_t len);
+
+// ---- Chip ----
+void setEfuseMac(uint64_t mac);
+void setResetReason(int reason);     // esp_reset_reason_t of this boot
+void setSdCardPresent(bool present);
+
+} // namespace sim
+
+#endif // SIM_HW_H
@@ -0,0 +1,84 @@
+#ifndef SIM_KERNEL_H
+#define SIM_KERNEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+// ============================================================================
+// SIM KERNEL - Virtual time and cooperative tasks for the native build
+// ============================================================================
+// Arduino's loopTask (setup(), loop()) and every task the firmware creates
+// run as coroutines on one host thread. A task runs until it blocks -
+// delay(), xTaskNotifyWait(), a UART flush - and the kernel then moves the
+// virtual clock straight to the earliest wake-up or scheduled event. Code
+// itself takes no virtual time, only waits do, so a simulated day passes
+// in seconds and two runs with the same options are identical. Nothing
+// runs concurrently: spinlocks are no-ops and no code may block while it
+// holds a std::mutex.
+//
+// Busy-wait loops (polling available() or millis() until a timeout) would
+// never see the clock move. Those calls spend spin credits; a task that
+// runs out sleeps SIM_SPIN_STEP_US and lets the others run.
+//
+// Simulated parts react through events: schedule() runs a callback at a
+// virtual time, between task switches (like an ISR or the UART event task).
+//
+// Outside run() (host benches calling firmware code directly) there is no
+// scheduler: delays and busy waits just move the clock, events never run.
+
+#define SIM_SPIN_LIMIT          1024    // Credits before a busy task sleeps
+#define SIM_SPIN_STEP_US        1000
+#define SIM_NEVER               UINT64_MAX
+#define SIM_TASK_STACK_BYTES    (1024 * 1024)   // Host stack per task (firmware sizes are reported only)
+
+namespace sim {
+
+struct Task;
+typedef std::function<void()> Event;
+
+uint64_t nowUs();
+
+// Calling task only
+void sleepUntil(uint64_t us);
+void sleepFor(uint64_t us);
+void spin(uint32_t credits);
+
+// Run `event` at virtual time `us` (never before now)
+void schedule(uint64_t us, Event event);
+
+// ---- Tasks (FreeRTOS mapping in freertos/task.h) ----
+Task* createTask(void (*fn)(void*), void* arg, const char* name, uint32_t stackBytes, int core);
+Task* currentTask();            // nullptr inside an event
+void deleteTask(Task* task);    // nullptr = calling task, does not return then
+
+// eSetBits / eIncrement / eSetValueWithOverwrite
+void notify(Task* task, uint32_t value, int action);
+// Bits (or count) received; false on timeout
+bool waitNotify(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, uint64_t timeoutUs);
+
+const char* taskName(const Task* task);
+uint32_t taskStackBytes(const Task* task);
+int taskCore(const Task* task);
+
+// ---- Runner ----
+// Start loopTask (`setupFn` once, then `loopFn` forever) and run until
+// `untilUs` or stop(); returns the reason ("" = time limit reached)
+const char* run(void (*setupFn)(), void (*loopFn)(), uint64_t untilUs);
+
+// Before run(): a boot after ESP.restart() carries on from the old clock
+void setStartTime(uint64_t us);
+
+// End the run at the next task switch (ESP.restart(), fatal model errors)
+void stop(const char* reason);
+
+struct Stats {
+    uint64_t switches;          // Task resumptions
+    uint64_t events;
+    uint64_t spinSleeps;        // Busy waits turned into sleeps
+};
+const Stats& getStats();
+
+} // namespace sim
+
+#endif // SIM_KERNEL_H
@@ -0,0 +1,172 @@
+#include <Arduino.h>
+#include <map>
+#include "sim_hw.h"
+
+// ============================================================================
+// ARDUINO CORE - Time, GPIO, chip (native simulation build)
+// ============================================================================
+
+#define SIM_GPIO_COUNT          49
+#define SIM_FREE_HEAP_BYTES     262144  // Reported, not measured
+#define SIM_SHUTDOWN_HANDLERS   5
+
+EspClass ESP;
+
+namespace {
+    uint8_t pinLevels[SIM_GPIO_COUNT];
+    std::multimap<uint8_t, sim::PinListener> pinListeners;
+    std::map<uint8_t, sim::PinSource> digitalSources;
+    std::map<uint8_t, sim::PinSource> analogSources;
+
+    uint64_t efuseMac = 0x8C4F00A1B2C3ULL;
+    esp_reset_reason_t resetReason = ESP_RST_POWERON;
+    shutdown_handler_t shutdownHandlers[SIM_SHUTDOWN_HANDLERS];
+    uint8_t shutdownHandlerCount = 0;
+}
+
+// ============================================================================
+// TIME
+// ============================================================================
+// Reading the clock is free but counts as spinning, so a loop polling
+// millis() for a timeout lets virtual time move.
+
+unsigned long millis() {
+    sim::spin(1);
+    return (unsigned long)(sim::nowUs() / 1000);
+}
+
+unsigned long micros() {
+    sim::spin(1);
+    return (unsigned long)sim::nowUs();
+}
+
+void delay(uint32_t ms) {
+    sim::sleepFor((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+    sim::sleepFor(us);
+}
+
+void yield() {
+    sim::spin(16);
+}
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1, const char* server2,
+                const char* server3) {
+    (void)gmtOffsetSec;
+    (void)daylightOffsetSec;
+    (void)server1;
+    (void)server2;
+    (void)server3;
+}
+
+// ============================================================================
+// GPIO / ADC
+// ============================================================================
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin >= SIM_GPIO_COUNT) {
+        return;
+    }
+    pinLevels[pin] = val ? HIGH : LOW;
+
+    auto range = pinListeners.equal_range(pin);
+    for (auto it = range.first; it != range.second; ++it) {
+        it->second(pin, pinLevels[pin]);
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    auto it = digitalSources.find(pin);
+    if (it != digitalSources.end()) {
+        return it->second() ? HIGH : LOW;
+    }
+    return pin < SIM_GPIO_COUNT ? pinLevels[pin] : LOW;
+}
+
+uint16_t analogRead(uint8_t pin) {
+    auto it = analogSources.find(pin);
+    if (it == analogSources.end()) {
+        return 0;
+    }
+    int counts = it->second();
+    return (uint16_t)(counts < 0 ? 0 : (counts > 4095 ? 4095 : counts));
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    if (inMax == inMin) {
+        return outMin;
+    }
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+namespace sim {
+
+void onPinWrite(uint8_t pin, PinListener listener) {
+    pinListeners.insert(std::make_pair(pin, listener));
+}
+
+void setDigitalSource(uint8_t pin, PinSource source) {
+    digitalSources[pin] = source;
+}
+
+void setAnalogSource(uint8_t pin, PinSource source) {
+    analogSources[pin] = source;
+}
+
+void setEfuseMac(uint64_t mac) {
+    efuseMac = mac;
+}
+
+void setResetReason(int reason) {
+    resetReason = (esp_reset_reason_t)reason;
+}
+
+} // namespace sim
+
+// ============================================================================
+// CHIP
+// ============================================================================
+
+uint64_t EspClass::getEfuseMac() {
+    return efuseMac;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return SIM_FREE_HEAP_BYTES;
+}
+
+void EspClass::restart() {
+    esp_restart();
+}
+
+esp_reset_reason_t esp_reset_reason(void) {
+    return resetReason;
+}
+
+// Shutdown handlers run as on the chip, then the run ends (sim_main.cpp reboots)
+void esp_restart(void) {
+    for (uint8_t i = 0; i < shutdownHandlerCount; i++) {
+        shutdownHandlers[i]();
+    }
+    sim::stop("ESP.restart()");
+    abort();    // Only reached from a simulated event
+}
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) {
+    if (shutdownHandlerCount >= SIM_SHUTDOWN_HANDLERS) {
+        return ESP_FAIL;
+    }
+    shutdownHandlers[shutdownHandlerCount++] = handler;
+    return ESP_OK;
+}
+
+uint32_t esp_get_free_heap_size(void) {
+    return SIM_FREE_HEAP_BYTES;
+}
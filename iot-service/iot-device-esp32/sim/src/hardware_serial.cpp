@@ -0,0 +1,156 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include "sim_kernel.h"
+
+// ============================================================================
+// HARDWARE SERIAL - UARTs on a simulated wire (native simulation build)
+// ============================================================================
+
+#define SIM_UART_COUNT          3
+#define SIM_UART_POLL_CREDITS   64      // Spin credits per empty poll (~60 us)
+
+namespace {
+    HardwareSerial* uarts[SIM_UART_COUNT];
+
+    void stdoutSink(const uint8_t* data, size_t len) {
+        fwrite(data, 1, len, stdout);
+    }
+
+    sim::ConsoleSink consoleSink = stdoutSink;
+}
+
+HardwareSerial Serial(0);
+
+namespace sim {
+
+void setConsoleSink(ConsoleSink sink) {
+    consoleSink = sink;
+}
+
+void consoleWrite(const uint8_t* data, size_t len) {
+    if (consoleSink) {
+        consoleSink(data, len);
+    }
+}
+
+} // namespace sim
+
+HardwareSerial::HardwareSerial(uint8_t uartNum) {
+    this->uartNum = uartNum;
+    byteUs = 10000000UL / 115200;
+    peer = nullptr;
+    rxLineFreeUs = 0;
+    txDoneUs = 0;
+    txBytes = 0;
+    rxBytes = 0;
+
+    if (uartNum < SIM_UART_COUNT) {
+        uarts[uartNum] = this;
+    }
+}
+
+HardwareSerial* HardwareSerial::byNumber(uint8_t uartNum) {
+    return uartNum < SIM_UART_COUNT ? uarts[uartNum] : nullptr;
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin, bool invert,
+                           unsigned long timeoutMs, uint8_t rxfifoFullThreshold) {
+    (void)config;
+    (void)rxPin;
+    (void)txPin;
+    (void)invert;
+    (void)timeoutMs;
+    (void)rxfifoFullThreshold;
+
+    // 8N1 = 10 bit times per byte
+    byteUs = baud ? (uint32_t)(10000000UL / baud) : byteUs;
+    if (byteUs == 0) {
+        byteUs = 1;
+    }
+}
+
+void HardwareSerial::onReceive(std::function<void()> callback, bool onlyOnTimeout) {
+    (void)onlyOnTimeout;
+    receiveCallback = callback;
+}
+
+bool HardwareSerial::rxReady() {
+    return !rx.empty() && rx.front().atUs <= sim::nowUs();
+}
+
+int HardwareSerial::available() {
+    uint64_t now = sim::nowUs();
+    int count = 0;
+    for (const RxByte& b : rx) {
+        if (b.atUs > now) {
+            break;
+        }
+        count++;
+    }
+    if (count == 0) {
+        sim::spin(SIM_UART_POLL_CREDITS);
+    }
+    return count;
+}
+
+int HardwareSerial::read() {
+    if (!rxReady()) {
+        sim::spin(SIM_UART_POLL_CREDITS);
+        return -1;
+    }
+    uint8_t value = rx.front().value;
+    rx.pop_front();
+    rxBytes++;
+    return value;
+}
+
+int HardwareSerial::peek() {
+    if (!rxReady()) {
+        sim::spin(SIM_UART_POLL_CREDITS);
+        return -1;
+    }
+    return rx.front().value;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (uartNum == 0) {
+        sim::consoleWrite(buffer, size);
+        return size;
+    }
+
+    uint64_t start = txDoneUs > sim::nowUs() ? txDoneUs : sim::nowUs();
+    txDoneUs = start + (uint64_t)size * byteUs;
+    txBytes += size;
+    if (peer) {
+        peer->onHostBytes(buffer, size, txDoneUs);
+    }
+    return size;
+}
+
+void HardwareSerial::flush() {
+    if (uartNum != 0 && txDoneUs > sim::nowUs()) {
+        sim::sleepUntil(txDoneUs);
+    }
+}
+
+void HardwareSerial::deliver(const uint8_t* data, size_t len, uint64_t atUs) {
+    uint64_t t = atUs;
+    if (t < rxLineFreeUs) t = rxLineFreeUs;
+    if (t < sim::nowUs()) t = sim::nowUs();
+
+    for (size_t i = 0; i < len; i++) {
+        t += byteUs;
+        rx.push_back(RxByte{t, data[i]});
+    }
+    rxLineFreeUs = t;
+
+    // RX timeout interrupt: only if nothing else arrived in the meantime
+    if (receiveCallback && len > 0) {
+        uint64_t lastByteUs = t;
+        sim::schedule(t + 2ULL * byteUs, [this, lastByteUs]() {
+            if (rxLineFreeUs == lastByteUs && receiveCallback) {
+                receiveCallback();
+            }
+        });
+    }
+}
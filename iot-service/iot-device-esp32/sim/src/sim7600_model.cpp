@@ -0,0 +1,556 @@
+#include "sim7600_model.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+#include "sim_kernel.h"
+#include "sim_server.h"
+
+// ============================================================================
+// SIM7600 MODEL IMPLEMENTATION
+// ============================================================================
+
+#define MODEL_PWRKEY_ON_US      500000      // Shortest press that starts the modem
+#define MODEL_PWRKEY_OFF_US     1300000     // Shortest press that shuts it down
+#define MODEL_RESET_US          100000
+#define MODEL_POWER_DOWN_US     500000      // Press released -> "NORMAL POWER DOWN"
+#define MODEL_NOT_PRESSED       UINT64_MAX
+
+Sim7600Model::Sim7600Model(HardwareSerial& uart, SimServer& server, const Options& options)
+    : uart(uart), server(server), options(options), rng(options.seed) {
+    memset(&stats, 0, sizeof(stats));
+    power = POWER_OFF;
+    generation = 0;
+    pwrkeyPressedUs = MODEL_NOT_PRESSED;
+    resetPressedUs = MODEL_NOT_PRESSED;
+    echo = true;
+    simReady = false;
+    registered = false;
+    netOpen = false;
+    cellDownUntilUs = 0;
+    networkFreeUs = 0;
+    mqttStarted = false;
+    mqttAcquired = false;
+    mqttConnected = false;
+    tlsClient = false;
+    sslBound = false;
+    lastCr = false;
+    expectData = 0;
+    pendingData = DATA_NONE;
+}
+
+void Sim7600Model::begin() {
+    uart.attach(this);
+    sim::onPinWrite(SIM7600_PWRKEY_PIN, [this](uint8_t, uint8_t level) { onPwrkey(level); });
+    #if SIM7600_RESET_PIN >= 0
+    sim::onPinWrite(SIM7600_RESET_PIN, [this](uint8_t, uint8_t level) { onReset(level); });
+    #endif
+
+    if (options.startOn) {
+        powerOn(true);
+    }
+    scheduleNextOutage();
+}
+
+// ============================================================================
+// POWER
+// ============================================================================
+
+void Sim7600Model::onPwrkey(uint8_t level) {
+    uint64_t now = sim::nowUs();
+    if (level == HIGH) {
+        pwrkeyPressedUs = now;
+        return;
+    }
+    if (pwrkeyPressedUs == MODEL_NOT_PRESSED) {
+        return;
+    }
+
+    uint64_t held = now - pwrkeyPressedUs;
+    pwrkeyPressedUs = MODEL_NOT_PRESSED;
+    if (power == POWER_OFF && held >= MODEL_PWRKEY_ON_US) {
+        powerOn(false);
+    } else if (power != POWER_OFF && held >= MODEL_PWRKEY_OFF_US) {
+        powerOff();
+    }
+}
+
+void Sim7600Model::onReset(uint8_t level) {
+    uint64_t now = sim::nowUs();
+    if (level == HIGH) {
+        resetPressedUs = now;
+        return;
+    }
+    if (resetPressedUs == MODEL_NOT_PRESSED) {
+        return;
+    }
+
+    uint64_t held = now - resetPressedUs;
+    resetPressedUs = MODEL_NOT_PRESSED;
+    if (power != POWER_OFF && held >= MODEL_RESET_US) {
+        stats.resets++;
+        loseMqtt(0);
+        powerOn(false);
+    }
+}
+
+void Sim7600Model::powerOn(bool instant) {
+    generation++;
+    stats.powerOns++;
+
+    echo = true;
+    simReady = false;
+    registered = false;
+    netOpen = false;
+    sockets.clear();
+    networkFreeUs = 0;
+    mqttStarted = false;
+    mqttAcquired = false;
+    mqttConnected = false;
+    tlsClient = false;
+    sslBound = false;
+    line.clear();
+    lastCr = false;
+    expectData = 0;
+    pendingData = DATA_NONE;
+
+    if (instant) {
+        power = POWER_ON;
+        simReady = true;
+        tryRegister();
+        return;
+    }
+
+    power = POWER_BOOTING;
+    uint32_t gen = generation;
+    uint64_t now = sim::nowUs();
+    uint64_t rdyUs = (uint64_t)options.bootMs * 1000;
+
+    sim::schedule(now + rdyUs, [this, gen]() {
+        if (gen == generation) {
+            power = POWER_ON;
+            urc("RDY", 0);
+        }
+    });
+    sim::schedule(now + rdyUs + 1000000, [this, gen]() {
+        if (gen == generation) {
+            simReady = true;
+            urc("+CPIN: READY", 0);
+        }
+    });
+    urc("SMS DONE", rdyUs + 2500000);
+    urc("PB DONE", rdyUs + 3000000);
+    sim::schedule(now + rdyUs + (uint64_t)options.registerMs * 1000, [this, gen]() {
+        if (gen == generation) {
+            tryRegister();
+        }
+    });
+}
+
+void Sim7600Model::powerOff() {
+    stats.powerOffs++;
+    loseMqtt(0);
+    generation++;
+    power = POWER_OFF;
+    simReady = false;
+    registered = false;
+    netOpen = false;
+    sockets.clear();
+    mqttStarted = false;
+    mqttAcquired = false;
+    urc("NORMAL POWER DOWN", MODEL_POWER_DOWN_US);
+}
+
+// ============================================================================
+// NETWORK
+// ============================================================================
+
+void Sim7600Model::tryRegister() {
+    uint64_t now = sim::nowUs();
+    if (power == POWER_OFF) {
+        return;
+    }
+    if (now >= cellDownUntilUs) {
+        registered = true;
+        return;
+    }
+
+    uint32_t gen = generation;
+    sim::schedule(cellDownUntilUs, [this, gen]() {
+        if (gen == generation) {
+            tryRegister();
+        }
+    });
+}
+
+void Sim7600Model::scheduleNextOutage() {
+    if (options.dropsPerDay <= 0) {
+        return;
+    }
+    std::exponential_distribution<double> gap(options.dropsPerDay / 86400e6);
+    sim::schedule(sim::nowUs() + (uint64_t)gap(rng) + 1, [this]() {
+        outage();
+        scheduleNextOutage();
+    });
+}
+
+void Sim7600Model::outage() {
+    uint64_t now = sim::nowUs();
+    uint64_t untilUs = now + (uint64_t)options.dropS * 1000000;
+    stats.outages++;
+    stats.outageUs += untilUs - (cellDownUntilUs > now ? cellDownUntilUs : now);
+    cellDownUntilUs = untilUs;
+
+    if (power != POWER_ON || !registered) {
+        return;
+    }
+    if (netOpen) {
+        netOpen = false;
+        sockets.clear();
+        urc("+CIPEVENT: NETWORK CLOSED UNEXPECTEDLY", 0);
+    }
+    loseMqtt(3);
+    registered = false;
+    tryRegister();
+}
+
+uint64_t Sim7600Model::halfRttUs() {
+    uint64_t us = (uint64_t)options.rttMs * 500;
+    if (options.jitterMs > 0) {
+        std::uniform_int_distribution<uint64_t> jitter(0, (uint64_t)options.jitterMs * 500);
+        us += jitter(rng);
+    }
+    return us;
+}
+
+// ============================================================================
+// OUTPUT
+// ============================================================================
+
+void Sim7600Model::emit(const std::string& text, uint64_t delayUs) {
+    uint32_t gen = generation;
+    sim::schedule(sim::nowUs() + delayUs, [this, gen, text]() {
+        if (gen == generation) {
+            uart.deliver((const uint8_t*)text.data(), text.size(), sim::nowUs());
+        }
+    });
+}
+
+void Sim7600Model::reply(const std::string& text) {
+    if (text.find("ERROR") != std::string::npos) {
+        stats.errors++;
+    }
+    emit(text, (uint64_t)options.atMs * 1000);
+}
+
+void Sim7600Model::networkEmit(const std::string& text, uint32_t trips) {
+    uint64_t now = sim::nowUs();
+    uint64_t at = now + (uint64_t)options.atMs * 1000;
+    for (uint32_t i = 0; i < trips; i++) {
+        at += halfRttUs();
+    }
+    if (at < networkFreeUs) {
+        at = networkFreeUs;
+    }
+    networkFreeUs = at;
+    emit(text, at - now);
+}
+
+void Sim7600Model::deliverMessage(const std::string& topic, const std::string& payload) {
+    if (!mqttConnected) {
+        stats.inboundLost++;
+        return;
+    }
+    stats.inbound++;
+
+    char head[96];
+    snprintf(head, sizeof(head), "\r\n+CMQTTRXSTART: 0,%zu,%zu\r\n+CMQTTRXTOPIC: 0,%zu\r\n",
+             topic.size(), payload.size(), topic.size());
+    std::string s = head;
+    s += topic;
+    snprintf(head, sizeof(head), "\r\n+CMQTTRXPAYLOAD: 0,%zu\r\n", payload.size());
+    s += head;
+    s += payload;
+    s += "\r\n+CMQTTRXEND: 0\r\n";
+    networkEmit(s, 1);
+}
+
+void Sim7600Model::loseMqtt(unsigned reason) {
+    if (!mqttConnected) {
+        return;
+    }
+    mqttConnected = false;
+    stats.connLost++;
+    networkFreeUs = 0;
+    server.onDisconnect();
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "+CMQTTCONNLOST: 0,%u", reason);
+    urc(buf, (uint64_t)options.atMs * 1000);
+}
+
+// ============================================================================
+// INPUT
+// ============================================================================
+
+void Sim7600Model::onHostBytes(const uint8_t* data, size_t len, uint64_t doneUs) {
+    std::string bytes((const char*)data, len);
+    sim::schedule(doneUs, [this, bytes]() {
+        if (power != POWER_ON) {
+            return;     // Off or still booting: the UART is not listening
+        }
+        for (char c : bytes) {
+            receive((uint8_t)c);
+        }
+    });
+}
+
+void Sim7600Model::receive(uint8_t c) {
+    bool afterCr = lastCr;
+    lastCr = c == '\r';
+    if (c == '\n' && afterCr) {
+        return;     // LF ending the command line, not prompt data
+    }
+    if (expectData > 0) {
+        data += (char)c;
+        if (--expectData == 0) {
+            dataDone();
+        }
+    } else if (c == '\r') {
+        handleCommand(line);
+        line.clear();
+    } else {
+        line += (char)c;
+    }
+}
+
+void Sim7600Model::prompt(DataTarget target, size_t length) {
+    pendingData = target;
+    expectData = length;
+    data.clear();
+    reply("\r\n>");
+}
+
+void Sim7600Model::dataDone() {
+    switch (pendingData) {
+        case DATA_TOPIC:
+            topic = data;
+            reply("\r\nOK\r\n");
+            break;
+        case DATA_PAYLOAD:
+            payload = data;
+            reply("\r\nOK\r\n");
+            break;
+        case DATA_SUB:
+            reply("\r\nOK\r\n");
+            if (mqttConnected) {
+                std::string filter = data;
+                sim::schedule(sim::nowUs() + halfRttUs(), [this, filter]() { server.onSubscribe(filter); });
+                networkUrc("+CMQTTSUB: 0,0", 2);
+            } else {
+                urc("+CMQTTSUB: 0,11", (uint64_t)options.atMs * 1000);
+            }
+            break;
+        default:
+            break;
+    }
+    pendingData = DATA_NONE;
+}
+
+// ============================================================================
+// COMMANDS
+// ============================================================================
+
+void Sim7600Model::handleCommand(const std::string& cmd) {
+    if (cmd.empty()) {
+        return;
+    }
+    stats.commands++;
+    if (echo) {
+        emit(cmd + "\r", 0);
+    }
+
+    unsigned a = 0;
+    char buf[96];
+    const char* s = cmd.c_str();
+
+    if (strcmp(s, "AT") == 0) {
+        reply("\r\nOK\r\n");
+    } else if (strcmp(s, "ATE0") == 0 || strcmp(s, "ATE1") == 0) {
+        echo = s[3] == '1';
+        reply("\r\nOK\r\n");
+    } else if (strcmp(s, "AT+CPIN?") == 0) {
+        reply(simReady ? "\r\n+CPIN: READY\r\n\r\nOK\r\n" : "\r\n+CME ERROR: SIM busy\r\n");
+    } else if (strcmp(s, "AT+CGREG?") == 0) {
+        snprintf(buf, sizeof(buf), "\r\n+CGREG: 0,%d\r\n\r\nOK\r\n", registered ? 1 : 2);
+        reply(buf);
+    } else if (strcmp(s, "AT+CSQ") == 0) {
+        std::uniform_int_distribution<int> rssi(14, 24);
+        snprintf(buf, sizeof(buf), "\r\n+CSQ: %d,99\r\n\r\nOK\r\n", registered ? rssi(rng) : 99);
+        reply(buf);
+    } else if (strcmp(s, "AT+COPS?") == 0) {
+        reply(registered ? "\r\n+COPS: 0,0,\"SIM NET\",7\r\n\r\nOK\r\n" : "\r\n+COPS: 0\r\n\r\nOK\r\n");
+    } else if (strcmp(s, "AT+NETCLOSE") == 0) {
+        if (netOpen) {
+            netOpen = false;
+            sockets.clear();
+            loseMqtt(1);
+            reply("\r\nOK\r\n");
+            urc("+NETCLOSE: 0", (uint64_t)options.atMs * 1000 + 100000);
+        } else {
+            reply("\r\n+NETCLOSE: 2\r\n\r\nERROR\r\n");
+        }
+    } else if (strcmp(s, "AT+NETOPEN?") == 0) {
+        snprintf(buf, sizeof(buf), "\r\n+NETOPEN: %d\r\n\r\nOK\r\n", netOpen ? 1 : 0);
+        reply(buf);
+    } else if (strcmp(s, "AT+NETOPEN") == 0) {
+        if (netOpen) {
+            reply("\r\n+IP ERROR: Network is already opened\r\n\r\nERROR\r\n");
+            return;
+        }
+        reply("\r\nOK\r\n");
+        uint32_t gen = generation;
+        sim::schedule(sim::nowUs() + (uint64_t)options.netOpenMs * 1000, [this, gen]() {
+            if (gen != generation) {
+                return;
+            }
+            netOpen = registered;
+            if (netOpen) {
+                stats.netOpens++;
+            }
+            urc(netOpen ? "+NETOPEN: 0" : "+NETOPEN: 1", 0);
+        });
+    } else if (strcmp(s, "AT+IPADDR") == 0) {
+        if (netOpen) {
+            snprintf(buf, sizeof(buf), "\r\n+IPADDR: 10.64.%u.%u\r\n\r\nOK\r\n",
+                     stats.netOpens / 250 % 250, stats.netOpens % 250 + 2);
+            reply(buf);
+        } else {
+            reply("\r\n+IP ERROR: Network not opened\r\n\r\nERROR\r\n");
+        }
+    } else if (sscanf(s, "AT+CIPOPEN=%u,", &a) == 1) {
+        reply("\r\nOK\r\n");
+        snprintf(buf, sizeof(buf), "+CIPOPEN: %u,%d", a, netOpen ? 0 : 1);
+        if (netOpen) {
+            sockets.insert(a);
+            networkUrc(buf, 2);
+        } else {
+            urc(buf, (uint64_t)options.atMs * 1000);
+        }
+    } else if (sscanf(s, "AT+CIPCLOSE=%u", &a) == 1) {
+        if (sockets.erase(a) > 0) {
+            reply("\r\nOK\r\n");
+            snprintf(buf, sizeof(buf), "+CIPCLOSE: %u,0", a);
+            networkUrc(buf, 1);
+        } else {
+            snprintf(buf, sizeof(buf), "\r\n+CIPCLOSE: %u,4\r\n\r\nERROR\r\n", a);
+            reply(buf);
+        }
+    } else if (strncmp(s, "AT+CGAUTH=", 10) == 0 || strncmp(s, "AT+CGDCONT=", 11) == 0 ||
+               strncmp(s, "AT+CIPMODE=", 11) == 0 || strncmp(s, "AT+CIPSENDMODE=", 15) == 0 ||
+               strncmp(s, "AT+CIPCCFG=", 11) == 0 || strncmp(s, "AT+CIPTIMEOUT=", 14) == 0 ||
+               strncmp(s, "AT+CIPRXGET=", 12) == 0) {
+        reply("\r\nOK\r\n");
+    } else if (!handleCmqtt(s)) {
+        reply("\r\nERROR\r\n");
+    }
+}
+
+// CMQTT command set, as FakeSim7600 in bench/cmqtt_sim.cpp
+bool Sim7600Model::handleCmqtt(const char* s) {
+    unsigned a = 0, b = 0, c = 0, d = 0, e = 0;
+    char buf[64];
+
+    if (strcmp(s, "AT+CMQTTDISC?") == 0) {
+        snprintf(buf, sizeof(buf), "\r\n+CMQTTDISC: 0,%d\r\n\r\nOK\r\n", mqttConnected ? 0 : 1);
+        reply(buf);
+    } else if (sscanf(s, "AT+CMQTTDISC=%u,%u", &a, &b) == 2) {
+        if (mqttConnected) {
+            mqttConnected = false;
+            sim::schedule(sim::nowUs() + halfRttUs(), [this]() { server.onDisconnect(); });
+            reply("\r\nOK\r\n");
+            networkUrc("+CMQTTDISC: 0,0", 2);
+        } else {
+            reply("\r\n+CMQTTDISC: 0,11\r\n\r\nERROR\r\n");
+        }
+    } else if (sscanf(s, "AT+CMQTTREL=%u", &a) == 1) {
+        reply(mqttAcquired && !mqttConnected ? "\r\nOK\r\n" : "\r\nERROR\r\n");
+        if (!mqttConnected) {
+            mqttAcquired = false;
+            sslBound = false;
+        }
+    } else if (strcmp(s, "AT+CMQTTSTART") == 0) {
+        reply(mqttStarted ? "\r\n+CMQTTSTART: 23\r\n\r\nERROR\r\n" : "\r\nOK\r\n\r\n+CMQTTSTART: 0\r\n");
+        mqttStarted = true;
+    } else if (strcmp(s, "AT+CMQTTSTOP") == 0) {
+        loseMqtt(0);
+        reply(mqttStarted ? "\r\nOK\r\n\r\n+CMQTTSTOP: 0\r\n" : "\r\nERROR\r\n");
+        mqttStarted = false;
+        mqttAcquired = false;
+    } else if (strncmp(s, "AT+CMQTTACCQ=", 13) == 0) {
+        bool ok = mqttStarted && !mqttAcquired;
+        reply(ok ? "\r\nOK\r\n" : "\r\nERROR\r\n");
+        if (ok) {
+            const char* open = strchr(s, '"');
+            const char* close = open ? strchr(open + 1, '"') : nullptr;
+            clientId = close ? std::string(open + 1, close) : std::string();
+            size_t len = strlen(s);
+            tlsClient = len > 2 && strcmp(s + len - 2, ",1") == 0;
+            mqttAcquired = true;
+        }
+    } else if (strncmp(s, "AT+CSSLCFG=", 11) == 0) {
+        reply("\r\nOK\r\n");
+    } else if (sscanf(s, "AT+CMQTTSSLCFG=%u,%u", &a, &b) == 2) {
+        sslBound = mqttAcquired && tlsClient;
+        reply(sslBound ? "\r\nOK\r\n" : "\r\nERROR\r\n");
+    } else if (strncmp(s, "AT+CMQTTCONNECT=", 16) == 0) {
+        if (!mqttAcquired || mqttConnected || tlsClient != sslBound) {
+            reply("\r\nERROR\r\n");
+            return true;
+        }
+        reply("\r\nOK\r\n");
+        if (!netOpen) {
+            urc("+CMQTTCONNECT: 0,6", (uint64_t)options.atMs * 1000 + 1000000);
+            return true;
+        }
+
+        const char* lastComma = strrchr(s, ',');
+        bool clean = lastComma && lastComma[1] == '1';
+        mqttConnected = true;
+        stats.mqttConnects++;
+        std::string id = clientId;
+        sim::schedule(sim::nowUs() + halfRttUs(), [this, id, clean]() { server.onConnect(id, clean); });
+        // TCP handshake + CONNACK, plus a full TLS 1.2 handshake
+        networkUrc("+CMQTTCONNECT: 0,0", tlsClient ? 8 : 4);
+    } else if (sscanf(s, "AT+CMQTTSUB=%u,%u,%u", &a, &b, &c) == 3) {
+        prompt(DATA_SUB, b);
+    } else if (sscanf(s, "AT+CMQTTTOPIC=%u,%u", &a, &b) == 2) {
+        prompt(DATA_TOPIC, b);
+    } else if (sscanf(s, "AT+CMQTTPAYLOAD=%u,%u", &a, &b) == 2) {
+        prompt(DATA_PAYLOAD, b);
+    } else if (sscanf(s, "AT+CMQTTPUB=%u,%u,%u,%u,%u", &a, &b, &c, &d, &e) == 5) {
+        if (!mqttConnected) {
+            reply("\r\n+CMQTTPUB: 0,11\r\n\r\nERROR\r\n");
+            return true;
+        }
+        reply("\r\nOK\r\n");
+        stats.publishes++;
+        if (e) {
+            stats.dupPublishes++;
+        }
+
+        std::string t = topic, p = payload;
+        bool dup = e != 0;
+        sim::schedule(sim::nowUs() + halfRttUs(), [this, t, p, dup]() { server.onPublish(t, p, dup); });
+
+        std::uniform_real_distribution<double> loss(0.0, 1.0);
+        if (options.urcLoss > 0 && loss(rng) < options.urcLoss) {
+            stats.pubResultsDropped++;
+        } else {
+            networkUrc("+CMQTTPUB: 0,0", 2);
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,154 @@
+#ifndef SIM7600_MODEL_H
+#define SIM7600_MODEL_H
+
+#include <stdint.h>
+#include <random>
+#include <set>
+#include <string>
+#include "sim_hw.h"
+
+class HardwareSerial;
+class SimServer;
+
+// ============================================================================
+// SIM7600 MODEL - The modem on UART1 (native simulation build)
+// ============================================================================
+// Answers the AT commands the firmware sends: boot and SIM URCs, network
+// registration, the TCP/IP data session (+NETOPEN, +CIPOPEN for the probe)
+// and the CMQTT command set with ">" data prompts (as bench/cmqtt_sim.cpp's
+// FakeSim7600). Broker traffic goes to SimServer after half a round trip.
+//
+// PWRKEY and RESET are watched like the real pins (through the board's
+// transistors, HIGH = pressed): a press of >= 500 ms starts an off modem,
+// >= 1300 ms shuts a running one down, a RESET press reboots it. Boot takes
+// bootMs to RDY, then the SIM and phonebook URCs; registration follows.
+//
+// Network drops arrive at random (exponential, dropsPerDay on average):
+// the data session and MQTT connection are lost with their URCs and the
+// cell is gone for dropS seconds. urcLoss drops that fraction of
+// "+CMQTTPUB" results, as when another reader eats them.
+
+class Sim7600Model : public sim::UartPeer {
+public:
+    struct Options {
+        uint32_t rttMs;
+        uint32_t jitterMs;          // Extra round-trip delay, uniform 0..jitterMs
+        uint32_t atMs;              // Command processing time
+        uint32_t bootMs;            // PWRKEY to RDY
+        uint32_t registerMs;        // RDY to registered
+        uint32_t netOpenMs;         // +NETOPEN to "+NETOPEN: 0"
+        double dropsPerDay;
+        uint32_t dropS;
+        double urcLoss;             // 0..1
+        bool startOn;               // Already on and registered at t = 0
+        uint64_t seed;
+    };
+
+    struct Stats {
+        uint32_t powerOns;
+        uint32_t powerOffs;
+        uint32_t resets;
+        uint32_t commands;
+        uint32_t errors;            // Commands answered with ERROR
+        uint32_t netOpens;
+        uint32_t mqttConnects;
+        uint32_t connLost;
+        uint32_t publishes;
+        uint32_t dupPublishes;
+        uint32_t pubResultsDropped;
+        uint32_t inbound;           // Messages to the firmware
+        uint32_t inboundLost;       // Broker had a message while disconnected
+        uint32_t outages;
+        uint64_t outageUs;          // Total time without a cell
+    };
+
+    Sim7600Model(HardwareSerial& uart, SimServer& server, const Options& options);
+
+    // Wire up UART and pins; call before setup()
+    void begin();
+
+    // Broker -> device (SimServer)
+    void deliverMessage(const std::string& topic, const std::string& payload);
+
+    bool isMqttConnected() const { return mqttConnected; }
+    const Stats& getStats() const { return stats; }
+
+    void onHostBytes(const uint8_t* data, size_t len, uint64_t doneUs) override;
+
+private:
+    enum PowerState {
+        POWER_OFF,
+        POWER_BOOTING,
+        POWER_ON
+    };
+
+    enum DataTarget {
+        DATA_NONE,
+        DATA_TOPIC,
+        DATA_PAYLOAD,
+        DATA_SUB
+    };
+
+    HardwareSerial& uart;
+    SimServer& server;
+    Options options;
+    Stats stats;
+    std::mt19937_64 rng;
+
+    PowerState power;
+    uint32_t generation;            // Bumped on power change, cancels pending output
+    uint64_t pwrkeyPressedUs;
+    uint64_t resetPressedUs;
+
+    bool echo;
+    bool simReady;
+    bool registered;
+    bool netOpen;
+    uint64_t cellDownUntilUs;
+    uint64_t networkFreeUs;         // Last broker URC due
+    std::set<unsigned> sockets;
+
+    // CMQTT service
+    bool mqttStarted;
+    bool mqttAcquired;
+    bool mqttConnected;
+    bool tlsClient;
+    bool sslBound;
+    std::string clientId;
+
+    // Host bytes
+    std::string line;
+    std::string data;
+    bool lastCr;
+    size_t expectData;
+    DataTarget pendingData;
+    std::string topic;
+    std::string payload;
+
+    void onPwrkey(uint8_t level);
+    void onReset(uint8_t level);
+    void powerOn(bool instant);
+    void powerOff();
+    void tryRegister();
+    void scheduleNextOutage();
+    void outage();
+
+    void receive(uint8_t c);
+    void handleCommand(const std::string& cmd);
+    bool handleCmqtt(const char* s);
+    void prompt(DataTarget target, size_t length);
+    void dataDone();
+    void loseMqtt(unsigned reason);
+
+    // Output after `delayUs`, dropped if the modem restarted meanwhile
+    void emit(const std::string& text, uint64_t delayUs);
+    void reply(const std::string& text);    // Answer to the command, after atMs
+    void urc(const std::string& text, uint64_t delayUs) { emit("\r\n" + text + "\r\n", delayUs); }
+    // Broker traffic after `trips` half round trips, in order with what
+    // came before it (one TCP connection)
+    void networkEmit(const std::string& text, uint32_t trips);
+    void networkUrc(const std::string& text, uint32_t trips) { networkEmit("\r\n" + text + "\r\n", trips); }
+    uint64_t halfRttUs();
+};
+
+#endif // SIM7600_MODEL_H
@@ -0,0 +1,224 @@
+#include <Arduino.h>
+#include <SD.h>
+#include <LittleFS.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+// ============================================================================
+// SIM FS - SD card and LittleFS as host directories (native simulation build)
+// ============================================================================
+
+#define SIM_SD_BYTES            7948206080ULL   // 8 GB card
+
+SDFS SD;
+LittleFSFS LittleFS;
+SPIClass SPI;
+
+namespace {
+    bool sdCardPresent = true;
+
+    uint64_t directoryBytes(const std::string& dir) {
+        DIR* d = opendir(dir.c_str());
+        if (!d) {
+            return 0;
+        }
+        uint64_t total = 0;
+        struct dirent* entry;
+        while ((entry = readdir(d)) != nullptr) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            std::string path = dir + "/" + entry->d_name;
+            struct stat st;
+            if (lstat(path.c_str(), &st) != 0) {
+                continue;
+            }
+            total += S_ISDIR(st.st_mode) ? directoryBytes(path) : (uint64_t)st.st_size;
+        }
+        closedir(d);
+        return total;
+    }
+}
+
+namespace sim {
+
+void setSdCardPresent(bool present) {
+    sdCardPresent = present;
+}
+
+} // namespace sim
+
+namespace fs {
+
+// ============================================================================
+// FILE
+// ============================================================================
+
+File& File::operator=(File&& other) noexcept {
+    if (this != &other) {
+        close();
+        file = other.file;
+        path = std::move(other.path);
+        other.file = nullptr;
+    }
+    return *this;
+}
+
+int File::available() {
+    if (!file) {
+        return 0;
+    }
+    long pos = ftell(file);
+    size_t total = size();
+    return pos >= 0 && (size_t)pos < total ? (int)(total - pos) : 0;
+}
+
+int File::read() {
+    if (!file) {
+        return -1;
+    }
+    int c = fgetc(file);
+    return c == EOF ? -1 : c;
+}
+
+int File::peek() {
+    if (!file) {
+        return -1;
+    }
+    int c = fgetc(file);
+    if (c == EOF) {
+        return -1;
+    }
+    ungetc(c, file);
+    return c;
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    return file ? fwrite(buffer, 1, size, file) : 0;
+}
+
+void File::flush() {
+    if (file) {
+        fflush(file);
+    }
+}
+
+size_t File::size() const {
+    if (!file) {
+        return 0;
+    }
+    fflush(file);
+    struct stat st;
+    return fstat(fileno(file), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+const char* File::name() const {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path.c_str() : path.c_str() + slash + 1;
+}
+
+void File::close() {
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+// ============================================================================
+// FS
+// ============================================================================
+
+bool FS::mount(const char* vfsPath) {
+    while (*vfsPath == '/') {
+        vfsPath++;
+    }
+    mountPoint = vfsPath;
+    if (::mkdir(mountPoint.c_str(), 0777) != 0 && errno != EEXIST) {
+        return false;
+    }
+    mounted = true;
+    return true;
+}
+
+std::string FS::hostPath(const char* path) const {
+    std::string host = mountPoint;
+    if (path[0] != '/') {
+        host += '/';
+    }
+    return host + path;
+}
+
+uint64_t FS::usedBytesOnHost() const {
+    return mounted ? directoryBytes(mountPoint) : 0;
+}
+
+bool FS::exists(const char* path) const {
+    struct stat st;
+    return mounted && stat(hostPath(path).c_str(), &st) == 0;
+}
+
+File FS::open(const char* path, const char* mode) {
+    if (!mounted) {
+        return File();
+    }
+    const char* hostMode = mode[0] == 'w' ? "wb" : (mode[0] == 'a' ? "ab" : "rb");
+    std::string host = hostPath(path);
+    FILE* f = fopen(host.c_str(), hostMode);
+    return f ? File(f, host) : File();
+}
+
+bool FS::remove(const char* path) {
+    return mounted && ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    if (!mounted) {
+        return false;
+    }
+    return ::mkdir(hostPath(path).c_str(), 0777) == 0 || errno == EEXIST;
+}
+
+} // namespace fs
+
+// ============================================================================
+// SD / LITTLEFS
+// ============================================================================
+
+bool SDFS::begin(uint8_t ssPin, SPIClass& spi, uint32_t frequency, const char* mountpoint, uint8_t maxFiles,
+                 bool formatIfEmpty) {
+    (void)ssPin;
+    (void)spi;
+    (void)frequency;
+    (void)maxFiles;
+    (void)formatIfEmpty;
+
+    if (!sdCardPresent) {
+        mounted = false;
+        return false;
+    }
+    return mount(mountpoint);
+}
+
+sdcard_type_t SDFS::cardType() {
+    return mounted ? CARD_SDHC : CARD_NONE;
+}
+
+uint64_t SDFS::cardSize() {
+    return mounted ? SIM_SD_BYTES : 0;
+}
+
+uint64_t SDFS::totalBytes() {
+    return mounted ? SIM_SD_BYTES : 0;
+}
+
+uint64_t SDFS::usedBytes() {
+    return usedBytesOnHost();
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)formatOnFail;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    return mount(basePath);
+}
@@ -0,0 +1,64 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_ADS1X15.h>
+#include <map>
+
+// ============================================================================
+// SIM I2C - Bus registry and the ADS1115 driver (native simulation build)
+// ============================================================================
+
+#define SIM_ADS_CONVERSION_US   9000    // Single shot at 128 SPS
+
+TwoWire Wire;
+
+namespace {
+    std::map<uint8_t, sim::I2cDevice*> i2cDevices;
+}
+
+namespace sim {
+
+void attachI2c(uint8_t address, I2cDevice* device) {
+    i2cDevices[address] = device;
+}
+
+I2cDevice* findI2c(uint8_t address) {
+    auto it = i2cDevices.find(address);
+    return it != i2cDevices.end() ? it->second : nullptr;
+}
+
+} // namespace sim
+
+bool Adafruit_ADS1115::begin(uint8_t address, TwoWire* wire) {
+    (void)wire;
+    this->address = address;
+    return sim::findI2c(address) != nullptr;
+}
+
+int16_t Adafruit_ADS1115::readADC_SingleEnded(uint8_t channel) {
+    sim::I2cDevice* device = sim::findI2c(address);
+    if (!device || channel > 3) {
+        return 0;
+    }
+    delayMicroseconds(SIM_ADS_CONVERSION_US);
+
+    double counts = device->read(channel) / (fullScale() / 32768.0);
+    if (counts > 32767.0) counts = 32767.0;
+    if (counts < -32768.0) counts = -32768.0;
+    return (int16_t)counts;
+}
+
+float Adafruit_ADS1115::computeVolts(int16_t counts) const {
+    return counts * (fullScale() / 32768.0f);
+}
+
+float Adafruit_ADS1115::fullScale() const {
+    switch (gain) {
+        case GAIN_TWOTHIRDS: return 6.144f;
+        case GAIN_ONE:       return 4.096f;
+        case GAIN_TWO:       return 2.048f;
+        case GAIN_FOUR:      return 1.024f;
+        case GAIN_EIGHT:     return 0.512f;
+        case GAIN_SIXTEEN:   return 0.256f;
+    }
+    return 6.144f;
+}
@@ -0,0 +1,339 @@
+#include "sim_kernel.h"
+#include <ucontext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <queue>
+#include <vector>
+
+// ============================================================================
+// SIM KERNEL IMPLEMENTATION
+// ============================================================================
+// The scheduler runs on the host's main stack and switches into one task
+// at a time (ucontext); a blocking call switches back. Tasks due at the
+// same time run in the order they blocked, events due at that time first.
+
+namespace sim {
+
+enum TaskState {
+    TASK_RUNNING,
+    TASK_READY,             // Sleeping until wakeUs
+    TASK_WAITING,           // Notification wait, times out at wakeUs (SIM_NEVER = no timeout)
+    TASK_DEAD
+};
+
+struct Task {
+    ucontext_t context;
+    void* stack;
+    void (*fn)(void*);
+    void* arg;
+    char name[16];
+    uint32_t stackBytes;
+    int core;
+
+    TaskState state;
+    uint64_t wakeUs;
+    uint64_t order;
+    uint32_t notifyValue;
+    bool notified;
+    uint32_t spinCredits;
+};
+
+namespace {
+    struct PendingEvent {
+        uint64_t at;
+        uint64_t order;
+        Event event;
+    };
+
+    struct EventLater {
+        bool operator()(const PendingEvent& a, const PendingEvent& b) const {
+            return a.at != b.at ? a.at > b.at : a.order > b.order;
+        }
+    };
+
+    uint64_t clockUs = 0;
+    uint64_t sequence = 0;
+    std::vector<Task*> tasks;
+    std::priority_queue<PendingEvent, std::vector<PendingEvent>, EventLater> events;
+    Task* current = nullptr;
+    ucontext_t schedulerContext;
+    const char* stopReason = nullptr;
+    bool running = false;
+    uint32_t hostSpinCredits = 0;   // spin() outside run()
+    Stats stats;
+
+    void (*loopSetup)() = nullptr;
+    void (*loopBody)() = nullptr;
+
+    Task* requireTask(const char* what) {
+        if (current == nullptr) {
+            fprintf(stderr, "[Sim] ❌ %s outside of a task (inside a simulated event)\n", what);
+            abort();
+        }
+        return current;
+    }
+
+    // Back to the scheduler until this task is picked again
+    void block() {
+        Task* self = current;
+        self->spinCredits = 0;
+        swapcontext(&self->context, &schedulerContext);
+    }
+
+    void taskEntry() {
+        Task* self = current;
+        self->fn(self->arg);
+        // A FreeRTOS task must not return; treat it as vTaskDelete(NULL)
+        deleteTask(nullptr);
+    }
+
+    void loopTask(void*) {
+        loopSetup();
+        for (;;) {
+            loopBody();
+        }
+    }
+
+    Task* nextDue() {
+        Task* next = nullptr;
+        for (Task* task : tasks) {
+            if ((task->state != TASK_READY && task->state != TASK_WAITING) || task->wakeUs == SIM_NEVER) {
+                continue;
+            }
+            if (next == nullptr || task->wakeUs < next->wakeUs ||
+                (task->wakeUs == next->wakeUs && task->order < next->order)) {
+                next = task;
+            }
+        }
+        return next;
+    }
+
+    void reapDead() {
+        for (size_t i = 0; i < tasks.size();) {
+            if (tasks[i]->state == TASK_DEAD) {
+                free(tasks[i]->stack);
+                delete tasks[i];
+                tasks.erase(tasks.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+}
+
+uint64_t nowUs() {
+    return clockUs;
+}
+
+void sleepUntil(uint64_t us) {
+    if (!running) {
+        // No scheduler (host bench): nothing else to run, time just passes
+        clockUs = us > clockUs && us != SIM_NEVER ? us : clockUs;
+        return;
+    }
+    Task* self = requireTask("sleep");
+    self->state = TASK_READY;
+    self->wakeUs = us > clockUs ? us : clockUs;
+    self->order = sequence++;
+    block();
+}
+
+void sleepFor(uint64_t us) {
+    sleepUntil(us == SIM_NEVER ? SIM_NEVER : clockUs + us);
+}
+
+void spin(uint32_t credits) {
+    if (!running) {
+        hostSpinCredits += credits;
+        if (hostSpinCredits >= SIM_SPIN_LIMIT) {
+            hostSpinCredits = 0;
+            stats.spinSleeps++;
+            clockUs += SIM_SPIN_STEP_US;
+        }
+        return;
+    }
+    if (current == nullptr) {
+        return;
+    }
+    current->spinCredits += credits;
+    if (current->spinCredits >= SIM_SPIN_LIMIT) {
+        stats.spinSleeps++;
+        sleepFor(SIM_SPIN_STEP_US);
+    }
+}
+
+void schedule(uint64_t us, Event event) {
+    PendingEvent pending;
+    pending.at = us > clockUs ? us : clockUs;
+    pending.order = sequence++;
+    pending.event = std::move(event);
+    events.push(std::move(pending));
+}
+
+// ============================================================================
+// TASKS
+// ============================================================================
+
+Task* createTask(void (*fn)(void*), void* arg, const char* name, uint32_t stackBytes, int core) {
+    Task* task = new Task();
+    task->fn = fn;
+    task->arg = arg;
+    snprintf(task->name, sizeof(task->name), "%s", name ? name : "");
+    task->stackBytes = stackBytes;
+    task->core = core;
+    task->state = TASK_READY;
+    task->wakeUs = clockUs;
+    task->order = sequence++;
+    task->notifyValue = 0;
+    task->notified = false;
+    task->spinCredits = 0;
+
+    task->stack = malloc(SIM_TASK_STACK_BYTES);
+    if (task->stack == nullptr || getcontext(&task->context) != 0) {
+        fprintf(stderr, "[Sim] ❌ Cannot create task %s\n", task->name);
+        abort();
+    }
+    task->context.uc_stack.ss_sp = task->stack;
+    task->context.uc_stack.ss_size = SIM_TASK_STACK_BYTES;
+    task->context.uc_link = &schedulerContext;
+    makecontext(&task->context, taskEntry, 0);
+
+    tasks.push_back(task);
+    return task;
+}
+
+Task* currentTask() {
+    return current;
+}
+
+void deleteTask(Task* task) {
+    if (task == nullptr || task == current) {
+        Task* self = requireTask("vTaskDelete(NULL)");
+        self->state = TASK_DEAD;
+        swapcontext(&self->context, &schedulerContext);
+        abort();    // A dead task is never resumed
+    }
+    task->state = TASK_DEAD;
+}
+
+void notify(Task* task, uint32_t value, int action) {
+    if (task == nullptr || task->state == TASK_DEAD) {
+        return;
+    }
+
+    switch (action) {
+        case 1: task->notifyValue |= value; break;     // eSetBits
+        case 2: task->notifyValue++; break;             // eIncrement
+        case 3:                                         // eSetValueWithOverwrite
+        case 4: task->notifyValue = value; break;       // eSetValueWithoutOverwrite
+        default: break;                                 // eNoAction
+    }
+    task->notified = true;
+
+    if (task->state == TASK_WAITING) {
+        task->state = TASK_READY;
+        task->wakeUs = clockUs;
+        task->order = sequence++;
+    }
+}
+
+bool waitNotify(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, uint64_t timeoutUs) {
+    Task* self = requireTask("xTaskNotifyWait");
+
+    if (!self->notified) {
+        self->notifyValue &= ~clearOnEntry;
+        if (timeoutUs > 0) {
+            self->state = TASK_WAITING;
+            self->wakeUs = timeoutUs == SIM_NEVER ? SIM_NEVER : clockUs + timeoutUs;
+            self->order = sequence++;
+            block();
+        }
+    }
+
+    bool received = self->notified;
+    if (value != nullptr) {
+        *value = self->notifyValue;
+    }
+    if (received) {
+        self->notifyValue &= ~clearOnExit;
+        self->notified = false;
+    }
+    return received;
+}
+
+const char* taskName(const Task* task) {
+    return task ? task->name : "";
+}
+
+uint32_t taskStackBytes(const Task* task) {
+    return task ? task->stackBytes : 0;
+}
+
+int taskCore(const Task* task) {
+    return task ? task->core : 0;
+}
+
+// ============================================================================
+// RUNNER
+// ============================================================================
+
+const char* run(void (*setupFn)(), void (*loopFn)(), uint64_t untilUs) {
+    loopSetup = setupFn;
+    loopBody = loopFn;
+    stopReason = nullptr;
+    running = true;
+
+    createTask(loopTask, nullptr, "loopTask", 8192, 1);
+    schedule(untilUs, []() { stopReason = ""; });
+
+    while (stopReason == nullptr) {
+        Task* next = nextDue();
+
+        if (!events.empty() && (next == nullptr || events.top().at <= next->wakeUs)) {
+            PendingEvent pending = events.top();
+            events.pop();
+            clockUs = pending.at > clockUs ? pending.at : clockUs;
+            stats.events++;
+            pending.event();
+            continue;
+        }
+
+        if (next == nullptr) {
+            stopReason = "every task waits forever";
+            break;
+        }
+
+        clockUs = next->wakeUs > clockUs ? next->wakeUs : clockUs;
+        next->state = TASK_RUNNING;
+        next->wakeUs = SIM_NEVER;
+        current = next;
+        stats.switches++;
+        swapcontext(&schedulerContext, &next->context);
+        current = nullptr;
+        reapDead();
+    }
+
+    running = false;
+    return stopReason;
+}
+
+void setStartTime(uint64_t us) {
+    clockUs = us;
+}
+
+void stop(const char* reason) {
+    stopReason = reason;
+    if (current != nullptr) {
+        // Parked for good; the scheduler returns from run() at once
+        current->state = TASK_WAITING;
+        current->wakeUs = SIM_NEVER;
+        block();
+    }
+}
+
+const Stats& getStats() {
+    return stats;
+}
+
+} // namespace sim
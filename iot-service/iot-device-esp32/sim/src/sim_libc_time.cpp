@@ -0,0 +1,54 @@
+// ============================================================================
+// SIM LIBC TIME - time() / gettimeofday() on the virtual clock
+// ============================================================================
+// Defined here, these take precedence over the C library's for the whole
+// executable, so the firmware's calls (and localtime_r() of their results)
+// follow virtual time. As on the chip, the clock counts from 0 at boot
+// until settimeofday() sets it. clock_gettime() is left to the host.
+//
+// The C library's prototypes carry exception specifications that would
+// clash with these definitions; they are renamed while the headers load.
+
+#define time sim_libc_time
+#define gettimeofday sim_libc_gettimeofday
+#define settimeofday sim_libc_settimeofday
+#include <time.h>
+#include <sys/time.h>
+#include "sim_kernel.h"
+#undef time
+#undef gettimeofday
+#undef settimeofday
+
+namespace {
+    int64_t epochOffsetUs = 0;  // Wall clock - virtual clock
+
+    int64_t wallUs() {
+        return (int64_t)sim::nowUs() + epochOffsetUs;
+    }
+}
+
+extern "C" time_t time(time_t* out) {
+    time_t now = (time_t)(wallUs() / 1000000);
+    if (out) {
+        *out = now;
+    }
+    return now;
+}
+
+extern "C" int gettimeofday(struct timeval* tv, void* tz) {
+    (void)tz;
+    if (tv) {
+        int64_t us = wallUs();
+        tv->tv_sec = (time_t)(us / 1000000);
+        tv->tv_usec = (suseconds_t)(us % 1000000);
+    }
+    return 0;
+}
+
+extern "C" int settimeofday(const struct timeval* tv, const void* tz) {
+    (void)tz;
+    if (tv) {
+        epochOffsetUs = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec - (int64_t)sim::nowUs();
+    }
+    return 0;
+}
@@ -0,0 +1,304 @@
+// ============================================================================
+// SIM MAIN - Runs the firmware on a Linux host in virtual time
+// ============================================================================
+// `pio run -e native` builds the real main.cpp and every module under it
+// against the stand-ins in sim/hal; this file wires the simulated parts to
+// the board's UARTs, pins and I2C bus, then runs setup() / loop() until the
+// virtual clock reaches --days / --hours.
+//
+// Parts: SIM7600 on UART1 (sim7600_model.h) with the broker and backend
+// behind it (sim_server.h), power meter (address 1) and TUF-2000 (address
+// 2) on the RS485 bus (sim_modbus.h), ADS1115 / INA219 / DS3231 and the
+// analog inputs (sim_plant.h). SD card and LittleFS are directories under
+// --fs, wiped at start unless --keep-fs.
+//
+// ESP.restart() (the connection manager gives up, a remote reboot) ends the
+// process; the runner prints that boot's report and execs itself again with
+// the clock, the files and the modem's power carried over, so the firmware
+// boots with ESP_RST_SW and static state as fresh as on the chip. RTC
+// memory does not survive. Counters in each report cover that boot only.
+//
+// Build + run:  pio run -e native && .pio/build/native/program --days 1
+// Options:      --days N  --hours N  --rtt MS  --jitter MS  --drops PER_DAY
+//               --drop-s S  --urc-loss 0..1  --modbus-ms MS  --modbus-fail 0..1
+//               --relay-every S  --seed N  --epoch UNIX  --fs DIR  --keep-fs
+//               --modem-on  --no-sd  --no-rtc  --quiet  --log FILE
+//
+// Free heap and task stack high-water marks are fixed stand-in values: the
+// host's allocator and stacks say nothing about the ESP32's.
+
+#include <Arduino.h>
+#include <errno.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include "sim_kernel.h"
+#include "sim_modbus.h"
+#include "sim_plant.h"
+#include "sim_server.h"
+#include "sim7600_model.h"
+
+#define SIM_DEFAULT_EPOCH       1767225600UL    // 2026-01-01 00:00:00 UTC
+#define SIM_DEFAULT_FS_DIR      "sim_fs"
+#define SIM_RESTART_REASON      "ESP.restart()"     // sim::stop() reason from esp_restart()
+
+void setup();
+void loop();
+
+namespace {
+    FILE* logFile = nullptr;
+
+    void fileSink(const uint8_t* data, size_t len) {
+        fwrite(data, 1, len, logFile);
+    }
+
+    int removeEntry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+        (void)st;
+        (void)flag;
+        (void)ftw;
+        ::remove(path);
+        return 0;
+    }
+
+    // Empty the card and flash directories so each run boots a blank board
+    bool prepareFsDir(const char* dir, bool keep) {
+        if (::mkdir(dir, 0777) != 0 && errno != EEXIST) {
+            fprintf(stderr, "cannot create %s: %s\n", dir, strerror(errno));
+            return false;
+        }
+        if (chdir(dir) != 0) {
+            fprintf(stderr, "cannot enter %s: %s\n", dir, strerror(errno));
+            return false;
+        }
+        if (!keep) {
+            nftw("sd", removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+            nftw("littlefs", removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+        }
+        return true;
+    }
+
+    void usage(const char* name) {
+        fprintf(stderr,
+                "usage: %s [--days N] [--hours N] [--rtt MS] [--jitter MS] [--drops PER_DAY] [--drop-s S]\n"
+                "          [--urc-loss 0..1] [--modbus-ms MS] [--modbus-fail 0..1] [--relay-every S]\n"
+                "          [--seed N] [--epoch UNIX] [--fs DIR] [--keep-fs] [--modem-on] [--no-sd]\n"
+                "          [--no-rtc] [--quiet] [--log FILE]\n",
+                name);
+    }
+
+    void printUart(const char* label, HardwareSerial* uart, double days) {
+        if (uart == nullptr) {
+            return;
+        }
+        fprintf(stderr, "  %-8s tx %10llu B  rx %10llu B  (%.0f B/day)\n", label,
+                (unsigned long long)uart->getTxBytes(), (unsigned long long)uart->getRxBytes(),
+                days > 0 ? (uart->getTxBytes() + uart->getRxBytes()) / days : 0.0);
+    }
+}
+
+int main(int argc, char** argv) {
+    double hours = 24;
+    uint64_t resumeUs = 0;      // Internal: boot after ESP.restart()
+    uint32_t boot = 1;
+    const char* fsDir = SIM_DEFAULT_FS_DIR;
+    const char* logPath = nullptr;
+    bool keepFs = false;
+    bool quiet = false;
+    bool sdCard = true;
+
+    sim::PlantOptions plant = {SIM_DEFAULT_EPOCH, true, true};
+    Sim7600Model::Options modem = {300, 100, 20, 12000, 8000, 1500, 2.0, 120, 0.0, false, 1};
+    SimModbusBus::Options modbus = {30, 0.0, 1};
+    SimServer::Options server = {50, 0};
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--resume-us") && hasValue) {
+            resumeUs = strtoull(argv[++i], nullptr, 10);
+            continue;
+        }
+        if (!strcmp(arg, "--boot") && hasValue) {
+            boot = (uint32_t)strtoul(argv[++i], nullptr, 10);
+            continue;
+        }
+        if (!strcmp(arg, "--days") && hasValue) {
+            hours = atof(argv[++i]) * 24;
+        } else if (!strcmp(arg, "--hours") && hasValue) {
+            hours = atof(argv[++i]);
+        } else if (!strcmp(arg, "--rtt") && hasValue) {
+            modem.rttMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--jitter") && hasValue) {
+            modem.jitterMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--drops") && hasValue) {
+            modem.dropsPerDay = atof(argv[++i]);
+        } else if (!strcmp(arg, "--drop-s") && hasValue) {
+            modem.dropS = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--urc-loss") && hasValue) {
+            modem.urcLoss = atof(argv[++i]);
+        } else if (!strcmp(arg, "--modbus-ms") && hasValue) {
+            modbus.responseMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--modbus-fail") && hasValue) {
+            modbus.failRate = atof(argv[++i]);
+        } else if (!strcmp(arg, "--relay-every") && hasValue) {
+            server.relayEveryS = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--seed") && hasValue) {
+            modem.seed = strtoull(argv[++i], nullptr, 10);
+            modbus.seed = modem.seed + 1;
+        } else if (!strcmp(arg, "--epoch") && hasValue) {
+            plant.epoch = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(arg, "--fs") && hasValue) {
+            fsDir = argv[++i];
+        } else if (!strcmp(arg, "--log") && hasValue) {
+            logPath = argv[++i];
+        } else if (!strcmp(arg, "--keep-fs")) {
+            keepFs = true;
+        } else if (!strcmp(arg, "--modem-on")) {
+            modem.startOn = true;
+        } else if (!strcmp(arg, "--no-sd")) {
+            sdCard = false;
+        } else if (!strcmp(arg, "--no-rtc")) {
+            plant.rtc = false;
+        } else if (!strcmp(arg, "--quiet")) {
+            quiet = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (hours <= 0 || modem.urcLoss < 0 || modem.urcLoss > 1 || modbus.failRate < 0 || modbus.failRate > 1) {
+        fprintf(stderr, "duration must be > 0, --urc-loss and --modbus-fail 0..1\n");
+        return 2;
+    }
+
+    // Open the log before chdir() so a relative path means the caller's directory
+    char startDir[4096];
+    if (getcwd(startDir, sizeof(startDir)) == nullptr) {
+        fprintf(stderr, "cannot read the working directory: %s\n", strerror(errno));
+        return 2;
+    }
+    if (logPath != nullptr) {
+        logFile = fopen(logPath, boot > 1 ? "a" : "w");
+        if (logFile == nullptr) {
+            fprintf(stderr, "cannot write %s: %s\n", logPath, strerror(errno));
+            return 2;
+        }
+        sim::setConsoleSink(fileSink);
+    } else if (quiet) {
+        sim::setConsoleSink(nullptr);
+    }
+    if (!prepareFsDir(fsDir, keepFs || boot > 1)) {
+        return 2;
+    }
+
+    // The device keeps UTC; localtime() must agree with the server
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    HardwareSerial* modemUart = HardwareSerial::byNumber(1);
+    HardwareSerial* rs485Uart = HardwareSerial::byNumber(2);
+    if (modemUart == nullptr || rs485Uart == nullptr) {
+        fprintf(stderr, "firmware did not create UART1 / UART2\n");
+        return 2;
+    }
+
+    if (boot > 1) {
+        sim::setStartTime(resumeUs);
+        sim::setResetReason(ESP_RST_SW);
+        modem.startOn = true;   // An MCU reset leaves the modem powered
+        modem.seed += boot - 1; // Not the same drops again
+        modbus.seed += boot - 1;
+    }
+    sim::setSdCardPresent(sdCard);
+    sim::attachPlant(plant);
+
+    SimModbusBus bus(*rs485Uart, modbus);
+    bus.addSlave(1, "3Phase-PowerMeter-V2305", 1);
+    bus.addSlave(2, "TUF-2000-FlowMeter", 1);
+    bus.begin();
+
+    SimServer broker(server);
+    Sim7600Model sim7600(*modemUart, broker, modem);
+    broker.attach(&sim7600);
+    sim7600.begin();
+    broker.begin();
+
+    uint64_t untilUs = (uint64_t)(hours * 3600.0 * 1000000.0);
+    auto wallStart = std::chrono::steady_clock::now();
+    const char* reason = sim::run(setup, loop, untilUs);
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    if (logFile != nullptr) {
+        fflush(logFile);
+    }
+    fflush(stdout);
+
+    // ---- Report (stderr, so it survives --quiet and stays out of the log) ----
+    double virtualS = sim::nowUs() / 1e6;
+    const sim::Stats& ks = sim::getStats();
+    double bootS = virtualS - resumeUs / 1e6;
+    fprintf(stderr, "\n========== SIMULATION REPORT (boot %u) ==========\n", boot);
+    fprintf(stderr, "Stopped: %s\n", reason[0] ? reason : "time limit");
+    fprintf(stderr, "Virtual %.1f-%.1f h in %.2f s wall (x%.0f)\n", resumeUs / 3.6e9, virtualS / 3600.0, wallS,
+            wallS > 0 ? bootS / wallS : 0.0);
+    fprintf(stderr, "Kernel: %llu task switches, %llu events, %llu busy-wait sleeps\n",
+            (unsigned long long)ks.switches, (unsigned long long)ks.events, (unsigned long long)ks.spinSleeps);
+
+    const Sim7600Model::Stats& ms = sim7600.getStats();
+    fprintf(stderr, "Modem: %u power-ons, %u power-offs, %u resets, %u commands (%u ERROR)\n",
+            ms.powerOns, ms.powerOffs, ms.resets, ms.commands, ms.errors);
+    fprintf(stderr, "  %u NETOPEN, %u MQTT connects, %u connection losses, %u outages (%.0f s without cell)\n",
+            ms.netOpens, ms.mqttConnects, ms.connLost, ms.outages, ms.outageUs / 1e6);
+    fprintf(stderr, "  %u publishes (%u dup), %u results dropped, %u inbound (%u lost while offline)\n",
+            ms.publishes, ms.dupPublishes, ms.pubResultsDropped, ms.inbound, ms.inboundLost);
+
+    const SimModbusBus::Stats& bs = bus.getStats();
+    fprintf(stderr, "Modbus: %u requests, %u answered, %u exceptions, %u dropped, %u CRC errors, %u no slave\n",
+            bs.requests, bs.answered, bs.exceptions, bs.dropped, bs.crcErrors, bs.noSlave);
+
+    broker.printReport(stderr);
+
+    fprintf(stderr, "UART bytes:\n");
+    printUart("modem", modemUart, bootS / 86400.0);
+    printUart("rs485", rs485Uart, bootS / 86400.0);
+
+    fflush(stderr);
+    if (logFile != nullptr) {
+        fclose(logFile);
+    }
+
+    if (!strcmp(reason, SIM_RESTART_REASON) && sim::nowUs() < untilUs) {
+        char resumeArg[24], bootArg[12];
+        snprintf(resumeArg, sizeof(resumeArg), "%llu", (unsigned long long)sim::nowUs());
+        snprintf(bootArg, sizeof(bootArg), "%u", boot + 1);
+
+        // Same options, minus the previous boot's internal ones
+        std::vector<char*> execArgs;
+        for (int i = 0; i < argc; i++) {
+            if (!strcmp(argv[i], "--resume-us") || !strcmp(argv[i], "--boot")) {
+                i++;
+                continue;
+            }
+            execArgs.push_back(argv[i]);
+        }
+        execArgs.push_back((char*)"--resume-us");
+        execArgs.push_back(resumeArg);
+        execArgs.push_back((char*)"--boot");
+        execArgs.push_back(bootArg);
+        execArgs.push_back(nullptr);
+        if (chdir(startDir) == 0) {
+            execv("/proc/self/exe", execArgs.data());
+        }
+        fprintf(stderr, "reboot failed: %s\n", strerror(errno));
+        _exit(1);
+    }
+
+    // Firmware tasks never return; leave without unwinding their stacks
+    _exit(reason[0] ? 1 : 0);
+}
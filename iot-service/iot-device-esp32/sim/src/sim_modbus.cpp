@@ -0,0 +1,211 @@
+#include "sim_modbus.h"
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+#include "config.h"
+#include "device_profiles.h"
+#include "sim_kernel.h"
+#include "sim_plant.h"
+
+// ============================================================================
+// SIM MODBUS IMPLEMENTATION
+// ============================================================================
+
+#define MODBUS_REQUEST_LEN      8
+#define MODBUS_MAX_REGISTERS    125
+
+namespace {
+    // Reading in engineering units and the scale of its integer encoding
+    struct Reading {
+        double value;
+        double scale;
+    };
+
+    Reading reading(const char* key, double t) {
+        bool pump = sim::pumpRunning(t);
+        double n = sim::noise((uint32_t)strlen(key) * 131 + (uint8_t)key[strlen(key) - 1], t);
+
+        if (strstr(key, "voltage")) {
+            return {230.0 + 2.0 * sin(sim::dailyPhase(t)) + 0.5 * n, 10};
+        }
+        if (strstr(key, "current")) {
+            return {(pump ? 9.5 : 1.2) + 0.1 * n, 100};
+        }
+        if (strstr(key, "power_factor")) {
+            return {(pump ? 0.92 : 0.85) + 0.005 * n, 1000};
+        }
+        if (strstr(key, "active_power")) {
+            return {(pump ? 230.0 * 9.5 * 0.92 : 230.0 * 1.2 * 0.85) + 10.0 * n, 1};
+        }
+        if (strstr(key, "frequency")) {
+            return {50.0 + 0.02 * n, 100};
+        }
+        if (strstr(key, "energy")) {
+            return {sim::pumpHours(t) * 6.0, 100};
+        }
+        if (strstr(key, "flow_rate")) {
+            return {pump ? 12.5 + 0.2 * n : 0.0, 1};
+        }
+        if (strstr(key, "flow_velocity")) {
+            return {pump ? 0.44 + 0.01 * n : 0.0, 1};
+        }
+        if (strstr(key, "totalizer")) {
+            return {sim::pumpHours(t) * 12.5, 1};
+        }
+        if (strstr(key, "temperature")) {
+            double offset = key[strlen(key) - 1] == '2' ? 0.3 : 0.0;
+            return {26.0 + offset + 2.0 * sin(sim::dailyPhase(t)) + 0.05 * n, 10};
+        }
+        if (strstr(key, "signal_quality")) {
+            return {85.0 + 3.0 * n, 1};
+        }
+        return {0.0, 1};
+    }
+
+    // Register words, low word first for 32-bit values
+    void encode(uint8_t type, Reading r, uint16_t words[2]) {
+        words[0] = words[1] = 0;
+        switch (type) {
+            case RS485_FLOAT32: {
+                float f = (float)r.value;
+                uint32_t bits;
+                memcpy(&bits, &f, sizeof(bits));
+                words[0] = bits & 0xFFFF;
+                words[1] = bits >> 16;
+                break;
+            }
+            case RS485_UINT32:
+            case RS485_INT32: {
+                uint32_t v = (uint32_t)(int32_t)lround(r.value * r.scale);
+                words[0] = v & 0xFFFF;
+                words[1] = v >> 16;
+                break;
+            }
+            case RS485_UINT16:
+            case RS485_INT16:
+                words[0] = (uint16_t)(int16_t)lround(r.value * r.scale);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+SimModbusBus::SimModbusBus(HardwareSerial& uart, const Options& options)
+    : uart(uart), options(options), rng(options.seed) {
+    memset(&stats, 0, sizeof(stats));
+    lastByteUs = 0;
+    byteUs = 10000000UL / MODBUS_BAUDRATE;
+}
+
+bool SimModbusBus::addSlave(uint8_t address, const char* profile, uint16_t version) {
+    const RS485Profile* found = findDeviceProfile(profile, version);
+    if (found == nullptr) {
+        return false;
+    }
+    slaves.push_back(Slave{address, found});
+    return true;
+}
+
+void SimModbusBus::begin() {
+    uart.attach(this);
+}
+
+uint16_t SimModbusBus::crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+void SimModbusBus::onHostBytes(const uint8_t* data, size_t len, uint64_t doneUs) {
+    // A silent interval of 3.5 characters ends a frame
+    uint64_t firstByteUs = doneUs - (uint64_t)len * byteUs;
+    if (!frame.empty() && firstByteUs > lastByteUs + byteUs * 7 / 2) {
+        frame.clear();
+    }
+    frame.insert(frame.end(), data, data + len);
+    lastByteUs = doneUs;
+
+    if (frame.size() >= MODBUS_REQUEST_LEN) {
+        handleFrame(doneUs);
+        frame.clear();
+    }
+}
+
+void SimModbusBus::handleFrame(uint64_t doneUs) {
+    stats.requests++;
+    uint16_t crc = crc16(frame.data(), MODBUS_REQUEST_LEN - 2);
+    if (frame[6] != (crc & 0xFF) || frame[7] != (crc >> 8)) {
+        stats.crcErrors++;
+        return;
+    }
+
+    const Slave* slave = nullptr;
+    for (const Slave& s : slaves) {
+        if (s.address == frame[0]) {
+            slave = &s;
+            break;
+        }
+    }
+    if (slave == nullptr) {
+        stats.noSlave++;
+        return;
+    }
+
+    std::uniform_real_distribution<double> fail(0.0, 1.0);
+    if (options.failRate > 0 && fail(rng) < options.failRate) {
+        stats.dropped++;
+        return;
+    }
+
+    uint64_t atUs = doneUs + (uint64_t)options.responseMs * 1000;
+    uint16_t start = (uint16_t)((frame[2] << 8) | frame[3]);
+    uint16_t count = (uint16_t)((frame[4] << 8) | frame[5]);
+    std::vector<uint8_t> response;
+    response.push_back(slave->address);
+
+    if (frame[1] != 0x03 || count == 0 || count > MODBUS_MAX_REGISTERS) {
+        stats.exceptions++;
+        response.push_back(frame[1] | 0x80);
+        response.push_back(frame[1] != 0x03 ? 0x01 : 0x03);
+        answer(response, atUs);
+        return;
+    }
+
+    response.push_back(0x03);
+    response.push_back((uint8_t)(count * 2));
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t word = readWord(*slave, start + i);
+        response.push_back(word >> 8);
+        response.push_back(word & 0xFF);
+    }
+    stats.answered++;
+    answer(response, atUs);
+}
+
+uint16_t SimModbusBus::readWord(const Slave& slave, uint16_t address) {
+    // Profile registers are 1-based, the wire address 0-based
+    for (uint8_t i = 0; i < slave.profile->registerCount; i++) {
+        const RS485Register& reg = slave.profile->registers[i];
+        uint16_t first = reg.reg - 1;
+        uint8_t words = reg.words ? reg.words : 1;
+        if (address >= first && address < first + words) {
+            uint16_t encoded[2];
+            encode(reg.type, reading(reg.key, sim::worldSeconds()), encoded);
+            return encoded[address - first];
+        }
+    }
+    return 0;   // Unmapped holding registers read as 0
+}
+
+void SimModbusBus::answer(std::vector<uint8_t>& response, uint64_t atUs) {
+    uint16_t crc = crc16(response.data(), response.size());
+    response.push_back(crc & 0xFF);
+    response.push_back(crc >> 8);
+    uart.deliver(response.data(), response.size(), atUs);
+}
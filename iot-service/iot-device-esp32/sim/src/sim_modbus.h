@@ -0,0 +1,73 @@
+#ifndef SIM_MODBUS_H
+#define SIM_MODBUS_H
+
+#include <stdint.h>
+#include <random>
+#include <vector>
+#include "sim_hw.h"
+
+class HardwareSerial;
+struct RS485Profile;
+
+// ============================================================================
+// SIM MODBUS - RS485 bus with Modbus RTU slaves (native simulation build)
+// ============================================================================
+// Slaves serve the register maps of the firmware's built-in profiles (one
+// per address), values derived from the key ("voltage_l1", "flow_rate",
+// ...) and the plant (sim_plant.h): plausible readings, not a calibrated
+// meter. Function 03 only; other functions get exception 01, more than 125
+// registers exception 03, a bad CRC or unknown address no answer. Word
+// order is what the firmware decodes (low word first for 32-bit values).
+// failRate drops that fraction of answers, as a noisy bus would.
+
+class SimModbusBus : public sim::UartPeer {
+public:
+    struct Options {
+        uint32_t responseMs;        // Request received -> first byte of the answer
+        double failRate;            // 0..1
+        uint64_t seed;
+    };
+
+    struct Stats {
+        uint32_t requests;
+        uint32_t answered;
+        uint32_t exceptions;
+        uint32_t dropped;           // failRate
+        uint32_t crcErrors;
+        uint32_t noSlave;
+    };
+
+    SimModbusBus(HardwareSerial& uart, const Options& options);
+
+    // Slave at `address` with the registers of a built-in profile
+    bool addSlave(uint8_t address, const char* profile, uint16_t version);
+    void begin();
+
+    const Stats& getStats() const { return stats; }
+
+    void onHostBytes(const uint8_t* data, size_t len, uint64_t doneUs) override;
+
+private:
+    struct Slave {
+        uint8_t address;
+        const RS485Profile* profile;
+    };
+
+    HardwareSerial& uart;
+    Options options;
+    Stats stats;
+    std::mt19937_64 rng;
+    std::vector<Slave> slaves;
+
+    std::vector<uint8_t> frame;
+    uint64_t lastByteUs;
+    uint32_t byteUs;
+
+    void handleFrame(uint64_t doneUs);
+    uint16_t readWord(const Slave& slave, uint16_t address);
+    void answer(std::vector<uint8_t>& response, uint64_t atUs);
+
+    static uint16_t crc16(const uint8_t* data, size_t len);
+};
+
+#endif // SIM_MODBUS_H
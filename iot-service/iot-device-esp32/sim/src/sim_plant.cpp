@@ -0,0 +1,133 @@
+#include "sim_plant.h"
+#include <Arduino.h>
+#include <math.h>
+#include "sim_hw.h"
+#include "config.h"
+
+// ============================================================================
+// SIM PLANT IMPLEMENTATION
+// ============================================================================
+
+#define PLANT_PUMP_ON_S         1200    // Pump runs this long at the top of each hour
+#define PLANT_ADC_FULL_SCALE_V  3.1     // ESP32 ADC at 11 dB attenuation
+#define PLANT_LOOP_SHUNT_OHM    150.0   // 4-20 mA loop -> 0.6-3.0 V
+
+namespace {
+    uint32_t epoch = 0;
+
+    // ADS1115 inputs: AIN0 tank level transducer (0.5-4.5 V), AIN1 line
+    // pressure (follows the pump), AIN2/3 open
+    class Ads1115Model : public sim::I2cDevice {
+    public:
+        double read(uint8_t channel) override {
+            double t = sim::worldSeconds();
+            switch (channel) {
+                case 0:
+                    return 2.5 + 1.2 * sin(sim::dailyPhase(t)) + 0.01 * sim::noise(10, t);
+                case 1:
+                    return (sim::pumpRunning(t) ? 3.1 : 0.6) + 0.05 * sim::noise(11, t);
+                default:
+                    return 0.002 * sim::noise(12 + channel, t);
+            }
+        }
+    };
+
+    // INA219 on the 12 V battery: charges by day
+    class Ina219Model : public sim::I2cDevice {
+    public:
+        double read(uint8_t channel) override {
+            double t = sim::worldSeconds();
+            if (channel == 0) {
+                return 12.4 + 0.6 * sin(sim::dailyPhase(t) - M_PI / 2) + 0.01 * sim::noise(20, t);
+            }
+            return 180.0 + 40.0 * sim::noise(21, t);
+        }
+    };
+
+    // DS3231: runs on the virtual clock from the epoch; adjust() moves it
+    class Ds3231Model : public sim::I2cDevice {
+    public:
+        double read(uint8_t channel) override {
+            (void)channel;
+            return floor(offsetS + sim::nowUs() / 1e6);
+        }
+        void write(uint8_t channel, double value) override {
+            (void)channel;
+            offsetS = value - sim::nowUs() / 1e6;
+        }
+
+        double offsetS = 0;
+    };
+
+    Ads1115Model ads1115;
+    Ina219Model ina219;
+    Ds3231Model ds3231;
+
+    // 4-20 mA loop to 12-bit ADC counts
+    int loopCounts(double mA) {
+        double volts = mA / 1000.0 * PLANT_LOOP_SHUNT_OHM;
+        return (int)(volts / PLANT_ADC_FULL_SCALE_V * 4095.0);
+    }
+}
+
+namespace sim {
+
+double worldSeconds() {
+    return epoch + nowUs() / 1e6;
+}
+
+bool pumpRunning(double worldSec) {
+    return fmod(worldSec, 3600.0) < PLANT_PUMP_ON_S;
+}
+
+double pumpHours(double worldSec) {
+    double elapsed = worldSec - epoch;
+    if (elapsed <= 0) {
+        return 0;
+    }
+    double fullHours = floor(elapsed / 3600.0);
+    double inHour = fmod(elapsed, 3600.0);
+    return (fullHours * PLANT_PUMP_ON_S + (inHour < PLANT_PUMP_ON_S ? inHour : PLANT_PUMP_ON_S)) / 3600.0;
+}
+
+double dailyPhase(double worldSec) {
+    return fmod(worldSec, 86400.0) / 86400.0 * 2.0 * M_PI;
+}
+
+double noise(uint32_t channel, double worldSec) {
+    // splitmix64 of (channel, second)
+    uint64_t x = ((uint64_t)channel << 40) ^ (uint64_t)worldSec;
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return (double)(x >> 11) / (double)(1ULL << 52) - 1.0;
+}
+
+void attachPlant(const PlantOptions& options) {
+    epoch = options.epoch;
+
+    attachI2c(ADS1115_I2C_ADDRESS, &ads1115);
+    if (options.ina219) {
+        attachI2c(INA219_I2C_ADDRESS, &ina219);
+    }
+    if (options.rtc) {
+        ds3231.offsetS = options.epoch;
+        attachI2c(0x68, &ds3231);
+    }
+
+    // Flow transmitter (follows the pump) and a temperature transmitter
+    setAnalogSource(ANALOG_CURRENT_A2_PIN, []() {
+        double t = worldSeconds();
+        return loopCounts((pumpRunning(t) ? 14.0 : 4.0) + 0.05 * noise(30, t));
+    });
+    setAnalogSource(ANALOG_CURRENT_A3_PIN, []() {
+        double t = worldSeconds();
+        return loopCounts(10.0 + 2.0 * sin(dailyPhase(t)) + 0.05 * noise(31, t));
+    });
+    setDigitalSource(IO_DIGITAL_IN_1_PIN, []() {
+        return pumpRunning(worldSeconds()) ? 1 : 0;
+    });
+}
+
+} // namespace sim
@@ -0,0 +1,33 @@
+#ifndef SIM_PLANT_H
+#define SIM_PLANT_H
+
+#include <stdint.h>
+
+// ============================================================================
+// SIM PLANT - The site around the board (native simulation build)
+// ============================================================================
+// Deterministic signals for everything the firmware samples: ADS1115 and
+// INA219 on I2C, the DS3231, two 4-20 mA loops on the ESP32 ADC and the
+// pump status input. The pump runs the first 20 minutes of every hour and
+// the Modbus meters follow it. Signals repeat daily; the noise is a hash of
+// the time, so runs with the same options read the same values.
+
+namespace sim {
+
+struct PlantOptions {
+    uint32_t epoch;         // Wall clock at virtual time 0 (RTC and server)
+    bool rtc;               // DS3231 fitted, holding a valid time
+    bool ina219;
+};
+
+void attachPlant(const PlantOptions& options);
+
+double worldSeconds();                  // Wall clock now, seconds
+bool pumpRunning(double worldSec);
+double pumpHours(double worldSec);      // Run hours since the epoch
+double dailyPhase(double worldSec);     // 0..2*pi over the UTC day
+double noise(uint32_t channel, double worldSec);    // -1..1, changes every second
+
+} // namespace sim
+
+#endif // SIM_PLANT_H
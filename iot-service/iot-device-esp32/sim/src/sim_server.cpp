@@ -0,0 +1,208 @@
+#include "sim_server.h"
+#include <stdlib.h>
+#include <string.h>
+#include "queue_record.h"
+#include "sim_kernel.h"
+#include "sim_plant.h"
+#include "sim7600_model.h"
+
+// ============================================================================
+// SIM SERVER IMPLEMENTATION
+// ============================================================================
+
+#define SERVER_CONFIG_JSON \
+    "[{\"profile\":\"3Phase-PowerMeter-V2305\",\"version\":1,\"modbus_address\":1}," \
+    "{\"profile\":\"TUF-2000-FlowMeter\",\"version\":1,\"modbus_address\":2}]"
+
+#define SERVER_RELAY_DURATION_MS 5000
+
+SimServer::SimServer(const Options& options) : options(options) {
+    modem = nullptr;
+    connected = false;
+    connects = 0;
+    dupPublishes = 0;
+    configRequests = 0;
+    configUnchanged = 0;
+    relayCommands = 0;
+    undelivered = 0;
+
+    configJson = SERVER_CONFIG_JSON;
+    snprintf(configHash, sizeof(configHash), "%08lx",
+             (unsigned long)queueCrc32(0, (const uint8_t*)configJson.data(), configJson.size()));
+}
+
+void SimServer::begin() {
+    if (options.relayEveryS == 0) {
+        return;
+    }
+    // On the same grid after a reboot (the clock does not restart at 0)
+    uint64_t everyUs = (uint64_t)options.relayEveryS * 1000000;
+    uint64_t firstUs = (sim::nowUs() / everyUs + 1) * everyUs;
+    struct Repeat {
+        static void at(SimServer* server, uint64_t us, uint64_t everyUs) {
+            sim::schedule(us, [server, us, everyUs]() {
+                server->sendRelayCommand();
+                at(server, us + everyUs, everyUs);
+            });
+        }
+    };
+    Repeat::at(this, firstUs, everyUs);
+}
+
+// ============================================================================
+// BROKER
+// ============================================================================
+
+bool SimServer::topicMatches(const std::string& filter, const std::string& topic) {
+    size_t f = 0, t = 0;
+    while (f < filter.size()) {
+        if (filter[f] == '#') {
+            return true;
+        }
+        if (filter[f] == '+') {
+            while (t < topic.size() && topic[t] != '/') {
+                t++;
+            }
+            f++;
+            continue;
+        }
+        if (t >= topic.size() || filter[f] != topic[t]) {
+            return false;
+        }
+        f++;
+        t++;
+    }
+    return t == topic.size();
+}
+
+void SimServer::onConnect(const std::string& clientId, bool cleanSession) {
+    connected = true;
+    connects++;
+    if (cleanSession) {
+        subscriptions.clear();
+    }
+    if (deviceId.empty()) {
+        deviceId = clientId;
+    }
+}
+
+void SimServer::onDisconnect() {
+    connected = false;
+}
+
+void SimServer::onSubscribe(const std::string& filter) {
+    for (const std::string& existing : subscriptions) {
+        if (existing == filter) {
+            return;
+        }
+    }
+    subscriptions.push_back(filter);
+}
+
+void SimServer::onPublish(const std::string& topic, const std::string& payload, bool dup) {
+    if (dup) {
+        dupPublishes++;
+    }
+
+    // "sensor/<id>/..." names the device even if the client id does not
+    if (topic.compare(0, 7, "sensor/") == 0) {
+        size_t slash = topic.find('/', 7);
+        if (slash != std::string::npos) {
+            deviceId = topic.substr(7, slash - 7);
+        }
+    }
+
+    TopicStats& entry = uplink[statsKey(topic)];
+    entry.messages++;
+    entry.bytes += topic.size() + payload.size();
+
+    sim::schedule(sim::nowUs() + (uint64_t)options.responseMs * 1000,
+                  [this, topic, payload]() { handle(topic, payload); });
+}
+
+std::string SimServer::statsKey(const std::string& topic) const {
+    if (deviceId.empty()) {
+        return topic;
+    }
+    std::string key = topic;
+    size_t pos = key.find(deviceId);
+    if (pos != std::string::npos) {
+        key.replace(pos, deviceId.size(), "<id>");
+    }
+    return key;
+}
+
+// ============================================================================
+// BACKEND
+// ============================================================================
+
+void SimServer::handle(const std::string& topic, const std::string& payload) {
+    if (topic.compare(0, 11, "get_config/") == 0) {
+        configRequests++;
+        std::string id = topic.substr(11);
+        std::string hashField = std::string("\"hash\":\"") + configHash + "\"";
+        bool unchanged = payload.find(hashField) != std::string::npos;
+        if (unchanged) {
+            configUnchanged++;
+        }
+        send("stream_config/" + id, unchanged ? "\"unchanged\"" : configJson);
+    } else if (topic == "cek_waktu") {
+        char response[96];
+        snprintf(response, sizeof(response), "{\"server_time\":{\"unix\":%lu}}",
+                 (unsigned long)sim::worldSeconds());
+        send("cek_waktu/response", response);
+    }
+}
+
+void SimServer::send(const std::string& topic, const std::string& payload) {
+    bool subscribed = false;
+    for (const std::string& filter : subscriptions) {
+        if (topicMatches(filter, topic)) {
+            subscribed = true;
+            break;
+        }
+    }
+    if (!subscribed || !modem) {
+        undelivered++;
+        return;
+    }
+
+    TopicStats& entry = downlink[statsKey(topic)];
+    entry.messages++;
+    entry.bytes += topic.size() + payload.size();
+    modem->deliverMessage(topic, payload);
+}
+
+void SimServer::sendRelayCommand() {
+    if (deviceId.empty()) {
+        return;
+    }
+    relayCommands++;
+    char payload[160];
+    snprintf(payload, sizeof(payload),
+             "{\"action\":\"relay\",\"target\":\"out1\",\"state\":\"restart\",\"id\":\"sim-%lu\","
+             "\"duration_ms\":%d}",
+             (unsigned long)relayCommands, SERVER_RELAY_DURATION_MS);
+    send("sensor/" + deviceId + "/command", payload);
+}
+
+// ============================================================================
+// REPORT
+// ============================================================================
+
+void SimServer::printReport(FILE* out) const {
+    fprintf(out, "Broker: device %s, %u connects, %u dup publishes, %zu subscriptions\n",
+            deviceId.empty() ? "(none)" : deviceId.c_str(), connects, dupPublishes, subscriptions.size());
+    fprintf(out, "  %-36s %10s %12s\n", "uplink topic", "messages", "bytes");
+    for (const auto& entry : uplink) {
+        fprintf(out, "  %-36s %10u %12llu\n", entry.first.c_str(), entry.second.messages,
+                (unsigned long long)entry.second.bytes);
+    }
+    fprintf(out, "  %-36s %10s %12s\n", "downlink topic", "messages", "bytes");
+    for (const auto& entry : downlink) {
+        fprintf(out, "  %-36s %10u %12llu\n", entry.first.c_str(), entry.second.messages,
+                (unsigned long long)entry.second.bytes);
+    }
+    fprintf(out, "Backend: %u config requests (%u unchanged), %u relay commands, %u undelivered\n",
+            configRequests, configUnchanged, relayCommands, undelivered);
+}
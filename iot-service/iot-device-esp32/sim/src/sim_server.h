@@ -0,0 +1,76 @@
+#ifndef SIM_SERVER_H
+#define SIM_SERVER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class Sim7600Model;
+
+// ============================================================================
+// SIM SERVER - MQTT broker and backend (native simulation build)
+// ============================================================================
+// The broker keeps the device's session: subscriptions survive reconnects
+// unless it connects with a clean session. The backend answers what the
+// real server answers: get_config/<id> with the two built-in profiles on
+// stream_config/<id> ("unchanged" when the request carries the current
+// hash) and cek_waktu with the server time. With relayEveryS it also sends
+// a relay restart command that often. Per-topic counts use the topic with
+// the device id replaced by "<id>".
+
+class SimServer {
+public:
+    struct Options {
+        uint32_t responseMs;        // Backend processing time
+        uint32_t relayEveryS;       // 0 = no relay commands
+    };
+
+    struct TopicStats {
+        uint32_t messages;
+        uint64_t bytes;
+    };
+
+    explicit SimServer(const Options& options);
+
+    void attach(Sim7600Model* modem) { this->modem = modem; }
+    void begin();
+
+    // ---- Broker side, called when the packet reaches the broker ----
+    void onConnect(const std::string& clientId, bool cleanSession);
+    void onDisconnect();
+    void onSubscribe(const std::string& filter);
+    void onPublish(const std::string& topic, const std::string& payload, bool dup);
+
+    const std::string& getDeviceId() const { return deviceId; }
+    void printReport(FILE* out) const;
+
+private:
+    Options options;
+    Sim7600Model* modem;
+
+    bool connected;
+    std::string deviceId;
+    std::vector<std::string> subscriptions;
+    std::string configJson;
+    char configHash[9];
+
+    std::map<std::string, TopicStats> uplink;
+    std::map<std::string, TopicStats> downlink;
+    uint32_t connects;
+    uint32_t dupPublishes;
+    uint32_t configRequests;
+    uint32_t configUnchanged;
+    uint32_t relayCommands;
+    uint32_t undelivered;       // Backend message with no matching subscription
+
+    void handle(const std::string& topic, const std::string& payload);
+    void send(const std::string& topic, const std::string& payload);
+    void sendRelayCommand();
+    std::string statsKey(const std::string& topic) const;
+
+    static bool topicMatches(const std::string& filter, const std::string& topic);
+};
+
+#endif // SIM_SERVER_H
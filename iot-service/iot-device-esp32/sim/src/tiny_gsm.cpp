@@ -0,0 +1,105 @@
+#include <Arduino.h>
+#include <TinyGsmClient.h>
+#include <stdio.h>
+
+// ============================================================================
+// TINY GSM - Blocking query calls (native simulation build)
+// ============================================================================
+
+#define SIM_GSM_QUERY_TIMEOUT_MS    1000
+#define SIM_GSM_NETCLOSE_TIMEOUT_MS 60000   // Library default for +NETCLOSE
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buf);
+}
+
+void TinyGsm::sendAT(const char* command) {
+    stream.print("AT");
+    stream.print(command);
+    stream.print("\r\n");
+}
+
+bool TinyGsm::readLine(String& out, uint32_t deadlineMs) {
+    out = "";
+    while ((int32_t)(deadlineMs - millis()) > 0) {
+        int c = stream.read();
+        if (c < 0) {
+            continue;
+        }
+        if (c == '\n') {
+            return true;
+        }
+        if (c != '\r') {
+            out += (char)c;
+        }
+    }
+    return false;
+}
+
+// OK only counts once the captured line is in, which for +NETCLOSE comes
+// after the OK
+int8_t TinyGsm::waitResponse(uint32_t timeoutMs, const char* capture, String* line) {
+    uint32_t deadline = millis() + timeoutMs;
+    bool captured = capture == nullptr;
+    bool ok = false;
+    String current;
+
+    while (readLine(current, deadline)) {
+        if (current == "OK") {
+            ok = true;
+        } else if (current == "ERROR" || current.startsWith("+CME ERROR")) {
+            return 2;
+        } else if (!captured && current.startsWith(capture)) {
+            captured = true;
+            if (line) {
+                *line = current;
+            }
+        }
+        if (ok && captured) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+bool TinyGsm::gprsDisconnect() {
+    sendAT("+NETCLOSE");
+    return waitResponse(SIM_GSM_NETCLOSE_TIMEOUT_MS, "+NETCLOSE:") == 1;
+}
+
+int16_t TinyGsm::getSignalQuality() {
+    String line;
+    sendAT("+CSQ");
+    if (waitResponse(SIM_GSM_QUERY_TIMEOUT_MS, "+CSQ:", &line) != 1) {
+        return 99;
+    }
+    int csq = 99;
+    sscanf(line.c_str(), "+CSQ: %d", &csq);
+    return (int16_t)csq;
+}
+
+String TinyGsm::getOperator() {
+    String line;
+    sendAT("+COPS?");
+    if (waitResponse(SIM_GSM_QUERY_TIMEOUT_MS, "+COPS:", &line) != 1) {
+        return "";
+    }
+    int open = line.indexOf('"');
+    int close = open >= 0 ? line.indexOf('"', open + 1) : -1;
+    return close > open ? line.substring(open + 1, close) : String();
+}
+
+IPAddress TinyGsm::localIP() {
+    String line;
+    sendAT("+IPADDR");
+    if (waitResponse(SIM_GSM_QUERY_TIMEOUT_MS, "+IPADDR:", &line) != 1) {
+        return IPAddress();
+    }
+    unsigned a = 0, b = 0, c = 0, d = 0;
+    if (sscanf(line.c_str(), "+IPADDR: %u.%u.%u.%u", &a, &b, &c, &d) != 4) {
+        return IPAddress();
+    }
+    return IPAddress((uint8_t)a, (uint8_t)b, (uint8_t)c, (uint8_t)d);
+}
@@ -0,0 +1,287 @@
+#include <Arduino.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <string.h>
+#include <math.h>
+
+// ============================================================================
+// STRING / PRINT / STREAM (native simulation build)
+// ============================================================================
+
+namespace {
+    std::string unsignedToString(unsigned long long num, unsigned char base) {
+        if (base < 2 || base > 36) {
+            base = 10;
+        }
+        char buf[65];
+        char* p = buf + sizeof(buf) - 1;
+        *p = '\0';
+        do {
+            unsigned digit = (unsigned)(num % base);
+            *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+            num /= base;
+        } while (num);
+        return p;
+    }
+
+    std::string signedToString(long long num, unsigned char base) {
+        if (num < 0 && base == 10) {
+            return "-" + unsignedToString(0ULL - (unsigned long long)num, base);
+        }
+        return unsignedToString((unsigned long long)num, base);
+    }
+
+    std::string floatToString(double num, unsigned int decimalPlaces) {
+        if (isnan(num)) return "nan";
+        if (isinf(num)) return "inf";
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, num);
+        return buf;
+    }
+}
+
+// ============================================================================
+// STRING
+// ============================================================================
+
+String::String(unsigned char num, unsigned char base) : value(unsignedToString(num, base)) {}
+String::String(int num, unsigned char base) : value(signedToString(num, base)) {}
+String::String(unsigned int num, unsigned char base) : value(unsignedToString(num, base)) {}
+String::String(long num, unsigned char base) : value(signedToString(num, base)) {}
+String::String(unsigned long num, unsigned char base) : value(unsignedToString(num, base)) {}
+String::String(long long num, unsigned char base) : value(signedToString(num, base)) {}
+String::String(unsigned long long num, unsigned char base) : value(unsignedToString(num, base)) {}
+String::String(float num, unsigned int decimalPlaces) : value(floatToString(num, decimalPlaces)) {}
+String::String(double num, unsigned int decimalPlaces) : value(floatToString(num, decimalPlaces)) {}
+
+bool String::equalsIgnoreCase(const String& s) const {
+    if (value.size() != s.value.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < value.size(); i++) {
+        if (tolower((unsigned char)value[i]) != tolower((unsigned char)s.value[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool String::endsWith(const String& suffix) const {
+    if (suffix.value.size() > value.size()) {
+        return false;
+    }
+    return value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+}
+
+void String::getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index) const {
+    if (!bufsize || !buf) {
+        return;
+    }
+    if (index >= value.size()) {
+        buf[0] = 0;
+        return;
+    }
+    size_t n = value.size() - index;
+    if (n > bufsize - 1) {
+        n = bufsize - 1;
+    }
+    memcpy(buf, value.data() + index, n);
+    buf[n] = 0;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+    size_t pos = value.find(ch, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const {
+    size_t pos = value.find(str.value, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char ch) const {
+    size_t pos = value.rfind(ch);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(const String& str) const {
+    size_t pos = value.rfind(str.value);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex) const {
+    return substring(beginIndex, length());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+        unsigned int tmp = beginIndex;
+        beginIndex = endIndex;
+        endIndex = tmp;
+    }
+    if (beginIndex >= value.size()) {
+        return String();
+    }
+    if (endIndex > value.size()) {
+        endIndex = (unsigned int)value.size();
+    }
+    return String(value.data() + beginIndex, endIndex - beginIndex);
+}
+
+void String::replace(char find, char replace) {
+    for (char& c : value) {
+        if (c == find) {
+            c = replace;
+        }
+    }
+}
+
+void String::replace(const String& find, const String& replace) {
+    if (find.value.empty()) {
+        return;
+    }
+    size_t pos = 0;
+    while ((pos = value.find(find.value, pos)) != std::string::npos) {
+        value.replace(pos, find.value.size(), replace.value);
+        pos += replace.value.size();
+    }
+}
+
+void String::remove(unsigned int index) {
+    if (index < value.size()) {
+        value.erase(index);
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < value.size()) {
+        value.erase(index, count);
+    }
+}
+
+void String::toLowerCase() {
+    for (char& c : value) {
+        c = (char)tolower((unsigned char)c);
+    }
+}
+
+void String::toUpperCase() {
+    for (char& c : value) {
+        c = (char)toupper((unsigned char)c);
+    }
+}
+
+void String::trim() {
+    size_t first = 0;
+    while (first < value.size() && isspace((unsigned char)value[first])) {
+        first++;
+    }
+    size_t last = value.size();
+    while (last > first && isspace((unsigned char)value[last - 1])) {
+        last--;
+    }
+    value = value.substr(first, last - first);
+}
+
+// ============================================================================
+// PRINT
+// ============================================================================
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        if (!write(*buffer++)) {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char stackBuf[128];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(stackBuf, sizeof(stackBuf), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    if ((size_t)len < sizeof(stackBuf)) {
+        return write((const uint8_t*)stackBuf, len);
+    }
+
+    std::string heapBuf((size_t)len + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&heapBuf[0], heapBuf.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)heapBuf.data(), len);
+}
+
+size_t Print::print(long num, int base) {
+    return print(String(num, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long num, int base) {
+    return print(String(num, (unsigned char)base));
+}
+
+size_t Print::print(long long num, int base) {
+    return print(String(num, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long long num, int base) {
+    return print(String(num, (unsigned char)base));
+}
+
+size_t Print::print(double num, int digits) {
+    return print(String(num, (unsigned int)digits));
+}
+
+// ============================================================================
+// STREAM
+// ============================================================================
+
+int Stream::timedRead() {
+    unsigned long start = millis();
+    do {
+        int c = read();
+        if (c >= 0) {
+            return c;
+        }
+    } while (millis() - start < timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0) {
+            break;
+        }
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String ret;
+    int c = timedRead();
+    while (c >= 0) {
+        ret += (char)c;
+        c = timedRead();
+    }
+    return ret;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String ret;
+    int c = timedRead();
+    while (c >= 0 && c != terminator) {
+        ret += (char)c;
+        c = timedRead();
+    }
+    return ret;
+}
@@ -0,0 +1,243 @@
+#include "actuator_manager.h"
+#include <Arduino.h>
+#include <string.h>
+
+// ============================================================================
+// ACTUATOR MANAGER IMPLEMENTATION
+// ============================================================================
+
+ActuatorManager::ActuatorManager() {
+    memset(outputs, 0, sizeof(outputs));
+    outputCount = 0;
+    memset(recentIds, 0, sizeof(recentIds));
+    recentNext = 0;
+    completionHandler = nullptr;
+}
+
+bool ActuatorManager::addOutput(const char* name, int8_t pin, bool activeLow, bool initialOn) {
+    if (pin < 0 || outputCount >= ACTUATOR_MAX_OUTPUTS || strlen(name) >= ACTUATOR_NAME_LEN) {
+        return false;
+    }
+
+    Output& out = outputs[outputCount++];
+    memset(&out, 0, sizeof(out));
+    strcpy(out.name, name);
+    out.pin = pin;
+    out.activeLow = activeLow;
+
+    pinMode(pin, OUTPUT);
+    setOutput(out, initialOn);
+    return true;
+}
+
+// ============================================================================
+// COMMANDS
+// ============================================================================
+
+ActuatorResult ActuatorManager::submit(const char* id, const char* target, const char* state,
+                                       uint32_t durationMs, unsigned long nowMs) {
+    char cutId[ACTUATOR_ID_LEN];
+    snprintf(cutId, sizeof(cutId), "%s", id ? id : "");
+
+    ActuatorResult result = ACTUATOR_QUEUED;
+    Output* out = findOutput(target);
+    Command cmd;
+
+    if (cutId[0] != '\0' && isKnownId(cutId)) {
+        result = ACTUATOR_DUPLICATE;
+    } else if (out == nullptr) {
+        result = ACTUATOR_UNKNOWN_TARGET;
+    } else if (durationMs > ACTUATOR_MAX_WAIT_MS) {
+        result = ACTUATOR_BAD_DURATION;
+    } else if (!buildSequence(cmd, state, durationMs)) {
+        result = ACTUATOR_UNKNOWN_STATE;
+    } else if (out->count >= ACTUATOR_QUEUE_LEN) {
+        result = ACTUATOR_QUEUE_FULL;
+    }
+
+    if (result != ACTUATOR_QUEUED) {
+        report(cutId, target, state, result, 0, 0);
+        return result;
+    }
+
+    strcpy(cmd.id, cutId);
+    cmd.queuedAt = nowMs;
+    out->queue[(out->head + out->count) % ACTUATOR_QUEUE_LEN] = cmd;
+    out->count++;
+
+    if (cutId[0] != '\0') {
+        rememberId(cutId);
+    }
+    return ACTUATOR_QUEUED;
+}
+
+// "on" / "off" set the output; "restart" is off, wait, on
+bool ActuatorManager::buildSequence(Command& cmd, const char* state, uint32_t durationMs) const {
+    memset(&cmd, 0, sizeof(cmd));
+    if (strlen(state) >= ACTUATOR_NAME_LEN) {
+        return false;
+    }
+    strcpy(cmd.state, state);
+
+    if (strcmp(state, "on") == 0) {
+        cmd.steps[cmd.stepCount++] = { STEP_ON, 0 };
+    } else if (strcmp(state, "off") == 0) {
+        cmd.steps[cmd.stepCount++] = { STEP_OFF, 0 };
+    } else if (strcmp(state, "restart") == 0) {
+        cmd.steps[cmd.stepCount++] = { STEP_OFF, 0 };
+        cmd.steps[cmd.stepCount++] = { STEP_WAIT, durationMs ? durationMs : ACTUATOR_RESTART_OFF_MS };
+        cmd.steps[cmd.stepCount++] = { STEP_ON, 0 };
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// SEQUENCER
+// ============================================================================
+
+void ActuatorManager::loop(unsigned long nowMs) {
+    for (uint8_t i = 0; i < outputCount; i++) {
+        Output& out = outputs[i];
+
+        if (!out.running) {
+            if (out.count == 0) {
+                continue;
+            }
+            startNext(out, nowMs);
+        }
+
+        Command& cmd = out.queue[out.head];
+        while (out.step < cmd.stepCount) {
+            const Step& step = cmd.steps[out.step];
+            if (step.type == STEP_WAIT) {
+                if (nowMs - out.stepAt < step.durationMs) {
+                    break;
+                }
+            } else {
+                setOutput(out, step.type == STEP_ON);
+            }
+            out.step++;
+            out.stepAt = nowMs;
+        }
+
+        if (out.step >= cmd.stepCount) {
+            finish(out, nowMs);
+        }
+    }
+}
+
+void ActuatorManager::startNext(Output& out, unsigned long nowMs) {
+    out.running = true;
+    out.step = 0;
+    out.startedAt = nowMs;
+    out.stepAt = nowMs;
+
+    const Command& cmd = out.queue[out.head];
+    Serial.printf("[Relay] %s: %s started%s%s\n", out.name, cmd.state,
+                  cmd.id[0] ? ", id " : "", cmd.id);
+}
+
+void ActuatorManager::finish(Output& out, unsigned long nowMs) {
+    const Command& cmd = out.queue[out.head];
+    report(cmd.id, out.name, cmd.state, ACTUATOR_DONE,
+           out.startedAt - cmd.queuedAt, nowMs - out.startedAt);
+
+    out.running = false;
+    out.head = (out.head + 1) % ACTUATOR_QUEUE_LEN;
+    out.count--;
+}
+
+unsigned long ActuatorManager::msUntilNext(unsigned long nowMs) const {
+    unsigned long next = ACTUATOR_IDLE;
+    for (uint8_t i = 0; i < outputCount; i++) {
+        const Output& out = outputs[i];
+        if (!out.running) {
+            if (out.count > 0) {
+                return 0;
+            }
+            continue;
+        }
+
+        const Step& step = out.queue[out.head].steps[out.step];
+        unsigned long elapsed = nowMs - out.stepAt;
+        if (step.type != STEP_WAIT || elapsed >= step.durationMs) {
+            return 0;
+        }
+        if (step.durationMs - elapsed < next) {
+            next = step.durationMs - elapsed;
+        }
+    }
+    return next;
+}
+
+bool ActuatorManager::isBusy() const {
+    for (uint8_t i = 0; i < outputCount; i++) {
+        if (outputs[i].count > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+ActuatorManager::Output* ActuatorManager::findOutput(const char* name) {
+    for (uint8_t i = 0; i < outputCount; i++) {
+        if (strcmp(outputs[i].name, name) == 0) {
+            return &outputs[i];
+        }
+    }
+    return nullptr;
+}
+
+bool ActuatorManager::isKnownId(const char* id) const {
+    for (uint8_t i = 0; i < ACTUATOR_RECENT_IDS; i++) {
+        if (strcmp(recentIds[i], id) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ActuatorManager::rememberId(const char* id) {
+    strcpy(recentIds[recentNext], id);
+    recentNext = (recentNext + 1) % ACTUATOR_RECENT_IDS;
+}
+
+void ActuatorManager::setOutput(Output& out, bool on) {
+    digitalWrite(out.pin, on == out.activeLow ? LOW : HIGH);
+    out.on = on;
+    Serial.printf("[Relay] %s → %s (GPIO%d = %s)\n", out.name, on ? "ON" : "OFF", out.pin,
+                  on == out.activeLow ? "LOW" : "HIGH");
+}
+
+void ActuatorManager::report(const char* id, const char* target, const char* state,
+                             ActuatorResult result, uint32_t queuedMs, uint32_t runMs) {
+    if (result == ACTUATOR_DONE) {
+        Serial.printf("[Relay] ✅ %s: %s done in %lu ms\n", target, state, (unsigned long)runMs);
+    } else {
+        Serial.printf("[Relay] ❌ %s: %s rejected (%s)\n", target, state, resultName(result));
+    }
+
+    if (completionHandler) {
+        Completion done = { id, target, state, result, queuedMs, runMs };
+        completionHandler(done);
+    }
+}
+
+const char* ActuatorManager::resultName(ActuatorResult result) {
+    switch (result) {
+        case ACTUATOR_QUEUED:         return "queued";
+        case ACTUATOR_DONE:           return "done";
+        case ACTUATOR_DUPLICATE:      return "duplicate";
+        case ACTUATOR_UNKNOWN_TARGET: return "unknown_target";
+        case ACTUATOR_UNKNOWN_STATE:  return "unknown_state";
+        case ACTUATOR_BAD_DURATION:   return "bad_duration";
+        case ACTUATOR_QUEUE_FULL:     return "queue_full";
+    }
+    return "?";
+}
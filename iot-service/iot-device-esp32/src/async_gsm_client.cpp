@@ -0,0 +1,111 @@
+#include "async_gsm_client.h"
+
+// ============================================================================
+// ASYNC GSM CLIENT IMPLEMENTATION
+// ============================================================================
+
+AsyncGsmClient::AsyncGsmClient(TinyGsm& modem, uint8_t mux, ModemAt& modemAt)
+    : TinyGsmClient(modem, mux), at(modemAt) {
+    muxId = mux;
+    op = OP_NONE;
+    host[0] = '\0';
+    port = 0;
+    timeoutMs = 0;
+    command[0] = '\0';
+}
+
+bool AsyncGsmClient::startOpen(const char* hostName, uint16_t hostPort, uint32_t timeout) {
+    if (op != OP_NONE || at.isBusy()) {
+        return false;
+    }
+
+    strncpy(host, hostName, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    port = hostPort;
+    timeoutMs = timeout;
+    abandon();
+
+    // A socket left open by an earlier session makes CIPOPEN fail
+    snprintf(command, sizeof(command), "+CIPCLOSE=%u", muxId);
+    at.start(command, 2000);
+    op = OP_OPEN_CLOSE_STALE;
+    return true;
+}
+
+bool AsyncGsmClient::startClose() {
+    if (op != OP_NONE || at.isBusy()) {
+        return false;
+    }
+
+    snprintf(command, sizeof(command), "+CIPCLOSE=%u", muxId);
+    at.start(command, 5000, "+CIPCLOSE:", true);
+    op = OP_CLOSE;
+    return true;
+}
+
+AsyncGsmClient::OpResult AsyncGsmClient::pollOp() {
+    if (op == OP_NONE) {
+        return OP_IDLE;
+    }
+
+    ModemAt::Result result = at.poll();
+    if (result == ModemAt::AT_PENDING) {
+        return OP_PENDING;
+    }
+
+    switch (op) {
+        case OP_OPEN_CLOSE_STALE:
+            // ERROR just means nothing was open
+            at.start("+CIPRXGET=1", 1000);
+            op = OP_OPEN_RX_MODE;
+            return OP_PENDING;
+
+        case OP_OPEN_RX_MODE:
+            if (result != ModemAt::AT_OK) {
+                return finish(false);
+            }
+            snprintf(command, sizeof(command), "+CIPOPEN=%u,\"TCP\",\"%s\",%u", muxId, host, port);
+            at.start(command, timeoutMs, "+CIPOPEN:", true);
+            op = OP_OPEN_CONNECT;
+            return OP_PENDING;
+
+        case OP_OPEN_CONNECT: {
+            // "+CIPOPEN: <mux>,<err>", err 0 = connected
+            int lineMux = -1;
+            int err = -1;
+            if (result != ModemAt::AT_OK ||
+                sscanf(at.getLine(), "+CIPOPEN: %d,%d", &lineMux, &err) != 2 ||
+                lineMux != muxId || err != 0) {
+                #if DEBUG_LTE
+                Serial.printf("[GSM] ❌ Socket %u open failed (%s)\n", muxId,
+                              result == ModemAt::AT_TIMEOUT ? "timeout" : at.getLine());
+                #endif
+                return finish(false);
+            }
+
+            // Hand the socket to TinyGSM
+            sock_connected = true;
+            return finish(true);
+        }
+
+        case OP_CLOSE:
+            // Closed, already closed or modem gone: the socket is unusable either way
+            abandon();
+            return finish(true);
+
+        default:
+            return finish(false);
+    }
+}
+
+void AsyncGsmClient::abandon() {
+    sock_connected = false;
+    sock_available = 0;
+    got_data = false;
+    rx.clear();
+}
+
+AsyncGsmClient::OpResult AsyncGsmClient::finish(bool ok) {
+    op = OP_NONE;
+    return ok ? OP_DONE : OP_FAILED;
+}
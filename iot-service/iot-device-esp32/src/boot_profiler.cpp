@@ -0,0 +1,167 @@
+#include "boot_profiler.h"
+#include "queue_record.h"
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <stddef.h>
+#include <string.h>
+
+// ============================================================================
+// BOOT PROFILER IMPLEMENTATION
+// ============================================================================
+
+#define BOOT_RECORD_MAGIC       0x544F4F42UL    // "BOOT"
+
+namespace {
+
+struct BootRecord {
+    uint32_t magic;
+    uint32_t bootCount;
+    BootProfiler::Summary last;
+    uint32_t crc;               // Over everything above
+};
+
+// Not cleared by the startup code: still holds the previous boot's record
+// after any reset but power-on
+RTC_NOINIT_ATTR BootRecord record;
+
+uint32_t recordCrc(const BootRecord& rec) {
+    return queueCrc32(0, (const uint8_t*)&rec, offsetof(BootRecord, crc));
+}
+
+const char* const PHASE_NAMES[BOOT_PHASE_COUNT] = {
+    "time", "rs485", "io", "storage", "post_init",
+    "modem", "network", "mqtt", "config", "telemetry"
+};
+
+} // namespace
+
+BootProfiler::BootProfiler() {
+    memset(&current, 0, sizeof(current));
+    memset(&previous, 0, sizeof(previous));
+    bootCount = 0;
+    portMUX_INITIALIZE(&lock);
+}
+
+void BootProfiler::begin() {
+    current.valid = true;
+    current.resetReason = (uint8_t)esp_reset_reason();
+
+    bool kept = current.resetReason != ESP_RST_POWERON &&
+                record.magic == BOOT_RECORD_MAGIC && record.crc == recordCrc(record);
+    if (kept) {
+        previous = record.last;
+        bootCount = record.bootCount + 1;
+    } else {
+        memset(&previous, 0, sizeof(previous));
+        bootCount = 1;
+    }
+    save();
+
+    Serial.printf("[Boot] Boot #%lu since power-on, reset reason: %s\n",
+                  (unsigned long)bootCount, resetReasonName(current.resetReason));
+    if (previous.valid) {
+        Serial.printf("[Boot] Previous boot ran %lu s (started by %s)\n",
+                      (unsigned long)previous.uptimeS, resetReasonName(previous.resetReason));
+    }
+}
+
+// ============================================================================
+// PHASES
+// ============================================================================
+
+void BootProfiler::start(BootPhase phase) {
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&lock);
+    Phase& p = current.phases[phase];
+    if (p.startMs == 0 && p.endMs == 0) {
+        p.startMs = now;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void BootProfiler::end(BootPhase phase) {
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&lock);
+    Phase& p = current.phases[phase];
+    bool first = p.endMs == 0;
+    if (first) {
+        p.endMs = now;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (first) {
+        save();
+    }
+}
+
+void BootProfiler::span(BootPhase phase, unsigned long startMs, unsigned long endMs) {
+    portENTER_CRITICAL(&lock);
+    Phase& p = current.phases[phase];
+    bool first = p.endMs == 0 && endMs != 0;
+    if (first) {
+        p.startMs = startMs;
+        p.endMs = endMs;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (first) {
+        save();
+    }
+}
+
+void BootProfiler::noteAlive(unsigned long nowMs) {
+    portENTER_CRITICAL(&lock);
+    current.uptimeS = nowMs / 1000;
+    portEXIT_CRITICAL(&lock);
+    save();
+}
+
+// Called from both tasks
+void BootProfiler::save() {
+    portENTER_CRITICAL(&lock);
+    record.magic = BOOT_RECORD_MAGIC;
+    record.bootCount = bootCount;
+    record.last = current;
+    record.crc = recordCrc(record);
+    portEXIT_CRITICAL(&lock);
+}
+
+// ============================================================================
+// REPORTING
+// ============================================================================
+
+void BootProfiler::printTimeline() const {
+    Serial.printf("[Boot] Timeline of boot #%lu (%s):\n",
+                  (unsigned long)bootCount, resetReasonName(current.resetReason));
+    for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+        const Phase& p = current.phases[i];
+        if (p.endMs == 0) {
+            Serial.printf("  %-10s -\n", PHASE_NAMES[i]);
+        } else {
+            Serial.printf("  %-10s done at %6lu ms, took %6lu ms\n", PHASE_NAMES[i],
+                          (unsigned long)p.endMs, (unsigned long)(p.endMs - p.startMs));
+        }
+    }
+}
+
+const char* BootProfiler::phaseName(uint8_t phase) {
+    return phase < BOOT_PHASE_COUNT ? PHASE_NAMES[phase] : "?";
+}
+
+const char* BootProfiler::resetReasonName(uint8_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON:   return "power_on";
+        case ESP_RST_EXT:       return "external";
+        case ESP_RST_SW:        return "software";
+        case ESP_RST_PANIC:     return "panic";
+        case ESP_RST_INT_WDT:   return "int_wdt";
+        case ESP_RST_TASK_WDT:  return "task_wdt";
+        case ESP_RST_WDT:       return "wdt";
+        case ESP_RST_DEEPSLEEP: return "deep_sleep";
+        case ESP_RST_BROWNOUT:  return "brownout";
+        case ESP_RST_SDIO:      return "sdio";
+        default:                return "unknown";
+    }
+}
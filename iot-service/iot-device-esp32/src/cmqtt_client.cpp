@@ -0,0 +1,561 @@
+#include "cmqtt_client.h"
+
+// ============================================================================
+// CMQTT CLIENT IMPLEMENTATION
+// ============================================================================
+
+#define CMQTT_CMD_TIMEOUT_MS    3000    // Plain commands / data prompts
+#define CMQTT_SUB_TIMEOUT_MS    15000   // Until "+CMQTTSUB: 0,<err>"
+
+CmqttClient::CmqttClient(ModemAt& modemAt) : at(modemAt) {
+    clock = nullptr;
+    host[0] = '\0';
+    port = 0;
+    tls = false;
+    caFile[0] = '\0';
+    sslStep = 0;
+    clientId[0] = '\0';
+    keepAliveS = 0;
+    cleanSession = false;
+    connectTimeoutMs = 0;
+    connectStartedAt = 0;
+    rxBuffer = nullptr;
+    rxSize = 0;
+    arena = nullptr;
+    arenaSize = 0;
+    arenaUsed = 0;
+    window = 1;
+    memset(entries, 0, sizeof(entries));
+    inflightHead = 0;
+    inflightCount = 0;
+    pubOutstanding = false;
+    pubSentAt = 0;
+    pubFailures = 0;
+    subscriptionCount = 0;
+    state = MqttClient::MQTT_IDLE;
+    returnCode = 0;
+    op = OP_NONE;
+    opStartedAt = 0;
+    lastCheckAt = 0;
+    checkRequested = false;
+    lastInAt = 0;
+    command[0] = '\0';
+    rxTopicLen = 0;
+    rxPayloadLen = 0;
+    rxTopicGot = 0;
+    rxPayloadGot = 0;
+    rxSkip = true;
+    messageHandler = nullptr;
+    messageContext = nullptr;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void CmqttClient::setServer(const char* hostName, uint16_t hostPort) {
+    strncpy(host, hostName, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    port = hostPort;
+}
+
+void CmqttClient::setTls(bool enabled, const char* file) {
+    tls = enabled;
+    snprintf(caFile, sizeof(caFile), "%s", file ? file : "");
+}
+
+void CmqttClient::begin(ClockFn millisClock, uint8_t* rx, size_t rxBytes,
+                        uint8_t* inflightArena, size_t inflightBytes, uint8_t windowSize) {
+    clock = millisClock;
+    rxBuffer = rx;
+    rxSize = rxBytes;
+    arena = inflightArena;
+    arenaSize = inflightBytes;
+    window = windowSize == 0 ? 1 : (windowSize > MQTT_INFLIGHT_MAX ? MQTT_INFLIGHT_MAX : windowSize);
+    clearInflight();
+    at.addUrcHandler(onUrc, this);
+}
+
+void CmqttClient::setMessageHandler(MessageFn handler, void* context) {
+    messageHandler = handler;
+    messageContext = context;
+}
+
+// ========================================
+// Session
+// ========================================
+
+bool CmqttClient::connect(const char* id, uint16_t keepAlive, bool clean, uint32_t timeoutMs) {
+    if (strlen(id) > MQTT_CLIENT_ID_MAX || port == 0) {
+        return false;
+    }
+    if (op != OP_NONE) {
+        at.cancel();
+        op = OP_NONE;
+    }
+    if (at.isBusy()) {
+        return false;
+    }
+
+    strcpy(clientId, id);
+    keepAliveS = keepAlive;
+    cleanSession = clean;
+    connectTimeoutMs = timeoutMs;
+    connectStartedAt = now();
+    returnCode = 0;
+    pubOutstanding = false;
+    subscriptionCount = 0;      // Subscriptions are redone after every connect
+    state = MqttClient::MQTT_CONNECTING;
+
+    // Whatever the modem client still holds (old session, half-open
+    // connect) is torn down first; errors here just mean "nothing to do"
+    snprintf(command, sizeof(command), "+CMQTTDISC=%d,60", CMQTT_CLIENT_INDEX);
+    startOp(OP_DISC, CMQTT_CMD_TIMEOUT_MS, "+CMQTTDISC:", true);
+    return true;
+}
+
+void CmqttClient::disconnect() {
+    if (op != OP_NONE) {
+        at.cancel();
+        op = OP_NONE;
+    }
+    if (state == MqttClient::MQTT_CONNECTED && !at.isBusy()) {
+        snprintf(command, sizeof(command), "+CMQTTDISC=%d,60", CMQTT_CLIENT_INDEX);
+        startOp(OP_CLOSE, CMQTT_CMD_TIMEOUT_MS, "+CMQTTDISC:", true);
+    }
+    state = MqttClient::MQTT_IDLE;
+    pubOutstanding = false;
+}
+
+void CmqttClient::drop() {
+    if (op != OP_NONE) {
+        at.cancel();
+        op = OP_NONE;
+    }
+    lose(MqttClient::MQTT_IDLE);
+}
+
+bool CmqttClient::ping() {
+    if (state != MqttClient::MQTT_CONNECTED) {
+        return false;
+    }
+    checkRequested = true;
+    return true;
+}
+
+void CmqttClient::lose(State reason) {
+    state = reason;
+    pubOutstanding = false;
+    rxSkip = true;
+}
+
+void CmqttClient::clearInflight() {
+    inflightHead = 0;
+    inflightCount = 0;
+    arenaUsed = 0;
+    pubOutstanding = false;
+}
+
+// ========================================
+// Poll
+// ========================================
+
+void CmqttClient::poll() {
+    if (op != OP_NONE) {
+        ModemAt::Result result = at.poll();
+        if (result == ModemAt::AT_PENDING) {
+            return;
+        }
+        finishOp(result);
+    } else if (!at.isBusy()) {
+        at.poll();      // URCs only
+    } else {
+        return;         // Someone else's command, not our result to take
+    }
+
+    unsigned long t = now();
+
+    if (state == MqttClient::MQTT_CONNECTING && op == OP_NONE &&
+        t - connectStartedAt >= connectTimeoutMs) {
+        lose(MqttClient::MQTT_TIMEOUT);
+        return;
+    }
+
+    // The result URC may have been eaten by a blocking TinyGSM command
+    if (pubOutstanding && t - pubSentAt >= (CMQTT_PUB_TIMEOUT_S + 5) * 1000UL) {
+        pubOutstanding = false;
+        slot(0).dup = true;
+        stats.resent++;
+    }
+
+    if (op == OP_NONE && !at.isBusy() && state == MqttClient::MQTT_CONNECTED) {
+        startNext();
+    }
+}
+
+void CmqttClient::startNext() {
+    unsigned long t = now();
+
+    if (subscriptionCount > 0) {
+        const Subscription& sub = subscriptions[0];
+        snprintf(command, sizeof(command), "+CMQTTSUB=%d,%u,%u",
+                 CMQTT_CLIENT_INDEX, (unsigned)strlen(sub.topic), sub.qos);
+        startDataOp(OP_SUBSCRIBE, (const uint8_t*)sub.topic, strlen(sub.topic),
+                    CMQTT_SUB_TIMEOUT_MS, "+CMQTTSUB:", true);
+        return;
+    }
+
+    if (inflightCount > 0 && !pubOutstanding) {
+        const Entry& entry = slot(0);
+        snprintf(command, sizeof(command), "+CMQTTTOPIC=%d,%u", CMQTT_CLIENT_INDEX, entry.topicLen);
+        startDataOp(OP_TOPIC, arena + entry.offset, entry.topicLen, CMQTT_CMD_TIMEOUT_MS);
+        return;
+    }
+
+    // Keepalive runs in the modem; this only confirms it still has the session
+    if (checkRequested || (keepAliveS > 0 && t - lastCheckAt >= keepAliveS * 1000UL)) {
+        checkRequested = false;
+        snprintf(command, sizeof(command), "+CMQTTDISC?");
+        startOp(OP_CHECK, CMQTT_CMD_TIMEOUT_MS, "+CMQTTDISC:");
+        stats.pings++;
+    }
+}
+
+void CmqttClient::startOp(Op next, uint32_t timeoutMs, const char* capturePrefix, bool untilCapture) {
+    if (at.start(command, timeoutMs, capturePrefix, untilCapture)) {
+        op = next;
+        opStartedAt = now();
+    }
+}
+
+void CmqttClient::startDataOp(Op next, const uint8_t* data, size_t length, uint32_t timeoutMs,
+                              const char* capturePrefix, bool untilCapture) {
+    if (at.startWithData(command, data, length, timeoutMs, capturePrefix, untilCapture)) {
+        op = next;
+        opStartedAt = now();
+    }
+}
+
+void CmqttClient::finishOp(ModemAt::Result result) {
+    Op done = op;
+    op = OP_NONE;
+    int index = -1;
+    int err = -1;
+
+    switch (done) {
+        case OP_DISC:
+            snprintf(command, sizeof(command), "+CMQTTREL=%d", CMQTT_CLIENT_INDEX);
+            startOp(OP_RELEASE, CMQTT_CMD_TIMEOUT_MS);
+            break;
+
+        case OP_RELEASE:
+            // ERROR with "+CMQTTSTART: 23" = service already running
+            snprintf(command, sizeof(command), "+CMQTTSTART");
+            startOp(OP_START, CMQTT_CMD_TIMEOUT_MS, "+CMQTTSTART:", true);
+            break;
+
+        case OP_START:
+            sslStep = 0;
+            if (!tls || !nextSslConfig()) {
+                startAcquire();
+            }
+            break;
+
+        case OP_SSL_CONFIG:
+            // A setting the firmware does not know is left at its default
+            if (!nextSslConfig()) {
+                startAcquire();
+            }
+            break;
+
+        case OP_ACQUIRE:
+            if (result != ModemAt::AT_OK) {
+                returnCode = 0xFF;
+                lose(MqttClient::MQTT_REFUSED);
+                break;
+            }
+            if (tls) {
+                snprintf(command, sizeof(command), "+CMQTTSSLCFG=%d,%d", CMQTT_CLIENT_INDEX, CMQTT_SSL_CONTEXT);
+                startOp(OP_SSL_BIND, CMQTT_CMD_TIMEOUT_MS);
+            } else {
+                startConnect();
+            }
+            break;
+
+        case OP_SSL_BIND:
+            if (result != ModemAt::AT_OK) {
+                returnCode = 0xFF;
+                lose(MqttClient::MQTT_REFUSED);
+                break;
+            }
+            startConnect();
+            break;
+
+        case OP_CONNECT:
+            if (result == ModemAt::AT_TIMEOUT) {
+                lose(MqttClient::MQTT_TIMEOUT);
+                break;
+            }
+            // "+CMQTTCONNECT: <index>,<err>", err 0 = CONNACK accepted
+            if (result != ModemAt::AT_OK ||
+                sscanf(at.getLine(), "+CMQTTCONNECT: %d,%d", &index, &err) != 2 || err != 0) {
+                returnCode = err < 0 ? 0xFF : err;
+                lose(MqttClient::MQTT_REFUSED);
+                break;
+            }
+            state = MqttClient::MQTT_CONNECTED;
+            lastCheckAt = now();
+            lastInAt = lastCheckAt;
+            checkRequested = false;
+            pubFailures = 0;
+            for (uint8_t i = 0; i < inflightCount; i++) {
+                slot(i).dup = true;
+            }
+            break;
+
+        case OP_SUBSCRIBE:
+            // Dropped either way; a refused topic is not retried forever
+            memmove(&subscriptions[0], &subscriptions[1],
+                    (subscriptionCount - 1) * sizeof(Subscription));
+            subscriptionCount--;
+            break;
+
+        case OP_TOPIC: {
+            if (result != ModemAt::AT_OK) {
+                publishFailed();
+                break;
+            }
+            const Entry& entry = slot(0);
+            snprintf(command, sizeof(command), "+CMQTTPAYLOAD=%d,%lu",
+                     CMQTT_CLIENT_INDEX, (unsigned long)entry.payloadLen);
+            startDataOp(OP_PAYLOAD, arena + entry.offset + entry.topicLen, entry.payloadLen,
+                        CMQTT_CMD_TIMEOUT_MS);
+            break;
+        }
+
+        case OP_PAYLOAD: {
+            if (result != ModemAt::AT_OK) {
+                publishFailed();
+                break;
+            }
+            Entry& entry = slot(0);
+            snprintf(command, sizeof(command), "+CMQTTPUB=%d,%u,%d,%d,%d", CMQTT_CLIENT_INDEX,
+                     entry.qos, CMQTT_PUB_TIMEOUT_S, entry.retained ? 1 : 0, entry.dup ? 1 : 0);
+            startOp(OP_PUBLISH, CMQTT_CMD_TIMEOUT_MS);
+            break;
+        }
+
+        case OP_PUBLISH:
+            if (result != ModemAt::AT_OK) {
+                publishFailed();
+                break;
+            }
+            // Result follows as "+CMQTTPUB: 0,<err>" once the broker acked
+            pubOutstanding = true;
+            pubSentAt = now();
+            break;
+
+        case OP_CHECK:
+            // "+CMQTTDISC: <index>,<state>", state 1 = disconnected
+            lastCheckAt = now();
+            if (result == ModemAt::AT_OK &&
+                sscanf(at.getLine(), "+CMQTTDISC: %d,%d", &index, &err) == 2) {
+                stats.lastPingMs = lastCheckAt - opStartedAt;
+                if (err == 1 && state == MqttClient::MQTT_CONNECTED) {
+                    lose(MqttClient::MQTT_LOST);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+// SSL context for the broker: any TLS version the modem has, server
+// authentication against caFile, SNI, and certificate dates not checked
+// against the modem clock (not set at boot)
+bool CmqttClient::nextSslConfig() {
+    switch (sslStep++) {
+        case 0:
+            snprintf(command, sizeof(command), "+CSSLCFG=\"sslversion\",%d,4", CMQTT_SSL_CONTEXT);
+            break;
+        case 1:
+            snprintf(command, sizeof(command), "+CSSLCFG=\"authmode\",%d,%d",
+                     CMQTT_SSL_CONTEXT, caFile[0] ? 1 : 0);
+            break;
+        case 2:
+            snprintf(command, sizeof(command), "+CSSLCFG=\"ignorelocaltime\",%d,1", CMQTT_SSL_CONTEXT);
+            break;
+        case 3:
+            snprintf(command, sizeof(command), "+CSSLCFG=\"enableSNI\",%d,1", CMQTT_SSL_CONTEXT);
+            break;
+        case 4:
+            if (caFile[0] == '\0') {
+                return false;
+            }
+            snprintf(command, sizeof(command), "+CSSLCFG=\"cacert\",%d,\"%s\"", CMQTT_SSL_CONTEXT, caFile);
+            break;
+        default:
+            return false;
+    }
+    startOp(OP_SSL_CONFIG, CMQTT_CMD_TIMEOUT_MS);
+    return true;
+}
+
+void CmqttClient::startAcquire() {
+    // Server type 1 = SSL/TLS
+    snprintf(command, sizeof(command), "+CMQTTACCQ=%d,\"%s\",%d", CMQTT_CLIENT_INDEX, clientId, tls ? 1 : 0);
+    startOp(OP_ACQUIRE, CMQTT_CMD_TIMEOUT_MS);
+}
+
+void CmqttClient::startConnect() {
+    snprintf(command, sizeof(command), "+CMQTTCONNECT=%d,\"tcp://%s:%u\",%u,%d",
+             CMQTT_CLIENT_INDEX, host, port, keepAliveS, cleanSession ? 1 : 0);
+    startOp(OP_CONNECT, connectTimeoutMs, "+CMQTTCONNECT:", true);
+}
+
+void CmqttClient::publishFailed() {
+    pubOutstanding = false;
+    if (++pubFailures >= CMQTT_PUB_RETRIES) {
+        lose(MqttClient::MQTT_LOST);
+    }
+}
+
+// ========================================
+// Publish / Subscribe
+// ========================================
+
+bool CmqttClient::canPublish(size_t topicLen, size_t payloadLen) const {
+    return inflightCount < window && arenaUsed + topicLen + payloadLen <= arenaSize;
+}
+
+uint32_t CmqttClient::getAckWaitMs() const {
+    return pubOutstanding ? now() - pubSentAt : 0;
+}
+
+bool CmqttClient::publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos, bool retained) {
+    size_t topicLen = strlen(topic);
+    if (state != MqttClient::MQTT_CONNECTED || !canPublish(topicLen, len)) {
+        return false;
+    }
+
+    Entry& entry = slot(inflightCount);
+    entry.offset = arenaUsed;
+    entry.topicLen = topicLen;
+    entry.payloadLen = len;
+    entry.qos = qos > 1 ? 1 : qos;
+    entry.retained = retained;
+    entry.dup = false;
+    memcpy(arena + arenaUsed, topic, topicLen);
+    memcpy(arena + arenaUsed + topicLen, payload, len);
+    arenaUsed += topicLen + len;
+    inflightCount++;
+
+    if (entry.qos == 0) {
+        stats.qos0++;
+    } else {
+        stats.published++;
+    }
+    return true;
+}
+
+void CmqttClient::releaseHead() {
+    const Entry& head = slot(0);
+    uint32_t size = head.topicLen + head.payloadLen;
+    inflightHead = (inflightHead + 1) % MQTT_INFLIGHT_MAX;
+    inflightCount--;
+
+    memmove(arena, arena + size, arenaUsed - size);
+    arenaUsed -= size;
+    for (uint8_t i = 0; i < inflightCount; i++) {
+        slot(i).offset -= size;
+    }
+}
+
+bool CmqttClient::subscribe(const char* topic, uint8_t qos) {
+    if (state != MqttClient::MQTT_CONNECTED || subscriptionCount >= CMQTT_SUB_QUEUE ||
+        strlen(topic) >= CMQTT_TOPIC_MAX) {
+        return false;
+    }
+
+    Subscription& sub = subscriptions[subscriptionCount++];
+    strcpy(sub.topic, topic);
+    sub.qos = qos > 1 ? 1 : qos;
+    return true;
+}
+
+// ========================================
+// URCs
+// ========================================
+
+void CmqttClient::onUrc(void* context, const char* line) {
+    if (strncmp(line, "+CMQTT", 6) == 0) {
+        static_cast<CmqttClient*>(context)->handleUrc(line);
+    }
+}
+
+void CmqttClient::handleUrc(const char* line) {
+    int index = -1;
+    unsigned long a = 0, b = 0;
+
+    if (sscanf(line, "+CMQTTPUB: %d,%lu", &index, &a) == 2) {
+        if (!pubOutstanding || inflightCount == 0) {
+            return;
+        }
+        pubOutstanding = false;
+        unsigned long t = now();
+        lastInAt = t;
+        if (a != 0) {
+            publishFailed();
+            return;
+        }
+        if (slot(0).qos > 0) {
+            stats.acked++;
+            stats.lastAckAt = t;
+            stats.lastAckMs = t - pubSentAt;
+            if (stats.lastAckMs > stats.maxAckMs) {
+                stats.maxAckMs = stats.lastAckMs;
+            }
+        }
+        pubFailures = 0;
+        releaseHead();
+
+    } else if (sscanf(line, "+CMQTTCONNLOST: %d,%lu", &index, &a) == 2) {
+        if (state == MqttClient::MQTT_CONNECTED) {
+            lose(MqttClient::MQTT_LOST);
+        }
+
+    } else if (sscanf(line, "+CMQTTRXSTART: %d,%lu,%lu", &index, &a, &b) == 3) {
+        rxTopicLen = a;
+        rxPayloadLen = b;
+        rxTopicGot = 0;
+        rxPayloadGot = 0;
+        rxSkip = rxBuffer == nullptr || a + 1 + b > rxSize;
+
+    } else if (sscanf(line, "+CMQTTRXTOPIC: %d,%lu", &index, &a) == 2) {
+        if (rxTopicGot + a > rxTopicLen) {
+            rxSkip = true;
+        }
+        at.readRaw(rxSkip ? nullptr : rxBuffer + rxTopicGot, a);
+        rxTopicGot += a;
+
+    } else if (sscanf(line, "+CMQTTRXPAYLOAD: %d,%lu", &index, &a) == 2) {
+        // Large payloads come in several pieces
+        if (rxPayloadGot + a > rxPayloadLen) {
+            rxSkip = true;
+        }
+        at.readRaw(rxSkip ? nullptr : rxBuffer + rxTopicLen + 1 + rxPayloadGot, a);
+        rxPayloadGot += a;
+
+    } else if (strncmp(line, "+CMQTTRXEND:", 12) == 0) {
+        if (rxSkip || rxTopicGot != rxTopicLen) {
+            stats.dropped++;
+        } else {
+            rxBuffer[rxTopicLen] = '\0';
+            stats.received++;
+            lastInAt = now();
+            if (messageHandler) {
+                messageHandler(messageContext, (char*)rxBuffer, rxBuffer + rxTopicLen + 1, rxPayloadGot);
+            }
+        }
+        rxSkip = true;
+    }
+}
@@ -3,11 +3,10 @@
 
 // Timing constants (from our design)
 #define LTE_RECONNECT_INTERVAL 30000          // 30s between LTE retries
-#define INTERNET_TEST_INTERVAL 300000         // 5min periodic internet test
-#define INTERNET_DOWN_RETRY_INTERVAL 10000    // 10s retry cadence when internet is down
+#define INTERNET_DOWN_RETRY_INTERVAL 10000    // First retry when internet is down, doubled per failure
+#define INTERNET_DOWN_RETRY_MAX 300000        // ...up to 5min between probes
 #define MQTT_RECONNECT_INTERVAL 10000         // 10s between MQTT retries
 #define MQTT_MAX_RETRIES 3                    // Max MQTT retries before checking internet
-#define HEALTH_CHECK_INTERVAL 300000          // 5min full health check
 #define LTE_REBOOT_RETRY_THRESHOLD 3          // Hard reboot after consecutive LTE failures
 #define MQTT_HARD_RESET_THRESHOLD 9           // Total failed MQTT reconnects before reboot
 #define CONNECTION_WATCHDOG_TIMEOUT 600000    // 10 min without successful publish triggers restart
@@ -28,16 +27,20 @@ ConnectionManager::ConnectionManager(LTEManager& lte, MQTTManager& mqtt)
     lastLTERetry = 0;
     lastInternetTest = 0;
     lastMQTTRetry = 0;
-    lastHealthCheck = 0;
     lastPublishSuccess = 0;
+    connectedSince = 0;
+    livenessCheckAt = 0;
+    internetRetryInterval = INTERNET_DOWN_RETRY_INTERVAL;
     mqttFailCount = 0;
     lteFailCount = 0;
     lteReconnectAttempts = 0;
     lteHardReboots = 0;
     internetFailCount = 0;
+    livenessFailures = 0;
     mqttReconnectAttempts = 0;
     mqttTotalFailures = 0;
     mqttPublishFailures = 0;
+    lteRebooting = false;
 }
 
 // ============================================================================
@@ -45,161 +48,176 @@ ConnectionManager::ConnectionManager(LTEManager& lte, MQTTManager& mqtt)
 // ============================================================================
 
 void ConnectionManager::begin() {
-    if (lteManager.isConnected()) {
-        currentState = LTE_UP_INTERNET_DOWN;
-        lastInternetTest = 0; // trigger immediate HTTP validation
-        Serial.println("\n[ConnMgr] LTE ready. Validating internet next...");
-    } else {
-        currentState = LTE_DOWN;
-        lastLTERetry = 0; // trigger immediate reconnect attempt
-        Serial.println("\n[ConnMgr] LTE offline. Starting reconnection loop...");
-    }
+    // lteManager.begin() has started power-up + attach; its outcome arrives
+    // through handleLTEDown() like any reconnect
+    currentState = LTE_DOWN;
+    lastLTERetry = 0;  // failed boot attach -> immediate retry
+    Serial.println("\n[ConnMgr] Waiting for LTE power-up...");
 
     Serial.print("[ConnMgr] Initial State: ");
     Serial.println(getStateString());
     lastPublishSuccess = millis();
 }
 
-// ============================================================================
-// TEST INTERNET
-// ============================================================================
-
-bool ConnectionManager::testInternet() {
-    return lteManager.testInternet();
-}
-
 // ============================================================================
 // STATE HANDLERS
 // ============================================================================
+// Each handler first collects the result of the operation it started (if
+// any), then starts the next one once its interval has passed. Nothing here
+// waits on the modem.
 
 void ConnectionManager::handleLTEDown() {
     unsigned long now = millis();
+    LTEManager::LinkStatus status = lteManager.poll();
 
-    if (!intervalElapsed(now, lastLTERetry, LTE_RECONNECT_INTERVAL)) {
+    if (status == LTEManager::LINK_BUSY) {
         return;
     }
 
-    lastLTERetry = now;
-    lteReconnectAttempts++;
-    Serial.println("\n[ConnMgr] Attempting LTE reconnection...");
-
-    if (lteManager.connect()) {
-        Serial.println("[ConnMgr] ✅ LTE reconnected");
-        currentState = LTE_UP_INTERNET_DOWN;
-        lastInternetTest = 0;  // force immediate internet test
+    if (status == LTEManager::LINK_UP) {
+        if (lteRebooting) {
+            Serial.println("[ConnMgr] ✅ Modem reboot complete");
+            lteHardReboots++;
+        } else {
+            Serial.println("[ConnMgr] ✅ LTE reconnected");
+        }
+        lteRebooting = false;
+        // The MQTT connect is the internet test; the TCP probe only runs
+        // once that keeps failing
+        currentState = LTE_UP_INTERNET_UP_MQTT_DOWN;
         lastMQTTRetry = 0;
+        mqttFailCount = 0;
         lteFailCount = 0;
-    } else {
-        lteFailCount++;
-        Serial.print("[ConnMgr] ❌ LTE reconnection failed (");
-        Serial.print(lteFailCount);
-        Serial.println(" consecutive failures)");
-
-        if (lteFailCount >= LTE_REBOOT_RETRY_THRESHOLD) {
-            Serial.println("[ConnMgr] LTE not recovering. Performing modem hard reboot...");
-            if (lteManager.rebootModem()) {
-                Serial.println("[ConnMgr] ✅ Modem reboot complete");
-                currentState = LTE_UP_INTERNET_DOWN;
-                lastInternetTest = 0;
-                lastMQTTRetry = 0;
-                lteFailCount = 0;
-                lteHardReboots++;
+        return;
+    }
+
+    if (status == LTEManager::LINK_FAILED || status == LTEManager::LINK_DOWN) {
+        if (lteRebooting) {
+            Serial.println("[ConnMgr] ❌ Modem reboot failed, will retry later");
+            lteRebooting = false;
+        } else {
+            lteFailCount++;
+            Serial.print("[ConnMgr] ❌ LTE reconnection failed (");
+            Serial.print(lteFailCount);
+            Serial.println(" consecutive failures)");
+
+            if (lteFailCount >= LTE_REBOOT_RETRY_THRESHOLD) {
+                Serial.println("[ConnMgr] LTE not recovering. Performing modem hard reboot...");
+                lteRebooting = lteManager.startReboot();
                 return;
-            } else {
-                Serial.println("[ConnMgr] ❌ Modem reboot failed, will retry later");
             }
         }
 
         Serial.println("[ConnMgr] Waiting before next LTE retry...");
     }
+
+    if (!intervalElapsed(now, lastLTERetry, LTE_RECONNECT_INTERVAL)) {
+        return;
+    }
+
+    lastLTERetry = now;
+    lteReconnectAttempts++;
+    Serial.println("\n[ConnMgr] Attempting LTE reconnection...");
+    lteManager.startConnect();
 }
 
 void ConnectionManager::handleInternetDown() {
     unsigned long now = millis();
+    LTEManager::LinkStatus status = lteManager.poll();
 
-    if (!lteManager.isConnected()) {
-        Serial.println("[ConnMgr] LTE dropped while checking internet. Returning to LTE_DOWN");
-        currentState = LTE_DOWN;
-        lastLTERetry = 0;
-        return;
+    switch (status) {
+        case LTEManager::LINK_BUSY:
+            return;
+
+        case LTEManager::LINK_UP:
+            Serial.println("[ConnMgr] ✅ Internet restored");
+            currentState = LTE_UP_INTERNET_UP_MQTT_DOWN;
+            internetRetryInterval = INTERNET_DOWN_RETRY_INTERVAL;
+            lastMQTTRetry = 0;
+            mqttFailCount = 0;
+            return;
+
+        case LTEManager::LINK_DOWN:
+            Serial.println("[ConnMgr] LTE dropped while checking internet. Returning to LTE_DOWN");
+            currentState = LTE_DOWN;
+            lastLTERetry = 0;
+            return;
+
+        case LTEManager::LINK_FAILED:
+            internetFailCount++;
+            internetRetryInterval = min(internetRetryInterval * 2, (unsigned long)INTERNET_DOWN_RETRY_MAX);
+            Serial.printf("[ConnMgr] ❌ Internet still down, retrying in %lus\n", internetRetryInterval / 1000);
+            break;
+
+        default:
+            break;
     }
 
-    if (!intervalElapsed(now, lastInternetTest, INTERNET_DOWN_RETRY_INTERVAL)) {
+    if (!intervalElapsed(now, lastInternetTest, internetRetryInterval)) {
         return;
     }
 
     lastInternetTest = now;
-    Serial.println("[ConnMgr] Testing internet via HTTP...");
-
-    if (testInternet()) {
-        Serial.println("[ConnMgr] ✅ Internet restored");
-        currentState = LTE_UP_INTERNET_UP_MQTT_DOWN;
-        lastMQTTRetry = 0;
-        mqttFailCount = 0;
-    } else {
-        Serial.println("[ConnMgr] ❌ Internet still down, retrying in 10s");
-        internetFailCount++;
-    }
+    Serial.println("[ConnMgr] Testing internet via TCP...");
+    lteManager.startInternetProbe();
 }
 
 void ConnectionManager::handleMQTTDown() {
     unsigned long now = millis();
+    MQTTManager::ConnectResult result = mqttManager.pollConnect();
 
-    if (!lteManager.isConnected()) {
-        Serial.println("[ConnMgr] LTE dropped during MQTT recovery. Returning to LTE_DOWN");
-        currentState = LTE_DOWN;
-        lastLTERetry = 0;
-        return;
-    }
-
-    if (!intervalElapsed(now, lastMQTTRetry, MQTT_RECONNECT_INTERVAL)) {
+    if (result == MQTTManager::CONNECT_PENDING) {
         return;
     }
 
-    lastMQTTRetry = now;
-    mqttReconnectAttempts++;
-    Serial.println("\n[ConnMgr] Attempting MQTT reconnection...");
-
-    if (mqttManager.connect()) {
+    if (result == MQTTManager::CONNECT_OK) {
         Serial.println("[ConnMgr] ✅ MQTT reconnected");
         currentState = FULLY_CONNECTED;
+        connectedSince = now;
+        livenessCheckAt = 0;
         mqttFailCount = 0;
         return;
     }
 
-    mqttFailCount++;
-    mqttTotalFailures++;
-    Serial.print("[ConnMgr] ❌ MQTT reconnection failed (");
-    Serial.print(mqttFailCount);
-    Serial.print("/");
-    Serial.print(MQTT_MAX_RETRIES);
-    Serial.println(")");
-
-    if (mqttFailCount >= MQTT_MAX_RETRIES) {
-        Serial.println("[ConnMgr] Escalating to internet diagnostics after MQTT failures");
-        currentState = LTE_UP_INTERNET_DOWN;
-        lastInternetTest = 0;
-        mqttFailCount = 0;
+    if (result == MQTTManager::CONNECT_FAILED) {
+        mqttFailCount++;
+        mqttTotalFailures++;
+        Serial.print("[ConnMgr] ❌ MQTT reconnection failed (");
+        Serial.print(mqttFailCount);
+        Serial.print("/");
+        Serial.print(MQTT_MAX_RETRIES);
+        Serial.println(")");
+
+        if (mqttTotalFailures >= MQTT_HARD_RESET_THRESHOLD) {
+            Serial.println("[ConnMgr] MQTT failures exceeded threshold. Rebooting MCU...");
+            delay(200);
+            ESP.restart();
+        }
+
+        // Last resort: the internet probe also notices a lost data session
+        if (mqttFailCount >= MQTT_MAX_RETRIES) {
+            Serial.println("[ConnMgr] Escalating to internet diagnostics after MQTT failures");
+            currentState = LTE_UP_INTERNET_DOWN;
+            lastInternetTest = 0;
+            internetRetryInterval = INTERNET_DOWN_RETRY_INTERVAL;
+            mqttFailCount = 0;
+            return;
+        }
     }
 
-    if (mqttTotalFailures >= MQTT_HARD_RESET_THRESHOLD) {
-        Serial.println("[ConnMgr] MQTT failures exceeded threshold. Rebooting MCU...");
-        delay(200);
-        ESP.restart();
+    if (!intervalElapsed(now, lastMQTTRetry, MQTT_RECONNECT_INTERVAL)) {
+        return;
     }
+
+    lastMQTTRetry = now;
+    mqttReconnectAttempts++;
+    Serial.println("\n[ConnMgr] Attempting MQTT reconnection...");
+    mqttManager.startConnect();
 }
 
 void ConnectionManager::handleConnected() {
     unsigned long now = millis();
 
-    // Immediate sanity checks
-    if (!lteManager.isConnected()) {
-        Serial.println("[ConnMgr] LTE lost while connected. Returning to LTE_DOWN");
-        currentState = LTE_DOWN;
-        lastLTERetry = 0;
-        return;
-    }
-
     if (!mqttManager.isConnected()) {
         Serial.println("[ConnMgr] MQTT disconnected! State → MQTT_DOWN");
         currentState = LTE_UP_INTERNET_UP_MQTT_DOWN;
@@ -208,16 +226,34 @@ void ConnectionManager::handleConnected() {
         return;
     }
 
-    // Periodic internet validation (every 5 minutes)
-    if (intervalElapsed(now, lastInternetTest, INTERNET_TEST_INTERVAL)) {
-        Serial.println("[ConnMgr] Running periodic internet diagnostics...");
-        if (!testInternet()) {
-            Serial.println("[ConnMgr] Internet degraded, moving back to diagnostics");
-            currentState = LTE_UP_INTERNET_DOWN;
-            lastInternetTest = 0;
+    // A PUBACK (or QoS 0 write) is what proves the path, not an accepted publish
+    unsigned long deliveredAt = mqttManager.getLastDeliveryAt();
+    if (deliveredAt != 0 && (long)(deliveredAt - lastPublishSuccess) > 0) {
+        lastPublishSuccess = deliveredAt;
+    }
+
+    // Liveness comes from the session: PUBACKs, PINGRESPs, the echo and
+    // inbound messages all move getLastInboundAt(). A quiet broker or a
+    // stalled QoS 1 window gets an explicit ping + echo; no answer to that
+    // means the broker path is gone, so reconnect MQTT straight away.
+    unsigned long lastProof = max(mqttManager.getLastInboundAt(), connectedSince);
+    if (livenessCheckAt != 0) {
+        if ((long)(lastProof - livenessCheckAt) >= 0) {
+            livenessCheckAt = 0;
+        } else if (now - livenessCheckAt >= MQTT_LIVENESS_TIMEOUT_MS) {
+            Serial.println("[ConnMgr] ❌ Broker not answering (no PINGRESP / PUBACK / echo). State → MQTT_DOWN");
+            livenessFailures++;
+            livenessCheckAt = 0;
+            mqttManager.drop();
+            currentState = LTE_UP_INTERNET_UP_MQTT_DOWN;
+            lastMQTTRetry = 0;
+            mqttFailCount = 0;
             return;
         }
-        lastInternetTest = now;
+    } else if (now - lastProof >= MQTT_LIVENESS_IDLE_MS ||
+               (now - lastProof >= MQTT_ACK_STALL_MS && mqttManager.getAckWaitMs() >= MQTT_ACK_STALL_MS)) {
+        livenessCheckAt = now;
+        mqttManager.startLivenessCheck();
     }
 
     // Connection watchdog - ensure successful publish within timeout
@@ -226,14 +262,12 @@ void ConnectionManager::handleConnected() {
         delay(200);
         ESP.restart();
     }
+}
 
-    // Periodic health summary
-    if (intervalElapsed(now, lastHealthCheck, HEALTH_CHECK_INTERVAL)) {
-        lastHealthCheck = now;
-        Serial.println("\n[ConnMgr] === PERIODIC HEALTH CHECK ===");
-        lteManager.printStatus();
-        mqttManager.printStatus();
-    }
+void ConnectionManager::printHealth() {
+    Serial.println("\n[ConnMgr] === PERIODIC HEALTH CHECK ===");
+    lteManager.printStatus();
+    mqttManager.printStatus();
 }
 
 // ============================================================================
@@ -259,7 +293,10 @@ void ConnectionManager::loop() {
             break;
     }
 
-    mqttManager.loop();
+    // TinyGSM owns the modem serial only while the session is up
+    if (currentState == FULLY_CONNECTED) {
+        mqttManager.loop();
+    }
 }
 
 // ============================================================================
@@ -267,7 +304,7 @@ void ConnectionManager::loop() {
 // ============================================================================
 
 bool ConnectionManager::isLTEReady() {
-    return lteManager.isConnected();
+    return currentState != LTE_DOWN;
 }
 
 bool ConnectionManager::isInternetReady() {
@@ -283,9 +320,8 @@ bool ConnectionManager::isFullyConnected() {
 }
 
 void ConnectionManager::notifyPublishResult(bool success) {
-    if (success) {
-        lastPublishSuccess = millis();
-    } else {
+    // Success is taken from PUBACKs in handleConnected()
+    if (!success) {
         mqttPublishFailures++;
     }
 }
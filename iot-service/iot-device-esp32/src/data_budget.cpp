@@ -0,0 +1,307 @@
+#include "data_budget.h"
+#include "queue_record.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// ============================================================================
+// DATA BUDGET IMPLEMENTATION
+// ============================================================================
+
+#define BUDGET_FILE_MAGIC   0x54474442UL    // "BDGT"
+#define BUDGET_FILE_VERSION 1
+#define BUDGET_EVAL_MS      10000           // Projection refresh
+#define BUDGET_HYSTERESIS   5               // Points below a threshold to leave its level
+
+namespace {
+    struct BudgetFile {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t size;
+        DataBudget::Month current;
+        DataBudget::Month previous;
+        uint32_t crc;               // Over everything before it
+    };
+
+    const uint8_t THRESHOLD_PCT[] = {
+        0,                          // BUDGET_NORMAL
+        DATA_BUDGET_STRETCH_PCT,
+        DATA_BUDGET_COMPACT_PCT,
+        DATA_BUDGET_MINIMAL_PCT
+    };
+
+    // Days from 1970-01-01 to y-m-d (proleptic Gregorian)
+    int32_t daysFromCivil(int32_t y, int32_t m, int32_t d) {
+        y -= m <= 2;
+        int32_t era = (y >= 0 ? y : y - 399) / 400;
+        int32_t yoe = y - era * 400;
+        int32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    uint32_t crcOf(const BudgetFile& file) {
+        return queueCrc32(0, (const uint8_t*)&file, offsetof(BudgetFile, crc));
+    }
+}
+
+DataBudget::DataBudget() {
+    path[0] = '\0';
+    deviceId[0] = '\0';
+    budget = 0;
+    tzOffset = 0;
+    memset(&current, 0, sizeof(current));
+    memset(&previous, 0, sizeof(previous));
+    projected = 0;
+    level = BUDGET_NORMAL;
+    dirty = false;
+    lastSaveMs = 0;
+    lastEvalMs = 0;
+}
+
+bool DataBudget::begin(const char* filePath, uint32_t budgetBytes, const char* id, int32_t tz) {
+    budget = budgetBytes;
+    tzOffset = tz;
+    snprintf(deviceId, sizeof(deviceId), "%s", id ? id : "");
+
+    if (filePath == nullptr || strlen(filePath) >= sizeof(path)) {
+        path[0] = '\0';
+        return false;
+    }
+    strcpy(path, filePath);
+    return load();
+}
+
+// ============================================================================
+// COUNTING
+// ============================================================================
+
+void DataBudget::count(DataTransport transport, DataDirection dir, uint32_t bytes) {
+    current.bytes[transport][dir] += bytes;
+    dirty = true;
+}
+
+void DataBudget::countTopic(const char* topic, DataDirection dir, uint32_t bytes) {
+    char key[DATA_BUDGET_TOPIC_LEN];
+    topicKey(topic, key);
+
+    TopicUsage* slot = topicSlot(key);
+    if (slot == nullptr) {
+        current.otherBytes[dir] += bytes;
+    } else {
+        slot->bytes[dir] += bytes;
+        slot->messages[dir]++;
+    }
+    dirty = true;
+}
+
+uint32_t DataBudget::total(const Month& month) {
+    uint32_t sum = 0;
+    for (uint8_t t = 0; t < DATA_TRANSPORT_COUNT; t++) {
+        sum += month.bytes[t][DATA_UP] + month.bytes[t][DATA_DOWN];
+    }
+    return sum;
+}
+
+// "sensor/<id>/telemetry" -> "sensor/telemetry", "get_config/<id>" -> "get_config"
+void DataBudget::topicKey(const char* topic, char* key) const {
+    size_t idLen = strlen(deviceId);
+    size_t out = 0;
+    const char* segment = topic;
+
+    while (true) {
+        const char* end = strchr(segment, '/');
+        size_t len = end ? (size_t)(end - segment) : strlen(segment);
+
+        if (idLen == 0 || len != idLen || memcmp(segment, deviceId, len) != 0) {
+            if (out > 0 && out < DATA_BUDGET_TOPIC_LEN - 1) {
+                key[out++] = '/';
+            }
+            for (size_t i = 0; i < len && out < DATA_BUDGET_TOPIC_LEN - 1; i++) {
+                key[out++] = segment[i];
+            }
+        }
+
+        if (end == nullptr) {
+            break;
+        }
+        segment = end + 1;
+    }
+    key[out] = '\0';
+}
+
+DataBudget::TopicUsage* DataBudget::topicSlot(const char* key) {
+    for (uint8_t i = 0; i < DATA_BUDGET_TOPICS; i++) {
+        TopicUsage& slot = current.topics[i];
+        if (slot.key[0] == '\0') {
+            strcpy(slot.key, key);
+            return &slot;
+        }
+        if (strcmp(slot.key, key) == 0) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+// ============================================================================
+// MONTH + GOVERNOR
+// ============================================================================
+
+void DataBudget::update(uint32_t unixTime, unsigned long nowMs) {
+    if (unixTime != 0 && (lastEvalMs == 0 || nowMs - lastEvalMs >= BUDGET_EVAL_MS)) {
+        lastEvalMs = nowMs ? nowMs : 1;
+
+        time_t local = (time_t)unixTime + tzOffset;
+        struct tm t;
+        gmtime_r(&local, &t);
+        int32_t year = t.tm_year + 1900;
+        int32_t month = t.tm_mon + 1;
+
+        uint32_t period = (uint32_t)(year * 100 + month);
+        uint32_t monthStart = (uint32_t)(daysFromCivil(year, month, 1) * 86400 - tzOffset);
+        uint32_t monthEnd = (uint32_t)((month == 12 ? daysFromCivil(year + 1, 1, 1)
+                                                    : daysFromCivil(year, month + 1, 1)) * 86400 - tzOffset);
+
+        if (current.period == 0) {
+            // First month on this device: count from now, bytes before the
+            // clock was set included
+            current.period = period;
+            current.since = unixTime;
+            dirty = true;
+        } else if (current.period != period) {
+            rollover(period, monthStart);
+        }
+
+        evaluate(unixTime, monthStart, monthEnd);
+    }
+
+    if (dirty && path[0] != '\0' && nowMs - lastSaveMs >= DATA_BUDGET_SAVE_MS) {
+        lastSaveMs = nowMs;
+        save();
+    }
+}
+
+void DataBudget::rollover(uint32_t period, uint32_t monthStart) {
+    previous = current;
+    memset(&current, 0, sizeof(current));
+    current.period = period;
+    current.since = monthStart;
+    dirty = true;
+
+    if (path[0] != '\0') {
+        save();
+    }
+}
+
+void DataBudget::evaluate(uint32_t unixTime, uint32_t monthStart, uint32_t monthEnd) {
+    uint32_t used = total(current);
+    uint32_t start = current.since > monthStart ? current.since : monthStart;
+    uint32_t elapsed = unixTime > start ? unixTime - start : 0;
+    if (elapsed < DATA_BUDGET_MIN_ELAPSED) {
+        elapsed = DATA_BUDGET_MIN_ELAPSED;
+    }
+    uint32_t remaining = monthEnd > unixTime ? monthEnd - unixTime : 0;
+
+    uint64_t projection = used + (uint64_t)used * remaining / elapsed;
+    projected = projection > UINT32_MAX ? UINT32_MAX : (uint32_t)projection;
+
+    if (budget == 0) {
+        level = BUDGET_NORMAL;
+        return;
+    }
+
+    uint32_t pct = used >= budget ? 1000 : (uint32_t)(projection * 100 / budget);
+
+    DataBudgetLevel next = BUDGET_NORMAL;
+    for (uint8_t l = BUDGET_MINIMAL; l > BUDGET_NORMAL; l--) {
+        if (pct >= THRESHOLD_PCT[l]) {
+            next = (DataBudgetLevel)l;
+            break;
+        }
+    }
+
+    // Stay until clearly below, the projection moves with every message
+    if (next < level && pct + BUDGET_HYSTERESIS >= THRESHOLD_PCT[level]) {
+        next = level;
+    }
+    level = next;
+}
+
+uint8_t DataBudget::getIntervalFactor() const {
+    return 1 << level;
+}
+
+const char* DataBudget::levelName(DataBudgetLevel level) {
+    switch (level) {
+        case BUDGET_NORMAL:  return "normal";
+        case BUDGET_STRETCH: return "stretch";
+        case BUDGET_COMPACT: return "compact";
+        case BUDGET_MINIMAL: return "minimal";
+    }
+    return "?";
+}
+
+// ============================================================================
+// PERSISTENCE
+// ============================================================================
+
+bool DataBudget::load() {
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        return false;       // First boot, nothing counted yet
+    }
+
+    BudgetFile file;
+    bool ok = fread(&file, 1, sizeof(file), f) == sizeof(file) &&
+              file.magic == BUDGET_FILE_MAGIC &&
+              file.version == BUDGET_FILE_VERSION &&
+              file.size == sizeof(file) &&
+              file.crc == crcOf(file);
+    fclose(f);
+
+    if (!ok) {
+        return false;
+    }
+
+    current = file.current;
+    previous = file.previous;
+    dirty = false;
+    return true;
+}
+
+bool DataBudget::save() {
+    if (path[0] == '\0') {
+        return false;
+    }
+
+    BudgetFile file;
+    memset(&file, 0, sizeof(file));
+    file.magic = BUDGET_FILE_MAGIC;
+    file.version = BUDGET_FILE_VERSION;
+    file.size = sizeof(file);
+    file.current = current;
+    file.previous = previous;
+    file.crc = crcOf(file);
+
+    // Written next to the old file and renamed over it, a reset mid-write
+    // keeps the last good counters
+    char tmpPath[DATA_BUDGET_PATH_MAX + 4];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+    FILE* f = fopen(tmpPath, "wb");
+    if (f == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(&file, 1, sizeof(file), f) == sizeof(file);
+    ok = fclose(f) == 0 && ok;
+
+    if (ok && rename(tmpPath, path) != 0) {
+        remove(path);
+        ok = rename(tmpPath, path) == 0;
+    }
+    if (ok) {
+        dirty = false;
+    }
+    return ok;
+}
@@ -0,0 +1,28 @@
+#include "device_profiles.h"
+#include "device_profiles_gen.h"
+#include <string.h>
+
+// ============================================================================
+// DEVICE PROFILES IMPLEMENTATION
+// ============================================================================
+
+static const uint8_t PROFILE_COUNT = sizeof(DEVICE_PROFILE_TABLE) / sizeof(DEVICE_PROFILE_TABLE[0]);
+
+const RS485Profile* findDeviceProfile(const char* deviceType, uint16_t version) {
+    for (uint8_t i = 0; i < PROFILE_COUNT; i++) {
+        const RS485Profile& profile = DEVICE_PROFILE_TABLE[i];
+        if (strcmp(profile.deviceType, deviceType) == 0 &&
+            (version == 0 || profile.version == version)) {
+            return &profile;
+        }
+    }
+    return nullptr;
+}
+
+uint8_t getDeviceProfileCount() {
+    return PROFILE_COUNT;
+}
+
+const RS485Profile& getDeviceProfile(uint8_t index) {
+    return DEVICE_PROFILE_TABLE[index];
+}
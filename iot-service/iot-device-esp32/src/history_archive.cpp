@@ -0,0 +1,580 @@
+#include "history_archive.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// ============================================================================
+// HISTORY ARCHIVE IMPLEMENTATION
+// ============================================================================
+
+#define CHANNELS_FILE_NAME  "channels"
+#define DATA_SUFFIX         ".dat"
+#define INDEX_SUFFIX        ".idx"
+#define PRUNE_BATCH         8
+
+static_assert(sizeof(HistoryRecord) == 20, "HistoryRecord must stay 20 bytes on disk");
+
+namespace {
+    const char* const TIER_NAMES[HISTORY_TIER_COUNT] = { "raw", "minute", "hour" };
+
+    const uint32_t RESOLUTION[HISTORY_TIER_COUNT] = {
+        1,                  // raw: as sampled
+        60,                 // minute aggregates
+        3600                // hour aggregates
+    };
+
+    const uint32_t BUCKET_WIDTH[HISTORY_TIER_COUNT] = {
+        3600,               // raw: 1 file per hour
+        86400,              // minute: 1 file per day
+        30UL * 86400        // hour: 1 file per 30 days
+    };
+
+    const uint32_t RETENTION[HISTORY_TIER_COUNT] = {
+        86400,              // raw: 24 hours
+        30UL * 86400,       // minute: 30 days
+        365UL * 86400       // hour: 1 year
+    };
+
+    // Start of the file bucket holding `timestamp`
+    inline uint32_t bucketOf(HistoryTier tier, uint32_t timestamp) {
+        return timestamp - timestamp % BUCKET_WIDTH[tier];
+    }
+
+    // Start of the aggregation period holding `timestamp`
+    inline uint32_t periodOf(HistoryTier tier, uint32_t timestamp) {
+        return timestamp - timestamp % RESOLUTION[tier];
+    }
+
+    uint32_t fileSizeOf(const char* path) {
+        struct stat st;
+        if (stat(path, &st) != 0) {
+            return 0;
+        }
+        return (uint32_t)st.st_size;
+    }
+
+    // "0000002A.dat" -> 0x2A
+    bool parseDataName(const char* name, uint32_t& bucket) {
+        if (strlen(name) != 8 + strlen(DATA_SUFFIX) ||
+            strcmp(name + 8, DATA_SUFFIX) != 0) {
+            return false;
+        }
+        char* end = nullptr;
+        bucket = strtoul(name, &end, 16);
+        return end == name + 8;
+    }
+}
+
+HistoryArchive::HistoryArchive() {
+    open = false;
+    dir[0] = '\0';
+    channelCount = 0;
+    cycleTime = 0;
+    lastCycleTime = 0;
+    pendingRawCount = 0;
+    queryActive = false;
+    memset(channels, 0, sizeof(channels));
+    memset(minuteAcc, 0, sizeof(minuteAcc));
+    memset(hourAcc, 0, sizeof(hourAcc));
+    memset(writeBucket, 0, sizeof(writeBucket));
+    memset(writeRecords, 0, sizeof(writeRecords));
+    memset(&queryState, 0, sizeof(queryState));
+    memset(&stats, 0, sizeof(stats));
+}
+
+// ========================================
+// Lifecycle
+// ========================================
+
+bool HistoryArchive::begin(const char* directory) {
+    end();
+
+    strncpy(dir, directory, sizeof(dir) - 1);
+    dir[sizeof(dir) - 1] = '\0';
+
+    mkdir(dir, 0777);  // EEXIST is fine
+    struct stat st;
+    if (stat(dir, &st) != 0) {
+        return false;
+    }
+
+    for (uint8_t tier = 0; tier < HISTORY_TIER_COUNT; tier++) {
+        char path[HISTORY_PATH_MAX];
+        tierPath((HistoryTier)tier, path);
+        mkdir(path, 0777);
+    }
+
+    loadChannels();
+
+    open = true;
+    return true;
+}
+
+void HistoryArchive::end() {
+    open = false;
+    queryActive = false;
+    cycleTime = 0;
+}
+
+// ========================================
+// Recording
+// ========================================
+
+bool HistoryArchive::beginCycle(uint32_t timestamp) {
+    cycleTime = 0;
+    pendingRawCount = 0;
+
+    // Files are append-only and must stay in time order
+    if (!open || timestamp < lastCycleTime) {
+        return false;
+    }
+
+    // Aggregates of buckets that ended before this cycle are final
+    closeAccumulators(minuteAcc, HISTORY_MINUTE, timestamp);
+    closeAccumulators(hourAcc, HISTORY_HOUR, timestamp);
+
+    cycleTime = timestamp;
+    return true;
+}
+
+bool HistoryArchive::record(const char* channel, float value) {
+    if (cycleTime == 0 || isnan(value) || isinf(value)) {
+        return false;
+    }
+
+    int id = findChannel(channel);
+    if (id < 0) {
+        id = addChannel(channel);
+        if (id < 0) {
+            return false;
+        }
+    }
+
+    if (pendingRawCount >= HISTORY_MAX_CHANNELS) {
+        return false;
+    }
+
+    HistoryRecord& raw = pendingRaw[pendingRawCount++];
+    raw.timestamp = cycleTime;
+    raw.channel = id;
+    raw.count = 1;
+    raw.mean = value;
+    raw.min = value;
+    raw.max = value;
+
+    Accumulator* tiers[2] = { &minuteAcc[id], &hourAcc[id] };
+    const HistoryTier tierIds[2] = { HISTORY_MINUTE, HISTORY_HOUR };
+    for (uint8_t i = 0; i < 2; i++) {
+        Accumulator& acc = *tiers[i];
+        if (acc.count == 0) {
+            acc.period = periodOf(tierIds[i], cycleTime);
+            acc.sum = 0;
+            acc.min = value;
+            acc.max = value;
+        }
+        acc.sum += value;
+        acc.min = value < acc.min ? value : acc.min;
+        acc.max = value > acc.max ? value : acc.max;
+        if (acc.count < UINT16_MAX) {
+            acc.count++;
+        }
+    }
+
+    return true;
+}
+
+bool HistoryArchive::commit() {
+    if (cycleTime == 0) {
+        return false;
+    }
+
+    bool ok = pendingRawCount == 0 || appendRecords(HISTORY_RAW, pendingRaw, pendingRawCount);
+
+    lastCycleTime = cycleTime;
+    cycleTime = 0;
+    pendingRawCount = 0;
+    return ok;
+}
+
+void HistoryArchive::closeAccumulators(Accumulator* acc, HistoryTier tier, uint32_t now) {
+    HistoryRecord closed[HISTORY_MAX_CHANNELS];
+    size_t count = 0;
+    uint32_t current = periodOf(tier, now);
+
+    for (uint16_t ch = 0; ch < HISTORY_MAX_CHANNELS; ch++) {
+        if (acc[ch].count == 0 || acc[ch].period >= current) {
+            continue;
+        }
+        HistoryRecord& rec = closed[count++];
+        rec.timestamp = acc[ch].period;
+        rec.channel = ch;
+        rec.count = acc[ch].count;
+        rec.mean = acc[ch].sum / acc[ch].count;
+        rec.min = acc[ch].min;
+        rec.max = acc[ch].max;
+        acc[ch].count = 0;
+    }
+
+    if (count > 0) {
+        appendRecords(tier, closed, count);
+    }
+}
+
+bool HistoryArchive::appendRecords(HistoryTier tier, const HistoryRecord* records, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        uint32_t bucket = bucketOf(tier, records[i].timestamp);
+        if (bucket != writeBucket[tier] && !openBucket(tier, bucket)) {
+            stats.writeErrors++;
+            return false;
+        }
+
+        char dataPath[HISTORY_PATH_MAX];
+        char indexPath[HISTORY_PATH_MAX];
+        bucketPath(tier, bucket, DATA_SUFFIX, dataPath);
+        bucketPath(tier, bucket, INDEX_SUFFIX, indexPath);
+
+        FILE* data = fopen(dataPath, "ab");
+        FILE* index = fopen(indexPath, "ab");
+        if (!data || !index) {
+            if (data) fclose(data);
+            if (index) fclose(index);
+            stats.writeErrors++;
+            return false;
+        }
+
+        bool ok = true;
+        for (; i < count && bucketOf(tier, records[i].timestamp) == bucket; i++) {
+            // A new data block starts: index its first timestamp
+            if (writeRecords[tier] % HISTORY_BLOCK_RECORDS == 0) {
+                ok = fwrite(&records[i].timestamp, sizeof(uint32_t), 1, index) == 1;
+            }
+            ok = ok && fwrite(&records[i], sizeof(HistoryRecord), 1, data) == 1;
+            if (!ok) {
+                break;
+            }
+            writeRecords[tier]++;
+            stats.recordsWritten[tier]++;
+        }
+
+        fclose(index);
+        fclose(data);
+
+        if (!ok) {
+            // Re-derive record count and index from disk on next append
+            writeBucket[tier] = 0;
+            stats.writeErrors++;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool HistoryArchive::openBucket(HistoryTier tier, uint32_t bucket) {
+    char dataPath[HISTORY_PATH_MAX];
+    char indexPath[HISTORY_PATH_MAX];
+    bucketPath(tier, bucket, DATA_SUFFIX, dataPath);
+    bucketPath(tier, bucket, INDEX_SUFFIX, indexPath);
+
+    // Cut a torn record left by a power loss
+    uint32_t dataSize = fileSizeOf(dataPath);
+    uint32_t records = dataSize / sizeof(HistoryRecord);
+    if (dataSize % sizeof(HistoryRecord) != 0) {
+        truncate(dataPath, records * sizeof(HistoryRecord));
+    }
+
+    // Bring the index in line with the data file
+    uint32_t expected = (records + HISTORY_BLOCK_RECORDS - 1) / HISTORY_BLOCK_RECORDS;
+    uint32_t entries = fileSizeOf(indexPath) / sizeof(uint32_t);
+    if (entries > expected || fileSizeOf(indexPath) % sizeof(uint32_t) != 0) {
+        truncate(indexPath, (entries > expected ? expected : entries) * sizeof(uint32_t));
+        entries = entries > expected ? expected : entries;
+    }
+    if (entries < expected) {
+        FILE* data = fopen(dataPath, "rb");
+        FILE* index = fopen(indexPath, "ab");
+        bool ok = data && index;
+        for (; ok && entries < expected; entries++) {
+            HistoryRecord rec;
+            ok = fseek(data, entries * HISTORY_BLOCK_RECORDS * sizeof(HistoryRecord), SEEK_SET) == 0 &&
+                 fread(&rec, sizeof(rec), 1, data) == 1 &&
+                 fwrite(&rec.timestamp, sizeof(uint32_t), 1, index) == 1;
+        }
+        if (data) fclose(data);
+        if (index) fclose(index);
+        if (!ok) {
+            return false;
+        }
+    }
+
+    writeBucket[tier] = bucket;
+    writeRecords[tier] = records;
+
+    // Only reached on a bucket roll or the first write since boot
+    prune(tier, bucket);
+    return true;
+}
+
+void HistoryArchive::prune(HistoryTier tier, uint32_t now) {
+    if (now < RETENTION[tier]) {
+        return;
+    }
+    uint32_t cutoff = now - RETENTION[tier];
+
+    char path[HISTORY_PATH_MAX];
+    tierPath(tier, path);
+
+    // Collect a few expired buckets, then unlink outside of readdir
+    while (true) {
+        uint32_t expired[PRUNE_BATCH];
+        uint8_t found = 0;
+
+        DIR* d = opendir(path);
+        if (!d) {
+            return;
+        }
+        struct dirent* entry;
+        while (found < PRUNE_BATCH && (entry = readdir(d)) != nullptr) {
+            uint32_t bucket;
+            if (parseDataName(entry->d_name, bucket) && bucket + BUCKET_WIDTH[tier] <= cutoff) {
+                expired[found++] = bucket;
+            }
+        }
+        closedir(d);
+
+        for (uint8_t i = 0; i < found; i++) {
+            char file[HISTORY_PATH_MAX];
+            bucketPath(tier, expired[i], DATA_SUFFIX, file);
+            unlink(file);
+            bucketPath(tier, expired[i], INDEX_SUFFIX, file);
+            unlink(file);
+            stats.filesPruned++;
+        }
+
+        if (found < PRUNE_BATCH) {
+            return;
+        }
+    }
+}
+
+// ========================================
+// Queries
+// ========================================
+
+bool HistoryArchive::startQuery(const Query& query) {
+    if (!open || query.from > query.to || query.tier >= HISTORY_TIER_COUNT) {
+        return false;
+    }
+
+    queryState.query = query;
+    queryState.bucket = bucketOf(query.tier, query.from);
+    queryState.position = UINT32_MAX;
+    queryActive = true;
+    return true;
+}
+
+size_t HistoryArchive::nextBatch(HistoryRecord* out, size_t capacity) {
+    size_t n = 0;
+    QueryState& st = queryState;
+    const HistoryTier tier = st.query.tier;
+
+    while (queryActive && n < capacity) {
+        if (st.bucket > st.query.to) {
+            queryActive = false;
+            break;
+        }
+
+        char dataPath[HISTORY_PATH_MAX];
+        bucketPath(tier, st.bucket, DATA_SUFFIX, dataPath);
+        FILE* data = fopen(dataPath, "rb");
+
+        if (data && st.position == UINT32_MAX) {
+            st.position = locate(tier, st.bucket, st.query.from);
+        }
+
+        bool bucketDone = data == nullptr;
+        if (data && fseek(data, st.position * sizeof(HistoryRecord), SEEK_SET) != 0) {
+            bucketDone = true;
+        }
+
+        HistoryRecord block[HISTORY_BLOCK_RECORDS];
+        while (!bucketDone && queryActive && n < capacity) {
+            size_t got = fread(block, sizeof(HistoryRecord), HISTORY_BLOCK_RECORDS, data);
+            if (got == 0) {
+                bucketDone = true;
+                break;
+            }
+            stats.blocksRead++;
+
+            for (size_t i = 0; i < got && n < capacity; i++) {
+                st.position++;
+                const HistoryRecord& rec = block[i];
+                if (rec.timestamp < st.query.from) {
+                    continue;
+                }
+                if (rec.timestamp > st.query.to) {
+                    // Sorted: nothing later can match
+                    queryActive = false;
+                    break;
+                }
+                if (st.query.channelMask != 0 && rec.channel < 32 &&
+                    !(st.query.channelMask & (1UL << rec.channel))) {
+                    continue;
+                }
+                out[n++] = rec;
+            }
+        }
+
+        if (data) {
+            fclose(data);
+        }
+
+        if (bucketDone) {
+            st.bucket += BUCKET_WIDTH[tier];
+            st.position = UINT32_MAX;
+        }
+    }
+
+    return n;
+}
+
+uint32_t HistoryArchive::locate(HistoryTier tier, uint32_t bucket, uint32_t from) {
+    char indexPath[HISTORY_PATH_MAX];
+    bucketPath(tier, bucket, INDEX_SUFFIX, indexPath);
+
+    FILE* index = fopen(indexPath, "rb");
+    if (!index) {
+        return 0;
+    }
+
+    // First block starting at or after `from`; the one before it may still
+    // hold matching records at its end
+    uint32_t lo = 0;
+    uint32_t hi = fileSizeOf(indexPath) / sizeof(uint32_t);
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t first = 0;
+        if (fseek(index, mid * sizeof(uint32_t), SEEK_SET) != 0 ||
+            fread(&first, sizeof(first), 1, index) != 1) {
+            break;
+        }
+        stats.indexReads++;
+        if (first < from) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    fclose(index);
+
+    uint32_t block = lo > 0 ? lo - 1 : 0;
+    return block * HISTORY_BLOCK_RECORDS;
+}
+
+HistoryTier HistoryArchive::tierFor(uint32_t from, uint32_t now) const {
+    for (uint8_t tier = 0; tier < HISTORY_TIER_COUNT; tier++) {
+        if (from + RETENTION[tier] >= now) {
+            return (HistoryTier)tier;
+        }
+    }
+    return HISTORY_HOUR;
+}
+
+// ========================================
+// Channels
+// ========================================
+
+int HistoryArchive::findChannel(const char* name) const {
+    for (uint16_t i = 0; i < channelCount; i++) {
+        if (strncmp(channels[i], name, HISTORY_CHANNEL_NAME_MAX - 1) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char* HistoryArchive::getChannelName(uint16_t id) const {
+    return id < channelCount ? channels[id] : "";
+}
+
+bool HistoryArchive::loadChannels() {
+    char path[HISTORY_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, CHANNELS_FILE_NAME);
+
+    channelCount = 0;
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+
+    char line[HISTORY_CHANNEL_NAME_MAX + 2];
+    while (channelCount < HISTORY_MAX_CHANNELS && fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        strncpy(channels[channelCount], line, HISTORY_CHANNEL_NAME_MAX - 1);
+        channels[channelCount][HISTORY_CHANNEL_NAME_MAX - 1] = '\0';
+        channelCount++;
+    }
+    fclose(f);
+    return true;
+}
+
+int HistoryArchive::addChannel(const char* name) {
+    if (channelCount >= HISTORY_MAX_CHANNELS || name[0] == '\0' || strpbrk(name, "\r\n")) {
+        return -1;
+    }
+
+    char path[HISTORY_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, CHANNELS_FILE_NAME);
+    FILE* f = fopen(path, "a");
+    if (!f) {
+        return -1;
+    }
+
+    char* slot = channels[channelCount];
+    strncpy(slot, name, HISTORY_CHANNEL_NAME_MAX - 1);
+    slot[HISTORY_CHANNEL_NAME_MAX - 1] = '\0';
+    bool ok = fprintf(f, "%s\n", slot) > 0;
+    fclose(f);
+
+    return ok ? channelCount++ : -1;
+}
+
+// ========================================
+// Helpers
+// ========================================
+
+void HistoryArchive::tierPath(HistoryTier tier, char* out) const {
+    snprintf(out, HISTORY_PATH_MAX, "%s/%s", dir, TIER_NAMES[tier]);
+}
+
+void HistoryArchive::bucketPath(HistoryTier tier, uint32_t bucket, const char* suffix, char* out) const {
+    snprintf(out, HISTORY_PATH_MAX, "%s/%s/%08lX%s", dir, TIER_NAMES[tier],
+             (unsigned long)bucket, suffix);
+}
+
+const char* HistoryArchive::tierName(HistoryTier tier) {
+    return tier < HISTORY_TIER_COUNT ? TIER_NAMES[tier] : "";
+}
+
+bool HistoryArchive::parseTier(const char* name, HistoryTier& tier) {
+    for (uint8_t i = 0; i < HISTORY_TIER_COUNT; i++) {
+        if (strcmp(name, TIER_NAMES[i]) == 0) {
+            tier = (HistoryTier)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t HistoryArchive::bucketWidth(HistoryTier tier) {
+    return BUCKET_WIDTH[tier];
+}
+
+uint32_t HistoryArchive::retention(HistoryTier tier) {
+    return RETENTION[tier];
+}
@@ -0,0 +1,138 @@
+#include "job_scheduler.h"
+#include <Arduino.h>
+#include <string.h>
+
+// ============================================================================
+// JOB SCHEDULER IMPLEMENTATION
+// ============================================================================
+
+JobScheduler::JobScheduler(const char* name) {
+    this->name = name;
+    memset(jobs, 0, sizeof(jobs));
+    jobCount = 0;
+    lastLateMs = 0;
+}
+
+int8_t JobScheduler::add(const char* name, JobFn fn, unsigned long periodMs) {
+    if (jobCount >= SCHEDULER_MAX_JOBS || fn == nullptr) {
+        return -1;
+    }
+
+    Job& job = jobs[jobCount];
+    memset(&job, 0, sizeof(job));
+    snprintf(job.name, sizeof(job.name), "%s", name);
+    job.fn = fn;
+    job.periodMs = periodMs;
+    return jobCount++;
+}
+
+int8_t JobScheduler::every(const char* name, unsigned long periodMs, JobFn fn,
+                           unsigned long nowMs, unsigned long firstDelayMs) {
+    if (periodMs == 0) {
+        return -1;
+    }
+    int8_t id = add(name, fn, periodMs);
+    if (id >= 0) {
+        runIn(id, firstDelayMs, nowMs);
+    }
+    return id;
+}
+
+int8_t JobScheduler::once(const char* name, JobFn fn) {
+    return add(name, fn, 0);
+}
+
+void JobScheduler::runIn(int8_t id, unsigned long delayMs, unsigned long nowMs) {
+    if (id >= 0 && id < jobCount) {
+        jobs[id].dueAt = nowMs + delayMs;
+        jobs[id].armed = true;
+    }
+}
+
+void JobScheduler::cancel(int8_t id) {
+    if (id >= 0 && id < jobCount) {
+        jobs[id].armed = false;
+    }
+}
+
+bool JobScheduler::isArmed(int8_t id) const {
+    return id >= 0 && id < jobCount && jobs[id].armed;
+}
+
+unsigned long JobScheduler::run(unsigned long nowMs) {
+    lastLateMs = 0;
+
+    for (uint8_t i = 0; i < jobCount; i++) {
+        Job& job = jobs[i];
+        if (!job.armed || (long)(nowMs - job.dueAt) < 0) {
+            continue;
+        }
+
+        uint32_t lateMs = nowMs - job.dueAt;
+        if (lateMs > lastLateMs) {
+            lastLateMs = lateMs;
+        }
+        if (lateMs > job.maxLateMs) {
+            job.maxLateMs = lateMs;
+        }
+
+        // Next deadline first, so the callback may override it
+        if (job.periodMs != 0) {
+            job.dueAt += job.periodMs;
+            if ((long)(nowMs - job.dueAt) >= 0) {
+                job.dueAt = nowMs + job.periodMs;   // Missed deadlines are skipped
+            }
+        } else {
+            job.armed = false;
+        }
+
+        unsigned long startedAt = millis();
+        job.fn(startedAt);
+        uint32_t runMs = millis() - startedAt;
+        job.runs++;
+        if (runMs > job.maxRunMs) {
+            job.maxRunMs = runMs;
+        }
+    }
+
+    // Jobs may have taken a while: measure against the time now
+    unsigned long now = millis();
+    unsigned long waitMs = SCHEDULER_IDLE_MS;
+    for (uint8_t i = 0; i < jobCount; i++) {
+        if (!jobs[i].armed) {
+            continue;
+        }
+        long left = (long)(jobs[i].dueAt - now);
+        if (left <= 0) {
+            return 0;
+        }
+        if ((unsigned long)left < waitMs) {
+            waitMs = left;
+        }
+    }
+    return waitMs;
+}
+
+void JobScheduler::printJobs(unsigned long nowMs) const {
+    Serial.printf("[Jobs] %s: %u job(s)\n", name, jobCount);
+    for (uint8_t i = 0; i < jobCount; i++) {
+        const Job& job = jobs[i];
+        char every[32];         // "every " + 10 digits (20 on a 64-bit host) + " ms"
+        char next[32];
+        if (job.periodMs != 0) {
+            snprintf(every, sizeof(every), "every %lu ms", job.periodMs);
+        } else {
+            snprintf(every, sizeof(every), "one-shot");
+        }
+        if (job.armed) {
+            long left = (long)(job.dueAt - nowMs);
+            snprintf(next, sizeof(next), "%ld ms", left > 0 ? left : 0L);
+        } else {
+            snprintf(next, sizeof(next), "-");
+        }
+        Serial.printf("  %-11s %-18s next %-10s %lu runs, late <= %lu ms, longest %lu ms\n",
+                      job.name, every, next,
+                      (unsigned long)job.runs, (unsigned long)job.maxLateMs,
+                      (unsigned long)job.maxRunMs);
+    }
+}
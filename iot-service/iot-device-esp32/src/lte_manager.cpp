@@ -1,11 +1,16 @@
 #define TINY_GSM_MODEM_SIM7600
 #include "lte_manager.h"
+#include "async_gsm_client.h"
+#include "modem_at.h"
+#include "data_budget.h"
 #include "config.h"
 
 // External references
 extern HardwareSerial simSerial;
 extern TinyGsm modem;
-extern TinyGsmClient diagClient;
+extern ModemAt modemAt;
+extern AsyncGsmClient diagClient;
+extern DataBudget dataBudget;
 
 // ============================================================================
 // CONSTRUCTOR
@@ -13,295 +18,608 @@ extern TinyGsmClient diagClient;
 
 LTEManager::LTEManager() {
     gprsConnected = false;
-    lastCheck = 0;
+    memset(&bootTimes, 0, sizeof(bootTimes));
+    task = TASK_NONE;
+    step = STEP_PROBE_ON;
+    result = LINK_IDLE;
+    stepStart = 0;
+    lastAt = 0;
+    setupIndex = 0;
+    attempt = 0;
+    commandSent = false;
+    awaitingCpin = false;
+    powerDown = false;
+    command[0] = '\0';
+    pulsePin = -1;
+    pulsePhase = 0;
+    memset(pulseTimes, 0, sizeof(pulseTimes));
+    pulseNext = STEP_PROBE_ON;
 }
 
 // ============================================================================
-// INTERNAL HELPERS
+// TASK PLUMBING
 // ============================================================================
 
-void LTEManager::pulsePowerKey(uint32_t durationMs) {
-    pinMode(SIM7600_PWRKEY_PIN, OUTPUT);
-    digitalWrite(SIM7600_PWRKEY_PIN, LOW);
-    delay(100);
-    digitalWrite(SIM7600_PWRKEY_PIN, HIGH);
-    delay(durationMs);
-    digitalWrite(SIM7600_PWRKEY_PIN, LOW);
+bool LTEManager::startTask(Task next) {
+    // ModemAt is shared with the sockets: never start while one is opening
+    if (task != TASK_NONE || modemAt.isBusy()) {
+        return false;
+    }
+
+    task = next;
+    result = LINK_BUSY;
+    return true;
 }
 
-void LTEManager::powerOffModem() {
-    Serial.println("[LTE] Powering OFF modem...");
-    pulsePowerKey(1500); // Hold longer to trigger shutdown
-    delay(2000);         // Allow modem to settle
-    Serial.println("[LTE] Power OFF sequence complete");
+void LTEManager::enter(Step next) {
+    step = next;
+    stepStart = millis();
+    lastAt = 0;
+    commandSent = false;
+    awaitingCpin = false;
 }
 
-void LTEManager::hardwareReset() {
-    #if SIM7600_RESET_PIN >= 0
-    Serial.println("[LTE] Toggling hardware RESET pin...");
-    pinMode(SIM7600_RESET_PIN, OUTPUT);
-    digitalWrite(SIM7600_RESET_PIN, LOW);
-    delay(200);
-    digitalWrite(SIM7600_RESET_PIN, HIGH);
-    delay(200);
-    digitalWrite(SIM7600_RESET_PIN, LOW);
-    delay(2000);
-    #endif
+void LTEManager::finishTask(LinkStatus status) {
+    modemAt.cancel();
+    task = TASK_NONE;
+    result = status;
+}
+
+void LTEManager::startPulse(int8_t pin, uint32_t preMs, uint32_t holdMs, uint32_t settleMs, Step next) {
+    pulsePin = pin;
+    pulseTimes[0] = preMs;
+    pulseTimes[1] = holdMs;
+    pulseTimes[2] = settleMs;
+    pulsePhase = 0;
+    pulseNext = next;
+
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+    enter(STEP_PULSE);
+}
+
+bool LTEManager::sendOnce(const char* cmd, uint32_t timeoutMs, const char* capturePrefix, bool untilCapture) {
+    if (commandSent) {
+        return false;
+    }
+    commandSent = modemAt.start(cmd, timeoutMs, capturePrefix, untilCapture);
+    return true;
+}
+
+bool LTEManager::atDue(uint32_t intervalMs) const {
+    return !modemAt.isBusy() && (lastAt == 0 || millis() - lastAt >= intervalMs);
 }
 
 // ============================================================================
-// POWER ON MODEM
+// BEGIN (Start power-up + attach)
 // ============================================================================
 
-bool LTEManager::powerOnModem() {
-    Serial.println("[LTE] Step 1/6: Powering ON modem...");
+bool LTEManager::begin() {
+    Serial.println("\n========== LTE INITIALIZATION ==========");
 
-    pulsePowerKey(1000);
+    // Init serial BEFORE power on (CRITICAL!)
+    Serial.println("[LTE] Initializing serial...");
+    simSerial.begin(115200, SERIAL_8N1, SIM7600_RX_PIN, SIM7600_TX_PIN);
+    modemAt.addUrcHandler(onUrc, this);
 
-    Serial.println("[LTE] Waiting 12s for modem boot...");
-    delay(12000);
+    if (!startTask(TASK_POWER_ON)) {
+        return false;
+    }
+
+    memset(&bootTimes, 0, sizeof(bootTimes));
+    powerDown = false;
+    Serial.println("[LTE] Step 1/6: Powering ON modem...");
+    enter(STEP_PROBE_ON);
+    return true;
+}
+
+// ============================================================================
+// START CONNECT (Reconnect if disconnected)
+// ============================================================================
 
-    // Extra delay for stability
-    Serial.println("[LTE] Extra 3s delay for stability...");
-    delay(3000);
+bool LTEManager::startConnect() {
+    if (!startTask(TASK_ATTACH)) {
+        return false;
+    }
 
-    Serial.println("[LTE] ✅ Power ON complete");
+    Serial.println("[LTE] Reconnecting...");
+    gprsConnected = false;
+    attempt = 0;
+    Serial.println("[LTE] Step 4/6: Connecting to network...");
+    enter(STEP_WAIT_NETWORK);
     return true;
 }
 
 // ============================================================================
-// INIT MODEM
+// START HARD REBOOT
 // ============================================================================
 
-bool LTEManager::initModem() {
-    Serial.println("[LTE] Step 2/6: Testing modem response...");
+bool LTEManager::startReboot() {
+    if (!startTask(TASK_REBOOT)) {
+        return false;
+    }
 
-    for (int i = 0; i < 5; i++) {
-        Serial.print("[LTE] Attempt ");
-        Serial.print(i + 1);
-        Serial.print("/5... ");
+    Serial.println("\n========== LTE HARD REBOOT ==========");
 
-        if (modem.testAT(1000)) {
-            Serial.println("✅ OK");
-            Serial.println("[LTE] Step 3/6: Getting modem info...");
+    // No graceful NETCLOSE: the power cycle drops the session anyway
+    gprsConnected = false;
+    memset(&bootTimes, 0, sizeof(bootTimes));
+    powerDown = false;
 
-            String modemInfo = modem.getModemInfo();
-            Serial.print("[LTE] Modem: ");
-            Serial.println(modemInfo);
+    Serial.println("[LTE] Powering OFF modem...");
+    startPulse(SIM7600_PWRKEY_PIN, 100, 1500, 0, STEP_WAIT_POWER_OFF);  // Hold longer to trigger shutdown
+    return true;
+}
 
-            return true;
-        }
+// ============================================================================
+// START INTERNET PROBE (TCP to INTERNET_PROBE_HOST)
+// ============================================================================
 
-        Serial.println("❌ No response");
-        delay(1000);
+bool LTEManager::startInternetProbe() {
+    if (!startTask(TASK_PROBE)) {
+        return false;
     }
 
-    Serial.println("[LTE] ❌ Modem not responding!");
-    return false;
+    // Dedicated diagnostic client (mux 1)
+    Serial.printf("[Test] TCP test (%s:%d)...\n", INTERNET_PROBE_HOST, INTERNET_PROBE_PORT);
+    diagClient.startOpen(INTERNET_PROBE_HOST, INTERNET_PROBE_PORT, MODEM_SOCKET_OPEN_TIMEOUT_MS);
+    dataBudget.count(DATA_PROBE, DATA_UP, DATA_PROBE_BYTES / 2);
+    dataBudget.count(DATA_PROBE, DATA_DOWN, DATA_PROBE_BYTES / 2);
+    enter(STEP_PROBE_OPEN);
+    return true;
 }
 
 // ============================================================================
-// CONNECT GPRS
+// POLL
 // ============================================================================
 
-bool LTEManager::connectGPRS() {
-    Serial.println("[LTE] Step 4/6: Connecting to network...");
+LTEManager::LinkStatus LTEManager::poll() {
+    if (task != TASK_NONE) {
+        switch (step) {
+            case STEP_PULSE:            stepPulse(); break;
+            case STEP_WAIT_POWER_OFF:   stepWaitPowerOff(); break;
+            case STEP_PROBE_ON:         stepProbeOn(); break;
+            case STEP_POWER_ON:         stepPowerOn(); break;
+            case STEP_WAIT_READY:       stepWaitReady(); break;
+            case STEP_ECHO_OFF:         stepEchoOff(); break;
+            case STEP_WAIT_NETWORK:     stepWaitNetwork(); break;
+            case STEP_DATA_SETUP:       stepDataSetup(); break;
+            case STEP_NET_OPEN:         stepNetOpen(); break;
+            case STEP_CHECK_IP:         stepCheckIp(); break;
+            case STEP_ATTACH_RETRY:     stepAttachRetry(); break;
+            case STEP_PROBE_OPEN:       stepProbeOpen(); break;
+            case STEP_PROBE_CLOSE:      stepProbeClose(); break;
+            case STEP_PROBE_NET_CHECK:  stepProbeNetCheck(); break;
+        }
+    }
 
-    if (!modem.waitForNetwork(30000)) {
-        Serial.println("[LTE] ❌ Network registration failed!");
-        return false;
+    if (task != TASK_NONE) {
+        return LINK_BUSY;
     }
 
-    Serial.println("[LTE] ✅ Network registered");
+    LinkStatus status = result;
+    result = LINK_IDLE;
+    return status;
+}
+
+// ============================================================================
+// POWER STEPS
+// ============================================================================
+
+void LTEManager::stepPulse() {
+    if (millis() - stepStart < pulseTimes[pulsePhase]) {
+        return;
+    }
 
-    Serial.println("[LTE] Step 5/6: Connecting GPRS...");
+    pulsePhase++;
+    stepStart = millis();
 
-    // Try to connect GPRS with retry
-    for (int i = 0; i < 3; i++) {
-        Serial.print("[LTE] GPRS Attempt ");
-        Serial.print(i + 1);
-        Serial.print("/3... ");
+    if (pulsePhase == 1) {
+        digitalWrite(pulsePin, HIGH);
+        return;
+    }
+    if (pulsePhase == 2) {
+        digitalWrite(pulsePin, LOW);
+        return;
+    }
 
-        if (modem.gprsConnect(APN_NAME, APN_USER, APN_PASS)) {
-            Serial.println("✅ Connected");
+    if (pulseNext == STEP_WAIT_READY && !bootTimes.powerOn) {
+        bootTimes.powerOn = millis();
+    }
+    enter(pulseNext);
+}
 
-            Serial.println("[LTE] Step 6/6: Verifying IP address...");
-            String ip = modem.localIP().toString();
+void LTEManager::stepWaitPowerOff() {
+    // Done at "NORMAL POWER DOWN" or once AT goes unanswered, not a fixed settle time
+    ModemAt::Result r = modemAt.poll();
+    bool done = powerDown || r == ModemAt::AT_TIMEOUT ||
+                millis() - stepStart >= MODEM_POWER_OFF_TIMEOUT_MS;
 
-            if (ip != "0.0.0.0") {
-                Serial.print("[LTE] IP Address: ");
-                Serial.println(ip);
-                gprsConnected = true;
-                return true;
-            } else {
-                Serial.println("[LTE] ⚠️ Invalid IP, retrying...");
-            }
-        } else {
-            Serial.println("❌ Failed");
+    if (!done) {
+        if (atDue(MODEM_AT_POLL_MS)) {
+            lastAt = millis();
+            modemAt.start("", MODEM_AT_TIMEOUT_MS);
         }
+        return;
+    }
+
+    modemAt.cancel();
+    Serial.printf("[LTE] Power OFF sequence complete (%lu ms)\n", millis() - stepStart);
 
-        delay(2000);
+    #if SIM7600_RESET_PIN >= 0
+    Serial.println("[LTE] Toggling hardware RESET pin...");
+    startPulse(SIM7600_RESET_PIN, 200, 200, 2000, STEP_POWER_ON);
+    #else
+    enter(STEP_POWER_ON);
+    #endif
+}
+
+void LTEManager::stepProbeOn() {
+    // Let the freshly opened UART settle before the first probe
+    if (!commandSent && millis() - stepStart < 1000) {
+        return;
+    }
+    if (sendOnce("", MODEM_AT_TIMEOUT_MS)) {
+        return;
+    }
+
+    ModemAt::Result r = modemAt.poll();
+    if (r == ModemAt::AT_PENDING) {
+        return;
+    }
+
+    // ESP32 restarted but the modem kept running: a PWRKEY pulse would turn it off
+    if (r == ModemAt::AT_OK) {
+        bootTimes.powerOn = millis();
+        bootTimes.atReady = bootTimes.powerOn;
+        Serial.println("[LTE] Modem already on, skipping power key");
+        Serial.println("[LTE] Waiting for modem ready (RDY / +CPIN: READY / PB DONE)...");
+        enter(STEP_WAIT_READY);
+        return;
     }
 
-    Serial.println("[LTE] ❌ GPRS connection failed!");
-    return false;
+    enter(STEP_POWER_ON);
+}
+
+void LTEManager::stepPowerOn() {
+    Serial.println("[LTE] Waiting for modem ready (RDY / +CPIN: READY / PB DONE)...");
+    startPulse(SIM7600_PWRKEY_PIN, 100, 1000, 0, STEP_WAIT_READY);
 }
 
 // ============================================================================
-// BEGIN (Full initialization)
+// MODEM READINESS
 // ============================================================================
 
-bool LTEManager::begin() {
-    Serial.println("\n========== LTE INITIALIZATION ==========");
+void LTEManager::stepWaitReady() {
+    // URCs update bootTimes through onUrc(); "+CPIN: READY" answers too
+    ModemAt::Result r = modemAt.poll();
+    unsigned long now = millis();
 
-    // Init serial BEFORE power on (CRITICAL!)
-    Serial.println("[LTE] Initializing serial...");
-    simSerial.begin(115200, SERIAL_8N1, SIM7600_RX_PIN, SIM7600_TX_PIN);
-    delay(1000);
+    if (r == ModemAt::AT_OK && !bootTimes.atReady) {
+        bootTimes.atReady = now;
+    }
 
-    // Power on modem
-    if (!powerOnModem()) {
-        return false;
+    // URCs are missed when the modem was already on or still autobauding,
+    // so also ask directly
+    if (r == ModemAt::AT_OK && !awaitingCpin && !bootTimes.cpinReady) {
+        modemAt.start("+CPIN?", 1000, "+CPIN:");
+        awaitingCpin = true;
+        return;
+    }
+    if (r != ModemAt::AT_PENDING) {
+        awaitingCpin = false;
     }
 
-    // Test modem
-    if (!initModem()) {
-        return false;
+    // PB DONE is the last URC of the boot sequence: SIM and phonebook are up
+    bool ready = bootTimes.pbDone || (bootTimes.atReady && bootTimes.cpinReady);
+    unsigned long elapsed = now - bootTimes.powerOn;
+
+    if (ready) {
+        modemAt.cancel();
+        bootTimes.ready = now;
+        Serial.printf("[LTE] ✅ Modem ready in %lu ms\n", elapsed);
+        enter(STEP_ECHO_OFF);
+        return;
     }
 
-    // Connect GPRS
-    if (!connectGPRS()) {
-        return false;
+    if (elapsed >= MODEM_READY_TIMEOUT_MS) {
+        modemAt.cancel();
+
+        // Modem answers but the SIM never came up: carry on, registration will tell
+        if (bootTimes.atReady) {
+            bootTimes.ready = now;
+            Serial.printf("[LTE] ⚠️ SIM not ready after %lu ms, continuing\n", elapsed);
+            enter(STEP_ECHO_OFF);
+            return;
+        }
+
+        Serial.printf("[LTE] ❌ Modem not ready after %lu ms\n", elapsed);
+        if (task == TASK_REBOOT) {
+            Serial.println("[LTE] ❌ Failed to power modem back on");
+        }
+        finishTask(LINK_FAILED);
+        return;
     }
 
-    Serial.println("========================================");
-    Serial.println("[LTE] ✅ LTE Ready!");
-    Serial.println("========================================\n");
+    if (atDue(MODEM_AT_POLL_MS)) {
+        lastAt = now;
+        modemAt.start("", MODEM_AT_TIMEOUT_MS);
+    }
+}
 
-    return true;
+void LTEManager::stepEchoOff() {
+    // Echo off keeps replies to one line per answer
+    if (sendOnce("E0", 1000)) {
+        Serial.println("[LTE] Step 2/6: Testing modem response...");
+        return;
+    }
+
+    ModemAt::Result r = modemAt.poll();
+    if (r == ModemAt::AT_PENDING) {
+        return;
+    }
+
+    if (r != ModemAt::AT_OK) {
+        Serial.println("[LTE] ⚠️ No answer to ATE0, continuing");
+    }
+
+    attempt = 0;
+    Serial.println("[LTE] Step 4/6: Connecting to network...");
+    enter(STEP_WAIT_NETWORK);
 }
 
 // ============================================================================
-// CONNECT (Reconnect if disconnected)
+// ATTACH STEPS
 // ============================================================================
 
-bool LTEManager::connect() {
-    Serial.println("[LTE] Reconnecting...");
+void LTEManager::stepWaitNetwork() {
+    ModemAt::Result r = modemAt.poll();
+
+    // "+CGREG: <n>,<stat>", 1 = home, 5 = roaming
+    int stat = -1;
+    if (r == ModemAt::AT_OK && sscanf(modemAt.getLine(), "+CGREG: %*d,%d", &stat) == 1 &&
+        (stat == 1 || stat == 5)) {
+        bootTimes.network = millis();
+        Serial.println("[LTE] ✅ Network registered");
+        Serial.println("[LTE] Step 5/6: Connecting GPRS...");
+        setupIndex = 0;
+        enter(STEP_DATA_SETUP);
+        return;
+    }
 
-    // Check network first
-    if (!modem.isNetworkConnected()) {
-        Serial.println("[LTE] Network lost, waiting for registration...");
-        if (!modem.waitForNetwork(30000)) {
-            Serial.println("[LTE] ❌ Network registration failed!");
-            return false;
-        }
+    if (millis() - stepStart >= MODEM_NETWORK_TIMEOUT_MS) {
+        Serial.println("[LTE] ❌ Network registration failed!");
+        finishTask(LINK_FAILED);
+        return;
     }
 
-    // Reconnect GPRS
-    return connectGPRS();
+    if (atDue(1000)) {
+        lastAt = millis();
+        modemAt.start("+CGREG?", 1000, "+CGREG:");
+    }
 }
 
-// ============================================================================
-// DISCONNECT
-// ============================================================================
+const char* LTEManager::setupCommand(uint8_t index) {
+    // Same sequence as TinyGsm::gprsConnect(), "" = skipped
+    switch (index) {
+        case 0:
+            return "+NETCLOSE";
+        case 1:
+            if (strlen(APN_USER) == 0) {
+                return "";
+            }
+            snprintf(command, sizeof(command), "+CGAUTH=1,0,\"%s\",\"%s\"", APN_USER, APN_PASS);
+            return command;
+        case 2:
+            snprintf(command, sizeof(command), "+CGDCONT=1,\"IP\",\"%s\",\"0.0.0.0\",0,0", APN_NAME);
+            return command;
+        case 3:
+            return "+CIPMODE=0";
+        case 4:
+            return "+CIPSENDMODE=0";
+        case 5:
+            return "+CIPCCFG=10,0,0,0,1,0,75000";
+        case 6:
+            return "+CIPTIMEOUT=75000,15000,15000";
+        default:
+            return nullptr;
+    }
+}
 
-bool LTEManager::disconnect() {
-    Serial.println("[LTE] Disconnecting GPRS...");
-    modem.gprsDisconnect();
-    gprsConnected = false;
-    Serial.println("[LTE] Disconnected");
-    return true;
+void LTEManager::stepDataSetup() {
+    ModemAt::Result r = modemAt.poll();
+    if (r == ModemAt::AT_PENDING) {
+        return;
+    }
+
+    if (r != ModemAt::AT_IDLE) {
+        // Answers are not checked (as in gprsConnect), silence is
+        if (r == ModemAt::AT_TIMEOUT && setupIndex > 0) {
+            attemptFailed("modem not answering");
+            return;
+        }
+        setupIndex++;
+    }
+
+    const char* cmd = setupCommand(setupIndex);
+    while (cmd != nullptr && cmd[0] == '\0') {
+        cmd = setupCommand(++setupIndex);
+    }
+
+    if (cmd == nullptr) {
+        enter(STEP_NET_OPEN);
+        return;
+    }
+
+    if (setupIndex == 0) {
+        // Closing a stale session; "+NETCLOSE: 0" follows the OK
+        modemAt.start(cmd, 10000, "+NETCLOSE:", true);
+    } else {
+        modemAt.start(cmd, 1000);
+    }
 }
 
-// ============================================================================
-// IS CONNECTED
-// ============================================================================
+void LTEManager::stepNetOpen() {
+    if (sendOnce("+NETOPEN", MODEM_NETOPEN_TIMEOUT_MS, "+NETOPEN:", true)) {
+        return;
+    }
 
-bool LTEManager::isConnected() {
-    // Check GPRS connection status
-    bool connected = modem.isGprsConnected();
-    gprsConnected = connected;
-    return connected;
+    ModemAt::Result r = modemAt.poll();
+    if (r == ModemAt::AT_PENDING) {
+        return;
+    }
+
+    // ERROR usually means "already opened": the IP check decides
+    if (r == ModemAt::AT_ERROR || strcmp(modemAt.getLine(), "+NETOPEN: 0") == 0) {
+        enter(STEP_CHECK_IP);
+        return;
+    }
+
+    attemptFailed(r == ModemAt::AT_TIMEOUT ? "NETOPEN timeout" : modemAt.getLine());
 }
 
-// ============================================================================
-// TEST INTERNET (HTTP to Google)
-// ============================================================================
+void LTEManager::stepCheckIp() {
+    if (sendOnce("+IPADDR", 1000, "+IPADDR:")) {
+        Serial.println("[LTE] Step 6/6: Verifying IP address...");
+        return;
+    }
 
-bool LTEManager::testInternet() {
-    Serial.println("\n========== INTERNET TEST ==========");
+    ModemAt::Result r = modemAt.poll();
+    if (r == ModemAt::AT_PENDING) {
+        return;
+    }
 
-    // Check GPRS
-    Serial.print("[Test] GPRS Status: ");
-    if (!isConnected()) {
-        Serial.println("❌ NOT CONNECTED");
-        Serial.println("===================================\n");
-        return false;
+    const char* ip = modemAt.getLine() + strlen("+IPADDR:");
+    while (*ip == ' ') {
+        ip++;
     }
-    Serial.println("✅ Connected");
 
-    // Get IP
-    Serial.print("[Test] IP Address: ");
-    Serial.println(getIPAddress());
+    if (r != ModemAt::AT_OK || *ip == '\0' || strcmp(ip, "0.0.0.0") == 0) {
+        attemptFailed("invalid IP");
+        return;
+    }
 
-    // Get signal quality
-    Serial.print("[Test] Signal Quality: CSQ ");
-    Serial.println(getSignalQuality());
+    Serial.printf("[LTE] IP Address: %s\n", ip);
+    bootTimes.gprs = millis();
+    gprsConnected = true;
+
+    if (task == TASK_REBOOT) {
+        Serial.println("[LTE] ✅ Hard reboot successful");
+        Serial.println("====================================\n");
+    } else if (task == TASK_POWER_ON) {
+        Serial.println("========================================");
+        Serial.println("[LTE] ✅ LTE Ready!");
+        Serial.println("========================================\n");
+    }
+
+    finishTask(LINK_UP);
+}
 
-    // HTTP test to Google using dedicated diagnostic client (mux 1)
-    Serial.print("[Test] HTTP Test (http://google.com): ");
-    if (diagClient.connected()) {
-        diagClient.stop();
+void LTEManager::attemptFailed(const char* reason) {
+    attempt++;
+    Serial.printf("[LTE] GPRS Attempt %u/%u... ❌ Failed (%s)\n", attempt, MODEM_GPRS_ATTEMPTS, reason);
+
+    if (attempt >= MODEM_GPRS_ATTEMPTS) {
+        Serial.println("[LTE] ❌ GPRS connection failed!");
+        finishTask(LINK_FAILED);
+        return;
     }
 
-    if (diagClient.connect("google.com", 80)) {
-        Serial.println("✅ SUCCESS");
-        diagClient.stop();
-        Serial.println("===================================\n");
-        return true;
-    } else {
-        Serial.println("❌ FAILED");
-        diagClient.stop();
-        Serial.println("===================================\n");
-        return false;
+    enter(STEP_ATTACH_RETRY);
+}
+
+void LTEManager::stepAttachRetry() {
+    if (millis() - stepStart >= MODEM_GPRS_RETRY_MS) {
+        setupIndex = 0;
+        enter(STEP_DATA_SETUP);
     }
 }
 
 // ============================================================================
-// HARD REBOOT
+// INTERNET PROBE STEPS
 // ============================================================================
 
-bool LTEManager::rebootModem() {
-    Serial.println("\n========== LTE HARD REBOOT ==========");
+void LTEManager::stepProbeOpen() {
+    AsyncGsmClient::OpResult r = diagClient.pollOp();
+    if (r == AsyncGsmClient::OP_PENDING) {
+        return;
+    }
 
-    gprsConnected = false;
+    if (r == AsyncGsmClient::OP_DONE) {
+        Serial.println("[Test] TCP test ✅ SUCCESS");
+        diagClient.startClose();
+        enter(STEP_PROBE_CLOSE);
+        return;
+    }
 
-    // Attempt graceful disconnect
-    modem.gprsDisconnect();
+    Serial.println("[Test] TCP test ❌ FAILED");
+    enter(STEP_PROBE_NET_CHECK);
+}
 
-    // Power cycle the module
-    powerOffModem();
-    hardwareReset();
+void LTEManager::stepProbeClose() {
+    if (diagClient.pollOp() != AsyncGsmClient::OP_PENDING) {
+        finishTask(LINK_UP);
+    }
+}
 
-    // Power back on
-    if (!powerOnModem()) {
-        Serial.println("[LTE] ❌ Failed to power modem back on");
-        return false;
+void LTEManager::stepProbeNetCheck() {
+    // Tell "no internet" apart from "data session gone"
+    if (sendOnce("+NETOPEN?", 1000, "+NETOPEN:")) {
+        return;
     }
 
-    // Re-run initialization
-    if (!initModem()) {
-        Serial.println("[LTE] ❌ Modem not responding after reboot");
-        return false;
+    ModemAt::Result r = modemAt.poll();
+    if (r == ModemAt::AT_PENDING) {
+        return;
     }
 
-    if (!connectGPRS()) {
-        Serial.println("[LTE] ❌ Failed to attach GPRS after reboot");
-        return false;
+    if (r == ModemAt::AT_OK && strcmp(modemAt.getLine(), "+NETOPEN: 1") == 0) {
+        finishTask(LINK_FAILED);
+        return;
+    }
+
+    Serial.println("[Test] GPRS Status: ❌ NOT CONNECTED");
+    gprsConnected = false;
+    finishTask(LINK_DOWN);
+}
+
+// ============================================================================
+// URC HANDLER
+// ============================================================================
+
+void LTEManager::onUrc(void* context, const char* line) {
+    LTEManager* self = (LTEManager*)context;
+    ModemBootTimes& times = self->bootTimes;
+    unsigned long now = millis();
+
+    if (strcmp(line, "RDY") == 0) {
+        if (!times.rdy) times.rdy = now;
+    } else if (strcmp(line, "+CPIN: READY") == 0) {
+        if (!times.cpinReady) times.cpinReady = now;
+    } else if (strcmp(line, "PB DONE") == 0) {
+        if (!times.pbDone) times.pbDone = now;
+    } else if (strcmp(line, "NORMAL POWER DOWN") == 0) {
+        self->powerDown = true;
+    } else if (strncmp(line, "+CIPEVENT: NETWORK CLOSED", 25) == 0) {
+        self->gprsConnected = false;
+    } else {
+        return;
     }
 
-    Serial.println("[LTE] ✅ Hard reboot successful");
-    Serial.println("====================================\n");
+    #if DEBUG_LTE
+    Serial.printf("[LTE] URC: %s (+%lu ms)\n", line, now - times.powerOn);
+    #endif
+}
+
+// ============================================================================
+// DISCONNECT
+// ============================================================================
+
+bool LTEManager::disconnect() {
+    Serial.println("[LTE] Disconnecting GPRS...");
+    modem.gprsDisconnect();
+    gprsConnected = false;
+    Serial.println("[LTE] Disconnected");
     return true;
 }
 
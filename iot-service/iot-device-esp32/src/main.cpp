@@ -10,6 +10,8 @@
 #include <TinyGsmClient.h>
 
 #include "config.h"
+#include "modem_at.h"
+#include "async_gsm_client.h"
 #include "lte_manager.h"
 #include "mqtt_manager.h"
 #include "connection_manager.h"
@@ -17,6 +19,18 @@
 #include "time_manager.h"
 #include "generic_io.h"
 #include "rs485_config_manager.h"
+#include "device_profiles.h"
+#include "history_archive.h"
+#include "storage_manager.h"
+#include "data_budget.h"
+#include "topic_router.h"
+#include "actuator_manager.h"
+#include "task_monitor.h"
+#include "job_scheduler.h"
+#include "metrics.h"
+#include "boot_profiler.h"
+#include "modbus_rtu.h"
+#include <SD.h>
 
 // ============================================================================
 // HARDWARE SERIAL FOR SIM7600
@@ -36,180 +50,218 @@ uint8_t modbusResponseBuffer[128];
 // ============================================================================
 
 TinyGsm modem(simSerial);
-TinyGsmClient gsmClient(modem, 0);
-TinyGsmClient diagClient(modem, 1);
+ModemAt modemAt(simSerial);
+AsyncGsmClient gsmClient(modem, 0, modemAt);
+AsyncGsmClient diagClient(modem, 1, modemAt);
 
 LTEManager lteManager;
+#if MQTT_USE_MODEM_STACK
+MQTTManager mqttManager(modemAt);
+#else
 MQTTManager mqttManager(gsmClient);
+#endif
 ConnectionManager connectionManager(lteManager, mqttManager);
 TimeManager timeManager;
 GenericIOManager ioManager;
+HistoryArchive historyArchive;
+StorageManager storageManager;
+DataBudget dataBudget;
+TopicRouter mqttRouter;
+ActuatorManager actuators;
+BootProfiler bootProfiler;
+
+// Acquisition (core 1) -> comms (core 0)
+SampleRing sampleRing;
+TaskMonitor acqMonitor("acq");
+TaskMonitor commsMonitor("comms");
+JobScheduler acqJobs("acq");
+JobScheduler commsJobs("comms");
+TaskHandle_t acqTaskHandle = nullptr;
+TaskHandle_t commsTaskHandle = nullptr;
+
+// Task event bits (xTaskNotify)
+#define ACQ_EVENT_PLAN          0x01    // RS485 config staged
+#define ACQ_EVENT_SCAN          0x02    // RS485 bus scan requested
+#define COMMS_EVENT_MODEM       0x01    // Bytes from the modem (URC, MQTT data)
+#define COMMS_EVENT_SAMPLE      0x02    // Sample in the ring
+
+// Job ids for jobs armed from elsewhere
+int8_t planJob = -1;
+int8_t scanJob = -1;
+int8_t modemJob = -1;
+int8_t samplesJob = -1;
+int8_t bootJob = -1;
+int8_t configRequestJob = -1;
+int8_t relayJob = -1;
+int8_t historyJob = -1;
+int8_t timeSyncJob = -1;
+int8_t bootReportJob = -1;
 
 String DEVICE_ID;
 unsigned long lastTelemetrySent = 0;
-unsigned long lastRS485Scan = 0;
+unsigned long telemetryInterval = TELEMETRY_INTERVAL_MS;
 bool bootNotificationSent = false;
+DataBudgetLevel dataBudgetLevel = BUDGET_NORMAL;
+
+static void notifyTask(TaskHandle_t task, uint32_t events) {
+    if (task != nullptr) {
+        xTaskNotify(task, events, eSetBits);
+    }
+}
 
 // ============================================================================
-// RELAY CONTROL FUNCTIONS
+// RELAY STATUS
 // ============================================================================
 
 /**
- * Control relay state
- * @param target "out1" for NE555 relay on GPIO14
- * @param state "on", "off", "restart"
- * 
- * Logic (Active LOW relay):
- * - "on"  = GPIO LOW  = No current = Relay de-energized
- * - "off" = GPIO HIGH = Current flowing = Relay energized
- * - "restart" = OFF → delay → ON (hard restart sequence)
+ * Relay sequence finished (or command rejected) -> sensor/{device_id}/relay_status
+ * Outputs are active LOW: "on" = GPIO LOW = relay de-energized,
+ * "off" = GPIO HIGH = relay energized, "restart" = off, wait, on.
  */
-void controlRelay(const String& target, const String& state) {
-    if (target != "out1") {
-        Serial.printf("[Relay] ❌ Unknown target: %s\n", target.c_str());
-        return;
+void onRelayDone(const ActuatorManager::Completion& done) {
+    JsonDocument statusDoc;
+    if (done.id[0] != '\0') {
+        statusDoc["id"] = done.id;
     }
-    
-    if (state == "on") {
-        digitalWrite(RELAY_NE555_PIN, LOW);  // Active LOW = ON
-        Serial.println("[Relay] ✅ OUT1 → ON (GPIO14 = LOW)");
-        
-    } else if (state == "off") {
-        digitalWrite(RELAY_NE555_PIN, HIGH);  // Active LOW = OFF
-        Serial.println("[Relay] ✅ OUT1 → OFF (GPIO14 = HIGH)");
-        
-    } else if (state == "restart") {
-        Serial.println("[Relay] 🔄 Restart sequence...");
-        
-        // Phase 1: OFF (energize relay)
-        digitalWrite(RELAY_NE555_PIN, HIGH);
-        Serial.println("[Relay]   → OFF (5 seconds)");
-        delay(5000);
-        
-        // Phase 2: ON (de-energize relay)
-        digitalWrite(RELAY_NE555_PIN, LOW);
-        Serial.println("[Relay]   → ON");
-        Serial.println("[Relay] ✅ Restart completed");
-        
-    } else {
-        Serial.printf("[Relay] ❌ Unknown state: %s\n", state.c_str());
+    statusDoc["target"] = done.target;
+    statusDoc["state"] = done.state;
+    statusDoc["success"] = done.result == ACTUATOR_DONE;
+    statusDoc["result"] = ActuatorManager::resultName(done.result);
+    if (done.result == ACTUATOR_DONE) {
+        statusDoc["queued_ms"] = done.queuedMs;
+        statusDoc["run_ms"] = done.runMs;
     }
+
+    char statusTopic[TOPIC_ROUTER_TOPIC_LEN];
+    snprintf(statusTopic, sizeof(statusTopic), "%s/%s/relay_status", MQTT_TOPIC, DEVICE_ID.c_str());
+    mqttManager.publish(statusTopic, statusDoc);
 }
 
 // ============================================================================
-// MQTT CONFIG CALLBACK
+// MQTT INBOUND HANDLERS
 // ============================================================================
+// Payloads are parsed where the MQTT client received them; nothing is copied
+// into a String on the way.
 
-void mqttCallback(char* topic, uint8_t* payload, unsigned int length) {
-    Serial.print("[MQTT] Message arrived [");
-    Serial.print(topic);
-    Serial.print("] ");
-    Serial.print(length);
-    Serial.println(" bytes");
-
-    // Convert payload to string
-    String message;
-    for (unsigned int i = 0; i < length; i++) {
-        message += (char)payload[i];
-    }
+static bool payloadEquals(const uint8_t* payload, size_t length, const char* text) {
+    size_t textLen = strlen(text);
+    return length == textLen && memcmp(payload, text, textLen) == 0;
+}
 
-    String topicStr = String(topic);
+// stream_config/{device_id}
+static void handleStreamConfig(const uint8_t* payload, size_t length) {
+    Serial.printf("[Config] Received config from server (%u bytes)\n", (unsigned)length);
+    Serial.println("[Config] Raw payload:");
+    Serial.println("========================================");
+    Serial.write(payload, length);
+    Serial.println();
+    Serial.println("========================================");
     
-    // Handle stream_config/{device_id}
-    if (topicStr.indexOf("stream_config/") >= 0) {
-        Serial.println("[Config] Received config from server");
-        Serial.println("[Config] Raw payload:");
-        Serial.println("========================================");
-        Serial.println(message);
-        Serial.println("========================================");
+    if (payloadEquals(payload, length, "\"unchanged\"")) {
+        // Answer to get_config with our hash: the cached config is current
+        Serial.printf("[Config] ✅ Cached config still current (hash %08lx)\n",
+                      (unsigned long)rs485ConfigMgr.getConfigHash());
+        bootProfiler.end(BOOT_CONFIG);
+        
+    } else if (payloadEquals(payload, length, "null") || payloadEquals(payload, length, "\"null\"")) {
+        Serial.println("[Config] ⚠️ No config available (null)");
+        rs485ConfigMgr.clearConfig();
+        rs485ConfigMgr.clearCache();
         
-        if (message == "null" || message == "\"null\"") {
-            Serial.println("[Config] ⚠️ No config available (null)");
-            rs485ConfigMgr.clearConfig();
-            
-            // Still scan to report what devices are online
-            Serial.println("[Config] Performing scan to report available devices...");
-            rs485ConfigMgr.scanDevices(1, 10);
-            rs485ConfigMgr.printDeviceStatus();
+        // Still scan to report what devices are online (acquisition task)
+        Serial.println("[Config] Requesting scan to report available devices...");
+        notifyTask(acqTaskHandle, ACQ_EVENT_PLAN | ACQ_EVENT_SCAN);
+    } else {
+        // Full config or delta; the acquisition task applies it between passes
+        if (rs485ConfigMgr.parseConfig(payload, length)) {
+            Serial.println("[Config] ✅ Config staged");
+            notifyTask(acqTaskHandle, ACQ_EVENT_PLAN);
         } else {
-            // Parse config JSON
-            if (rs485ConfigMgr.parseConfig(message)) {
-                Serial.println("[Config] ✅ Config loaded successfully");
-                
-                // Scan to update device status
-                rs485ConfigMgr.scanDevices(1, 10);
-                rs485ConfigMgr.printDeviceStatus();
-            } else {
-                Serial.println("[Config] ❌ Failed to parse config");
-            }
+            Serial.println("[Config] ❌ Failed to parse config");
         }
     }
+}
+
+// sensor/{device_id}/command
+static void handleCommand(const uint8_t* payload, size_t length) {
+    Serial.print("[Command] Payload: ");
+    Serial.write(payload, length);
+    Serial.println();
     
-    // Handle sensor/{device_id}/command
-    else if (topicStr.indexOf("/command") >= 0) {
-        Serial.println("[Command] Received command from server");
-        Serial.print("[Command] Payload: ");
-        Serial.println(message);
-        
-        // Parse JSON command
-        DynamicJsonDocument doc(256);
-        DeserializationError error = deserializeJson(doc, message);
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, payload, length);
+    
+    if (error) {
+        Serial.print("[Command] ❌ JSON parse failed: ");
+        Serial.println(error.c_str());
+        return;
+    }
+    
+    const char* action = doc["action"] | "";
+    
+    if (strcmp(action, "relay") == 0) {
+        // {"action":"relay","target":"out1","state":"restart","id":"..","duration_ms":5000}
+        const char* target = doc["target"] | "";
+        const char* state = doc["state"] | "";
         
-        if (error) {
-            Serial.print("[Command] ❌ JSON parse failed: ");
-            Serial.println(error.c_str());
-            return;
-        }
+        Serial.printf("[Command] Relay control: target=%s, state=%s\n", target, state);
         
-        String action = doc["action"] | "";
+        // Runs as the relay job; relay_status follows when the sequence is done
+        actuators.submit(doc["id"] | "", target, state, doc["duration_ms"] | 0, millis());
+        commsJobs.runIn(relayJob, 0, millis());
         
-        if (action == "relay") {
-            String target = doc["target"] | "";
-            String state = doc["state"] | "";
-            
-            Serial.printf("[Command] Relay control: target=%s, state=%s\n", 
-                         target.c_str(), state.c_str());
-            
-            controlRelay(target, state);
-            
-            // Send status feedback
-            DynamicJsonDocument statusDoc(128);
-            statusDoc["target"] = target;
-            statusDoc["state"] = state;
-            statusDoc["success"] = true;
-            
-            String statusPayload;
-            serializeJson(statusDoc, statusPayload);
-            
-            String statusTopic = "sensor/" + DEVICE_ID + "/relay_status";
-            mqttManager.publish(statusTopic.c_str(), statusPayload.c_str());
-            
-        } else {
-            Serial.printf("[Command] ❌ Unknown action: %s\n", action.c_str());
-        }
+    } else if (strcmp(action, "history") == 0) {
+        // {"action":"history","from":..,"to":..,"tier":"minute","channels":[..]}
+        startHistoryQuery(doc);
+        commsJobs.runIn(historyJob, 0, millis());
+
+    } else if (strcmp(action, "data_usage") == 0) {
+        sendDataUsage();
+
+    } else {
+        Serial.printf("[Command] ❌ Unknown action: %s\n", action);
     }
 }
 
-// ============================================================================
-// RAW MODBUS RTU FUNCTIONS (Proven working from test)
-// ============================================================================
+// cek_waktu/response: {"server_time":{"unix":..}, ...}, for every device
+// that asked; any answer is the server's time
+static void handleTimeResponse(const uint8_t* payload, size_t length) {
+    JsonDocument filter;
+    filter["server_time"]["unix"] = true;
+    
+    JsonDocument doc;
+    if (deserializeJson(doc, payload, length, DeserializationOption::Filter(filter))) {
+        Serial.println("[Time] ❌ Bad cek_waktu response");
+        return;
+    }
+    timeManager.setTimeFromMQTT(doc["server_time"]["unix"] | 0UL);
+}
 
-uint16_t modbusCRC(const uint8_t* buffer, size_t length) {
-    uint16_t crc = 0xFFFF;
-    for (size_t i = 0; i < length; i++) {
-        crc ^= buffer[i];
-        for (uint8_t bit = 0; bit < 8; bit++) {
-            if (crc & 0x0001) {
-                crc >>= 1;
-                crc ^= 0xA001;
-            } else {
-                crc >>= 1;
-            }
-        }
+// Topics are final once DEVICE_ID is known; subscribing stays where it was
+static void registerTopicRoutes() {
+    char topic[TOPIC_ROUTER_TOPIC_LEN];
+
+    snprintf(topic, sizeof(topic), "stream_config/%s", DEVICE_ID.c_str());
+    mqttRouter.add(topic, handleStreamConfig);
+
+    snprintf(topic, sizeof(topic), "%s/%s/command", MQTT_TOPIC, DEVICE_ID.c_str());
+    mqttRouter.add(topic, handleCommand);
+
+    mqttRouter.add(timeManager.getResponseTopic().c_str(), handleTimeResponse);
+}
+
+void mqttCallback(char* topic, uint8_t* payload, unsigned int length) {
+    Serial.printf("[MQTT] Message arrived [%s] %u bytes\n", topic, length);
+
+    if (!mqttRouter.dispatch(topic, payload, length)) {
+        Serial.printf("[MQTT] ⚠️ No handler for %s\n", topic);
     }
-    return crc;
 }
 
+// ============================================================================
+// RAW MODBUS RTU FUNCTIONS (Proven working from test)
+// ============================================================================
+
 void rs485Write(const uint8_t* buffer, size_t length) {
     if (RS485_DE_RE_PIN >= 0) {
         digitalWrite(RS485_DE_RE_PIN, HIGH);
@@ -250,44 +302,31 @@ size_t readModbusResponse(uint8_t* buffer, size_t bufferSize, uint32_t timeoutMs
 }
 
 void sendReadHoldingRegisters(uint8_t address, uint16_t startRegister, uint16_t count) {
-    uint8_t frame[8];
-    frame[0] = address;
-    frame[1] = 0x03;  // Function: Read Holding Registers
-    frame[2] = startRegister >> 8;
-    frame[3] = startRegister & 0xFF;
-    frame[4] = count >> 8;
-    frame[5] = count & 0xFF;
-
-    uint16_t crc = modbusCRC(frame, 6);
-    frame[6] = crc & 0xFF;
-    frame[7] = (crc >> 8) & 0xFF;
-
-    rs485Write(frame, 8);
+    uint8_t frame[MODBUS_REQUEST_SIZE];
+    modbusBuildReadRequest(frame, address, startRegister, count);
+    rs485Write(frame, sizeof(frame));
 }
 
 // ============================================================================
 // RS485 DATA READING (Public - for telemetry)
 // ============================================================================
 
-bool readRS485Register(uint8_t slaveId, uint16_t regAddr, uint16_t count, uint16_t* output) {
+static bool readHoldingRegisters(uint8_t slaveId, uint16_t regAddr, uint16_t count, uint16_t* output) {
     clearRS485Input();
     sendReadHoldingRegisters(slaveId, regAddr, count);
     
     size_t frameLen = readModbusResponse(modbusResponseBuffer, sizeof(modbusResponseBuffer), 300);
-    
-    if (frameLen < 5) return false;
-    if (modbusResponseBuffer[0] != slaveId) return false;
-    if (modbusResponseBuffer[1] & 0x80) return false;  // Exception
-    
-    uint8_t dataBytes = modbusResponseBuffer[2];
-    if (dataBytes != count * 2) return false;
-    
-    // Extract data
-    for (uint16_t i = 0; i < count; i++) {
-        output[i] = (modbusResponseBuffer[3 + i*2] << 8) | modbusResponseBuffer[4 + i*2];
+    return modbusDecodeReadResponse(modbusResponseBuffer, frameLen, slaveId, count, output);
+}
+
+// Every Modbus read of the firmware goes through here: timed and counted
+bool readRS485Register(uint8_t slaveId, uint16_t regAddr, uint16_t count, uint16_t* output) {
+    ScopedMetric timer(METRIC_RS485_READ);
+    bool ok = readHoldingRegisters(slaveId, regAddr, count, output);
+    if (!ok) {
+        countMetric(COUNTER_RS485_FAIL);
     }
-    
-    return true;
+    return ok;
 }
 
 // Helper: Read Float32 from 2 registers (BADC byte order)
@@ -296,17 +335,7 @@ float readRS485Float32(uint8_t slaveId, uint16_t regAddr) {
     if (!readRS485Register(slaveId, regAddr, 2, regs)) {
         return NAN;
     }
-    
-    // BADC byte order for TUF-2000M
-    uint8_t bytes[4];
-    bytes[0] = regs[0] & 0xFF;      // B
-    bytes[1] = (regs[0] >> 8) & 0xFF; // A
-    bytes[2] = regs[1] & 0xFF;      // D
-    bytes[3] = (regs[1] >> 8) & 0xFF; // C
-    
-    float value;
-    memcpy(&value, bytes, 4);
-    return value;
+    return modbusFloat32BADC(regs);
 }
 
 // Helper: Read Uint32 from 2 registers (swap words)
@@ -315,9 +344,7 @@ uint32_t readRS485Uint32(uint8_t slaveId, uint16_t regAddr) {
     if (!readRS485Register(slaveId, regAddr, 2, regs)) {
         return 0;
     }
-    
-    // Swap words: low word first, then high word
-    return ((uint32_t)regs[1] << 16) | regs[0];
+    return modbusUint32LowFirst(regs);
 }
 
 // ============================================================================
@@ -358,6 +385,8 @@ static String buildDeviceId() {
 // SETUP
 // ============================================================================
 
+static void startTasks();
+
 void setup() {
     Serial.begin(115200);
     delay(1000);
@@ -367,36 +396,78 @@ void setup() {
     Serial.println("Full Stack: LTE + MQTT + All Sensors");
     Serial.println("========================================");
 
+    bootProfiler.begin();
+
     DEVICE_ID = buildDeviceId();
     Serial.print("Device ID: ");
     Serial.println(DEVICE_ID);
 
     Serial.println("\n[1/6] Initializing Time Manager...");
+    bootProfiler.start(BOOT_TIME);
     timeManager.begin();
     timeManager.printStatus();
+    bootProfiler.end(BOOT_TIME);
 
     Serial.println("\n[2/6] Setting up RS485/Modbus...");
+    bootProfiler.start(BOOT_RS485);
     setupModbus();
     delay(500);
+    bootProfiler.end(BOOT_RS485);
 
     Serial.println("\n[3/6] Initializing Generic I/O...");
+    bootProfiler.start(BOOT_IO);
     ioManager.begin();
 
-    // Initialize GPIO pins
-    pinMode(RELAY_NE555_PIN, OUTPUT);
-    digitalWrite(RELAY_NE555_PIN, LOW);  // Relay OFF (active LOW)
-    Serial.println("[Relay] NE555 module initialized on GPIO14");
+    // Relay outputs, active LOW, start "on" (GPIO LOW, relay de-energized)
+    actuators.addOutput("out1", ACTUATOR_OUT1_PIN, true, true);
+    actuators.addOutput("out2", ACTUATOR_OUT2_PIN, true, true);
+    actuators.setCompletionHandler(onRelayDone);
+    Serial.printf("[Relay] %u output(s) initialized\n", actuators.getOutputCount());
     
     pinMode(IO_DIGITAL_IN_1_PIN, INPUT);  // Pump status input
     Serial.println("[Digital Input] GPIO38 initialized for pump status");
+    bootProfiler.end(BOOT_IO);
+
+    bootProfiler.start(BOOT_STORAGE);
+    // Offline queue doubles as the MQTT outbox; mounts SD before the archive
+    storageManager.begin();
+
+    // This month's cellular bytes, kept across reboots
+    if (dataBudget.begin(DATA_BUDGET_FILE, DATA_BUDGET_MB * 1048576UL, DEVICE_ID.c_str(),
+                         DATA_BUDGET_TZ_OFFSET_S)) {
+        Serial.printf("[Data] ✅ %lu KB used in %lu\n", (unsigned long)(dataBudget.getUsed() / 1024),
+                      (unsigned long)dataBudget.getMonth().period);
+    } else {
+        Serial.println("[Data] ⚠️ No saved counters, counting from 0");
+    }
+
+    // Last RS485 config from flash: acquisition starts before LTE is up,
+    // the server only confirms it later
+    if (rs485ConfigMgr.loadCache(RS485_CONFIG_CACHE_FILE)) {
+        rs485ConfigMgr.printDeviceStatus();
+    } else {
+        Serial.println("[Config] No cached RS485 config, waiting for server");
+    }
+
+    #if ENABLE_HISTORY
+    if (storageManager.mountSd() && historyArchive.begin(HISTORY_DIR)) {
+        Serial.printf("[History] ✅ Archive ready (%u channels)\n", historyArchive.getChannelCount());
+    } else {
+        Serial.println("[History] ⚠️ SD not available - history archive disabled");
+    }
+    #endif
+    bootProfiler.end(BOOT_STORAGE);
 
     Serial.println("\n[4/6] Powering LTE stack...");
-    bool lteReady = lteManager.begin();
-    Serial.println(lteReady ? "[LTE] ✅ Ready" : "[LTE] ❌ Failed (auto-retry active)");
+    // Power-up and attach continue in the comms task via connectionManager
+    lteManager.begin();
 
     Serial.println("\n[5/6] Preparing MQTT manager...");
-    mqttManager.begin(MQTT_BROKER, MQTT_PORT, DEVICE_ID.c_str());
-    mqttManager.setCallback(mqttCallback);  // Set callback for config messages
+    mqttManager.begin(MQTT_BROKER, MQTT_TLS_ENABLED ? MQTT_TLS_PORT : MQTT_PORT, DEVICE_ID.c_str());
+    registerTopicRoutes();
+    mqttManager.setCallback(mqttCallback);  // Routes config / command messages
+    mqttManager.setOutbox(&storageManager.getEngine());
+    mqttManager.setDataBudget(&dataBudget);
 
     Serial.println("\n[6/6] Starting Connection Manager...");
     connectionManager.begin();
@@ -406,17 +477,14 @@ void setup() {
     Serial.println("========================================\n");
     
     // Post-init: Scan devices (after LTE stable)
+    bootProfiler.start(BOOT_POST_INIT);
     Serial.println("[POST-INIT] Scanning I2C devices...");
     ioManager.getI2C().scanDevices();
     
     Serial.println("\n[POST-INIT] Testing RS485 device...");
     // Simple ping test
     clearRS485Input();
-    uint8_t frame[8] = {1, 0x03, 0, 0, 0, 1, 0, 0};
-    uint16_t crc = modbusCRC(frame, 6);
-    frame[6] = crc & 0xFF;
-    frame[7] = (crc >> 8) & 0xFF;
-    rs485Write(frame, 8);
+    sendReadHoldingRegisters(1, 0, 1);
     
     delay(100);
     size_t resp = readModbusResponse(modbusResponseBuffer, sizeof(modbusResponseBuffer), 300);
@@ -428,6 +496,9 @@ void setup() {
     
     ioManager.printDeviceSummary();
     Serial.println();
+    bootProfiler.end(BOOT_POST_INIT);
+
+    startTasks();
 }
 
 // ============================================================================
@@ -441,13 +512,26 @@ void requestRS485Config() {
     }
     
     String topic = "get_config/" + DEVICE_ID;
-    String payload = "request";
     
-    Serial.print("[Config] Requesting config from server: ");
-    Serial.println(topic);
+    // With a cached config the server only answers "unchanged" if it matches;
+    // devices with a built-in profile are sent as {"profile":..} only
+    JsonDocument request;
+    if (rs485ConfigMgr.hasConfigHash()) {
+        char hash[9];
+        snprintf(hash, sizeof(hash), "%08lx", (unsigned long)rs485ConfigMgr.getConfigHash());
+        request["hash"] = hash;
+    }
+    JsonArray profiles = request["profiles"].to<JsonArray>();
+    for (uint8_t i = 0; i < getDeviceProfileCount(); i++) {
+        const RS485Profile& profile = getDeviceProfile(i);
+        profiles.add(String(profile.deviceType) + "@" + profile.version);
+    }
+    
+    Serial.printf("[Config] Requesting config from server: %s\n", topic.c_str());
     
-    if (mqttManager.publish(topic.c_str(), payload.c_str())) {
+    if (mqttManager.publish(topic.c_str(), request)) {
         Serial.println("[Config] ✅ Config request sent");
+        bootProfiler.start(BOOT_CONFIG);
         
         // Subscribe to stream_config topic
         String streamTopic = "stream_config/" + DEVICE_ID;
@@ -460,37 +544,290 @@ void requestRS485Config() {
 }
 
 // ============================================================================
-// LOOP
+// DATA BUDGET
 // ============================================================================
 
-void loop() {
+// Telemetry interval for the current budget level; applies the replay pause
+static unsigned long applyDataBudget(unsigned long now) {
+    dataBudget.update(timeManager.isSynced() ? timeManager.getUnixTime() : 0, now);
+
+    DataBudgetLevel level = dataBudget.getLevel();
+    if (level != dataBudgetLevel) {
+        Serial.printf("[Data] Budget level %s -> %s (%lu KB projected of %lu KB), telemetry every %lu s\n",
+                      DataBudget::levelName(dataBudgetLevel), DataBudget::levelName(level),
+                      (unsigned long)(dataBudget.getProjected() / 1024),
+                      (unsigned long)(dataBudget.getBudget() / 1024),
+                      TELEMETRY_INTERVAL_MS * dataBudget.getIntervalFactor() / 1000);
+        dataBudgetLevel = level;
+        mqttManager.setReplayPaused(dataBudget.isReplayPaused());
+    }
+
+    return TELEMETRY_INTERVAL_MS * dataBudget.getIntervalFactor();
+}
+
+// ============================================================================
+// TASKS
+// ============================================================================
+// Core 1: acquisition owns RS485, ADC and I2C and samples on a fixed period.
+// Core 0: comms owns the modem, MQTT, storage and the history archive. They
+// share only the sample ring and the staged RS485 config. Each task runs its
+// own job scheduler and sleeps until the next deadline or an event bit.
+
+// ---- Acquisition jobs ----
+
+static void runSample(unsigned long) {
+    SensorSample* sample = sampleRing.reserve();
+    if (sample == nullptr) {
+        Serial.println("[Acq] ⚠️ Sample ring full (comms behind), sample dropped");
+    } else if (acquireSample(*sample)) {
+        sampleRing.publish();
+        notifyTask(commsTaskHandle, COMMS_EVENT_SAMPLE);
+    }
+
+    // Uptime for the next boot's summary, from the task that must keep going
+    bootProfiler.noteAlive(millis());
+}
+
+// Between samples: jobs never overlap
+static void runPlanCommit(unsigned long) {
+    if (rs485ConfigMgr.hasStaged()) {
+        rs485ConfigMgr.commitStaged();
+        rs485ConfigMgr.printDeviceStatus();
+        bootProfiler.end(BOOT_CONFIG);
+    }
+}
+
+static void runRS485Scan(unsigned long) {
+    Serial.println("\n[Periodic] RS485 device scan...");
+    rs485ConfigMgr.scanDevices(1, 10);
+    rs485ConfigMgr.printDeviceStatus();
+}
+
+// ---- Comms jobs ----
+
+static void runModem(unsigned long now) {
     connectionManager.loop();
 
-    unsigned long now = millis();
+    if (!bootNotificationSent && connectionManager.isFullyConnected()) {
+        const ModemBootTimes& times = lteManager.getBootTimes();
+        bootProfiler.span(BOOT_MODEM, times.powerOn, times.ready);
+        bootProfiler.span(BOOT_NETWORK, times.ready, times.gprs);
+        bootProfiler.span(BOOT_MQTT, times.gprs, now);
+
+        bootNotificationSent = true;
+        commsJobs.runIn(bootJob, 0, now);
+    }
+}
+
+static void runBootNotification(unsigned long now) {
+    sendBootNotification();
+    commsJobs.runIn(configRequestJob, 1000, now);   // Give server time to process boot event
+}
+
+static void runConfigRequest(unsigned long) {
+    requestRS485Config();
+}
+
+// Every sample goes to the history archive; the newest is published once
+// the (data budget stretched) telemetry interval is due
+static void runSamples(unsigned long now) {
+    bool connected = connectionManager.isFullyConnected();
+
+    while (const SensorSample* sample = sampleRing.peek()) {
+        bool newest = sampleRing.size() == 1;
+        bool publish = newest && connected && now - lastTelemetrySent >= telemetryInterval;
+        if (publish) {
+            lastTelemetrySent = now;
+        }
+        processSample(*sample, publish);
+        sampleRing.release();
+
+        if (publish && !bootProfiler.isDone(BOOT_TELEMETRY)) {
+            bootProfiler.end(BOOT_TELEMETRY);
+            commsJobs.runIn(bootReportJob, 0, now);
+        }
+    }
+}
+
+static void runBootReport(unsigned long) {
+    bootProfiler.printTimeline();
+    sendBootTimeline();
+}
+
+static void runStorage(unsigned long) {
+    storageManager.loop();
+}
+
+static void runDataBudget(unsigned long now) {
+    telemetryInterval = applyDataBudget(now);
+}
+
+static void runRelays(unsigned long now) {
+    actuators.loop(now);
+
+    unsigned long waitMs = actuators.msUntilNext(millis());
+    if (waitMs != ACTUATOR_IDLE) {
+        commsJobs.runIn(relayJob, waitMs, now);
+    }
+}
+
+// One batch per run while a query is open; waits for outbox room
+static void runHistoryQuery(unsigned long now) {
+    if (connectionManager.isFullyConnected()) {
+        serviceHistoryQuery();
+    }
+    if (historyArchive.isQueryActive()) {
+        commsJobs.runIn(historyJob, COMMS_TICK_MS, now);
+    }
+}
+
+static void runTimeSync(unsigned long now) {
+    if (mqttManager.isConnected()) {
+        JsonDocument request;
+        request["device_id"] = DEVICE_ID;
+        mqttManager.subscribe(timeManager.getResponseTopic().c_str());
+        if (!timeManager.isSynced()) {
+            timeManager.requestMQTTTimeSync();  // A resync keeps the current time valid
+        }
+        mqttManager.publish(timeManager.getRequestTopic().c_str(), request);
+    }
+    // Until the first answer, ask again sooner than the daily resync
+    if (!timeManager.isSynced()) {
+        commsJobs.runIn(timeSyncJob, TIME_SYNC_RETRY_MS, now);
+    }
+}
+
+static void runNodeInfo(unsigned long) {
+    requestNodeInfo();
+}
 
+static void runMetrics(unsigned long) {
+    sendMetrics();
+}
+
+static void runHealthCheck(unsigned long) {
     if (connectionManager.isFullyConnected()) {
-        // Send boot notification and request config
-        if (!bootNotificationSent) {
-            sendBootNotification();
-            delay(1000);  // Give server time to process boot event
-            requestRS485Config();
-            bootNotificationSent = true;
+        connectionManager.printHealth();
+    }
+}
+
+static void runTaskReport(unsigned long now) {
+    for (TaskMonitor* monitor : { &acqMonitor, &commsMonitor }) {
+        monitor->roll();
+        const TaskMonitor::Report& report = monitor->getLast();
+        Serial.printf("[Tasks] %s (core %u): load %u%%, stack free %lu B, %lu passes, "
+                      "longest %lu ms, late %lu ms\n",
+                      monitor->getName(), monitor->getCore(), report.loadPct,
+                      (unsigned long)report.stackFree, (unsigned long)report.passes,
+                      (unsigned long)report.maxPassMs, (unsigned long)report.maxLateMs);
+    }
+    if (sampleRing.getDropped() > 0) {
+        Serial.printf("[Tasks] ⚠️ %lu sample(s) dropped so far\n",
+                      (unsigned long)sampleRing.getDropped());
+    }
+    commsJobs.printJobs(now);
+}
+
+// ---- Task bodies ----
+
+static void acquisitionTask(void*) {
+    unsigned long waitMs = 0;
+
+    for (;;) {
+        uint32_t events = 0;
+        xTaskNotifyWait(0, 0xFFFFFFFF, &events, pdMS_TO_TICKS(waitMs));
+
+        acqMonitor.beginWork();
+        unsigned long now = millis();
+        if (events & ACQ_EVENT_PLAN) {
+            acqJobs.runIn(planJob, 0, now);
         }
+        if (events & ACQ_EVENT_SCAN) {
+            acqJobs.runIn(scanJob, 0, now);
+        }
+        waitMs = acqJobs.run(now);
+        acqMonitor.noteLate(acqJobs.getLastLateMs());
+        acqMonitor.endWork();
+    }
+}
 
-        // Periodic telemetry
-        if (now - lastTelemetrySent >= TELEMETRY_INTERVAL_MS) {
-            lastTelemetrySent = now;
-            sendFullTelemetry();
+static void commsTask(void*) {
+    unsigned long waitMs = 0;
+
+    for (;;) {
+        uint32_t events = 0;
+        xTaskNotifyWait(0, 0xFFFFFFFF, &events, pdMS_TO_TICKS(waitMs));
+
+        commsMonitor.beginWork();
+        unsigned long now = millis();
+        if (events & COMMS_EVENT_MODEM) {
+            commsJobs.runIn(modemJob, 0, now);
         }
-        
-        // Periodic RS485 scan (configured interval in config.h)
-        if (now - lastRS485Scan >= RS485_SCAN_INTERVAL_MS) {
-            lastRS485Scan = now;
-            Serial.println("\n[Periodic] RS485 device scan...");
-            rs485ConfigMgr.scanDevices(1, 10);
-            rs485ConfigMgr.printDeviceStatus();
+        if (events & COMMS_EVENT_SAMPLE) {
+            commsJobs.runIn(samplesJob, 0, now);
         }
+        waitMs = commsJobs.run(now);
+        commsMonitor.noteLate(commsJobs.getLastLateMs());
+        commsMonitor.endWork();
     }
+}
 
-    delay(100);
+// All periodic work of the firmware, in one place
+static void registerJobs() {
+    unsigned long now = millis();
+
+    acqJobs.every("sample", TELEMETRY_INTERVAL_MS, runSample, now);
+    planJob = acqJobs.once("rs485_plan", runPlanCommit);
+    scanJob = acqJobs.every("rs485_scan", RS485_SCAN_INTERVAL_MS, runRS485Scan, now,
+                            RS485_SCAN_INTERVAL_MS);
+
+    modemJob = commsJobs.every("modem", COMMS_TICK_MS, runModem, now);
+    samplesJob = commsJobs.once("samples", runSamples);
+    relayJob = commsJobs.once("relay", runRelays);
+    bootJob = commsJobs.once("boot", runBootNotification);
+    configRequestJob = commsJobs.once("config_req", runConfigRequest);
+    bootReportJob = commsJobs.once("boot_report", runBootReport);
+    historyJob = commsJobs.once("history", runHistoryQuery);
+    commsJobs.every("storage", STORAGE_POLL_MS, runStorage, now);
+    commsJobs.every("budget", 1000, runDataBudget, now);
+    timeSyncJob = commsJobs.every("time_sync", TIME_RESYNC_INTERVAL_MS, runTimeSync, now);
+    commsJobs.every("node_info", DATA_COMPACT_NODE_INFO_MS, runNodeInfo, now,
+                    DATA_COMPACT_NODE_INFO_MS);
+    commsJobs.every("metrics", METRICS_INTERVAL_MS, runMetrics, now, METRICS_INTERVAL_MS);
+    commsJobs.every("health", HEALTH_CHECK_INTERVAL_MS, runHealthCheck, now,
+                    HEALTH_CHECK_INTERVAL_MS);
+    commsJobs.every("tasks", TASK_REPORT_INTERVAL_MS, runTaskReport, now,
+                    TASK_REPORT_INTERVAL_MS);
+
+    acqJobs.printJobs(now);
+    commsJobs.printJobs(now);
+}
+
+static void startTasks() {
+    registerJobs();
+    bootProfiler.start(BOOT_TELEMETRY);
+
+    xTaskCreatePinnedToCore(acquisitionTask, "acq", ACQ_TASK_STACK, nullptr,
+                            ACQ_TASK_PRIORITY, &acqTaskHandle, ACQ_TASK_CORE);
+    acqMonitor.attach(acqTaskHandle, ACQ_TASK_CORE);
+
+    xTaskCreatePinnedToCore(commsTask, "comms", COMMS_TASK_STACK, nullptr,
+                            COMMS_TASK_PRIORITY, &commsTaskHandle, COMMS_TASK_CORE);
+    commsMonitor.attach(commsTaskHandle, COMMS_TASK_CORE);
+
+    // Modem bytes (URCs, MQTT data) wake comms straight away instead of at
+    // the next tick; runs in the UART event task
+    simSerial.onReceive([]() { notifyTask(commsTaskHandle, COMMS_EVENT_MODEM); });
+
+    Serial.printf("[Tasks] ✅ Acquisition on core %d, comms on core %d\n",
+                  ACQ_TASK_CORE, COMMS_TASK_CORE);
+}
+
+// ============================================================================
+// LOOP
+// ============================================================================
+
+void loop() {
+    // All work runs in the pinned tasks started by setup()
+    vTaskDelete(NULL);
 }
@@ -0,0 +1,117 @@
+#include <Arduino.h>
+#include "metrics_snapshot.h"
+#include <string.h>
+
+// ============================================================================
+// METRICS IMPLEMENTATION
+// ============================================================================
+
+namespace {
+
+struct Histogram {
+    uint32_t count;
+    uint64_t sumUs;
+    uint32_t maxUs;
+    uint32_t buckets[METRIC_BUCKETS];
+};
+
+const char* const TIMER_NAMES[METRIC_TIMER_COUNT] = {
+    "acq", "rs485", "json", "telemetry", "node_info", "publish",
+    "at", "st_push", "st_read", "st_poll", "history"
+};
+
+const char* const COUNTER_NAMES[COUNTER_COUNT] = {
+    "rs485_fail", "at_error", "at_timeout", "pub_spill", "pub_replay", "pub_fail",
+    "rs485_drop"
+};
+
+portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+Histogram timers[METRIC_TIMER_COUNT];
+uint32_t counters[COUNTER_COUNT];
+unsigned long windowStart = 0;
+
+// Scratch copy taken under the lock; only the comms task snapshots
+Histogram timersCopy[METRIC_TIMER_COUNT];
+uint32_t countersCopy[COUNTER_COUNT];
+
+uint8_t bucketOf(uint32_t us) {
+    uint32_t scaled = us >> METRIC_BUCKET_SHIFT;
+    if (scaled == 0) {
+        return 0;
+    }
+    uint8_t bucket = 32 - __builtin_clz(scaled);
+    return bucket < METRIC_BUCKETS ? bucket : METRIC_BUCKETS - 1;
+}
+
+} // namespace
+
+void recordMetric(MetricId id, uint32_t us) {
+    uint8_t bucket = bucketOf(us);
+
+    portENTER_CRITICAL(&lock);
+    Histogram& h = timers[id];
+    h.count++;
+    h.sumUs += us;
+    if (us > h.maxUs) {
+        h.maxUs = us;
+    }
+    h.buckets[bucket]++;
+    portEXIT_CRITICAL(&lock);
+}
+
+uint32_t metricsMicros() {
+    return micros();
+}
+
+void countMetric(MetricCounter counter, uint32_t n) {
+    portENTER_CRITICAL(&lock);
+    counters[counter] += n;
+    portEXIT_CRITICAL(&lock);
+}
+
+bool snapshotMetrics(JsonObject out, unsigned long nowMs) {
+    portENTER_CRITICAL(&lock);
+    memcpy(timersCopy, timers, sizeof(timers));
+    memcpy(countersCopy, counters, sizeof(counters));
+    memset(timers, 0, sizeof(timers));
+    memset(counters, 0, sizeof(counters));
+    portEXIT_CRITICAL(&lock);
+
+    out["w"] = (nowMs - windowStart) / 1000;
+    out["b"] = 1UL << METRIC_BUCKET_SHIFT;
+    windowStart = nowMs;
+
+    bool any = false;
+    JsonObject stages = out["t"].to<JsonObject>();
+    for (uint8_t i = 0; i < METRIC_TIMER_COUNT; i++) {
+        const Histogram& h = timersCopy[i];
+        if (h.count == 0) {
+            continue;
+        }
+        any = true;
+
+        // [count, sum ms, max ms, [buckets]]
+        JsonArray stage = stages[TIMER_NAMES[i]].to<JsonArray>();
+        stage.add(h.count);
+        stage.add((uint32_t)(h.sumUs / 1000));
+        stage.add(h.maxUs / 1000);
+
+        uint8_t used = METRIC_BUCKETS;
+        while (used > 0 && h.buckets[used - 1] == 0) {
+            used--;
+        }
+        JsonArray buckets = stage.add<JsonArray>();
+        for (uint8_t b = 0; b < used; b++) {
+            buckets.add(h.buckets[b]);
+        }
+    }
+
+    JsonObject events = out["c"].to<JsonObject>();
+    for (uint8_t i = 0; i < COUNTER_COUNT; i++) {
+        if (countersCopy[i] != 0) {
+            events[COUNTER_NAMES[i]] = countersCopy[i];
+            any = true;
+        }
+    }
+    return any;
+}
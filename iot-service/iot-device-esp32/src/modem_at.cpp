@@ -0,0 +1,175 @@
+#include "modem_at.h"
+#include "metrics.h"
+
+// ============================================================================
+// MODEM AT IMPLEMENTATION
+// ============================================================================
+
+ModemAt::ModemAt(Stream& s) : stream(s) {
+    urcHandlerCount = 0;
+    pending = false;
+    startedAt = 0;
+    startedUs = 0;
+    timeoutMs = 0;
+    prefix[0] = '\0';
+    untilCapture = false;
+    okSeen = false;
+    captured[0] = '\0';
+    line[0] = '\0';
+    lineLength = 0;
+    lastEndedCr = false;
+    promptData = nullptr;
+    promptLength = 0;
+    rawDest = nullptr;
+    rawRemaining = 0;
+    rawSkipLf = false;
+}
+
+bool ModemAt::addUrcHandler(UrcHandler handler, void* context) {
+    if (urcHandlerCount >= MODEM_AT_URC_HANDLERS) {
+        return false;
+    }
+    urcHandlers[urcHandlerCount] = handler;
+    urcContexts[urcHandlerCount] = context;
+    urcHandlerCount++;
+    return true;
+}
+
+bool ModemAt::start(const char* command, uint32_t timeout, const char* capturePrefix, bool until) {
+    if (pending) {
+        return false;
+    }
+
+    strncpy(prefix, capturePrefix ? capturePrefix : "", sizeof(prefix) - 1);
+    prefix[sizeof(prefix) - 1] = '\0';
+    untilCapture = until && prefix[0] != '\0';
+    captured[0] = '\0';
+    okSeen = false;
+
+    stream.print("AT");
+    stream.print(command);
+    stream.print("\r\n");
+
+    #if DEBUG_LTE > 1
+    Serial.printf("[AT] >> AT%s\n", command);
+    #endif
+
+    pending = true;
+    startedAt = millis();
+    startedUs = micros();
+    timeoutMs = timeout;
+    promptData = nullptr;
+    return true;
+}
+
+bool ModemAt::startWithData(const char* command, const uint8_t* data, size_t length, uint32_t timeout,
+                            const char* capturePrefix, bool until) {
+    if (!start(command, timeout, capturePrefix, until)) {
+        return false;
+    }
+    promptData = data;
+    promptLength = length;
+    return true;
+}
+
+void ModemAt::readRaw(uint8_t* dest, size_t length) {
+    rawDest = dest;
+    rawRemaining = length;
+    // The CR of the announcing line ended it; its LF is still unread
+    rawSkipLf = lastEndedCr;
+}
+
+ModemAt::Result ModemAt::poll() {
+    while (readLine()) {
+        #if DEBUG_LTE > 1
+        Serial.printf("[AT] << %s\n", line);
+        #endif
+
+        for (uint8_t i = 0; i < urcHandlerCount; i++) {
+            urcHandlers[i](urcContexts[i], line);
+        }
+
+        if (!pending) {
+            continue;
+        }
+
+        if (prefix[0] != '\0' && strncmp(line, prefix, strlen(prefix)) == 0) {
+            strncpy(captured, line, sizeof(captured));
+            if (okSeen) {
+                return finish(AT_OK);
+            }
+        } else if (strcmp(line, "OK") == 0) {
+            // With untilCapture the result line may still follow the OK
+            if (!untilCapture || captured[0] != '\0') {
+                return finish(AT_OK);
+            }
+            okSeen = true;
+        } else if (strcmp(line, "ERROR") == 0 || strncmp(line, "+CME ERROR", 10) == 0) {
+            return finish(AT_ERROR);
+        }
+    }
+
+    if (!pending) {
+        return AT_IDLE;
+    }
+
+    if (millis() - startedAt >= timeoutMs) {
+        promptData = nullptr;
+        return finish(AT_TIMEOUT);
+    }
+
+    return AT_PENDING;
+}
+
+ModemAt::Result ModemAt::finish(Result result) {
+    pending = false;
+    recordMetric(METRIC_MODEM_AT, micros() - startedUs);
+    if (result == AT_ERROR) {
+        countMetric(COUNTER_AT_ERROR);
+    } else if (result == AT_TIMEOUT) {
+        countMetric(COUNTER_AT_TIMEOUT);
+    }
+    return result;
+}
+
+bool ModemAt::readLine() {
+    while (stream.available()) {
+        char c = stream.read();
+
+        if (rawRemaining > 0) {
+            if (rawSkipLf) {
+                rawSkipLf = false;
+                if (c == '\n') {
+                    continue;
+                }
+            }
+            if (rawDest) {
+                *rawDest++ = c;
+            }
+            rawRemaining--;
+            continue;
+        }
+
+        // The data prompt is a bare ">" with no line ending after it
+        if (promptData != nullptr && lineLength == 0 && c == '>') {
+            stream.write(promptData, promptLength);
+            promptData = nullptr;
+            continue;
+        }
+
+        if (c != '\r' && c != '\n') {
+            if (lineLength < sizeof(line) - 1) {
+                line[lineLength++] = c;
+            }
+            continue;
+        }
+
+        if (lineLength > 0) {
+            line[lineLength] = '\0';
+            lineLength = 0;
+            lastEndedCr = c == '\r';
+            return true;
+        }
+    }
+    return false;
+}
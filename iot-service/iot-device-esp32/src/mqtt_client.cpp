@@ -0,0 +1,852 @@
+#include "mqtt_client.h"
+#include <string.h>
+
+// ============================================================================
+// MQTT CLIENT IMPLEMENTATION
+// ============================================================================
+
+#define MQTT_CONNECT     0x10
+#define MQTT_CONNACK     0x20
+#define MQTT_PUBLISH     0x30
+#define MQTT_PUBACK      0x40
+#define MQTT_SUBSCRIBE   0x82    // Reserved flag bits 0010
+#define MQTT_SUBACK      0x90
+#define MQTT_PINGREQ     0xC0
+#define MQTT_PINGRESP    0xD0
+#define MQTT_DISCONNECT  0xE0
+
+#define MQTT_FLAG_DUP    0x08
+
+// MQTT 5 properties used here
+#define MQTT_PROP_MESSAGE_EXPIRY    0x02
+#define MQTT_PROP_SESSION_EXPIRY    0x11
+#define MQTT_PROP_SERVER_KEEP_ALIVE 0x13
+#define MQTT_PROP_RECEIVE_MAX       0x21
+#define MQTT_PROP_TOPIC_ALIAS_MAX   0x22
+#define MQTT_PROP_TOPIC_ALIAS       0x23
+#define MQTT_PROP_USER              0x26
+
+namespace {
+    inline uint16_t readU16(const uint8_t* p) {
+        return ((uint16_t)p[0] << 8) | p[1];
+    }
+
+    inline uint8_t* writeU16(uint8_t* p, uint16_t value) {
+        p[0] = value >> 8;
+        p[1] = value & 0xFF;
+        return p + 2;
+    }
+
+    inline uint8_t* writeU32(uint8_t* p, uint32_t value) {
+        p = writeU16(p, value >> 16);
+        return writeU16(p, value & 0xFFFF);
+    }
+
+    // Variable byte integer; returns its size, 0 if malformed / cut off
+    size_t decodeLength(const uint8_t* p, const uint8_t* end, uint32_t& value) {
+        value = 0;
+        for (size_t i = 0; i < 4 && p + i < end; i++) {
+            value |= (uint32_t)(p[i] & 0x7F) << (7 * i);
+            if (!(p[i] & 0x80)) {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    // One MQTT 5 property. Integer values land in `value`; strings, binary
+    // data and pairs are skipped. False if malformed or unknown.
+    bool readProperty(const uint8_t*& p, const uint8_t* end, uint8_t& id, uint32_t& value) {
+        if (p >= end) {
+            return false;
+        }
+        id = *p++;
+        value = 0;
+
+        size_t size;
+        switch (id) {
+            case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+                size = 1;
+                break;
+            case 0x13: case 0x21: case 0x22: case 0x23:
+                size = 2;
+                break;
+            case 0x02: case 0x11: case 0x18: case 0x27:
+                size = 4;
+                break;
+            case 0x0B: {
+                size_t n = decodeLength(p, end, value);
+                p += n;
+                return n > 0;
+            }
+            case 0x03: case 0x08: case 0x09: case 0x12: case 0x15: case 0x16: case 0x1A: case 0x1C: case 0x1F:
+            case MQTT_PROP_USER:
+                for (int strings = id == MQTT_PROP_USER ? 2 : 1; strings > 0; strings--) {
+                    if (end - p < 2 || (size_t)(end - p) < 2u + readU16(p)) {
+                        return false;
+                    }
+                    p += 2 + readU16(p);
+                }
+                return true;
+            default:
+                return false;
+        }
+
+        if ((size_t)(end - p) < size) {
+            return false;
+        }
+        for (size_t i = 0; i < size; i++) {
+            value = (value << 8) | p[i];
+        }
+        p += size;
+        return true;
+    }
+}
+
+MqttClient::MqttClient() {
+    transport = nullptr;
+    clock = nullptr;
+    rxBuffer = nullptr;
+    rxSize = 0;
+    arena = nullptr;
+    arenaSize = 0;
+    arenaUsed = 0;
+    window = 1;
+    receiveMax = MQTT_INFLIGHT_MAX;
+    protocol = 4;
+    sessionExpiryS = 0;
+    messageExpiryS = 0;
+    userKeyLen = 0;
+    userValueLen = 0;
+    memset(aliasTopics, 0, sizeof(aliasTopics));
+    aliasCount = 0;
+    aliasLimit = 0;
+    aliasSent = 0;
+    memset(inflight, 0, sizeof(inflight));
+    inflightHead = 0;
+    inflightCount = 0;
+    nextPacketId = 1;
+    state = MQTT_IDLE;
+    sessionPresent = false;
+    returnCode = 0;
+    keepAliveMs = 0;
+    connectTimeoutMs = 0;
+    connectStartedAt = 0;
+    lastInAt = 0;
+    lastOutAt = 0;
+    pingSentAt = 0;
+    pingOutstanding = false;
+    rxState = RX_HEADER;
+    rxHeader = 0;
+    rxRemaining = 0;
+    rxLength = 0;
+    rxMultiplier = 1;
+    rxSkip = false;
+    messageHandler = nullptr;
+    messageContext = nullptr;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void MqttClient::begin(MqttTransport* net, ClockFn millisClock,
+                       uint8_t* rx, size_t rxBytes,
+                       uint8_t* inflightArena, size_t inflightBytes, uint8_t windowSize) {
+    transport = net;
+    clock = millisClock;
+    rxBuffer = rx;
+    rxSize = rxBytes;
+    arena = inflightArena;
+    arenaSize = inflightBytes;
+    window = windowSize == 0 ? 1 : (windowSize > MQTT_INFLIGHT_MAX ? MQTT_INFLIGHT_MAX : windowSize);
+    clearInflight();
+}
+
+void MqttClient::setMessageHandler(MessageFn handler, void* context) {
+    messageHandler = handler;
+    messageContext = context;
+}
+
+void MqttClient::setProtocol(uint8_t level) {
+    // Aliases are a v5 thing; packets still in the window keep their framing
+    protocol = level == 5 ? 5 : 4;
+    aliasCount = 0;
+}
+
+bool MqttClient::setUserProperty(const char* key, const char* value) {
+    if (key == nullptr || value == nullptr) {
+        userKeyLen = 0;
+        userValueLen = 0;
+        return true;
+    }
+
+    size_t keyLen = strlen(key), valueLen = strlen(value);
+    if (keyLen == 0 || keyLen + valueLen > MQTT_USER_PROPERTY_MAX) {
+        return false;
+    }
+    memcpy(userProperty, key, keyLen);
+    memcpy(userProperty + keyLen, value, valueLen);
+    userKeyLen = keyLen;
+    userValueLen = valueLen;
+    return true;
+}
+
+// ========================================
+// Session
+// ========================================
+
+bool MqttClient::connect(const char* clientId, uint16_t keepAliveS, bool cleanSession, uint32_t timeoutMs) {
+    size_t idLen = strlen(clientId);
+    if (transport == nullptr || idLen > MQTT_CLIENT_ID_MAX) {
+        return false;
+    }
+
+    // v5: Session Expiry keeps a non-clean session after the connection
+    bool v5 = protocol == 5;
+    size_t propsLen = v5 && !cleanSession && sessionExpiryS > 0 ? 5 : 0;
+
+    uint8_t packet[24 + MQTT_CLIENT_ID_MAX];
+    uint8_t* p = packet;
+    *p++ = MQTT_CONNECT;
+    p += encodeLength(p, 10 + (v5 ? 1 + propsLen : 0) + 2 + idLen);
+    p = writeU16(p, 4);
+    memcpy(p, "MQTT", 4);
+    p += 4;
+    *p++ = protocol;                            // 4 = 3.1.1, 5 = MQTT 5
+    *p++ = cleanSession ? 0x02 : 0x00;
+    p = writeU16(p, keepAliveS);
+    if (v5) {
+        *p++ = propsLen;
+        if (propsLen > 0) {
+            *p++ = MQTT_PROP_SESSION_EXPIRY;
+            p = writeU32(p, sessionExpiryS);
+        }
+    }
+    p = writeU16(p, idLen);
+    memcpy(p, clientId, idLen);
+    p += idLen;
+
+    rxState = RX_HEADER;
+    pingOutstanding = false;
+    sessionPresent = false;
+    returnCode = 0;
+    receiveMax = MQTT_INFLIGHT_MAX;
+    aliasLimit = 0;
+    aliasSent = 0;
+    keepAliveMs = keepAliveS * 1000UL;
+    connectTimeoutMs = timeoutMs;
+    connectStartedAt = now();
+    lastInAt = connectStartedAt;
+    state = MQTT_CONNECTING;
+
+    return sendPacket(packet, p - packet);
+}
+
+void MqttClient::disconnect() {
+    if (state == MQTT_CONNECTED) {
+        uint8_t packet[2] = { MQTT_DISCONNECT, 0 };
+        sendPacket(packet, sizeof(packet));
+    }
+    state = MQTT_IDLE;
+}
+
+void MqttClient::drop() {
+    state = MQTT_IDLE;
+    rxState = RX_HEADER;
+    pingOutstanding = false;
+}
+
+bool MqttClient::ping() {
+    if (state != MQTT_CONNECTED) {
+        return false;
+    }
+    if (pingOutstanding) {
+        return true;
+    }
+
+    uint8_t packet[2] = { MQTT_PINGREQ, 0 };
+    if (!sendPacket(packet, sizeof(packet))) {
+        return false;
+    }
+    pingOutstanding = true;
+    pingSentAt = now();
+    stats.pings++;
+    return true;
+}
+
+void MqttClient::lose(State reason) {
+    state = reason;
+    rxState = RX_HEADER;
+    pingOutstanding = false;
+}
+
+void MqttClient::clearInflight() {
+    inflightHead = 0;
+    inflightCount = 0;
+    arenaUsed = 0;
+}
+
+// ========================================
+// Poll
+// ========================================
+
+void MqttClient::poll() {
+    if (state != MQTT_CONNECTING && state != MQTT_CONNECTED) {
+        return;
+    }
+
+    while (readPacket()) {
+        handlePacket();
+        if (state != MQTT_CONNECTING && state != MQTT_CONNECTED) {
+            return;
+        }
+    }
+
+    if (!transport->connected()) {
+        lose(MQTT_LOST);
+        return;
+    }
+
+    unsigned long t = now();
+
+    if (state == MQTT_CONNECTING) {
+        if (t - connectStartedAt >= connectTimeoutMs) {
+            lose(MQTT_TIMEOUT);
+        }
+        return;
+    }
+
+    if (keepAliveMs == 0) {
+        return;
+    }
+
+    // Same rule as PubSubClient: ping once either direction went quiet,
+    // give up if the PINGRESP does not come back within another keepalive
+    if (pingOutstanding) {
+        if (t - pingSentAt >= keepAliveMs) {
+            lose(MQTT_TIMEOUT);
+        }
+    } else if (t - lastInAt >= keepAliveMs || t - lastOutAt >= keepAliveMs) {
+        uint8_t packet[2] = { MQTT_PINGREQ, 0 };
+        if (sendPacket(packet, sizeof(packet))) {
+            pingOutstanding = true;
+            pingSentAt = t;
+            stats.pings++;
+        }
+    }
+}
+
+bool MqttClient::readPacket() {
+    while (transport->available() > 0) {
+        if (rxState == RX_BODY) {
+            int n;
+            uint32_t want = rxRemaining - rxLength;
+            if (rxSkip) {
+                uint8_t discard[64];
+                n = transport->read(discard, want < sizeof(discard) ? want : sizeof(discard));
+            } else {
+                n = transport->read(rxBuffer + rxLength, want);
+            }
+            if (n <= 0) {
+                return false;
+            }
+
+            rxLength += n;
+            if (rxLength == rxRemaining) {
+                rxState = RX_HEADER;
+                if (!rxSkip) {
+                    return true;
+                }
+            }
+            continue;
+        }
+
+        uint8_t b;
+        if (transport->read(&b, 1) != 1) {
+            return false;
+        }
+
+        if (rxState == RX_HEADER) {
+            rxHeader = b;
+            rxRemaining = 0;
+            rxMultiplier = 1;
+            rxState = RX_LENGTH;
+            continue;
+        }
+
+        // RX_LENGTH: 1-4 byte variable length
+        rxRemaining += (b & 0x7F) * rxMultiplier;
+        if (b & 0x80) {
+            rxMultiplier *= 128;
+            if (rxMultiplier > 128UL * 128 * 128) {
+                lose(MQTT_LOST);    // Malformed, stream out of sync
+                return false;
+            }
+            continue;
+        }
+
+        rxLength = 0;
+        rxSkip = rxRemaining > rxSize;
+        if (rxSkip) {
+            stats.dropped++;
+        }
+        if (rxRemaining == 0) {
+            rxState = RX_HEADER;
+            return true;
+        }
+        rxState = RX_BODY;
+    }
+    return false;
+}
+
+void MqttClient::handlePacket() {
+    lastInAt = now();
+
+    switch (rxHeader & 0xF0) {
+        case MQTT_CONNACK:
+            handleConnack();
+            break;
+
+        case MQTT_PUBACK:
+            // v5 may add a reason code; it is still the end of that message
+            if (rxLength >= 3 && rxBuffer[2] >= 0x80) {
+                stats.rejected++;
+            }
+            if (rxLength >= 2) {
+                handleAck(readU16(rxBuffer));
+            }
+            break;
+
+        case MQTT_PUBLISH:
+            handlePublish();
+            break;
+
+        case MQTT_PINGRESP:
+            if (pingOutstanding) {
+                pingOutstanding = false;
+                stats.lastPingMs = lastInAt - pingSentAt;
+            }
+            break;
+
+        case MQTT_DISCONNECT:
+            // v5 broker closing the session, with a reason code
+            returnCode = rxLength >= 1 ? rxBuffer[0] : 0;
+            lose(MQTT_LOST);
+            break;
+
+        default:
+            break;      // SUBACK, anything unexpected
+    }
+}
+
+void MqttClient::handleConnack() {
+    if (state != MQTT_CONNECTING || rxLength < 2) {
+        return;
+    }
+    sessionPresent = rxBuffer[0] & 0x01;
+    returnCode = rxBuffer[1];
+    if (returnCode != 0) {
+        lose(MQTT_REFUSED);
+        return;
+    }
+
+    if (protocol == 5) {
+        const uint8_t* end = rxBuffer + rxLength;
+        uint32_t propsLen = 0;
+        size_t n = decodeLength(rxBuffer + 2, end, propsLen);
+        const uint8_t* p = rxBuffer + 2 + n;
+        if (n > 0 && propsLen <= (size_t)(end - p)) {
+            end = p + propsLen;
+        }
+
+        uint8_t id;
+        uint32_t value;
+        while (n > 0 && readProperty(p, end, id, value)) {
+            if (id == MQTT_PROP_TOPIC_ALIAS_MAX) {
+                aliasLimit = value < MQTT_TOPIC_ALIAS_MAX ? value : MQTT_TOPIC_ALIAS_MAX;
+            } else if (id == MQTT_PROP_RECEIVE_MAX && value > 0) {
+                receiveMax = value < MQTT_INFLIGHT_MAX ? value : MQTT_INFLIGHT_MAX;
+            } else if (id == MQTT_PROP_SERVER_KEEP_ALIVE) {
+                keepAliveMs = value * 1000UL;
+            }
+        }
+    }
+
+    state = MQTT_CONNECTED;
+    lastOutAt = lastInAt;
+    resendInflight();
+}
+
+void MqttClient::handlePublish() {
+    uint8_t qos = (rxHeader >> 1) & 0x03;
+    if (rxLength < 2) {
+        return;
+    }
+
+    uint16_t topicLen = readU16(rxBuffer);
+    size_t pos = 2 + topicLen;
+    uint16_t packetId = 0;
+    if (qos > 0) {
+        if (pos + 2 > rxLength) {
+            return;
+        }
+        packetId = readU16(rxBuffer + pos);
+        pos += 2;
+    }
+    if (protocol == 5 && pos < rxLength) {
+        // Properties are not used (no inbound aliases were offered)
+        uint32_t propsLen = 0;
+        size_t n = decodeLength(rxBuffer + pos, rxBuffer + rxLength, propsLen);
+        if (n == 0) {
+            return;
+        }
+        pos += n + propsLen;
+    }
+    if (pos > rxLength) {
+        return;
+    }
+
+    // Terminate the topic in place by moving it over its length field
+    memmove(rxBuffer, rxBuffer + 2, topicLen);
+    rxBuffer[topicLen] = '\0';
+
+    stats.received++;
+    if (messageHandler) {
+        messageHandler(messageContext, (char*)rxBuffer, rxBuffer + pos, rxLength - pos);
+    }
+
+    // QoS 2 is never requested (subscriptions are QoS 0 / 1)
+    if (qos == 1 && state == MQTT_CONNECTED) {
+        uint8_t ack[4] = { MQTT_PUBACK, 2, (uint8_t)(packetId >> 8), (uint8_t)(packetId & 0xFF) };
+        sendPacket(ack, sizeof(ack));
+    }
+}
+
+// ========================================
+// Publish
+// ========================================
+
+size_t MqttClient::propertiesSize() const {
+    // Without the topic alias (3 bytes when present); always < 128
+    size_t size = 0;
+    if (messageExpiryS > 0) {
+        size += 5;
+    }
+    if (userKeyLen > 0) {
+        size += 1 + 2 + userKeyLen + 2 + userValueLen;
+    }
+    return size;
+}
+
+size_t MqttClient::packetSize(size_t topicLen, size_t payloadLen, uint8_t qos) const {
+    // Upper bound: full topic, and an alias property in v5
+    uint32_t remaining = 2 + topicLen + (qos > 0 ? 2 : 0) + payloadLen;
+    if (protocol == 5) {
+        remaining += 1 + propertiesSize() + 3;
+    }
+    uint8_t lengthBytes = remaining < 128 ? 1 : remaining < 16384 ? 2 : remaining < 2097152 ? 3 : 4;
+    return 1 + lengthBytes + remaining;
+}
+
+size_t MqttClient::buildPublish(uint8_t* out, const char* topic, size_t topicLen,
+                                const uint8_t* payload, size_t len, uint8_t qos, bool retained,
+                                uint16_t packetId, uint8_t alias) {
+    size_t propsLen = protocol == 5 ? propertiesSize() + (alias ? 3 : 0) : 0;
+
+    uint8_t* p = out;
+    *p++ = MQTT_PUBLISH | (qos << 1) | (retained ? 0x01 : 0x00);
+    p += encodeLength(p, 2 + topicLen + (qos > 0 ? 2 : 0) + (protocol == 5 ? 1 + propsLen : 0) + len);
+    p = writeU16(p, topicLen);
+    memcpy(p, topic, topicLen);
+    p += topicLen;
+    if (qos > 0) {
+        p = writeU16(p, packetId);
+    }
+    if (protocol == 5) {
+        // The alias goes first: resendExpanded() relies on it
+        *p++ = propsLen;
+        if (alias) {
+            *p++ = MQTT_PROP_TOPIC_ALIAS;
+            p = writeU16(p, alias);
+        }
+        if (messageExpiryS > 0) {
+            *p++ = MQTT_PROP_MESSAGE_EXPIRY;
+            p = writeU32(p, messageExpiryS);
+        }
+        if (userKeyLen > 0) {
+            *p++ = MQTT_PROP_USER;
+            p = writeU16(p, userKeyLen);
+            memcpy(p, userProperty, userKeyLen);
+            p += userKeyLen;
+            p = writeU16(p, userValueLen);
+            memcpy(p, userProperty + userKeyLen, userValueLen);
+            p += userValueLen;
+        }
+    }
+    memcpy(p, payload, len);
+    p += len;
+    return p - out;
+}
+
+uint8_t MqttClient::aliasFor(const char* topic, size_t topicLen, bool& known) {
+    known = false;
+    for (uint8_t i = 0; i < aliasCount; i++) {
+        if (strcmp(aliasTopics[i], topic) == 0) {
+            if (i >= aliasLimit) {
+                return 0;       // Broker allows fewer aliases this time
+            }
+            known = aliasSent & (1u << i);
+            return i + 1;
+        }
+    }
+
+    if (aliasCount >= aliasLimit || topicLen > MQTT_TOPIC_ALIAS_LEN) {
+        return 0;
+    }
+    memcpy(aliasTopics[aliasCount], topic, topicLen + 1);
+    return ++aliasCount;
+}
+
+bool MqttClient::canPublish(size_t topicLen, size_t payloadLen) const {
+    return inflightCount < window && inflightCount < receiveMax &&
+           arenaUsed + packetSize(topicLen, payloadLen, 1) <= arenaSize;
+}
+
+uint32_t MqttClient::getAckWaitMs() const {
+    // Acked heads are released at once, so the head is the oldest waiting
+    if (inflightCount == 0) {
+        return 0;
+    }
+    return now() - inflight[inflightHead].sentAt;
+}
+
+bool MqttClient::publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos, bool retained) {
+    if (state != MQTT_CONNECTED) {
+        return false;
+    }
+
+    size_t topicLen = strlen(topic);
+
+    // v5: topic + alias the first time on this connection, then alias only
+    bool known = false;
+    uint8_t alias = protocol == 5 ? aliasFor(topic, topicLen, known) : 0;
+    size_t sendTopicLen = known ? 0 : topicLen;
+
+    if (qos == 0) {
+        // Built in the free end of the arena, gone once written
+        if (arenaUsed + packetSize(topicLen, len, 0) > arenaSize) {
+            return false;
+        }
+        size_t size = buildPublish(arena + arenaUsed, topic, sendTopicLen, payload, len, 0, retained, 0, alias);
+        if (!sendPacket(arena + arenaUsed, size)) {
+            return false;
+        }
+        if (alias) {
+            aliasSent |= 1u << (alias - 1);
+        }
+        stats.qos0++;
+        return true;
+    }
+
+    if (!canPublish(topicLen, len)) {
+        return false;
+    }
+
+    Inflight& entry = slot(inflightCount);
+    entry.packetId = allocatePacketId();
+    entry.acked = false;
+    entry.offset = arenaUsed;
+    entry.length = buildPublish(arena + arenaUsed, topic, sendTopicLen, payload, len, 1, retained,
+                                entry.packetId, alias);
+    entry.sentAt = now();
+    entry.alias = alias;
+    entry.aliasOnly = known;
+    arenaUsed += entry.length;
+    inflightCount++;
+    stats.published++;
+
+    // A failed write loses the connection; the copy is resent after reconnect
+    if (alias) {
+        aliasSent |= 1u << (alias - 1);
+    }
+    sendPacket(arena + entry.offset, entry.length);
+    return true;
+}
+
+uint16_t MqttClient::allocatePacketId() {
+    for (;;) {
+        uint16_t id = nextPacketId++;
+        if (nextPacketId == 0) {
+            nextPacketId = 1;
+        }
+
+        bool inUse = false;
+        for (uint8_t i = 0; i < inflightCount; i++) {
+            if (slot(i).packetId == id) {
+                inUse = true;
+                break;
+            }
+        }
+        if (!inUse) {
+            return id;
+        }
+    }
+}
+
+void MqttClient::handleAck(uint16_t packetId) {
+    for (uint8_t i = 0; i < inflightCount; i++) {
+        Inflight& entry = slot(i);
+        if (entry.packetId != packetId || entry.acked) {
+            continue;
+        }
+
+        entry.acked = true;
+        stats.acked++;
+        stats.lastAckAt = lastInAt;
+        stats.lastAckMs = lastInAt - entry.sentAt;
+        if (stats.lastAckMs > stats.maxAckMs) {
+            stats.maxAckMs = stats.lastAckMs;
+        }
+        releaseAcked();
+        return;
+    }
+}
+
+void MqttClient::releaseAcked() {
+    // Brokers ack QoS 1 in order, so this normally frees the head right away
+    bool released = false;
+    while (inflightCount > 0 && slot(0).acked) {
+        inflightHead = (inflightHead + 1) % MQTT_INFLIGHT_MAX;
+        inflightCount--;
+        released = true;
+    }
+
+    if (!released) {
+        return;
+    }
+    if (inflightCount == 0) {
+        arenaUsed = 0;
+        return;
+    }
+
+    uint32_t base = slot(0).offset;
+    memmove(arena, arena + base, arenaUsed - base);
+    arenaUsed -= base;
+    for (uint8_t i = 0; i < inflightCount; i++) {
+        slot(i).offset -= base;
+    }
+}
+
+void MqttClient::resendInflight() {
+    for (uint8_t i = 0; i < inflightCount && state == MQTT_CONNECTED; i++) {
+        Inflight& entry = slot(i);
+        if (entry.acked) {
+            continue;
+        }
+        arena[entry.offset] |= MQTT_FLAG_DUP;
+        entry.sentAt = now();
+
+        // The broker forgot our aliases with the old connection
+        bool sent;
+        uint16_t bit = entry.alias ? 1u << (entry.alias - 1) : 0;
+        if (entry.alias && (entry.aliasOnly ? !(aliasSent & bit) : entry.alias > aliasLimit)) {
+            sent = resendExpanded(entry);
+        } else {
+            sent = sendPacket(arena + entry.offset, entry.length);
+            if (entry.alias) {
+                aliasSent |= bit;
+            }
+        }
+        if (sent) {
+            stats.resent++;
+        }
+    }
+}
+
+bool MqttClient::resendExpanded(const Inflight& entry) {
+    // Same packet with the topic written back in, and without the alias
+    // if the broker now allows fewer. Two writes; only after reconnects.
+    const uint8_t* packet = arena + entry.offset;
+    const uint8_t* end = packet + entry.length;
+    uint32_t remaining;
+    const uint8_t* p = packet + 1 + decodeLength(packet + 1, end, remaining);
+    p += 2 + readU16(p);                        // Stored topic (may be empty)
+    const uint8_t* packetId = p;
+    uint8_t propsLen = packetId[2];
+    const uint8_t* props = packetId + 3;        // Alias property first
+    const uint8_t* rest = props + 3;
+
+    const char* topic = aliasTopics[entry.alias - 1];
+    size_t topicLen = strlen(topic);
+    bool keepAlias = entry.alias <= aliasLimit;
+    uint8_t newPropsLen = keepAlias ? propsLen : propsLen - 3;
+
+    uint8_t head[5 + 2 + MQTT_TOPIC_ALIAS_LEN + 2 + 1 + 3];
+    uint8_t* h = head;
+    *h++ = packet[0];
+    h += encodeLength(h, 2 + topicLen + 2 + 1 + (keepAlias ? 3 : 0) + (end - rest));
+    h = writeU16(h, topicLen);
+    memcpy(h, topic, topicLen);
+    h += topicLen;
+    memcpy(h, packetId, 2);
+    h += 2;
+    *h++ = newPropsLen;
+    if (keepAlias) {
+        memcpy(h, props, 3);
+        h += 3;
+        aliasSent |= 1u << (entry.alias - 1);
+    }
+
+    return sendPacket(head, h - head) && sendPacket(rest, end - rest);
+}
+
+// ========================================
+// Subscribe
+// ========================================
+
+bool MqttClient::subscribe(const char* topic, uint8_t qos) {
+    if (state != MQTT_CONNECTED) {
+        return false;
+    }
+
+    size_t topicLen = strlen(topic);
+    uint32_t remaining = 2 + (protocol == 5 ? 1 : 0) + 2 + topicLen + 1;
+    if (arenaUsed + remaining + 5 > arenaSize) {
+        return false;
+    }
+
+    uint8_t* p = arena + arenaUsed;
+    *p++ = MQTT_SUBSCRIBE;
+    p += encodeLength(p, remaining);
+    p = writeU16(p, allocatePacketId());
+    if (protocol == 5) {
+        *p++ = 0;           // No properties
+    }
+    p = writeU16(p, topicLen);
+    memcpy(p, topic, topicLen);
+    p += topicLen;
+    *p++ = qos > 1 ? 1 : qos;
+
+    return sendPacket(arena + arenaUsed, p - (arena + arenaUsed));
+}
+
+// ========================================
+// Helpers
+// ========================================
+
+bool MqttClient::sendPacket(const uint8_t* data, size_t len) {
+    if (transport->write(data, len) != len) {
+        lose(MQTT_LOST);
+        return false;
+    }
+    lastOutAt = now();
+    return true;
+}
+
+size_t MqttClient::encodeLength(uint8_t* out, uint32_t length) {
+    size_t n = 0;
+    do {
+        uint8_t b = length % 128;
+        length /= 128;
+        out[n++] = length > 0 ? (b | 0x80) : b;
+    } while (length > 0);
+    return n;
+}
@@ -1,17 +1,58 @@
 #define TINY_GSM_MODEM_SIM7600
 #include "mqtt_manager.h"
-#include "config.h"
+#include "queue_record.h"
+#include "metrics.h"
+
+// Outbox record: [flags][topic]\0[payload], flags bit 0 = retained.
+// Records starting with '{' are bare telemetry JSON from older firmware.
+#define OUTBOX_FLAG_RETAINED 0x01
+
+// Data budget estimates: one segment per MSS, every segment acknowledged
+#define DATA_TCP_MSS            1360
+#define MQTT_PUBLISH_OVERHEAD   9       // Fixed header, topic length, packet id
+#define MQTT_PUBACK_BYTES       4
+
+// IP + TCP headers under `len` bytes in one direction and the peer's ACKs
+static void countTcp(DataBudget* budget, DataDirection dir, size_t len) {
+    uint32_t segments = (len + DATA_TCP_MSS - 1) / DATA_TCP_MSS;
+    budget->count(DATA_TCP, dir, segments * DATA_TCP_OVERHEAD_BYTES);
+    budget->count(DATA_TCP, dir == DATA_UP ? DATA_DOWN : DATA_UP, segments * DATA_TCP_OVERHEAD_BYTES);
+}
 
 // ============================================================================
 // CONSTRUCTOR
 // ============================================================================
 
-MQTTManager::MQTTManager(Client& netClient)
-    : networkClient(netClient), mqttClient(netClient) {
+#if MQTT_USE_MODEM_STACK
+MQTTManager::MQTTManager(ModemAt& modemAt) : mqtt(modemAt) {
+#else
+MQTTManager::MQTTManager(AsyncGsmClient& netClient)
+#if MQTT_TLS_ENABLED
+    : networkClient(netClient), transport(netClient), tls(transport) {
+    tlsPending = false;
+#else
+    : networkClient(netClient), transport(netClient) {
+#endif
+#endif
     brokerPort = 0;
+    rxBuffer = nullptr;
+    arena = nullptr;
+    outbox = nullptr;
+    outboxBuffer = nullptr;
+    dataBudget = nullptr;
+    replayPaused = false;
+    subscriptionCount = 0;
+    messageCallback = nullptr;
     connected = false;
+    connecting = false;
+    socketOpen = false;
     publishCount = 0;
     failedCount = 0;
+    spilledCount = 0;
+    lastQos0At = 0;
+    echoSubscribed = false;
+    echoSentAt = 0;
+    lastEchoMs = 0;
 }
 
 // ============================================================================
@@ -22,11 +63,41 @@ bool MQTTManager::begin(const char* brokerAddr, uint16_t port, const char* clien
     brokerHost = brokerAddr;
     brokerPort = port;
     clientId = String(clientIdStr);
+    telemetryTopic = String(MQTT_TOPIC) + "/" + clientId + "/telemetry";
+    echoTopic = String(MQTT_TOPIC) + "/" + clientId + "/echo";
+
+    if (rxBuffer == nullptr) {
+        rxBuffer = (uint8_t*)malloc(MQTT_MAX_PACKET_SIZE);
+        arena = (uint8_t*)malloc(MQTT_INFLIGHT_BYTES);
+        if (rxBuffer == nullptr || arena == nullptr) {
+            Serial.println(F("[MQTT] ❌ Failed to allocate buffers"));
+            return false;
+        }
+    }
 
-    mqttClient.setServer(brokerHost.c_str(), brokerPort);
-    mqttClient.setKeepAlive(MQTT_KEEP_ALIVE);
-    mqttClient.setSocketTimeout(MQTT_SOCKET_TIMEOUT);  // Set via platformio.ini build_flags
-    mqttClient.setBufferSize(MQTT_MAX_PACKET_SIZE);    // Set via platformio.ini build_flags
+#if MQTT_USE_MODEM_STACK
+    mqtt.setServer(brokerHost.c_str(), brokerPort);
+    mqtt.setTls(MQTT_TLS_ENABLED, MQTT_TLS_VERIFY ? MQTT_TLS_MODEM_CA_FILE : "");
+    mqtt.begin(millis, rxBuffer, MQTT_MAX_PACKET_SIZE,
+               arena, MQTT_INFLIGHT_BYTES, MQTT_INFLIGHT_WINDOW);
+#elif MQTT_TLS_ENABLED
+    if (!beginTls()) {
+        brokerPort = 0;     // Not connecting in plaintext instead
+        return false;
+    }
+    mqtt.begin(&tls, millis, rxBuffer, MQTT_MAX_PACKET_SIZE,
+               arena, MQTT_INFLIGHT_BYTES, MQTT_INFLIGHT_WINDOW);
+#else
+    mqtt.begin(&transport, millis, rxBuffer, MQTT_MAX_PACKET_SIZE,
+               arena, MQTT_INFLIGHT_BYTES, MQTT_INFLIGHT_WINDOW);
+#endif
+#if !MQTT_USE_MODEM_STACK
+    mqtt.setProtocol(MQTT_PROTOCOL_VERSION);
+    mqtt.setSessionExpiry(MQTT_SESSION_EXPIRY_S);
+    mqtt.setMessageExpiry(MQTT_MESSAGE_EXPIRY_S);
+    mqtt.setUserProperty(MQTT_SCHEMA_VERSION[0] ? "v" : nullptr, MQTT_SCHEMA_VERSION);
+#endif
+    mqtt.setMessageHandler(onMessage, this);
 
     #if DEBUG_MQTT
     Serial.print(F("[MQTT] Initialized for "));
@@ -37,28 +108,106 @@ bool MQTTManager::begin(const char* brokerAddr, uint16_t port, const char* clien
     Serial.println(clientId);
     Serial.print(F("[MQTT] Max packet size: "));
     Serial.println(MQTT_MAX_PACKET_SIZE);
-    Serial.print(F("[MQTT] Buffer size: "));
-    Serial.println(mqttClient.getBufferSize());
-    Serial.print(F("[MQTT] Socket timeout: "));
-    Serial.print(MQTT_SOCKET_TIMEOUT);
-    Serial.println(F(" seconds"));
+    Serial.println(MQTT_USE_MODEM_STACK ? F("[MQTT] Backend: SIM7600 AT+CMQTT") : F("[MQTT] Backend: MqttClient over TCP socket"));
+    Serial.println(MQTT_TLS_ENABLED ? F("[MQTT] TLS: on") : F("[MQTT] TLS: off"));
+    Serial.printf("[MQTT] QoS 1 window: %u messages / %u bytes, clean session: %s\n",
+                  (unsigned)mqtt.getWindow(), (unsigned)MQTT_INFLIGHT_BYTES,
+                  MQTT_CLEAN_SESSION ? "yes" : "no");
     #endif
 
     return true;
 }
 
+void MQTTManager::setOutbox(StorageEngine* engine) {
+    if (engine != nullptr && outboxBuffer == nullptr) {
+        outboxBuffer = (uint8_t*)malloc(QUEUE_RECORD_MAX_PAYLOAD);
+        if (outboxBuffer == nullptr) {
+            Serial.println(F("[MQTT] ❌ Failed to allocate outbox buffer"));
+            return;
+        }
+    }
+    outbox = engine;
+}
+
+#if !MQTT_USE_MODEM_STACK && MQTT_TLS_ENABLED
+bool MQTTManager::beginTls() {
+    // PEM is parsed into mbedTLS and not needed afterwards
+    char* caPem = nullptr;
+    if (MQTT_TLS_VERIFY) {
+        FILE* f = fopen(MQTT_TLS_CA_FILE, "rb");
+        long size = 0;
+        if (f != nullptr && fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) > 0) {
+            caPem = (char*)malloc(size + 1);
+            rewind(f);
+            if (caPem != nullptr && fread(caPem, 1, size, f) == (size_t)size) {
+                caPem[size] = '\0';
+            } else {
+                free(caPem);
+                caPem = nullptr;
+            }
+        }
+        if (f != nullptr) {
+            fclose(f);
+        }
+        if (caPem == nullptr) {
+            Serial.println(F("[MQTT] ❌ TLS: no CA certificate at " MQTT_TLS_CA_FILE));
+            return false;
+        }
+    }
+
+    bool ok = tls.begin(caPem, MQTT_TLS_SERVER_NAME[0] ? MQTT_TLS_SERVER_NAME : nullptr,
+                        MQTT_TLS_SESSION_FILE, millis, MQTT_TLS_HANDSHAKE_TIMEOUT_MS);
+    free(caPem);
+
+    if (!ok) {
+        Serial.printf("[MQTT] ❌ TLS setup failed (-0x%04X)\n", -tls.getStats().lastError);
+    } else if (!MQTT_TLS_VERIFY) {
+        Serial.println(F("[MQTT] ⚠️ TLS without broker verification"));
+    } else if (tls.hasSession()) {
+        Serial.println(F("[MQTT] TLS session from flash, next connect resumes"));
+    }
+    return ok;
+}
+#endif
+
+void MQTTManager::setDataBudget(DataBudget* budget) {
+    dataBudget = budget;
+#if !MQTT_USE_MODEM_STACK
+    transport.budget = budget;
+#endif
+}
+
+#if !MQTT_USE_MODEM_STACK
+int MQTTManager::Transport::read(uint8_t* buf, size_t len) {
+    int n = client.read(buf, len);
+    if (n > 0 && budget != nullptr) {
+        budget->count(DATA_MQTT, DATA_DOWN, n);
+        countTcp(budget, DATA_DOWN, n);
+    }
+    return n;
+}
+
+size_t MQTTManager::Transport::write(const uint8_t* buf, size_t len) {
+    size_t n = client.write(buf, len);
+    if (n > 0 && budget != nullptr) {
+        budget->count(DATA_MQTT, DATA_UP, n);
+        countTcp(budget, DATA_UP, n);
+    }
+    return n;
+}
+#endif
+
 // ============================================================================
 // CONNECT / DISCONNECT
 // ============================================================================
 
-bool MQTTManager::connect() {
-    if (brokerPort == 0) {
+bool MQTTManager::startConnect() {
+    if (brokerPort == 0 || rxBuffer == nullptr) {
         Serial.println(F("[MQTT] Broker not configured"));
         return false;
     }
 
-    if (mqttClient.connected()) {
-        connected = true;
+    if (connecting) {
         return true;
     }
 
@@ -67,30 +216,153 @@ bool MQTTManager::connect() {
     Serial.print(F(":"));
     Serial.println(brokerPort);
 
-    bool result = mqttClient.connect(clientId.c_str());
-    logConnectionState(result);
+    drop();
 
-    if (result) {
-        connected = true;
-    } else {
-        connected = false;
+#if MQTT_USE_MODEM_STACK
+    // The modem opens the TCP connection itself as part of CMQTTCONNECT
+    if (!mqtt.connect(clientId.c_str(), MQTT_KEEP_ALIVE, MQTT_CLEAN_SESSION,
+                      MODEM_SOCKET_OPEN_TIMEOUT_MS + MQTT_CONNACK_TIMEOUT_S * 1000UL)) {
+        Serial.println(F("[MQTT] ❌ Modem busy, connect not started"));
         failedCount++;
+        return false;
+    }
+    socketOpen = true;
+#else
+    if (!networkClient.startOpen(brokerHost.c_str(), brokerPort, MODEM_SOCKET_OPEN_TIMEOUT_MS)) {
+        Serial.println(F("[MQTT] ❌ Modem busy, socket not opened"));
+        failedCount++;
+        return false;
     }
+    socketOpen = false;
+#endif
 
-    return result;
+    connecting = true;
+    return true;
+}
+
+MQTTManager::ConnectResult MQTTManager::pollConnect() {
+    if (!connecting) {
+        return CONNECT_IDLE;
+    }
+
+#if !MQTT_USE_MODEM_STACK
+    if (!socketOpen) {
+        AsyncGsmClient::OpResult op = networkClient.pollOp();
+        if (op == AsyncGsmClient::OP_PENDING) {
+            return CONNECT_PENDING;
+        }
+
+        if (op != AsyncGsmClient::OP_DONE) {
+            Serial.println(F("[MQTT] ❌ Socket open failed"));
+            connecting = false;
+            connected = false;
+            failedCount++;
+            return CONNECT_FAILED;
+        }
+
+        socketOpen = true;
+        if (dataBudget != nullptr) {
+            // SYN, SYN-ACK, ACK
+            dataBudget->count(DATA_TCP, DATA_UP, 2 * DATA_TCP_OVERHEAD_BYTES);
+            dataBudget->count(DATA_TCP, DATA_DOWN, DATA_TCP_OVERHEAD_BYTES);
+        }
+#if MQTT_TLS_ENABLED
+        if (!tls.startHandshake()) {
+            Serial.println(F("[MQTT] ❌ TLS handshake not started"));
+            connecting = false;
+            failedCount++;
+            return CONNECT_FAILED;
+        }
+        tlsPending = true;
+    }
+
+    if (tlsPending) {
+        TlsTransport::HandshakeResult hs = tls.pollHandshake();
+        if (hs == TlsTransport::TLS_PENDING) {
+            return CONNECT_PENDING;
+        }
+
+        tlsPending = false;
+        if (hs == TlsTransport::TLS_FAILED) {
+            Serial.printf("[MQTT] ❌ TLS handshake failed (-0x%04X)\n", -tls.getStats().lastError);
+            connecting = false;
+            failedCount++;
+            return CONNECT_FAILED;
+        }
+#endif
+        if (!mqtt.connect(clientId.c_str(), MQTT_KEEP_ALIVE, MQTT_CLEAN_SESSION,
+                          MQTT_CONNACK_TIMEOUT_S * 1000UL)) {
+            connecting = false;
+            logConnectionState(false);
+            failedCount++;
+            return CONNECT_FAILED;
+        }
+    }
+#endif
+
+    mqtt.poll();
+    if (mqtt.getState() == MqttClient::MQTT_CONNECTING) {
+        return CONNECT_PENDING;
+    }
+
+    connecting = false;
+    connected = mqtt.isConnected();
+    logConnectionState(connected);
+
+    if (!connected) {
+#if !MQTT_USE_MODEM_STACK
+        // 3.1.1 brokers answer a v5 CONNECT with "unacceptable protocol
+        // version" (1), v5 brokers that refuse it with 0x84
+        uint8_t rc = mqtt.getReturnCode();
+        if (MQTT_PROTOCOL_FALLBACK && mqtt.getProtocol() == 5 &&
+            mqtt.getState() == MqttClient::MQTT_REFUSED && (rc == 0x01 || rc == 0x84)) {
+            Serial.println(F("[MQTT] ⚠️ Broker refused MQTT 5, using 3.1.1 from now on"));
+            mqtt.setProtocol(4);
+        }
+#endif
+        failedCount++;
+        return CONNECT_FAILED;
+    }
+
+    // A persistent session keeps the subscriptions on the broker
+    if (!mqtt.isSessionPresent()) {
+        resubscribe();
+        echoSubscribed = false;
+    }
+    if (MQTT_ECHO_ENABLED && !echoSubscribed) {
+        echoSubscribed = mqtt.subscribe(echoTopic.c_str(), 0);
+    }
+    echoSentAt = 0;
+    return CONNECT_OK;
 }
 
 bool MQTTManager::disconnect() {
-    if (mqttClient.connected()) {
-        mqttClient.disconnect();
+    if (mqtt.isConnected()) {
+        mqtt.disconnect();
+#if !MQTT_USE_MODEM_STACK
+        networkClient.stop();
+#endif
+#if !MQTT_USE_MODEM_STACK && MQTT_TLS_ENABLED
+        tls.reset();
+#endif
     }
 
     connected = false;
     return true;
 }
 
-bool MQTTManager::reconnect() {
-    return connect();
+void MQTTManager::drop() {
+    // No DISCONNECT packet: writing to a dead link blocks on CIPSEND.
+    // Unacknowledged messages stay in the window for the next session.
+#if !MQTT_USE_MODEM_STACK
+    networkClient.abandon();
+#endif
+#if !MQTT_USE_MODEM_STACK && MQTT_TLS_ENABLED
+    tls.reset();
+    tlsPending = false;
+#endif
+    mqtt.drop();
+    connected = false;
 }
 
 // ============================================================================
@@ -98,76 +370,216 @@ bool MQTTManager::reconnect() {
 // ============================================================================
 
 bool MQTTManager::isConnected() {
-    connected = mqttClient.connected();
+    connected = mqtt.isConnected();
     return connected;
 }
 
 void MQTTManager::loop() {
-    mqttClient.loop();
-    connected = mqttClient.connected();
+    mqtt.poll();
+    connected = mqtt.isConnected();
+
+    if (connected && !replayPaused) {
+        drainOutbox();
+    }
+}
+
+unsigned long MQTTManager::getLastDeliveryAt() const {
+    unsigned long lastAckAt = mqtt.getStats().lastAckAt;
+    return lastAckAt > lastQos0At ? lastAckAt : lastQos0At;
+}
+
+void MQTTManager::startLivenessCheck() {
+    if (!mqtt.isConnected()) {
+        return;
+    }
+
+    mqtt.ping();
+
+    // Our own QoS 0 message coming back proves the whole broker path
+    if (echoSubscribed) {
+        char nonce[12];
+        unsigned long t = millis();
+        int n = snprintf(nonce, sizeof(nonce), "%lu", t);
+        if (mqtt.publish(echoTopic.c_str(), (const uint8_t*)nonce, n, 0, false)) {
+            countTopic(echoTopic.c_str(), DATA_UP, n);
+            echoSentAt = t;
+        }
+    }
 }
 
 // ============================================================================
 // PUBLISH HELPERS
 // ============================================================================
 
-bool MQTTManager::publish(const char* topic, const char* payload, bool retained) {
-    if (!mqttClient.connected()) {
-        connected = false;
-        failedCount++;
-        #if DEBUG_MQTT
-        Serial.println(F("[MQTT] Cannot publish - not connected"));
-        #endif
-        return false;
-    }
+bool MQTTManager::publish(const char* topic, const char* payload, bool retained, uint8_t qos) {
+    ScopedMetric timer(METRIC_MQTT_PUBLISH);
+    size_t len = strlen(payload);
 
     #if DEBUG_MQTT
     Serial.print(F("[MQTT] Publishing to "));
     Serial.print(topic);
     Serial.print(F(" ("));
-    Serial.print(strlen(payload));
+    Serial.print(len);
     Serial.println(F(" bytes)"));
     #endif
 
-    // Retry mechanism: Try up to 3 times
-    const int maxRetries = 3;
-    bool ok = false;
-    
-    for (int attempt = 1; attempt <= maxRetries; attempt++) {
-        ok = mqttClient.publish(topic, payload, retained);
-        
-        if (ok) {
+    if (qos == 0) {
+        if (mqtt.isConnected() && mqtt.publish(topic, (const uint8_t*)payload, len, 0, retained)) {
+            countTopic(topic, DATA_UP, len);
             publishCount++;
-            #if DEBUG_MQTT
-            if (attempt > 1) {
-                Serial.printf("[MQTT] ✅ Success on attempt %d\n", attempt);
-            }
-            #endif
-            break;
-        } else {
-            #if DEBUG_MQTT
-            Serial.printf("[MQTT] ❌ Attempt %d/%d failed, state=%d\n", 
-                         attempt, maxRetries, mqttClient.state());
-            #endif
-            
-            if (attempt < maxRetries) {
-                delay(500); // Wait 500ms before retry
-                mqttClient.loop(); // Process any pending MQTT traffic
-            }
+            lastQos0At = millis();
+            return true;
         }
-    }
-    
-    if (!ok) {
+        connected = mqtt.isConnected();
         failedCount++;
+        countMetric(COUNTER_PUBLISH_FAIL);
+        return false;
     }
 
-    return ok;
+    // Straight into the window unless older messages are still waiting
+    // (or held back while replay is paused)
+    if (mqtt.isConnected() && (outboxEmpty() || replayPaused) && mqtt.canPublish(strlen(topic), len)) {
+        mqtt.publish(topic, (const uint8_t*)payload, len, 1, retained);
+        countTopic(topic, DATA_UP, len);
+        publishCount++;
+        return true;
+    }
+
+    if (spill(topic, payload, len, retained)) {
+        spilledCount++;
+        countMetric(COUNTER_PUBLISH_SPILL);
+        #if DEBUG_MQTT
+        Serial.printf("[MQTT] Window full or offline, queued (%lu waiting)\n",
+                      (unsigned long)outbox->count());
+        #endif
+        return true;
+    }
+
+    #if DEBUG_MQTT
+    Serial.println(F("[MQTT] ❌ Dropped - window full and no outbox"));
+    #endif
+    failedCount++;
+    countMetric(COUNTER_PUBLISH_FAIL);
+    return false;
 }
 
-bool MQTTManager::publish(const char* topic, JsonDocument& doc, bool retained) {
+bool MQTTManager::publish(const char* topic, JsonDocument& doc, bool retained, uint8_t qos) {
     String payload;
-    serializeJson(doc, payload);
-    return publish(topic, payload.c_str(), retained);
+    {
+        ScopedMetric timer(METRIC_JSON_ENCODE);
+        serializeJson(doc, payload);
+    }
+    return publish(topic, payload.c_str(), retained, qos);
+}
+
+bool MQTTManager::canPublish(size_t payloadLen) {
+    return mqtt.isConnected() && outboxEmpty() && mqtt.canPublish(0, payloadLen);
+}
+
+// ============================================================================
+// OUTBOX
+// ============================================================================
+
+bool MQTTManager::outboxEmpty() {
+    return outbox == nullptr || outbox->count() == 0;
+}
+
+bool MQTTManager::spill(const char* topic, const char* payload, size_t len, bool retained) {
+    if (outbox == nullptr || outboxBuffer == nullptr) {
+        return false;
+    }
+
+    size_t topicLen = strlen(topic);
+    size_t recordLen = 1 + topicLen + 1 + len;
+    if (recordLen > QUEUE_RECORD_MAX_PAYLOAD) {
+        return false;
+    }
+
+    outboxBuffer[0] = retained ? OUTBOX_FLAG_RETAINED : 0;
+    memcpy(outboxBuffer + 1, topic, topicLen + 1);
+    memcpy(outboxBuffer + 1 + topicLen + 1, payload, len);
+    return outbox->push(outboxBuffer, recordLen);
+}
+
+void MQTTManager::drainOutbox() {
+    if (outbox == nullptr || outboxBuffer == nullptr) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < MQTT_OUTBOX_BATCH; i++) {
+        size_t len = outbox->peekLength();
+        if (len == 0) {
+            return;
+        }
+
+        // Upper bound for both record layouts, checked before the record
+        // leaves the queue
+        if (!mqtt.canPublish(telemetryTopic.length(), len + 2)) {
+            return;
+        }
+
+        // RAM records publish in place; file records are read out first
+        const uint8_t* record = outbox->peek(len);
+        if (record != nullptr) {
+            publishRecord(record, len);
+            outbox->skip();
+        } else if (outbox->pop(outboxBuffer, QUEUE_RECORD_MAX_PAYLOAD, len)) {
+            publishRecord(outboxBuffer, len);
+        } else if (len > QUEUE_RECORD_MAX_PAYLOAD) {
+            // Larger than any record we queue - would block the outbox forever
+            outbox->skip();
+            failedCount++;
+        } else {
+            return;  // Read error, try again next loop
+        }
+    }
+}
+
+void MQTTManager::publishRecord(const uint8_t* record, size_t len) {
+    if (record[0] == '{') {
+        mqtt.publish(telemetryTopic.c_str(), record, len, 1, false);
+        countTopic(telemetryTopic.c_str(), DATA_UP, len);
+        publishCount++;
+        countMetric(COUNTER_PUBLISH_REPLAY);
+        return;
+    }
+
+    const uint8_t* end = (const uint8_t*)memchr(record + 1, '\0', len - 1);
+    if (end == nullptr) {
+        failedCount++;      // Not a record we wrote, drop it
+        return;
+    }
+
+    size_t payloadOffset = end - record + 1;
+    mqtt.publish((const char*)record + 1, record + payloadOffset, len - payloadOffset,
+                 1, record[0] & OUTBOX_FLAG_RETAINED);
+    countTopic((const char*)record + 1, DATA_UP, len - payloadOffset);
+    publishCount++;
+    countMetric(COUNTER_PUBLISH_REPLAY);
+}
+
+// ============================================================================
+// DATA BUDGET
+// ============================================================================
+
+void MQTTManager::countTopic(const char* topic, DataDirection dir, size_t payloadLen) {
+    if (dataBudget == nullptr) {
+        return;
+    }
+
+    size_t topicLen = strlen(topic);
+    dataBudget->countTopic(topic, dir, topicLen + payloadLen);
+
+#if MQTT_USE_MODEM_STACK
+    // The modem's bytes are not visible here: estimate the PUBLISH, its
+    // PUBACK and the TCP segments under both
+    size_t packetLen = MQTT_PUBLISH_OVERHEAD + topicLen + payloadLen;
+    DataDirection back = dir == DATA_UP ? DATA_DOWN : DATA_UP;
+    dataBudget->count(DATA_MQTT, dir, packetLen);
+    dataBudget->count(DATA_MQTT, back, MQTT_PUBACK_BYTES);
+    countTcp(dataBudget, dir, packetLen);
+    countTcp(dataBudget, back, MQTT_PUBACK_BYTES);
+#endif
 }
 
 // ============================================================================
@@ -175,11 +587,18 @@ bool MQTTManager::publish(const char* topic, JsonDocument& doc, bool retained) {
 // ============================================================================
 
 bool MQTTManager::subscribe(const char* topic) {
-    if (!mqttClient.connected()) {
-        return false;
+    bool known = false;
+    for (uint8_t i = 0; i < subscriptionCount; i++) {
+        if (subscriptions[i] == topic) {
+            known = true;
+            break;
+        }
+    }
+    if (!known && subscriptionCount < MQTT_MAX_SUBSCRIPTIONS) {
+        subscriptions[subscriptionCount++] = topic;
     }
 
-    bool ok = mqttClient.subscribe(topic);
+    bool ok = mqtt.subscribe(topic, 1);
 
     #if DEBUG_MQTT
     Serial.print(F("[MQTT] Subscribe "));
@@ -190,8 +609,39 @@ bool MQTTManager::subscribe(const char* topic) {
     return ok;
 }
 
+void MQTTManager::resubscribe() {
+    for (uint8_t i = 0; i < subscriptionCount; i++) {
+        mqtt.subscribe(subscriptions[i].c_str(), 1);
+    }
+
+    #if DEBUG_MQTT
+    if (subscriptionCount > 0) {
+        Serial.printf("[MQTT] New session, re-subscribed %u topics\n", subscriptionCount);
+    }
+    #endif
+}
+
 void MQTTManager::setCallback(void (*callback)(char*, uint8_t*, unsigned int)) {
-    mqttClient.setCallback(callback);
+    messageCallback = callback;
+}
+
+void MQTTManager::onMessage(void* context, char* topic, uint8_t* payload, size_t len) {
+    MQTTManager* self = static_cast<MQTTManager*>(context);
+    self->countTopic(topic, DATA_DOWN, len);
+
+    if (self->echoTopic == topic) {
+        char nonce[12];
+        int n = snprintf(nonce, sizeof(nonce), "%lu", self->echoSentAt);
+        if (self->echoSentAt != 0 && len == (size_t)n && memcmp(payload, nonce, n) == 0) {
+            self->lastEchoMs = millis() - self->echoSentAt;
+            self->echoSentAt = 0;
+        }
+        return;
+    }
+
+    if (self->messageCallback) {
+        self->messageCallback(topic, payload, len);
+    }
 }
 
 // ============================================================================
@@ -199,6 +649,8 @@ void MQTTManager::setCallback(void (*callback)(char*, uint8_t*, unsigned int)) {
 // ============================================================================
 
 void MQTTManager::printStatus() {
+    const MqttSession::Stats& stats = mqtt.getStats();
+
     Serial.println(F("\n========== MQTT STATUS =========="));
     Serial.print(F("Broker: "));
     Serial.print(brokerHost);
@@ -207,21 +659,53 @@ void MQTTManager::printStatus() {
     Serial.print(F("Client ID: "));
     Serial.println(clientId);
     Serial.print(F("Connected: "));
-    Serial.println(mqttClient.connected() ? F("Yes") : F("No"));
+    Serial.println(mqtt.isConnected() ? F("Yes") : F("No"));
     Serial.print(F("State: "));
-    Serial.println(mqttClient.state());
+    Serial.println(mqtt.getState());
     Serial.print(F("Published: "));
     Serial.println(publishCount);
     Serial.print(F("Failed: "));
     Serial.println(failedCount);
+    Serial.printf("In flight: %u/%u (%u bytes)\n", mqtt.getInflightCount(),
+                  mqtt.getWindow(), (unsigned)mqtt.getInflightBytes());
+    Serial.printf("Acked: %lu, resent: %lu, last ack %lu ms (max %lu ms)\n",
+                  (unsigned long)stats.acked, (unsigned long)stats.resent,
+                  (unsigned long)stats.lastAckMs, (unsigned long)stats.maxAckMs);
+    Serial.printf("Liveness: ping %lu ms, echo %lu ms, oldest unacked %lu ms\n",
+                  (unsigned long)stats.lastPingMs, (unsigned long)lastEchoMs,
+                  (unsigned long)mqtt.getAckWaitMs());
+#if !MQTT_USE_MODEM_STACK && MQTT_TLS_ENABLED
+    const TlsTransport::Stats& ts = tls.getStats();
+    Serial.printf("TLS: %lu handshakes, %lu resumed, %lu failed (last error -0x%04X)\n",
+                  (unsigned long)ts.handshakes, (unsigned long)ts.resumed,
+                  (unsigned long)ts.failed, -ts.lastError);
+#endif
+    Serial.printf("Outbox: %lu waiting, %lu spilled%s\n",
+                  outbox ? (unsigned long)outbox->count() : 0UL, spilledCount,
+                  replayPaused ? " (replay paused)" : "");
     Serial.println(F("=================================\n"));
 }
 
 void MQTTManager::logConnectionState(bool result) {
     if (result) {
-        Serial.println(F("[MQTT] ✅ Connected"));
+        Serial.print(F("[MQTT] ✅ Connected"));
+        Serial.print(mqtt.isSessionPresent() ? F(" (session resumed)") : F(""));
+#if !MQTT_USE_MODEM_STACK
+        if (mqtt.getProtocol() == 5) {
+            Serial.printf(" MQTT 5, %u topic aliases", mqtt.getTopicAliasLimit());
+        }
+#if MQTT_TLS_ENABLED
+        const TlsTransport::Stats& ts = tls.getStats();
+        Serial.printf(", TLS %s in %lu ms (%lu B up, %lu B down)",
+                      tls.wasResumed() ? "resumed" : "full handshake", (unsigned long)ts.lastHandshakeMs,
+                      (unsigned long)ts.lastBytesUp, (unsigned long)ts.lastBytesDown);
+#endif
+#endif
+        Serial.println();
     } else {
         Serial.print(F("[MQTT] ❌ Failed, state="));
-        Serial.println(mqttClient.state());
+        Serial.print(mqtt.getState());
+        Serial.print(F(" rc="));
+        Serial.println(mqtt.getReturnCode());
     }
 }
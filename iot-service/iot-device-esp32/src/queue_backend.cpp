@@ -0,0 +1,100 @@
+#include "queue_backend.h"
+#include <string.h>
+#include <sys/stat.h>
+
+// ============================================================================
+// FILE BACKEND
+// ============================================================================
+
+FileQueueBackend::FileQueueBackend(const Config& cfg) {
+    config = cfg;
+    sinkFailures = 0;
+}
+
+bool FileQueueBackend::mount() {
+    if (log.isOpen()) {
+        return true;
+    }
+
+    if (!mountFilesystem()) {
+        return false;
+    }
+
+    if (!log.begin(config.dir, config.segmentSize, config.maxSegments, config.blockSize,
+                   config.stagingSize, config.durabilityMs, config.millisFn, config.microsFn)) {
+        return false;
+    }
+
+    sinkFailures = log.getWriter().getStats().sinkFailures;
+    return true;
+}
+
+void FileQueueBackend::unmount(SalvageFn salvage, void* context) {
+    log.abandon(salvage, context);
+}
+
+bool FileQueueBackend::probe() {
+    if (!log.isOpen()) {
+        return false;
+    }
+
+    // Any failed flush (including age flushes in poll) means the media is gone
+    if (log.getWriter().getStats().sinkFailures != sinkFailures) {
+        return false;
+    }
+
+    struct stat st;
+    return stat(config.dir, &st) == 0;
+}
+
+bool FileQueueBackend::push(const uint8_t* data, size_t len) {
+    return log.append(data, len);
+}
+
+// ============================================================================
+// RAM BACKEND
+// ============================================================================
+
+RamQueueBackend::RamQueueBackend(size_t psram, size_t internal, size_t slab) {
+    psramBytes = psram;
+    internalBytes = internal;
+    slabSize = slab;
+}
+
+bool RamQueueBackend::mount() {
+    if (ring.isReady()) {
+        return true;
+    }
+
+    // Big arena when the module has PSRAM, small one in internal RAM otherwise
+    if (ring.begin(psramBytes, slabSize, true) && ring.isInPsram()) {
+        return true;
+    }
+    return ring.begin(internalBytes, slabSize, false);
+}
+
+void RamQueueBackend::unmount(SalvageFn salvage, void* context) {
+    // RAM does not fail; only used when the queue is torn down
+    size_t len;
+    const uint8_t* record;
+    while (salvage && (record = ring.peek(len)) != nullptr) {
+        salvage(context, record, len);
+        ring.pop();
+    }
+    ring.end();
+}
+
+size_t RamQueueBackend::peekLength() {
+    size_t len;
+    ring.peek(len);
+    return len;
+}
+
+bool RamQueueBackend::pop(uint8_t* buf, size_t capacity, size_t& len) {
+    const uint8_t* record = ring.peek(len);
+    if (record == nullptr || len > capacity) {
+        return false;
+    }
+    memcpy(buf, record, len);
+    return ring.pop();
+}
@@ -0,0 +1,748 @@
+#include "record_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// ============================================================================
+// RECORD LOG IMPLEMENTATION
+// ============================================================================
+
+#define CURSOR_FILE_NAME   "cursor"
+#define CURSOR_SLOT_SIZE   16
+#define SEGMENT_SUFFIX     ".seg"
+#define SCAN_CHUNK_SIZE    256
+
+namespace {
+    inline void putU32(uint8_t* out, uint32_t value) {
+        out[0] = value & 0xFF;
+        out[1] = (value >> 8) & 0xFF;
+        out[2] = (value >> 16) & 0xFF;
+        out[3] = (value >> 24) & 0xFF;
+    }
+
+    inline uint32_t getU32(const uint8_t* in) {
+        return (uint32_t)in[0] | ((uint32_t)in[1] << 8) |
+               ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+    }
+
+    // "0000002A.seg" -> 0x2A
+    bool parseSegmentName(const char* name, uint32_t& firstSeq) {
+        if (strlen(name) != 8 + strlen(SEGMENT_SUFFIX) ||
+            strcmp(name + 8, SEGMENT_SUFFIX) != 0) {
+            return false;
+        }
+        char* end = nullptr;
+        firstSeq = strtoul(name, &end, 16);
+        return end == name + 8;
+    }
+
+    uint32_t fileSizeOf(const char* path) {
+        struct stat st;
+        if (stat(path, &st) != 0) {
+            return 0;
+        }
+        return (uint32_t)st.st_size;
+    }
+
+    bool fileExists(const char* path) {
+        struct stat st;
+        return stat(path, &st) == 0;
+    }
+}
+
+RecordLog::RecordLog() {
+    open = false;
+    dir[0] = '\0';
+    segmentSize = 0;
+    maxSegments = 0;
+    segmentCount = 0;
+    tailSegment = 0;
+    tailSize = 0;
+    nextSeq = 0;
+    headSegment = 0;
+    readOffset = 0;
+    readSeq = 0;
+    cursorSlot = 0;
+    cursorDirty = false;
+    cursorMovedAt = 0;
+    millisFn = nullptr;
+    bytesOnDisk = 0;
+    droppedRecords = 0;
+    corruptRecords = 0;
+    readErrors = 0;
+    memset(&recovery, 0, sizeof(recovery));
+}
+
+RecordLog::~RecordLog() {
+    end();
+}
+
+// ========================================
+// Lifecycle + Recovery
+// ========================================
+
+bool RecordLog::begin(const char* directory, uint32_t segSize, uint16_t maxSegs,
+                      size_t blockSize, size_t stagingSize, uint32_t durabilityMs,
+                      WriteCoalescer::ClockFn millisFn, WriteCoalescer::ClockFn microsFn) {
+    end();
+
+    this->millisFn = millisFn;
+    cursorDirty = false;
+
+    unsigned long startUs = microsFn ? microsFn() : 0;
+    memset(&recovery, 0, sizeof(recovery));
+
+    strncpy(dir, directory, sizeof(dir) - 1);
+    dir[sizeof(dir) - 1] = '\0';
+    segmentSize = segSize;
+    maxSegments = maxSegs < 2 ? 2 : maxSegs;
+
+    mkdir(dir, 0777);  // EEXIST is fine
+
+    uint32_t first = 0;
+    uint32_t last = 0;
+    if (!listSegments(first, last, segmentCount) && !fileExists(dir)) {
+        return false;
+    }
+    recovery.segments = segmentCount;
+
+    // Tail: the only place a torn write can be
+    if (segmentCount > 0) {
+        tailSegment = last;
+        if (!scanTail()) {
+            return false;
+        }
+    }
+
+    // Head: persisted cursor, validated against what is on disk
+    recovery.cursorValid = loadCursor();
+
+    if (segmentCount == 0) {
+        // Keep seq monotonic across clears so old cursor slots stay ordered
+        nextSeq = recovery.cursorValid ? readSeq : 1;
+        tailSegment = nextSeq;
+        tailSize = 0;
+    }
+
+    if (!recovery.cursorValid || readSeq < (segmentCount > 0 ? first : nextSeq)) {
+        headSegment = segmentCount > 0 ? first : tailSegment;
+        readOffset = 0;
+        readSeq = headSegment;
+    } else if (readSeq >= nextSeq) {
+        headSegment = tailSegment;
+        readOffset = tailSize;
+        readSeq = nextSeq;
+    } else {
+        char path[RECORD_LOG_PATH_MAX];
+        segmentPath(headSegment, path);
+        if (!fileExists(path)) {
+            // Crashed between saving the cursor and deleting a segment
+            uint32_t next = tailSegment;
+            findNextSegment(headSegment, next);
+            headSegment = next;
+            readOffset = 0;
+            readSeq = next;
+        }
+    }
+
+    // Segments entirely before the head were consumed but not yet deleted
+    uint32_t seq = first;
+    while (segmentCount > 0 && seq < headSegment) {
+        removeSegment(seq);
+        recovery.orphansRemoved++;
+        if (!findNextSegment(seq, seq)) {
+            break;
+        }
+    }
+
+    saveCursor();
+
+    if (!writer.begin(blockSize, stagingSize, durabilityMs, appendToTail, this,
+                      millisFn, microsFn, tailSize)) {
+        return false;
+    }
+
+    if (microsFn) {
+        recovery.recoveryMicros = microsFn() - startUs;
+    }
+
+    open = true;
+    return true;
+}
+
+void RecordLog::end() {
+    if (!open) {
+        return;
+    }
+    writer.end();
+    if (cursorDirty) {
+        saveCursor();
+    }
+    open = false;
+}
+
+void RecordLog::poll() {
+    writer.poll();
+    if (cursorDirty && millisFn() - cursorMovedAt >= writer.getMaxAgeMs()) {
+        saveCursor();
+    }
+}
+
+void RecordLog::flush() {
+    writer.flush();
+    if (cursorDirty) {
+        saveCursor();
+    }
+}
+
+bool RecordLog::scanTail() {
+    char path[RECORD_LOG_PATH_MAX];
+    segmentPath(tailSegment, path);
+
+    uint32_t fileSize = fileSizeOf(path);
+    uint32_t validEnd = 0;
+    uint32_t lastSeq = 0;
+    bool found = false;
+
+    FILE* f = fopen(path, "rb");
+    if (f) {
+        uint8_t chunk[SCAN_CHUNK_SIZE];
+        while (true) {
+            uint8_t raw[QUEUE_RECORD_HEADER_SIZE];
+            if (fread(raw, 1, sizeof(raw), f) != sizeof(raw)) {
+                break;
+            }
+            recovery.scannedBytes += sizeof(raw);
+
+            QueueRecordHeader header;
+            if (!queueRecordDecodeHeader(raw, header)) {
+                break;
+            }
+
+            uint32_t crc = queueRecordHeaderCrc(header.length, header.seq);
+            size_t remaining = header.length;
+            while (remaining > 0) {
+                size_t want = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+                size_t got = fread(chunk, 1, want, f);
+                recovery.scannedBytes += got;
+                crc = queueCrc32(crc, chunk, got);
+                if (got != want) {
+                    break;
+                }
+                remaining -= got;
+            }
+
+            if (remaining > 0 || crc != header.crc) {
+                break;
+            }
+
+            validEnd += QUEUE_RECORD_HEADER_SIZE + header.length;
+            lastSeq = header.seq;
+            found = true;
+        }
+        fclose(f);
+    }
+
+    if (validEnd < fileSize) {
+        recovery.truncatedBytes = fileSize - validEnd;
+        if (truncate(path, validEnd) != 0) {
+            if (!found) {
+                // Nothing worth keeping; the file is recreated on next append
+                unlink(path);
+                tailSize = 0;
+                nextSeq = tailSegment;
+                return true;
+            }
+            // Cannot cut the torn bytes: leave them as garbage at the end of
+            // a sealed segment (readers skip it) and append to a fresh one
+            nextSeq = lastSeq + 1;
+            tailSegment = nextSeq;
+            tailSize = 0;
+            segmentCount++;
+            return true;
+        }
+    }
+
+    tailSize = validEnd;
+    nextSeq = found ? lastSeq + 1 : tailSegment;
+    return true;
+}
+
+bool RecordLog::loadCursor() {
+    char path[RECORD_LOG_PATH_MAX];
+    cursorPath(path);
+
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        cursorSlot = 0;
+        return false;
+    }
+
+    uint8_t raw[CURSOR_SLOT_SIZE * 2];
+    size_t got = fread(raw, 1, sizeof(raw), f);
+    fclose(f);
+
+    bool valid = false;
+    uint32_t bestSeq = 0;
+
+    for (uint8_t slot = 0; slot < 2; slot++) {
+        if (got < (size_t)(slot + 1) * CURSOR_SLOT_SIZE) {
+            break;
+        }
+        const uint8_t* p = raw + slot * CURSOR_SLOT_SIZE;
+        if (queueCrc32(0, p, 12) != getU32(p + 12)) {
+            continue;
+        }
+        uint32_t seq = getU32(p + 8);
+        if (!valid || seq >= bestSeq) {
+            headSegment = getU32(p);
+            readOffset = getU32(p + 4);
+            readSeq = seq;
+            bestSeq = seq;
+            cursorSlot = slot ^ 1;
+            valid = true;
+        }
+    }
+
+    return valid;
+}
+
+bool RecordLog::saveCursor() {
+    char path[RECORD_LOG_PATH_MAX];
+    cursorPath(path);
+
+    uint8_t raw[CURSOR_SLOT_SIZE];
+    putU32(raw, headSegment);
+    putU32(raw + 4, readOffset);
+    putU32(raw + 8, readSeq);
+    putU32(raw + 12, queueCrc32(0, raw, 12));
+
+    FILE* f = fopen(path, "r+b");
+    if (!f) {
+        f = fopen(path, "w+b");
+    }
+    if (!f) {
+        return false;
+    }
+
+    // Only one slot is ever being written, the other stays intact
+    bool ok = fseek(f, cursorSlot * CURSOR_SLOT_SIZE, SEEK_SET) == 0 &&
+              fwrite(raw, 1, sizeof(raw), f) == sizeof(raw);
+    fclose(f);
+
+    cursorSlot ^= 1;
+    if (ok) {
+        cursorDirty = false;
+    }
+    return ok;
+}
+
+// Dequeues only move the cursor in RAM; a drained log saves it right away
+void RecordLog::cursorMoved() {
+    if (count() == 0) {
+        saveCursor();
+    } else if (!cursorDirty) {
+        cursorDirty = true;
+        cursorMovedAt = millisFn();
+    }
+}
+
+// ========================================
+// Append
+// ========================================
+
+bool RecordLog::append(const uint8_t* data, size_t len) {
+    if (!open || len == 0 || len > QUEUE_RECORD_MAX_PAYLOAD) {
+        return false;
+    }
+
+    uint32_t frameLen = QUEUE_RECORD_HEADER_SIZE + len;
+    if (tailSize > 0 && tailSize + frameLen > segmentSize) {
+        if (!rollSegment()) {
+            return false;
+        }
+    }
+
+    uint8_t header[QUEUE_RECORD_HEADER_SIZE];
+    queueRecordEncodeHeader(header, (uint16_t)len, nextSeq, data);
+
+    size_t stagedBefore = writer.getStagedBytes();
+    uint64_t writtenBefore = writer.getStats().bytesWritten;
+
+    if (!writer.append(header, sizeof(header), data, len)) {
+        // Roll back the part of this frame that is still staged. A part that
+        // reached the file is a torn tail, cut by the next begin().
+        size_t staged = writer.getStagedBytes();
+        uint64_t handed = staged + (writer.getStats().bytesWritten - writtenBefore);
+        size_t copied = handed > stagedBefore ? (size_t)(handed - stagedBefore) : 0;
+        writer.dropStagedTail(copied < staged ? copied : staged);
+        return false;
+    }
+
+    tailSize += frameLen;
+    bytesOnDisk += frameLen;
+    nextSeq++;
+    return true;
+}
+
+bool RecordLog::rollSegment() {
+    if (!writer.flush()) {
+        return false;
+    }
+
+    if (segmentCount >= maxSegments) {
+        dropOldestSegment();
+    }
+
+    tailSegment = nextSeq;
+    tailSize = 0;
+    writer.resetFileSize(0);
+    segmentCount++;
+    return true;
+}
+
+void RecordLog::dropOldestSegment() {
+    if (headSegment == tailSegment) {
+        return;
+    }
+
+    uint32_t next = tailSegment;
+    findNextSegment(headSegment, next);
+
+    droppedRecords += next - readSeq;
+
+    uint32_t old = headSegment;
+    headSegment = next;
+    readOffset = 0;
+    readSeq = next;
+    saveCursor();
+    removeSegment(old);
+}
+
+// ========================================
+// Read
+// ========================================
+
+RecordLog::ReadResult RecordLog::advanceToReadableRecord(QueueRecordHeader& header) {
+    char path[RECORD_LOG_PATH_MAX];
+
+    while (count() > 0) {
+        segmentPath(headSegment, path);
+        uint32_t size = tailSize;
+        if (headSegment != tailSegment) {
+            struct stat st;
+            if (stat(path, &st) == 0) {
+                size = (uint32_t)st.st_size;
+            } else if (errno == ENOENT) {
+                size = 0;               // Gone: nothing left to read in it
+            } else {
+                return READ_IO_ERROR;
+            }
+        }
+
+        if (readOffset + QUEUE_RECORD_HEADER_SIZE <= size) {
+            uint8_t raw[QUEUE_RECORD_HEADER_SIZE];
+            if (!readSegment(headSegment, readOffset, raw, sizeof(raw))) {
+                return READ_IO_ERROR;
+            }
+
+            if (queueRecordDecodeHeader(raw, header) &&
+                readOffset + QUEUE_RECORD_HEADER_SIZE + header.length <= size) {
+                return READ_OK;
+            }
+        }
+
+        // End of segment, or garbage that cannot be framed: the rest of this
+        // segment is unreadable, continue with the next one
+        if (headSegment == tailSegment) {
+            corruptRecords += nextSeq - readSeq;
+            readOffset = tailSize;
+            readSeq = nextSeq;
+            saveCursor();
+            return READ_EMPTY;
+        }
+
+        uint32_t next = tailSegment;
+        bool listed;
+        findNextSegment(headSegment, next, &listed);
+        if (!listed) {
+            return READ_IO_ERROR;       // Not knowing the next one is no reason to drop this one
+        }
+        corruptRecords += next - readSeq;
+
+        uint32_t old = headSegment;
+        headSegment = next;
+        readOffset = 0;
+        readSeq = next;
+        saveCursor();          // Cursor first, so a crash here leaves an orphan,
+        removeSegment(old);    // never a cursor pointing at a deleted segment
+    }
+
+    return READ_EMPTY;
+}
+
+size_t RecordLog::peekLength() {
+    QueueRecordHeader header;
+    if (!open || advanceToReadableRecord(header) != READ_OK) {
+        return 0;
+    }
+    return header.length;
+}
+
+bool RecordLog::pop(uint8_t* buf, size_t capacity, size_t& length) {
+    length = 0;
+    if (!open) {
+        return false;
+    }
+
+    QueueRecordHeader header;
+    ReadResult result;
+    while ((result = advanceToReadableRecord(header)) == READ_OK) {
+        if (header.length > capacity) {
+            length = header.length;     // Caller's buffer is too small; record stays
+            return false;
+        }
+
+        result = readRecordAt(headSegment, readOffset, header, buf);
+        if (result == READ_IO_ERROR) {
+            break;
+        }
+
+        readOffset += QUEUE_RECORD_HEADER_SIZE + header.length;
+        readSeq = header.seq + 1;
+        cursorMoved();
+
+        if (result == READ_OK) {
+            length = header.length;
+            return true;
+        }
+
+        // CRC mismatch (media corruption) - skip the record, not the queue
+        corruptRecords++;
+    }
+
+    if (result == READ_IO_ERROR) {
+        readErrors++;
+    }
+    return false;
+}
+
+bool RecordLog::skip() {
+    QueueRecordHeader header;
+    ReadResult result = open ? advanceToReadableRecord(header) : READ_EMPTY;
+    if (result != READ_OK) {
+        if (result == READ_IO_ERROR) {
+            readErrors++;
+        }
+        return false;
+    }
+
+    readOffset += QUEUE_RECORD_HEADER_SIZE + header.length;
+    readSeq = header.seq + 1;
+    cursorMoved();
+    return true;
+}
+
+// Bytes of a segment; the part of the tail still staged comes from RAM
+bool RecordLog::readSegment(uint32_t firstSeq, uint32_t offset, uint8_t* out, size_t len) {
+    size_t fileLen = len;
+    if (firstSeq == tailSegment) {
+        uint32_t onDisk = tailSize - (uint32_t)writer.getStagedBytes();
+        fileLen = offset >= onDisk ? 0 : (offset + len <= onDisk ? len : onDisk - offset);
+        if (fileLen < len) {
+            memcpy(out + fileLen, writer.getStagedData() + (offset + fileLen - onDisk), len - fileLen);
+        }
+    }
+    if (fileLen == 0) {
+        return true;
+    }
+
+    char path[RECORD_LOG_PATH_MAX];
+    segmentPath(firstSeq, path);
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+
+    bool ok = fseek(f, offset, SEEK_SET) == 0 && fread(out, 1, fileLen, f) == fileLen;
+    fclose(f);
+    return ok;
+}
+
+RecordLog::ReadResult RecordLog::readRecordAt(uint32_t firstSeq, uint32_t offset,
+                                              const QueueRecordHeader& header, uint8_t* payload) {
+    if (!readSegment(firstSeq, offset + QUEUE_RECORD_HEADER_SIZE, payload, header.length)) {
+        return READ_IO_ERROR;
+    }
+
+    uint32_t crc = queueCrc32(queueRecordHeaderCrc(header.length, header.seq),
+                              payload, header.length);
+    return crc == header.crc ? READ_OK : READ_CORRUPT;
+}
+
+// ========================================
+// Abandon
+// ========================================
+
+uint32_t RecordLog::abandon(SalvageFn salvage, void* context) {
+    if (!open) {
+        return 0;
+    }
+
+    // Records with any byte still staged never made it to the file whole
+    const uint8_t* data = writer.getPendingData();
+    size_t pending = writer.getRetainedBytes() + writer.getStagedBytes();
+    size_t pos = 0;
+    uint32_t salvaged = 0;
+
+    while (pos + QUEUE_RECORD_HEADER_SIZE <= pending) {
+        QueueRecordHeader header;
+        const uint8_t* payload = data + pos + QUEUE_RECORD_HEADER_SIZE;
+        if (!queueRecordDecodeHeader(data + pos, header) ||
+            pos + QUEUE_RECORD_HEADER_SIZE + header.length > pending ||
+            queueCrc32(queueRecordHeaderCrc(header.length, header.seq),
+                       payload, header.length) != header.crc) {
+            // Pending data starts mid-frame: resync
+            pos++;
+            continue;
+        }
+
+        if (salvage) {
+            salvage(context, payload, header.length);
+        }
+        salvaged++;
+        pos += QUEUE_RECORD_HEADER_SIZE + header.length;
+    }
+
+    // Nothing left to write; end() must not touch the dead filesystem
+    writer.discard();
+    writer.end();
+    open = false;
+    return salvaged;
+}
+
+// ========================================
+// Clear
+// ========================================
+
+bool RecordLog::clear() {
+    if (!open) {
+        return false;
+    }
+
+    writer.discard();
+
+    uint32_t seq = 0;
+    while (findNextSegment(seq, seq)) {
+        removeSegment(seq);
+    }
+
+    tailSegment = nextSeq;
+    tailSize = 0;
+    headSegment = nextSeq;
+    readOffset = 0;
+    readSeq = nextSeq;
+    segmentCount = 0;
+    bytesOnDisk = 0;
+    return saveCursor();
+}
+
+// ========================================
+// Helpers
+// ========================================
+
+void RecordLog::segmentPath(uint32_t firstSeq, char* out) const {
+    snprintf(out, RECORD_LOG_PATH_MAX, "%s/%08lX%s", dir, (unsigned long)firstSeq, SEGMENT_SUFFIX);
+}
+
+void RecordLog::cursorPath(char* out) const {
+    snprintf(out, RECORD_LOG_PATH_MAX, "%s/%s", dir, CURSOR_FILE_NAME);
+}
+
+bool RecordLog::listSegments(uint32_t& first, uint32_t& last, uint16_t& count) {
+    count = 0;
+    bytesOnDisk = 0;
+
+    DIR* d = opendir(dir);
+    if (!d) {
+        return false;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(d)) != nullptr) {
+        uint32_t seq;
+        if (!parseSegmentName(entry->d_name, seq)) {
+            continue;
+        }
+        if (count == 0 || seq < first) {
+            first = seq;
+        }
+        if (count == 0 || seq > last) {
+            last = seq;
+        }
+        count++;
+
+        char path[RECORD_LOG_PATH_MAX];
+        segmentPath(seq, path);
+        bytesOnDisk += fileSizeOf(path);
+    }
+
+    closedir(d);
+    return true;
+}
+
+bool RecordLog::findNextSegment(uint32_t after, uint32_t& next, bool* listed) {
+    DIR* d = opendir(dir);
+    if (listed) {
+        *listed = d != nullptr;
+    }
+    if (!d) {
+        return false;
+    }
+
+    bool found = false;
+    struct dirent* entry;
+    while ((entry = readdir(d)) != nullptr) {
+        uint32_t seq;
+        if (parseSegmentName(entry->d_name, seq) && seq > after && (!found || seq < next)) {
+            next = seq;
+            found = true;
+        }
+    }
+
+    closedir(d);
+    return found;
+}
+
+void RecordLog::removeSegment(uint32_t firstSeq) {
+    char path[RECORD_LOG_PATH_MAX];
+    segmentPath(firstSeq, path);
+
+    uint32_t size = fileSizeOf(path);
+    if (unlink(path) == 0) {
+        bytesOnDisk = bytesOnDisk > size ? bytesOnDisk - size : 0;
+        if (segmentCount > 0) {
+            segmentCount--;
+        }
+    }
+}
+
+size_t RecordLog::appendToTail(void* context, const uint8_t* data, size_t len) {
+    RecordLog* log = (RecordLog*)context;
+
+    char path[RECORD_LOG_PATH_MAX];
+    log->segmentPath(log->tailSegment, path);
+
+    FILE* f = fopen(path, "ab");
+    if (!f) {
+        return 0;
+    }
+
+    size_t written = fwrite(data, 1, len, f);
+    fclose(f);
+    return written;
+}
@@ -1,5 +1,162 @@
 #include "rs485_config_manager.h"
+#include "device_profiles.h"
+#include "config.h"
+#include "queue_record.h"
 #include <HardwareSerial.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <algorithm>
+
+#define CONFIG_CACHE_MAGIC      0x46435352UL    // "RSCF"
+#define CONFIG_CACHE_VERSION    2
+#define CONFIG_CACHE_HASH_VALID 0x0001
+
+namespace {
+    struct ConfigCacheHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t flags;
+        uint32_t length;        // JSON bytes after the header
+        uint32_t crc;           // CRC-32 of the JSON
+        uint32_t hash;          // Server's config hash
+    };
+
+    // malloc with a size prefix, to see the document's high-water mark
+    class PeakAllocator : public ArduinoJson::Allocator {
+    public:
+        size_t current = 0;
+        size_t peak = 0;
+
+        void* allocate(size_t size) override {
+            size_t* block = (size_t*)malloc(size + HEADER);
+            if (block == nullptr) {
+                return nullptr;
+            }
+            *block = size;
+            grow(size);
+            return (uint8_t*)block + HEADER;
+        }
+
+        void deallocate(void* ptr) override {
+            if (ptr != nullptr) {
+                size_t* block = (size_t*)((uint8_t*)ptr - HEADER);
+                current -= *block;
+                free(block);
+            }
+        }
+
+        void* reallocate(void* ptr, size_t size) override {
+            if (ptr == nullptr) {
+                return allocate(size);
+            }
+            size_t* block = (size_t*)((uint8_t*)ptr - HEADER);
+            size_t old = *block;
+            block = (size_t*)realloc(block, size + HEADER);
+            if (block == nullptr) {
+                return nullptr;
+            }
+            *block = size;
+            current -= old;
+            grow(size);
+            return (uint8_t*)block + HEADER;
+        }
+
+    private:
+        static const size_t HEADER = 8;     // Keeps the pool 8-byte aligned
+
+        void grow(size_t size) {
+            current += size;
+            if (current > peak) {
+                peak = current;
+            }
+        }
+    };
+
+    void addDeviceFilter(JsonObject device) {
+        device["profile"] = true;
+        device["modbus_address"] = true;
+        device["device_type"] = true;
+        device["baud_rate"] = true;
+        device["version"] = true;
+
+        JsonObject reg = device["registers"][0].to<JsonObject>();
+        reg["reg"] = true;
+        reg["type"] = true;
+        reg["label"] = true;
+        reg["words"] = true;
+        reg["swap"] = true;
+    }
+
+    // Only the fields the device uses survive deserialization; the same
+    // filter applies to every element of the array format. An object may
+    // also be a delta, whose ops carry a device or a single register.
+    void buildFilter(JsonDocument& filter, bool array) {
+        if (array) {
+            addDeviceFilter(filter[0].to<JsonObject>());
+            return;
+        }
+        addDeviceFilter(filter.to<JsonObject>());
+        filter["hash"] = true;
+
+        JsonObject op = filter["delta"][0].to<JsonObject>();
+        addDeviceFilter(op);
+        op["op"] = true;
+        op["reg"] = true;
+        JsonObject reg = op["register"].to<JsonObject>();
+        reg["reg"] = true;
+        reg["type"] = true;
+        reg["label"] = true;
+        reg["words"] = true;
+        reg["swap"] = true;
+    }
+
+    bool isArrayPayload(const uint8_t* json, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            if (!isspace(json[i])) {
+                return json[i] == '[';
+            }
+        }
+        return false;
+    }
+
+    const char* const TYPE_NAMES[] = { "uint16", "int16", "uint32", "int32", "float32", "hex16", "unknown" };
+
+    uint8_t parseRegisterType(const char* type) {
+        for (uint8_t i = 0; i < RS485_TYPE_UNKNOWN; i++) {
+            if (strcmp(type, TYPE_NAMES[i]) == 0) {
+                return i;
+            }
+        }
+        return RS485_TYPE_UNKNOWN;
+    }
+
+    // "Flow Rate" -> "flow_rate"
+    void labelToKey(const char* label, char* key) {
+        size_t i = 0;
+        for (; label[i] != '\0' && i < RS485_KEY_LEN - 1; i++) {
+            key[i] = label[i] == ' ' ? '_' : (char)tolower((unsigned char)label[i]);
+        }
+        key[i] = '\0';
+    }
+
+    std::vector<RS485DeviceConfig>::iterator findDevice(std::vector<RS485DeviceConfig>& plan,
+                                                        uint8_t address) {
+        return std::find_if(plan.begin(), plan.end(), [address](const RS485DeviceConfig& device) {
+            return device.modbus_address == address;
+        });
+    }
+
+    // A register op on a built-in profile turns it into a custom map
+    void detachProfile(RS485DeviceConfig& device) {
+        if (device.profileRegisters != nullptr) {
+            device.registers.assign(device.profileRegisters,
+                                    device.profileRegisters + device.profileRegisterCount);
+            device.profileRegisters = nullptr;
+            device.profileRegisterCount = 0;
+        }
+    }
+}
 
 // External RS485 functions from main.cpp
 extern bool readRS485Register(uint8_t slaveId, uint16_t regAddr, uint16_t count, uint16_t* output);
@@ -11,75 +168,254 @@ RS485ConfigManager rs485ConfigMgr;
 
 RS485ConfigManager::RS485ConfigManager() {
     devices.clear();
+    stagedPending = false;
+    stagedFromCache = false;
+    stagedHash = 0;
+    stagedHashValid = false;
+    cachePath[0] = '\0';
+    configHash = 0;
+    configHashValid = false;
 }
 
 // ============================
 // Config Management
 // ============================
 
-bool RS485ConfigManager::parseConfig(const String& jsonPayload) {
+bool RS485ConfigManager::parseConfig(const uint8_t* json, size_t length) {
     Serial.println("[RS485Config] Parsing config JSON...");
     
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, jsonPayload);
+    bool array = isArrayPayload(json, length);
+    JsonDocument filter;
+    buildFilter(filter, array);
+    
+    PeakAllocator allocator;
+    std::vector<RS485DeviceConfig> parsed;
+    uint16_t registerCount = 0;
+    uint32_t hash = queueCrc32(0, json, length);
+    bool hashValid = true;
+    {
+        JsonDocument doc(&allocator);
+        DeserializationError error = deserializeJson(doc, json, length,
+                                                     DeserializationOption::Filter(filter));
+        
+        if (error) {
+            Serial.print("[RS485Config] ❌ Parse error: ");
+            Serial.println(error.c_str());
+            return false;
+        }
+        
+        // Check if root is array (multiple devices) or object (single device)
+        if (array && doc.is<JsonArray>()) {
+            // Multiple devices - array format
+            JsonArray devicesArray = doc.as<JsonArray>();
+            Serial.printf("[RS485Config] Array format: %u devices\n", (unsigned)devicesArray.size());
+            parsed.reserve(devicesArray.size());
+            
+            for (JsonObject deviceObj : devicesArray) {
+                parsed.emplace_back();
+                if (!parseDeviceObject(deviceObj, parsed.back())) {
+                    parsed.pop_back();
+                }
+            }
+            
+        } else if (!array && doc["delta"].is<JsonArray>()) {
+            // Delta on top of the newest plan, including one not applied yet
+            JsonArray ops = doc["delta"];
+            Serial.printf("[RS485Config] Delta format: %u op(s)\n", (unsigned)ops.size());
+            {
+                std::lock_guard<std::mutex> guard(planLock);
+                parsed = stagedPending ? staged : devices;
+            }
+            if (!applyDelta(ops, parsed)) {
+                return false;
+            }
+            
+            // Server's hash of the full config after the delta; without it
+            // the next get_config asks for the whole config again
+            const char* deltaHash = doc["hash"];
+            hashValid = deltaHash != nullptr;
+            hash = hashValid ? strtoul(deltaHash, nullptr, 16) : 0;
+            
+        } else if (!array && doc.is<JsonObject>()) {
+            // Single device - object format
+            Serial.println("[RS485Config] Object format: single device");
+            
+            parsed.emplace_back();
+            if (!parseDeviceObject(doc.as<JsonObject>(), parsed.back())) {
+                parsed.pop_back();
+            }
+        } else {
+            Serial.println("[RS485Config] ❌ Invalid format (not array or object)");
+            return false;
+        }
+    }
     
-    if (error) {
-        Serial.print("[RS485Config] ❌ Parse error: ");
-        Serial.println(error.c_str());
+    if (parsed.empty()) {
+        Serial.println("[RS485Config] ⚠️ No valid devices parsed");
         return false;
     }
     
-    // Clear existing config
-    devices.clear();
+    size_t configBytes = parsed.capacity() * sizeof(RS485DeviceConfig);
+    for (const auto& device : parsed) {
+        registerCount += device.getRegisters().size();
+        configBytes += device.registers.capacity() * sizeof(RS485Register);
+        Serial.printf("[RS485Config] ✅ Device %d: %s, %u registers%s\n", 
+                     device.modbus_address, device.device_type, (unsigned)device.getRegisters().size(),
+                     device.profileRegisters ? " (built-in profile)" : "");
+    }
+    
+    parseStats.jsonBytes = length;
+    parseStats.docPeakBytes = allocator.peak;
+    parseStats.configBytes = configBytes;
+    parseStats.registers = registerCount;
     
-    // Check if root is array (multiple devices) or object (single device)
-    if (doc.is<JsonArray>()) {
-        // Multiple devices - array format
-        JsonArray devicesArray = doc.as<JsonArray>();
-        Serial.printf("[RS485Config] Array format: %d devices\n", devicesArray.size());
+    Serial.printf("[RS485Config] ✅ Next plan staged: %u device(s), hash %08lx\n",
+                  (unsigned)parsed.size(), (unsigned long)hash);
+    Serial.printf("[RS485Config] Heap: %lu B JSON -> %lu B document peak -> %lu B config (%u registers)\n",
+                  (unsigned long)parseStats.jsonBytes, (unsigned long)parseStats.docPeakBytes,
+                  (unsigned long)parseStats.configBytes, parseStats.registers);
+    
+    // The running plan stays untouched until commitStaged()
+    stage(parsed, hash, hashValid);
+    return true;
+}
+
+// ops: {"op":"upsert", <device>}, {"op":"remove","modbus_address":N},
+// {"op":"upsert_register","modbus_address":N,"register":{..}},
+// {"op":"remove_register","modbus_address":N,"reg":R}
+bool RS485ConfigManager::applyDelta(JsonArray ops, std::vector<RS485DeviceConfig>& plan) {
+    for (JsonObject op : ops) {
+        const char* name = op["op"] | "";
+        uint8_t address = op["modbus_address"] | 0;
+        auto device = findDevice(plan, address);
+        bool ok = false;
         
-        for (JsonObject deviceObj : devicesArray) {
-            RS485DeviceConfig device;
-            if (parseDeviceObject(deviceObj, device)) {
-                devices.push_back(device);
-                Serial.printf("[RS485Config] ✅ Device %d: %s, %d registers\n", 
-                             device.modbus_address, 
-                             device.device_type.c_str(),
-                             device.registers.size());
+        if (strcmp(name, "upsert") == 0) {
+            RS485DeviceConfig parsed = RS485DeviceConfig();
+            ok = parseDeviceObject(op, parsed);
+            if (ok) {
+                device = findDevice(plan, parsed.modbus_address);
+                if (device != plan.end()) {
+                    *device = std::move(parsed);
+                } else {
+                    plan.push_back(std::move(parsed));
+                }
+            }
+            
+        } else if (strcmp(name, "remove") == 0) {
+            ok = device != plan.end();
+            if (ok) {
+                plan.erase(device);
+            }
+            
+        } else if (strcmp(name, "upsert_register") == 0) {
+            RS485Register reg;
+            ok = device != plan.end() && parseRegister(op["register"], reg);
+            if (ok) {
+                detachProfile(*device);
+                auto& regs = device->registers;
+                auto existing = std::find_if(regs.begin(), regs.end(),
+                                             [&reg](const RS485Register& r) { return r.reg == reg.reg; });
+                if (existing != regs.end()) {
+                    *existing = reg;
+                } else {
+                    regs.push_back(reg);
+                }
+            }
+            
+        } else if (strcmp(name, "remove_register") == 0) {
+            uint16_t regAddr = op["reg"] | 0;
+            ok = device != plan.end() && !op["reg"].isNull() && device->getRegisters().size() > 1;
+            if (ok) {
+                detachProfile(*device);
+                auto& regs = device->registers;
+                auto existing = std::find_if(regs.begin(), regs.end(),
+                                             [regAddr](const RS485Register& r) { return r.reg == regAddr; });
+                ok = existing != regs.end();
+                if (ok) {
+                    regs.erase(existing);
+                }
             }
         }
         
-    } else if (doc.is<JsonObject>()) {
-        // Single device - object format
-        Serial.println("[RS485Config] Object format: single device");
-        
-        RS485DeviceConfig device;
-        if (parseDeviceObject(doc.as<JsonObject>(), device)) {
-            devices.push_back(device);
-            Serial.printf("[RS485Config] ✅ Device %d: %s, %d registers\n", 
-                         device.modbus_address, 
-                         device.device_type.c_str(),
-                         device.registers.size());
+        if (!ok) {
+            Serial.printf("[RS485Config] ❌ Delta op '%s' for device %u rejected, nothing applied\n",
+                          name, address);
+            return false;
         }
-    } else {
-        Serial.println("[RS485Config] ❌ Invalid format (not array or object)");
-        return false;
+    }
+    return true;
+}
+
+void RS485ConfigManager::stage(std::vector<RS485DeviceConfig>& plan, uint32_t hash, bool hashValid) {
+    std::lock_guard<std::mutex> guard(planLock);
+    staged.swap(plan);
+    stagedHash = hash;
+    stagedHashValid = hashValid;
+    stagedFromCache = false;
+    stagedPending = true;
+}
+
+void RS485ConfigManager::commitStaged() {
+    std::vector<RS485DeviceConfig> next;
+    uint32_t hash;
+    bool hashValid;
+    bool fromCache;
+    {
+        std::lock_guard<std::mutex> guard(planLock);
+        if (!stagedPending) {
+            return;
+        }
+        next.swap(staged);
+        hash = stagedHash;
+        hashValid = stagedHashValid;
+        fromCache = stagedFromCache;
+        stagedPending = false;
     }
     
-    if (devices.empty()) {
-        Serial.println("[RS485Config] ⚠️ No valid devices parsed");
-        return false;
+    // Devices that stay keep their status; only new addresses are probed,
+    // instead of rescanning the whole bus
+    uint8_t kept = 0;
+    uint8_t probed = 0;
+    for (auto& device : next) {
+        auto old = findDevice(devices, device.modbus_address);
+        if (old != devices.end()) {
+            device.is_online = old->is_online;
+            device.last_seen = old->last_seen;
+            kept++;
+        } else {
+            device.is_online = testDevice(device.modbus_address);
+            device.last_seen = device.is_online ? millis() : 0;
+            probed++;
+        }
     }
     
-    Serial.printf("[RS485Config] ✅ Total config loaded: %d device(s)\n", devices.size());
-    return true;
+    {
+        std::lock_guard<std::mutex> guard(planLock);
+        devices.swap(next);         // `next` now holds the old plan, freed below
+        configHash = hash;
+        configHashValid = hashValid;
+    }
+    
+    Serial.printf("[RS485Config] ✅ Plan applied: %u device(s), %u kept, %u probed\n",
+                  (unsigned)devices.size(), kept, probed);
+    
+    if (!fromCache) {
+        saveCache();
+    }
 }
 
 bool RS485ConfigManager::parseDeviceObject(JsonObject deviceObj, RS485DeviceConfig& device) {
+    // {"profile":"TUF-2000-FlowMeter","version":1,"modbus_address":2}: registers from flash
+    const char* profileName = deviceObj["profile"];
+    if (profileName != nullptr) {
+        return applyProfile(deviceObj, profileName, device);
+    }
+    
     device.modbus_address = deviceObj["modbus_address"] | 1;
-    device.device_type = deviceObj["device_type"] | "Unknown";
+    snprintf(device.device_type, sizeof(device.device_type), "%s",
+             deviceObj["device_type"] | "Unknown");
     device.baud_rate = deviceObj["baud_rate"] | 9600;
-    device.description = deviceObj["description"] | "";
     device.version = deviceObj["version"] | 1;
     device.is_online = false;
     device.last_seen = 0;
@@ -91,6 +427,7 @@ bool RS485ConfigManager::parseDeviceObject(JsonObject deviceObj, RS485DeviceConf
         return false;
     }
     
+    device.registers.reserve(regsArray.size());
     for (JsonObject regObj : regsArray) {
         RS485Register reg;
         if (parseRegister(regObj, reg)) {
@@ -101,23 +438,172 @@ bool RS485ConfigManager::parseDeviceObject(JsonObject deviceObj, RS485DeviceConf
     return !device.registers.empty();
 }
 
+bool RS485ConfigManager::applyProfile(JsonObject deviceObj, const char* profileName,
+                                      RS485DeviceConfig& device) {
+    uint16_t version = deviceObj["version"] | 0;
+    const RS485Profile* profile = findDeviceProfile(profileName, version);
+    if (profile == nullptr) {
+        Serial.printf("[RS485Config] ❌ No built-in profile %s v%u\n", profileName, version);
+        return false;
+    }
+    
+    device.modbus_address = deviceObj["modbus_address"] | profile->modbusAddress;
+    snprintf(device.device_type, sizeof(device.device_type), "%s", profile->deviceType);
+    device.baud_rate = deviceObj["baud_rate"] | profile->baudRate;
+    device.version = profile->version;
+    device.profileRegisters = profile->registers;
+    device.profileRegisterCount = profile->registerCount;
+    device.is_online = false;
+    device.last_seen = 0;
+    return true;
+}
+
 bool RS485ConfigManager::parseRegister(JsonObject regObj, RS485Register& reg) {
-    if (!regObj.containsKey("reg")) return false;
+    if (regObj["reg"].isNull()) return false;
     
     reg.reg = regObj["reg"];
-    reg.type = regObj["type"] | "uint16";
-    reg.label = regObj["label"] | "Unknown";
-    reg.unit = regObj["unit"] | "";
+    reg.type = parseRegisterType(regObj["type"] | "uint16");
     reg.words = regObj["words"] | 1;
     reg.swap = regObj["swap"] | false;
-    reg.category = regObj["category"] | "uncategorized";
+    labelToKey(regObj["label"] | "Unknown", reg.key);
     
     return true;
 }
 
+// Staged like any other plan: the running one belongs to the reader
 void RS485ConfigManager::clearConfig() {
-    devices.clear();
-    Serial.println("[RS485Config] Config cleared");
+    std::vector<RS485DeviceConfig> empty;
+    stage(empty, 0, false);
+    Serial.println("[RS485Config] Empty config staged");
+}
+
+// ============================
+// Config Cache
+// ============================
+
+bool RS485ConfigManager::loadCache(const char* path) {
+    snprintf(cachePath, sizeof(cachePath), "%s", path);
+
+    FILE* f = fopen(cachePath, "rb");
+    if (f == nullptr) {
+        return false;       // Never configured
+    }
+
+    ConfigCacheHeader header;
+    uint8_t* json = nullptr;
+    bool ok = fread(&header, 1, sizeof(header), f) == sizeof(header) &&
+              header.magic == CONFIG_CACHE_MAGIC &&
+              header.version == CONFIG_CACHE_VERSION &&
+              header.length > 0 && header.length <= RS485_CONFIG_CACHE_MAX;
+    if (ok) {
+        json = (uint8_t*)malloc(header.length);
+        ok = json != nullptr && fread(json, 1, header.length, f) == header.length &&
+             queueCrc32(0, json, header.length) == header.crc;
+    }
+    fclose(f);
+
+    if (ok) {
+        Serial.printf("[RS485Config] Cached config: %lu bytes, hash %08lx\n",
+                      (unsigned long)header.length, (unsigned long)header.hash);
+        ok = parseConfig(json, header.length);
+    } else {
+        Serial.println("[RS485Config] ⚠️ Config cache unreadable, ignored");
+    }
+    free(json);
+    
+    if (ok) {
+        {
+            std::lock_guard<std::mutex> guard(planLock);
+            stagedHash = header.hash;
+            stagedHashValid = (header.flags & CONFIG_CACHE_HASH_VALID) != 0;
+            stagedFromCache = true;
+        }
+        commitStaged();
+    }
+    return ok;
+}
+
+// The running plan in the format parseConfig() reads: a delta has no JSON
+// of its own to store
+bool RS485ConfigManager::saveCache() {
+    if (cachePath[0] == '\0' || devices.empty()) {
+        return false;
+    }
+
+    JsonDocument doc;
+    JsonArray array = doc.to<JsonArray>();
+    for (const auto& device : devices) {
+        JsonObject obj = array.add<JsonObject>();
+        if (device.profileRegisters != nullptr) {
+            obj["profile"] = device.device_type;
+            obj["version"] = device.version;
+            obj["modbus_address"] = device.modbus_address;
+            obj["baud_rate"] = device.baud_rate;
+            continue;
+        }
+        
+        obj["modbus_address"] = device.modbus_address;
+        obj["device_type"] = device.device_type;
+        obj["baud_rate"] = device.baud_rate;
+        obj["version"] = device.version;
+        JsonArray regs = obj["registers"].to<JsonArray>();
+        for (const auto& reg : device.registers) {
+            JsonObject r = regs.add<JsonObject>();
+            r["reg"] = reg.reg;
+            r["type"] = TYPE_NAMES[reg.type < RS485_TYPE_UNKNOWN ? (uint8_t)reg.type : (uint8_t)RS485_TYPE_UNKNOWN];
+            r["words"] = reg.words;
+            r["swap"] = reg.swap;
+            r["label"] = reg.key;
+        }
+    }
+
+    size_t length = measureJson(doc);
+    if (length > RS485_CONFIG_CACHE_MAX) {
+        Serial.printf("[RS485Config] ❌ Config too large to cache (%u bytes)\n", (unsigned)length);
+        return false;
+    }
+    char* json = (char*)malloc(length + 1);
+    if (json == nullptr) {
+        return false;
+    }
+    serializeJson(doc, json, length + 1);
+
+    ConfigCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CONFIG_CACHE_MAGIC;
+    header.version = CONFIG_CACHE_VERSION;
+    header.flags = configHashValid ? CONFIG_CACHE_HASH_VALID : 0;
+    header.length = length;
+    header.crc = queueCrc32(0, (const uint8_t*)json, length);
+    header.hash = configHash;
+
+    // Renamed over the old file only when complete: a reset mid-write keeps
+    // the previous config
+    char tmpPath[sizeof(cachePath) + 4];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", cachePath);
+
+    bool ok = false;
+    FILE* f = fopen(tmpPath, "wb");
+    if (f != nullptr) {
+        ok = fwrite(&header, 1, sizeof(header), f) == sizeof(header) &&
+             fwrite(json, 1, length, f) == length;
+        ok = fclose(f) == 0 && ok;
+    }
+    free(json);
+
+    if (ok && rename(tmpPath, cachePath) != 0) {
+        remove(cachePath);
+        ok = rename(tmpPath, cachePath) == 0;
+    }
+
+    Serial.printf("[RS485Config] %s Config cached (%u bytes)\n", ok ? "✅" : "❌", (unsigned)length);
+    return ok;
+}
+
+void RS485ConfigManager::clearCache() {
+    if (cachePath[0] != '\0') {
+        remove(cachePath);
+    }
 }
 
 RS485DeviceConfig* RS485ConfigManager::getDevice(uint8_t address) {
@@ -147,6 +633,7 @@ void RS485ConfigManager::scanDevices(uint8_t startAddr, uint8_t endAddr) {
             Serial.printf("  [✓] Address %d: ONLINE\n", addr);
             
             // Update device status if in config
+            std::lock_guard<std::mutex> guard(planLock);
             RS485DeviceConfig* device = getDevice(addr);
             if (device) {
                 device->is_online = true;
@@ -189,8 +676,9 @@ void RS485ConfigManager::printDeviceStatus() const {
             Serial.printf("  Address %d: %s\n", 
                          device.modbus_address,
                          device.is_online ? "✅ ONLINE" : "❌ OFFLINE");
-            Serial.printf("    Type: %s\n", device.device_type.c_str());
-            Serial.printf("    Registers: %d\n", device.registers.size());
+            Serial.printf("    Type: %s\n", device.device_type);
+            Serial.printf("    Registers: %u%s\n", (unsigned)device.getRegisters().size(),
+                          device.profileRegisters ? " (built-in profile)" : "");
             if (device.is_online) {
                 Serial.printf("    Last seen: %lu ms ago\n", 
                              millis() - device.last_seen);
@@ -234,26 +722,34 @@ JsonDocument RS485ConfigManager::buildDynamicTelemetry() {
         // Read all registers
         JsonObject dataObj = deviceObj["data"].to<JsonObject>();
         
-        for (const auto& reg : device.registers) {
-            String key = reg.label;
-            key.replace(" ", "_");
-            key.toLowerCase();
+        for (const auto& reg : device.getRegisters()) {
+            const char* key = reg.key;
             
-            if (reg.type == "float32") {
+            if (reg.type == RS485_FLOAT32) {
                 float value = readRS485Float32(device.modbus_address, reg.reg);
                 dataObj[key] = serialized(String(value, 2));
                 
-            } else if (reg.type == "uint32") {
+            } else if (reg.type == RS485_UINT32) {
                 uint32_t value = readRS485Uint32(device.modbus_address, reg.reg);
                 dataObj[key] = value;
                 
-            } else if (reg.type == "uint16") {
+            } else if (reg.type == RS485_INT32) {
+                int32_t value = (int32_t)readRS485Uint32(device.modbus_address, reg.reg);
+                dataObj[key] = value;
+                
+            } else if (reg.type == RS485_UINT16) {
                 uint16_t value = 0;
                 if (readRS485Register(device.modbus_address, reg.reg, 1, &value)) {
                     dataObj[key] = value;
                 }
                 
-            } else if (reg.type == "hex16") {
+            } else if (reg.type == RS485_INT16) {
+                uint16_t value = 0;
+                if (readRS485Register(device.modbus_address, reg.reg, 1, &value)) {
+                    dataObj[key] = (int16_t)value;
+                }
+                
+            } else if (reg.type == RS485_HEX16) {
                 uint16_t value = 0;
                 if (readRS485Register(device.modbus_address, reg.reg, 1, &value)) {
                     char hexStr[8];
@@ -49,6 +49,10 @@ bool SDLogger::begin() {
 
     initialized = true;
 
+    logWriter.begin(SD_WRITE_BLOCK_SIZE, LOG_STAGING_SIZE, STORAGE_DURABILITY_MS,
+                    appendToFile, (void*)LOG_FILE, millis, micros,
+                    fileSize(LOG_FILE));
+
     #if DEBUG_SD
     Serial.print(F("[SD] Card Type: "));
     if (cardType == CARD_MMC) {
@@ -72,115 +76,6 @@ bool SDLogger::begin() {
     return true;
 }
 
-// ============================================================================
-// QUEUE TELEMETRY
-// ============================================================================
-
-bool SDLogger::queueTelemetry(JsonDocument& doc) {
-    if (!initialized) {
-        return false;
-    }
-
-    #if DEBUG_SD
-    Serial.println(F("[SD] Queueing telemetry to offline storage..."));
-    #endif
-
-    // Open file in append mode
-    File file = SD.open(QUEUE_FILE, FILE_APPEND);
-    if (!file) {
-        #if DEBUG_SD
-        Serial.println(F("[SD] Failed to open queue file!"));
-        #endif
-        return false;
-    }
-
-    // Write JSON as single line (JSON Lines format)
-    serializeJson(doc, file);
-    file.println(); // Newline separator
-    file.close();
-
-    #if DEBUG_SD
-    Serial.print(F("[SD] Queued. Total records: "));
-    Serial.println(getQueueSize());
-    #endif
-
-    return true;
-}
-
-// ============================================================================
-// GET QUEUE SIZE
-// ============================================================================
-
-uint16_t SDLogger::getQueueSize() {
-    if (!initialized) {
-        return 0;
-    }
-
-    return countLines(QUEUE_FILE);
-}
-
-// ============================================================================
-// DEQUEUE OLDEST RECORD
-// ============================================================================
-
-bool SDLogger::dequeueOldest(JsonDocument& doc) {
-    if (!initialized) {
-        return false;
-    }
-
-    if (getQueueSize() == 0) {
-        return false;
-    }
-
-    // Read first line
-    String line;
-    if (!readLine(QUEUE_FILE, 0, line)) {
-        return false;
-    }
-
-    // Parse JSON
-    DeserializationError error = deserializeJson(doc, line);
-    if (error) {
-        #if DEBUG_SD
-        Serial.print(F("[SD] Failed to parse queued JSON: "));
-        Serial.println(error.c_str());
-        #endif
-        // Remove corrupted line
-        removeFirstLine(QUEUE_FILE);
-        return false;
-    }
-
-    // Remove the line from file
-    removeFirstLine(QUEUE_FILE);
-
-    #if DEBUG_SD
-    Serial.print(F("[SD] Dequeued. Remaining: "));
-    Serial.println(getQueueSize());
-    #endif
-
-    return true;
-}
-
-// ============================================================================
-// CLEAR QUEUE
-// ============================================================================
-
-bool SDLogger::clearQueue() {
-    if (!initialized) {
-        return false;
-    }
-
-    if (SD.exists(QUEUE_FILE)) {
-        SD.remove(QUEUE_FILE);
-
-        #if DEBUG_SD
-        Serial.println(F("[SD] Queue cleared"));
-        #endif
-    }
-
-    return true;
-}
-
 // ============================================================================
 // LOG MESSAGE
 // ============================================================================
@@ -190,19 +85,10 @@ bool SDLogger::logMessage(const char* message) {
         return false;
     }
 
-    File file = SD.open(LOG_FILE, FILE_APPEND);
-    if (!file) {
-        return false;
-    }
-
     // Add timestamp (TODO: use RTC if available)
-    file.print(F("["));
-    file.print(millis());
-    file.print(F("] "));
-    file.println(message);
-    file.close();
+    String line = "[" + String(millis()) + "] " + message + "\r\n";
 
-    return true;
+    return logWriter.append((const uint8_t*)line.c_str(), line.length());
 }
 
 // ============================================================================
@@ -241,106 +127,52 @@ void SDLogger::printInfo() {
     Serial.print(F("Free: "));
     Serial.print(getFreeSpaceMB());
     Serial.println(F(" MB"));
-    Serial.print(F("Queued records: "));
-    Serial.println(getQueueSize());
+
+    const WriteCoalescer::Stats& ls = logWriter.getStats();
+    Serial.print(F("Log writes: "));
+    Serial.print(ls.recordsStaged);
+    Serial.print(F(" lines in "));
+    Serial.print(ls.sinkWrites);
+    Serial.print(F(" writes, WA "));
+    Serial.print(logWriter.getWriteAmplificationX100() / 100.0f, 2);
+    Serial.println(F("x"));
     Serial.println(F("==================================\n"));
 }
 
 // ============================================================================
-// HELPER: COUNT LINES
+// WRITE COALESCING
 // ============================================================================
 
-uint16_t SDLogger::countLines(const char* filename) {
-    if (!SD.exists(filename)) {
-        return 0;
-    }
+void SDLogger::loop() {
+    logWriter.poll();
+}
 
-    File file = SD.open(filename, FILE_READ);
+void SDLogger::flush() {
+    logWriter.flush();
+}
+
+size_t SDLogger::appendToFile(void* context, const uint8_t* data, size_t len) {
+    File file = SD.open((const char*)context, FILE_APPEND);
     if (!file) {
         return 0;
     }
 
-    uint16_t lines = 0;
-    while (file.available()) {
-        String line = file.readStringUntil('\n');
-        if (line.length() > 0) {
-            lines++;
-        }
-    }
-
+    size_t written = file.write(data, len);
     file.close();
-    return lines;
+    return written;
 }
 
-// ============================================================================
-// HELPER: READ LINE
-// ============================================================================
-
-bool SDLogger::readLine(const char* filename, uint16_t lineNumber, String& output) {
+uint32_t SDLogger::fileSize(const char* filename) {
     if (!SD.exists(filename)) {
-        return false;
+        return 0;
     }
 
     File file = SD.open(filename, FILE_READ);
     if (!file) {
-        return false;
-    }
-
-    uint16_t currentLine = 0;
-    while (file.available()) {
-        String line = file.readStringUntil('\n');
-        if (currentLine == lineNumber) {
-            output = line;
-            file.close();
-            return true;
-        }
-        currentLine++;
+        return 0;
     }
 
+    uint32_t size = file.size();
     file.close();
-    return false;
-}
-
-// ============================================================================
-// HELPER: REMOVE FIRST LINE
-// ============================================================================
-
-bool SDLogger::removeFirstLine(const char* filename) {
-    if (!SD.exists(filename)) {
-        return false;
-    }
-
-    // Create temporary file
-    const char* tempFile = "/temp.tmp";
-
-    File source = SD.open(filename, FILE_READ);
-    if (!source) {
-        return false;
-    }
-
-    File dest = SD.open(tempFile, FILE_WRITE);
-    if (!dest) {
-        source.close();
-        return false;
-    }
-
-    // Skip first line
-    if (source.available()) {
-        source.readStringUntil('\n');
-    }
-
-    // Copy remaining lines
-    while (source.available()) {
-        String line = source.readStringUntil('\n');
-        dest.println(line);
-    }
-
-    source.close();
-    dest.close();
-
-    // Replace original file
-    SD.remove(filename);
-    SD.rename(tempFile, filename);
-
-    return true;
+    return size;
 }
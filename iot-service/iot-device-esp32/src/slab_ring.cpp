@@ -0,0 +1,246 @@
+#include "slab_ring.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif
+
+// ============================================================================
+// SLAB RING IMPLEMENTATION
+// ============================================================================
+// Slab header of a record: [len lo][len hi][0][0]. len == PADDING_MARKER
+// means "rest of the arena is unused, continue at slab 0".
+
+#define PADDING_MARKER 0xFFFF
+
+namespace {
+    inline uint16_t readLength(const uint8_t* slab) {
+        return (uint16_t)slab[0] | ((uint16_t)slab[1] << 8);
+    }
+
+    inline void writeLength(uint8_t* slab, uint16_t len) {
+        slab[0] = len & 0xFF;
+        slab[1] = len >> 8;
+        slab[2] = 0;
+        slab[3] = 0;
+    }
+}
+
+SlabRing::SlabRing() {
+    arena = nullptr;
+    inPsram = false;
+    slabSize = 0;
+    slabCount = 0;
+    head = 0;
+    tail = 0;
+    usedSlabs = 0;
+    records = 0;
+    reservedSlabs = 0;
+    droppedRecords = 0;
+    highWaterRecords = 0;
+}
+
+SlabRing::~SlabRing() {
+    end();
+}
+
+// ========================================
+// Lifecycle
+// ========================================
+
+bool SlabRing::begin(size_t bytes, size_t slab, bool preferPsram) {
+    end();
+
+    if (slab <= SLAB_RECORD_HEADER_SIZE || bytes < slab * 2) {
+        return false;
+    }
+
+    slabSize = slab;
+    slabCount = bytes / slab;
+
+    #ifdef ESP_PLATFORM
+    if (preferPsram && heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0) {
+        arena = (uint8_t*)heap_caps_malloc(slabCount * slabSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        inPsram = arena != nullptr;
+    }
+    #else
+    (void)preferPsram;
+    #endif
+
+    if (arena == nullptr) {
+        arena = (uint8_t*)malloc(slabCount * slabSize);
+    }
+
+    if (arena == nullptr) {
+        slabCount = 0;
+        return false;
+    }
+
+    clear();
+    return true;
+}
+
+void SlabRing::end() {
+    if (arena == nullptr) {
+        return;
+    }
+
+    #ifdef ESP_PLATFORM
+    heap_caps_free(arena);
+    #else
+    free(arena);
+    #endif
+
+    arena = nullptr;
+    inPsram = false;
+    slabCount = 0;
+}
+
+void SlabRing::clear() {
+    head = 0;
+    tail = 0;
+    usedSlabs = 0;
+    records = 0;
+    reservedSlabs = 0;
+}
+
+size_t SlabRing::maxRecordSize() const {
+    size_t max = slabCount * slabSize - SLAB_RECORD_HEADER_SIZE;
+    return max < PADDING_MARKER ? max : PADDING_MARKER - 1;
+}
+
+size_t SlabRing::slabsFor(size_t len) const {
+    return (len + SLAB_RECORD_HEADER_SIZE + slabSize - 1) / slabSize;
+}
+
+// ========================================
+// Write
+// ========================================
+
+bool SlabRing::push(const uint8_t* data, size_t len) {
+    uint8_t* dest = reserve(len);
+    if (dest == nullptr) {
+        return false;
+    }
+    memcpy(dest, data, len);
+    return commit(len);
+}
+
+uint8_t* SlabRing::reserve(size_t len) {
+    if (arena == nullptr || len == 0 || len > maxRecordSize()) {
+        return nullptr;
+    }
+
+    size_t slabs = slabsFor(len);
+    if (!makeRoom(slabs)) {
+        return nullptr;
+    }
+
+    reservedSlabs = slabs;
+    return slabAt(tail) + SLAB_RECORD_HEADER_SIZE;
+}
+
+bool SlabRing::commit(size_t len) {
+    if (reservedSlabs == 0 || len == 0 || slabsFor(len) > reservedSlabs) {
+        reservedSlabs = 0;
+        return false;
+    }
+
+    size_t slabs = slabsFor(len);
+    writeLength(slabAt(tail), (uint16_t)len);
+
+    tail += slabs;
+    if (tail == slabCount) {
+        tail = 0;
+    }
+    usedSlabs += slabs;
+    records++;
+    reservedSlabs = 0;
+
+    if (records > highWaterRecords) {
+        highWaterRecords = records;
+    }
+    return true;
+}
+
+bool SlabRing::makeRoom(size_t slabs) {
+    while (true) {
+        // Slabs needed at tail, including padding when the record would
+        // run past the end of the arena
+        bool wraps = tail + slabs > slabCount;
+        size_t needed = wraps ? (slabCount - tail) + slabs : slabs;
+
+        if (slabCount - usedSlabs >= needed) {
+            if (wraps) {
+                writeLength(slabAt(tail), PADDING_MARKER);
+                usedSlabs += slabCount - tail;
+                tail = 0;
+            }
+            return true;
+        }
+
+        if (records == 0) {
+            // Only padding left - start over at the beginning of the arena
+            clear();
+            if (slabs > slabCount) {
+                return false;
+            }
+            continue;
+        }
+
+        dropOldest();
+    }
+}
+
+// ========================================
+// Read
+// ========================================
+
+void SlabRing::skipPadding() {
+    if (records > 0 && readLength(slabAt(head)) == PADDING_MARKER) {
+        usedSlabs -= slabCount - head;
+        head = 0;
+    }
+}
+
+const uint8_t* SlabRing::peek(size_t& len) {
+    len = 0;
+    if (arena == nullptr || records == 0) {
+        return nullptr;
+    }
+
+    skipPadding();
+    len = readLength(slabAt(head));
+    return slabAt(head) + SLAB_RECORD_HEADER_SIZE;
+}
+
+bool SlabRing::pop() {
+    if (arena == nullptr || records == 0) {
+        return false;
+    }
+
+    skipPadding();
+    size_t slabs = slabsFor(readLength(slabAt(head)));
+
+    head += slabs;
+    if (head == slabCount) {
+        head = 0;
+    }
+    usedSlabs -= slabs;
+    records--;
+
+    if (records == 0) {
+        // Only padding can be left - restart at slab 0
+        head = 0;
+        tail = 0;
+        usedSlabs = 0;
+    }
+    return true;
+}
+
+void SlabRing::dropOldest() {
+    if (pop()) {
+        droppedRecords++;
+    }
+}
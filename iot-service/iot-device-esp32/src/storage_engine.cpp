@@ -0,0 +1,272 @@
+#include "storage_engine.h"
+#include "metrics.h"
+#include <string.h>
+
+// ============================================================================
+// STORAGE ENGINE IMPLEMENTATION
+// ============================================================================
+
+StorageEngine::StorageEngine() {
+    memset(backends, 0, sizeof(backends));
+    backendCount = 0;
+    active = -1;
+    recovered = -1;
+    retryMs = 0;
+    millisFn = nullptr;
+    lastRetry = 0;
+    lastProbe = 0;
+    scratch = nullptr;
+    scratchSize = 0;
+    salvageTarget = nullptr;
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool StorageEngine::addBackend(QueueBackend* backend) {
+    if (backend == nullptr || backendCount >= STORAGE_ENGINE_MAX_BACKENDS) {
+        return false;
+    }
+    backends[backendCount++] = backend;
+    return true;
+}
+
+bool StorageEngine::begin(uint32_t retry, ClockFn millisClock, uint8_t* buffer, size_t bufferSize) {
+    retryMs = retry;
+    millisFn = millisClock;
+    scratch = buffer;
+    scratchSize = bufferSize;
+    lastRetry = millisFn ? millisFn() : 0;
+    lastProbe = lastRetry;
+
+    // Mount all of them: lower ones may hold records from an earlier outage
+    active = -1;
+    recovered = -1;
+    for (uint8_t i = 0; i < backendCount; i++) {
+        if (backends[i]->mount() && active < 0) {
+            active = i;
+        }
+    }
+
+    return active >= 0;
+}
+
+// ========================================
+// Write
+// ========================================
+
+bool StorageEngine::push(const uint8_t* data, size_t len) {
+    ScopedMetric timer(METRIC_STORAGE_PUSH);
+    while (active >= 0) {
+        if (backends[active]->push(data, len)) {
+            return true;
+        }
+        failover(active);
+    }
+    return false;
+}
+
+void StorageEngine::failover(uint8_t index) {
+    // Next backend down that is (or can be) mounted takes over
+    int8_t next = -1;
+    for (uint8_t i = index + 1; i < backendCount; i++) {
+        if (backends[i]->isMounted() || backends[i]->mount()) {
+            next = i;
+            break;
+        }
+    }
+
+    salvageTarget = next >= 0 ? backends[next] : nullptr;
+    backends[index]->unmount(salvageInto, this);
+    salvageTarget = nullptr;
+
+    stats.failovers++;
+    if (recovered == index) {
+        recovered = -1;
+    }
+    if (active == index) {
+        active = next;
+    }
+}
+
+void StorageEngine::salvageInto(void* context, const uint8_t* data, size_t len) {
+    StorageEngine* engine = (StorageEngine*)context;
+    if (engine->salvageTarget && engine->salvageTarget->push(data, len)) {
+        engine->stats.salvagedRecords++;
+    } else {
+        engine->stats.lostRecords++;
+    }
+}
+
+// ========================================
+// Read
+// ========================================
+
+QueueBackend* StorageEngine::readBackend() const {
+    for (uint8_t i = 0; i < backendCount; i++) {
+        if (backends[i]->isMounted() && backends[i]->count() > 0) {
+            return backends[i];
+        }
+    }
+    return nullptr;
+}
+
+size_t StorageEngine::peekLength() {
+    QueueBackend* backend = readBackend();
+    return backend ? backend->peekLength() : 0;
+}
+
+const uint8_t* StorageEngine::peek(size_t& len) {
+    ScopedMetric timer(METRIC_STORAGE_READ);
+    QueueBackend* backend = readBackend();
+    if (backend == nullptr) {
+        len = 0;
+        return nullptr;
+    }
+    return backend->peek(len);
+}
+
+bool StorageEngine::pop(uint8_t* buf, size_t capacity, size_t& len) {
+    ScopedMetric timer(METRIC_STORAGE_READ);
+    QueueBackend* backend = readBackend();
+    len = 0;
+    return backend && backend->pop(buf, capacity, len);
+}
+
+bool StorageEngine::skip() {
+    QueueBackend* backend = readBackend();
+    return backend && backend->skip();
+}
+
+uint32_t StorageEngine::count() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < backendCount; i++) {
+        if (backends[i]->isMounted()) {
+            total += backends[i]->count();
+        }
+    }
+    return total;
+}
+
+bool StorageEngine::clear() {
+    bool ok = true;
+    for (uint8_t i = 0; i < backendCount; i++) {
+        if (backends[i]->isMounted()) {
+            ok = backends[i]->clear() && ok;
+        }
+    }
+    return ok;
+}
+
+// ========================================
+// Maintenance
+// ========================================
+
+void StorageEngine::poll() {
+    ScopedMetric timer(METRIC_STORAGE_POLL);
+    for (uint8_t i = 0; i < backendCount; i++) {
+        if (backends[i]->isMounted()) {
+            backends[i]->poll();
+        }
+    }
+
+    if (millisFn && millisFn() - lastProbe >= STORAGE_ENGINE_PROBE_MS) {
+        lastProbe = millisFn();
+        if (active >= 0 && !backends[active]->probe()) {
+            failover(active);
+        }
+    }
+
+    if (millisFn && millisFn() - lastRetry >= retryMs) {
+        lastRetry = millisFn();
+        retryMounts();
+    }
+
+    migrateStep();
+}
+
+void StorageEngine::flush() {
+    for (uint8_t i = 0; i < backendCount; i++) {
+        if (backends[i]->isMounted()) {
+            backends[i]->flush();
+        }
+    }
+}
+
+void StorageEngine::retryMounts() {
+    int8_t limit = migrationTarget() >= 0 ? migrationTarget() : backendCount;
+    for (int8_t i = 0; i < limit; i++) {
+        if (backends[i]->mount()) {
+            if (active < 0) {
+                active = i;
+                stats.recoveries++;
+            } else {
+                recovered = i;
+            }
+            return;
+        }
+    }
+}
+
+int8_t StorageEngine::migrationSource() const {
+    int8_t target = migrationTarget();
+    for (uint8_t i = target + 1; target >= 0 && i < backendCount; i++) {
+        if (backends[i]->isMounted() && backends[i]->count() > 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool StorageEngine::isMigrating() const {
+    return recovered >= 0 || migrationSource() >= 0;
+}
+
+void StorageEngine::migrateStep() {
+    for (uint8_t moved = 0; moved < STORAGE_ENGINE_MIGRATE_BATCH && migrationTarget() >= 0; moved++) {
+        // Oldest leftovers first: the backend right below the target
+        int8_t from = migrationSource();
+        if (from < 0) {
+            // Lower backends drained: new records can go up now
+            if (recovered >= 0) {
+                active = recovered;
+                recovered = -1;
+                stats.recoveries++;
+            }
+            return;
+        }
+
+        QueueBackend* source = backends[from];
+        int8_t to = migrationTarget();
+        QueueBackend* target = backends[to];
+        size_t len;
+        const uint8_t* record = source->peek(len);
+
+        if (record != nullptr) {
+            // In place: only drop it from the source once the target has it
+            if (!target->push(record, len)) {
+                failover(to);
+                return;
+            }
+            source->skip();
+        } else {
+            if (!source->pop(scratch, scratchSize, len)) {
+                if (source->peekLength() <= scratchSize) {
+                    return;  // Read error, try again next poll
+                }
+                // Larger than any record we queue - cannot be moved
+                source->skip();
+                stats.lostRecords++;
+                continue;
+            }
+            if (!target->push(scratch, len)) {
+                failover(to);
+                // Already out of the source; try whoever is active now
+                if (!push(scratch, len)) {
+                    stats.lostRecords++;
+                }
+                return;
+            }
+        }
+
+        stats.migratedRecords++;
+    }
+}
@@ -1,249 +1,238 @@
 #include "storage_manager.h"
 #include "config.h"
+#include <SPI.h>
+#include <sys/stat.h>
 
 // ============================================================================
-// STORAGE MANAGER IMPLEMENTATION
+// ARDUINO FILESYSTEM BACKENDS
 // ============================================================================
 
-StorageManager::StorageManager() {
-    sdAvailable = false;
-    littlefsAvailable = false;
-    activeStorage = STORAGE_NONE;
-    ramQueueCount = 0;
-    ramQueueHead = 0;
-    ramQueueTail = 0;
-}
-
-// ========================================
-// Initialization
-// ========================================
-
-bool StorageManager::begin() {
-    Serial.println(F("[Storage] Initializing storage..."));
-
-    // Try SD card first (primary)
-    if (initSD()) {
-        activeStorage = STORAGE_SD_CARD;
-        Serial.println(F("[Storage] ✅ Using SD Card (primary)"));
+// Card mount shared by the SD queue and the history archive
+// (StorageManager::mountSd): a mount that still answers is kept as it is
+static bool mountSdCard() {
+    struct stat st;
+    if (SD.cardType() != CARD_NONE && stat(SD_QUEUE_DIR, &st) == 0) {
         return true;
     }
 
-    // Try LittleFS (fallback)
-    if (initLittleFS()) {
-        activeStorage = STORAGE_LITTLEFS;
-        Serial.println(F("[Storage] ⚠️  SD Card failed, using LittleFS (fallback)"));
-        return true;
-    }
+    // Drop a stale mount first: after the card was pulled SD.begin() would
+    // otherwise report success on the old handle
+    SD.end();
 
-    // Last resort: RAM queue
-    activeStorage = STORAGE_RAM;
-    Serial.println(F("[Storage] ⚠️  No filesystem available, using RAM queue (limited)"));
-    return true;
-}
-
-bool StorageManager::initSD() {
-    #if DEBUG_SD
-    Serial.println(F("[Storage] Trying SD Card..."));
-    #endif
-
-    if (!SD.begin()) {
+    SPI.begin(SD_SCK_PIN, SD_MISO_PIN, SD_MOSI_PIN, SD_CS_PIN);
+    if (!SD.begin(SD_CS_PIN, SPI)) {
         #if DEBUG_SD
         Serial.println(F("[Storage] SD Card init failed"));
         #endif
         return false;
     }
 
-    sdAvailable = true;
-    #if DEBUG_SD
-    Serial.println(F("[Storage] SD Card initialized"));
-    #endif
+    if (SD.cardType() == CARD_NONE) {
+        #if DEBUG_SD
+        Serial.println(F("[Storage] No SD card attached"));
+        #endif
+        SD.end();
+        return false;
+    }
+
     return true;
 }
 
-bool StorageManager::initLittleFS() {
-    #if DEBUG_SD
-    Serial.println(F("[Storage] Trying LittleFS..."));
-    #endif
+bool SdQueueBackend::mountFilesystem() {
+    return mountSdCard();
+}
 
+bool LittleFsQueueBackend::mountFilesystem() {
     if (!LittleFS.begin(true)) {  // format if mount failed
         #if DEBUG_SD
         Serial.println(F("[Storage] LittleFS init failed"));
         #endif
         return false;
     }
-
-    littlefsAvailable = true;
-    #if DEBUG_SD
-    Serial.println(F("[Storage] LittleFS initialized"));
-    #endif
     return true;
 }
 
-bool StorageManager::isAvailable() {
-    return activeStorage != STORAGE_NONE;
+static FileQueueBackend::Config queueConfig(const char* name, const char* dir,
+                                            uint16_t maxSegments, size_t blockSize) {
+    FileQueueBackend::Config config;
+    config.name = name;
+    config.dir = dir;
+    config.segmentSize = QUEUE_SEGMENT_SIZE;
+    config.maxSegments = maxSegments;
+    config.blockSize = blockSize;
+    config.stagingSize = STORAGE_STAGING_SIZE;
+    config.durabilityMs = STORAGE_DURABILITY_MS;
+    config.millisFn = millis;
+    config.microsFn = micros;
+    return config;
 }
 
-// ========================================
-// Queue Management
-// ========================================
+// ============================================================================
+// STORAGE MANAGER IMPLEMENTATION
+// ============================================================================
 
-bool StorageManager::queueTelemetry(JsonDocument& doc) {
-    switch (activeStorage) {
-        case STORAGE_SD_CARD:
-            return queueToSD(doc);
+StorageManager::StorageManager()
+    : sdQueue(queueConfig("SD Card", SD_QUEUE_DIR, SD_QUEUE_MAX_SEGMENTS, SD_WRITE_BLOCK_SIZE)),
+      lfsQueue(queueConfig("LittleFS", LITTLEFS_QUEUE_DIR, LFS_QUEUE_MAX_SEGMENTS, LFS_WRITE_BLOCK_SIZE)),
+      ramQueue(RAM_QUEUE_PSRAM_BYTES, RAM_QUEUE_INTERNAL_BYTES, RAM_QUEUE_SLAB_SIZE) {
+    recordBuffer = nullptr;
+    lastActive = -1;
+    lostReported = 0;
+
+    // Order matters: StorageType values are the engine's backend indexes
+    engine.addBackend(&sdQueue);
+    engine.addBackend(&lfsQueue);
+    engine.addBackend(&ramQueue);
+}
 
-        case STORAGE_LITTLEFS:
-            return queueToLittleFS(doc);
+// ========================================
+// Initialization
+// ========================================
 
-        case STORAGE_RAM:
-            return queueToRAM(doc);
+bool StorageManager::begin() {
+    Serial.println(F("[Storage] Initializing storage..."));
 
-        default:
-            Serial.println(F("[Storage] ❌ No storage available!"));
+    if (recordBuffer == nullptr) {
+        recordBuffer = (uint8_t*)malloc(QUEUE_RECORD_MAX_PAYLOAD + 1);
+        if (recordBuffer == nullptr) {
+            Serial.println(F("[Storage] ❌ Failed to allocate record buffer"));
             return false;
+        }
     }
-}
 
-bool StorageManager::queueToSD(JsonDocument& doc) {
-    File file = SD.open(SD_QUEUE_FILE, FILE_APPEND);
-    if (!file) {
-        Serial.println(F("[Storage] ❌ Failed to open SD queue file"));
-        return false;
-    }
+    bool ok = engine.begin(STORAGE_RETRY_MS, millis, recordBuffer, QUEUE_RECORD_MAX_PAYLOAD);
 
-    String jsonLine;
-    serializeJson(doc, jsonLine);
-    file.println(jsonLine);
-    file.close();
+    if (sdQueue.isMounted()) {
+        reportRecovery(sdQueue);
+        importLegacyQueue(SD_QUEUE_FILE, SD, sdQueue);
+        importLegacyQueue(SD_LOGGER_QUEUE_FILE, SD, sdQueue);
+    }
+    if (lfsQueue.isMounted()) {
+        reportRecovery(lfsQueue);
+        importLegacyQueue(LITTLEFS_QUEUE_FILE, LittleFS, lfsQueue);
+    }
 
     #if DEBUG_SD
-    Serial.println(F("[Storage] ✅ Queued to SD Card"));
+    if (ramQueue.isMounted()) {
+        const SlabRing& ring = ramQueue.getRing();
+        Serial.printf("[Storage] RAM queue: %u KB in %s (%u B slabs)\n",
+                      (unsigned)(ring.capacityBytes() / 1024),
+                      ring.isInPsram() ? "PSRAM" : "internal RAM",
+                      (unsigned)RAM_QUEUE_SLAB_SIZE);
+    }
     #endif
 
-    return true;
-}
-
-bool StorageManager::queueToLittleFS(JsonDocument& doc) {
-    File file = LittleFS.open(LITTLEFS_QUEUE_FILE, "a");
-    if (!file) {
-        Serial.println(F("[Storage] ❌ Failed to open LittleFS queue file"));
-        return false;
+    lastActive = engine.getActiveIndex();
+    switch (getActiveStorage()) {
+        case STORAGE_SD_CARD:
+            Serial.println(F("[Storage] ✅ Using SD Card (primary)"));
+            break;
+        case STORAGE_LITTLEFS:
+            Serial.println(F("[Storage] ⚠️  SD Card failed, using LittleFS (fallback)"));
+            break;
+        case STORAGE_RAM:
+            Serial.println(F("[Storage] ⚠️  No filesystem available, using RAM queue (limited)"));
+            break;
+        default:
+            Serial.println(F("[Storage] ❌ No storage available!"));
+            break;
     }
 
-    String jsonLine;
-    serializeJson(doc, jsonLine);
-    file.println(jsonLine);
-    file.close();
+    return ok;
+}
 
+void StorageManager::reportRecovery(const FileQueueBackend& backend) {
+    const RecordLog& log = backend.getLog();
+    const RecordLog::RecoveryInfo& info = log.getRecoveryInfo();
     #if DEBUG_SD
-    Serial.println(F("[Storage] ✅ Queued to LittleFS"));
+    Serial.printf("[Storage] Queue %s: %lu records, %lu segments, recovered in %lu us\n",
+                  backend.getName(), (unsigned long)log.count(), (unsigned long)info.segments,
+                  (unsigned long)info.recoveryMicros);
     #endif
-
-    return true;
-}
-
-bool StorageManager::queueToRAM(JsonDocument& doc) {
-    if (ramQueueCount >= MAX_RAM_QUEUE_SIZE) {
-        Serial.println(F("[Storage] ⚠️  RAM queue full! Dropping oldest..."));
-        // Drop oldest to make room
-        ramQueueHead = (ramQueueHead + 1) % MAX_RAM_QUEUE_SIZE;
-        ramQueueCount--;
+    if (info.truncatedBytes > 0) {
+        Serial.printf("[Storage] ⚠️  Truncated %lu torn bytes at %s queue tail\n",
+                      (unsigned long)info.truncatedBytes, backend.getName());
     }
+}
 
-    String jsonLine;
-    serializeJson(doc, jsonLine);
-    ramQueue[ramQueueTail] = jsonLine;
-    ramQueueTail = (ramQueueTail + 1) % MAX_RAM_QUEUE_SIZE;
-    ramQueueCount++;
+bool StorageManager::mountSd() {
+    return mountSdCard();
+}
 
-    #if DEBUG_SD
-    Serial.print(F("[Storage] ✅ Queued to RAM ("));
-    Serial.print(ramQueueCount);
-    Serial.print(F("/"));
-    Serial.print(MAX_RAM_QUEUE_SIZE);
-    Serial.println(F(")"));
-    #endif
+bool StorageManager::isAvailable() {
+    return engine.getActive() != nullptr;
+}
 
-    return true;
+StorageType StorageManager::getActiveStorage() {
+    int8_t index = engine.getActiveIndex();
+    return index >= 0 ? (StorageType)index : STORAGE_NONE;
 }
 
 // ========================================
-// Dequeue
+// Queue Management
 // ========================================
 
-bool StorageManager::dequeueOldest(JsonDocument& doc) {
-    switch (activeStorage) {
-        case STORAGE_SD_CARD:
-            return dequeueFromSD(doc);
-
-        case STORAGE_LITTLEFS:
-            return dequeueFromLittleFS(doc);
-
-        case STORAGE_RAM:
-            return dequeueFromRAM(doc);
-
-        default:
-            return false;
+bool StorageManager::queueTelemetry(JsonDocument& doc) {
+    if (recordBuffer == nullptr || !isAvailable()) {
+        Serial.println(F("[Storage] ❌ No storage available!"));
+        return false;
     }
-}
 
-bool StorageManager::dequeueFromSD(JsonDocument& doc) {
-    File file = SD.open(SD_QUEUE_FILE, FILE_READ);
-    if (!file || file.size() == 0) {
+    // +1 for ArduinoJson's terminator
+    size_t length = measureJson(doc);
+    if (length == 0 || length > QUEUE_RECORD_MAX_PAYLOAD) {
+        Serial.println(F("[Storage] ❌ Record too large to queue"));
         return false;
     }
+    serializeJson(doc, (char*)recordBuffer, length + 1);
 
-    // Read first line
-    String line = file.readStringUntil('\n');
-    file.close();
-
-    // Parse JSON
-    DeserializationError error = deserializeJson(doc, line);
-    if (error) {
-        Serial.println(F("[Storage] ❌ Failed to parse queued JSON"));
+    if (!engine.push(recordBuffer, length)) {
+        Serial.println(F("[Storage] ❌ Failed to queue record"));
         return false;
     }
+    reportActiveChange();
 
-    // Remove first line
-    removeFirstLine(SD_QUEUE_FILE, SD);
+    #if DEBUG_SD
+    Serial.print(F("[Storage] ✅ Queued to "));
+    Serial.println(engine.getActive()->getName());
+    #endif
 
     return true;
 }
 
-bool StorageManager::dequeueFromLittleFS(JsonDocument& doc) {
-    File file = LittleFS.open(LITTLEFS_QUEUE_FILE, "r");
-    if (!file || file.size() == 0) {
-        return false;
-    }
-
-    // Read first line
-    String line = file.readStringUntil('\n');
-    file.close();
+// ========================================
+// Dequeue
+// ========================================
 
-    // Parse JSON
-    DeserializationError error = deserializeJson(doc, line);
-    if (error) {
-        Serial.println(F("[Storage] ❌ Failed to parse queued JSON"));
+bool StorageManager::dequeueOldest(JsonDocument& doc) {
+    if (recordBuffer == nullptr) {
         return false;
     }
 
-    // Remove first line
-    removeFirstLine(LITTLEFS_QUEUE_FILE, LittleFS);
-
-    return true;
-}
-
-bool StorageManager::dequeueFromRAM(JsonDocument& doc) {
-    if (ramQueueCount == 0) {
-        return false;
+    // RAM records parse in place; file records are read into the buffer
+    size_t length;
+    const uint8_t* record = engine.peek(length);
+    DeserializationError error;
+
+    if (record != nullptr) {
+        error = deserializeJson(doc, (const char*)record, length);
+        engine.skip();
+    } else {
+        length = engine.peekLength();
+        if (length == 0) {
+            return false;
+        }
+        if (!engine.pop(recordBuffer, QUEUE_RECORD_MAX_PAYLOAD, length)) {
+            if (length > QUEUE_RECORD_MAX_PAYLOAD) {
+                engine.skip();  // Can never be read back, don't stall on it
+            }
+            Serial.println(F("[Storage] ❌ Failed to read queued record"));
+            return false;
+        }
+        error = deserializeJson(doc, (const char*)recordBuffer, length);
     }
 
-    String line = ramQueue[ramQueueHead];
-    ramQueueHead = (ramQueueHead + 1) % MAX_RAM_QUEUE_SIZE;
-    ramQueueCount--;
-
-    // Parse JSON
-    DeserializationError error = deserializeJson(doc, line);
+    // The record is already removed - a bad payload never stalls the queue
     if (error) {
         Serial.println(F("[Storage] ❌ Failed to parse queued JSON"));
         return false;
@@ -257,35 +246,7 @@ bool StorageManager::dequeueFromRAM(JsonDocument& doc) {
 // ========================================
 
 uint16_t StorageManager::getQueueSize() {
-    switch (activeStorage) {
-        case STORAGE_SD_CARD:
-            return getFileQueueSize(SD_QUEUE_FILE, SD);
-
-        case STORAGE_LITTLEFS:
-            return getFileQueueSize(LITTLEFS_QUEUE_FILE, LittleFS);
-
-        case STORAGE_RAM:
-            return ramQueueCount;
-
-        default:
-            return 0;
-    }
-}
-
-uint16_t StorageManager::getFileQueueSize(const char* filename, fs::FS& filesystem) {
-    File file = filesystem.open(filename, FILE_READ);
-    if (!file) {
-        return 0;
-    }
-
-    uint16_t count = 0;
-    while (file.available()) {
-        file.readStringUntil('\n');
-        count++;
-    }
-
-    file.close();
-    return count;
+    return min(engine.count(), (uint32_t)UINT16_MAX);
 }
 
 // ========================================
@@ -293,28 +254,7 @@ uint16_t StorageManager::getFileQueueSize(const char* filename, fs::FS& filesyst
 // ========================================
 
 bool StorageManager::clearQueue() {
-    switch (activeStorage) {
-        case STORAGE_SD_CARD:
-            if (SD.exists(SD_QUEUE_FILE)) {
-                SD.remove(SD_QUEUE_FILE);
-            }
-            return true;
-
-        case STORAGE_LITTLEFS:
-            if (LittleFS.exists(LITTLEFS_QUEUE_FILE)) {
-                LittleFS.remove(LITTLEFS_QUEUE_FILE);
-            }
-            return true;
-
-        case STORAGE_RAM:
-            ramQueueHead = 0;
-            ramQueueTail = 0;
-            ramQueueCount = 0;
-            return true;
-
-        default:
-            return false;
-    }
+    return engine.clear();
 }
 
 // ========================================
@@ -322,7 +262,7 @@ bool StorageManager::clearQueue() {
 // ========================================
 
 uint32_t StorageManager::getFreeSpaceMB() {
-    switch (activeStorage) {
+    switch (getActiveStorage()) {
         case STORAGE_SD_CARD:
             return (SD.totalBytes() - SD.usedBytes()) / (1024 * 1024);
 
@@ -338,7 +278,7 @@ uint32_t StorageManager::getFreeSpaceMB() {
 }
 
 String StorageManager::getStorageTypeName() {
-    switch (activeStorage) {
+    switch (getActiveStorage()) {
         case STORAGE_SD_CARD:
             return "SD Card";
         case STORAGE_LITTLEFS:
@@ -359,57 +299,190 @@ void StorageManager::printInfo() {
     Serial.print(F("Queue Size: "));
     Serial.println(getQueueSize());
 
-    if (activeStorage != STORAGE_RAM) {
+    for (uint8_t i = 0; i < engine.getBackendCount(); i++) {
+        QueueBackend* backend = engine.getBackend(i);
+        Serial.print(F("  "));
+        Serial.print(backend->getName());
+        Serial.print(F(": "));
+        if (backend->isMounted()) {
+            Serial.print(backend->count());
+            Serial.println(F(" records"));
+        } else {
+            Serial.println(F("unavailable"));
+        }
+    }
+
+    const StorageEngine::Stats& engineStats = engine.getStats();
+    Serial.print(F("Failovers / Recoveries: "));
+    Serial.print(engineStats.failovers);
+    Serial.print(F(" / "));
+    Serial.println(engineStats.recoveries);
+    Serial.print(F("Salvaged / Migrated / Lost: "));
+    Serial.print(engineStats.salvagedRecords);
+    Serial.print(F(" / "));
+    Serial.print(engineStats.migratedRecords);
+    Serial.print(F(" / "));
+    Serial.println(engineStats.lostRecords);
+
+    if (getActiveStorage() != STORAGE_RAM) {
         Serial.print(F("Free Space: "));
         Serial.print(getFreeSpaceMB());
         Serial.println(F(" MB"));
     }
 
-    if (activeStorage == STORAGE_RAM) {
+    if (ramQueue.isMounted()) {
+        const SlabRing& ring = ramQueue.getRing();
         Serial.print(F("RAM Queue: "));
-        Serial.print(ramQueueCount);
+        Serial.print(ring.usedBytes() / 1024);
         Serial.print(F("/"));
-        Serial.print(MAX_RAM_QUEUE_SIZE);
-        Serial.println(F(" slots"));
-        Serial.println(F("⚠️  WARNING: RAM queue is volatile (lost on restart)"));
+        Serial.print(ring.capacityBytes() / 1024);
+        Serial.print(F(" KB in "));
+        Serial.println(ring.isInPsram() ? F("PSRAM") : F("internal RAM"));
+        Serial.print(F("RAM Records (peak) / Dropped: "));
+        Serial.print(ring.count());
+        Serial.print(F(" ("));
+        Serial.print(ring.getHighWaterRecords());
+        Serial.print(F(") / "));
+        Serial.println(ring.getDroppedRecords());
+        if (getActiveStorage() == STORAGE_RAM) {
+            Serial.println(F("⚠️  WARNING: RAM queue is volatile (lost on restart)"));
+        }
+    }
+
+    const WriteCoalescer* writer = getActiveWriter();
+    if (writer) {
+        const WriteCoalescer::Stats& stats = writer->getStats();
+        Serial.print(F("Staged: "));
+        Serial.print(writer->getStagedBytes());
+        Serial.print(F(" bytes (window "));
+        Serial.print(writer->getMaxAgeMs() / 1000);
+        Serial.println(F(" s)"));
+        Serial.print(F("Records / Writes: "));
+        Serial.print(stats.recordsStaged);
+        Serial.print(F(" / "));
+        Serial.println(stats.sinkWrites);
+        Serial.print(F("Flushes size/age/explicit: "));
+        Serial.print(stats.flushes[WriteCoalescer::FLUSH_SIZE]);
+        Serial.print(F("/"));
+        Serial.print(stats.flushes[WriteCoalescer::FLUSH_AGE]);
+        Serial.print(F("/"));
+        Serial.println(stats.flushes[WriteCoalescer::FLUSH_EXPLICIT]);
+        Serial.print(F("Write amplification: "));
+        Serial.print(writer->getWriteAmplificationX100() / 100.0f, 2);
+        Serial.println(F("x"));
+        Serial.print(F("Write throughput: "));
+        Serial.print(writer->getThroughputBps() / 1024);
+        Serial.println(F(" KB/s"));
+    }
+
+    const RecordLog* log = getActiveLog();
+    if (log) {
+        const RecordLog::RecoveryInfo& info = log->getRecoveryInfo();
+        Serial.print(F("Queue on disk: "));
+        Serial.print(log->getBytesOnDisk() / 1024);
+        Serial.println(F(" KB"));
+        Serial.print(F("Boot recovery: "));
+        Serial.print(info.recoveryMicros / 1000);
+        Serial.print(F(" ms, scanned "));
+        Serial.print(info.scannedBytes);
+        Serial.print(F(" B, truncated "));
+        Serial.print(info.truncatedBytes);
+        Serial.println(F(" B"));
+        Serial.print(F("Dropped / Corrupt / Read errors: "));
+        Serial.print(log->getDroppedRecords());
+        Serial.print(F(" / "));
+        Serial.print(log->getCorruptRecords());
+        Serial.print(F(" / "));
+        Serial.println(log->getReadErrors());
     }
 
     Serial.println(F("==================================\n"));
 }
 
 // ========================================
-// Helpers
+// Maintenance
 // ========================================
 
-bool StorageManager::removeFirstLine(const char* filename, fs::FS& filesystem) {
-    // Read all lines except first
-    File file = filesystem.open(filename, FILE_READ);
-    if (!file) {
-        return false;
-    }
+void StorageManager::loop() {
+    engine.poll();
+    reportActiveChange();
+}
 
-    String tempContent = "";
-    bool firstLine = true;
+void StorageManager::flush() {
+    engine.flush();
+}
 
-    while (file.available()) {
-        String line = file.readStringUntil('\n');
-        if (firstLine) {
-            firstLine = false;
-            continue;  // Skip first line
+void StorageManager::reportActiveChange() {
+    int8_t active = engine.getActiveIndex();
+    if (active == lastActive) {
+        return;
+    }
+
+    const StorageEngine::Stats& stats = engine.getStats();
+    if (active < 0) {
+        Serial.println(F("[Storage] ❌ No storage available!"));
+    } else if (lastActive < 0 || active > lastActive) {
+        Serial.printf("[Storage] ⚠️  Storage failed, queueing to %s (%lu staged records saved so far)\n",
+                      engine.getActive()->getName(), (unsigned long)stats.salvagedRecords);
+    } else {
+        Serial.printf("[Storage] ✅ %s is back, queued records moved up\n",
+                      engine.getActive()->getName());
+        if (active < STORAGE_RAM) {
+            reportRecovery((const FileQueueBackend&)*engine.getActive());
         }
-        tempContent += line + "\n";
     }
 
-    file.close();
+    if (stats.lostRecords != lostReported) {
+        Serial.printf("[Storage] ⚠️  %lu records lost during failover\n",
+                      (unsigned long)(stats.lostRecords - lostReported));
+        lostReported = stats.lostRecords;
+    }
+
+    lastActive = active;
+}
+
+const WriteCoalescer* StorageManager::getActiveWriter() const {
+    const RecordLog* log = getActiveLog();
+    return log ? &log->getWriter() : nullptr;
+}
+
+const RecordLog* StorageManager::getActiveLog() const {
+    switch (engine.getActiveIndex()) {
+        case STORAGE_SD_CARD:
+            return &sdQueue.getLog();
+        case STORAGE_LITTLEFS:
+            return &lfsQueue.getLog();
+        default:
+            return nullptr;
+    }
+}
+
+// ========================================
+// Legacy Queue Import
+// ========================================
+
+void StorageManager::importLegacyQueue(const char* filename, fs::FS& filesystem, QueueBackend& backend) {
+    if (!filesystem.exists(filename)) {
+        return;
+    }
 
-    // Write back
-    file = filesystem.open(filename, FILE_WRITE);
+    File file = filesystem.open(filename, FILE_READ);
     if (!file) {
-        return false;
+        return;
     }
 
-    file.print(tempContent);
+    uint16_t imported = 0;
+    while (file.available()) {
+        String line = file.readStringUntil('\n');
+        line.trim();
+        if (line.length() > 0 && backend.push((const uint8_t*)line.c_str(), line.length())) {
+            imported++;
+        }
+    }
     file.close();
 
-    return true;
+    backend.flush();
+    filesystem.remove(filename);
+
+    Serial.printf("[Storage] Imported %u records from %s\n", imported, filename);
 }
@@ -0,0 +1,88 @@
+#include "task_monitor.h"
+#include <esp_timer.h>
+#include <string.h>
+
+// ============================================================================
+// TASK MONITOR IMPLEMENTATION
+// ============================================================================
+
+TaskMonitor::TaskMonitor(const char* name) {
+    this->name = name;
+    task = nullptr;
+    core = 0;
+    portMUX_INITIALIZE(&lock);
+    windowStart = 0;
+    workStart = 0;
+    busyUs = 0;
+    passes = 0;
+    maxPassMs = 0;
+    maxLateMs = 0;
+    memset(&last, 0, sizeof(last));
+}
+
+void TaskMonitor::attach(TaskHandle_t handle, uint8_t core) {
+    task = handle;
+    this->core = core;
+    windowStart = esp_timer_get_time();
+}
+
+void TaskMonitor::beginWork() {
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&lock);
+    workStart = now;
+    portEXIT_CRITICAL(&lock);
+}
+
+void TaskMonitor::noteLate(uint32_t lateMs) {
+    portENTER_CRITICAL(&lock);
+    if (lateMs > maxLateMs) {
+        maxLateMs = lateMs;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void TaskMonitor::endWork() {
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&lock);
+    if (workStart != 0) {
+        uint32_t passMs = (now - workStart) / 1000;
+        busyUs += now - workStart;
+        passes++;
+        if (passMs > maxPassMs) {
+            maxPassMs = passMs;
+        }
+        workStart = 0;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void TaskMonitor::roll() {
+    int64_t now = esp_timer_get_time();
+    Report report;
+
+    portENTER_CRITICAL(&lock);
+    // A pass still running counts up to now and continues in the next window
+    int64_t busy = busyUs;
+    if (workStart != 0) {
+        busy += now - workStart;
+        workStart = now;
+    }
+    int64_t window = now - windowStart;
+    report.loadPct = window > 0 ? (uint8_t)(busy * 100 / window) : 0;
+    report.passes = passes;
+    report.maxPassMs = maxPassMs;
+    report.maxLateMs = maxLateMs;
+
+    windowStart = now;
+    busyUs = 0;
+    passes = 0;
+    maxPassMs = 0;
+    maxLateMs = 0;
+    portEXIT_CRITICAL(&lock);
+
+    // ESP-IDF reports the high-water mark in bytes
+    report.stackFree = task ? uxTaskGetStackHighWaterMark(task) : 0;
+    last = report;
+}
@@ -1,32 +1,101 @@
 #define TINY_GSM_MODEM_SIM7600
 #include "telemetry.h"
 #include "config.h"
+#include "lte_manager.h"
 #include "mqtt_manager.h"
 #include "connection_manager.h"
 #include "time_manager.h"
 #include "generic_io.h"
 #include "rs485_config_manager.h"
+#include "history_archive.h"
+#include "data_budget.h"
+#include "task_monitor.h"
+#include "metrics_snapshot.h"
+#include "boot_profiler.h"
 #include <ArduinoJson.h>
 #include <TinyGsmClient.h>
 
 // External references
 extern String DEVICE_ID;
 extern TinyGsm modem;
+extern LTEManager lteManager;
 extern MQTTManager mqttManager;
 extern TimeManager timeManager;
 extern ConnectionManager connectionManager;
 extern GenericIOManager ioManager;
+extern HistoryArchive historyArchive;
+extern DataBudget dataBudget;
+extern TaskMonitor acqMonitor;
+extern TaskMonitor commsMonitor;
+extern BootProfiler bootProfiler;
 
 // RS485 functions from main.cpp
 extern bool readRS485Register(uint8_t slaveId, uint16_t regAddr, uint16_t count, uint16_t* output);
 extern float readRS485Float32(uint8_t slaveId, uint16_t regAddr);
 extern uint32_t readRS485Uint32(uint8_t slaveId, uint16_t regAddr);
-extern uint32_t readRS485Uint32(uint8_t slaveId, uint16_t regAddr);
 
 // ============================================================================
 // HELPERS
 // ============================================================================
 
+// History archive: true while a sample cycle is open
+static bool historyCycleOpen = false;
+
+static void beginHistoryCycle(unsigned long unixTime) {
+    historyCycleOpen = historyArchive.isOpen() && timeManager.isSynced() &&
+                       historyArchive.beginCycle(unixTime);
+}
+
+static void commitHistoryCycle() {
+    if (historyCycleOpen) {
+        ScopedMetric timer(METRIC_HISTORY_WRITE);
+        historyArchive.commit();
+        historyCycleOpen = false;
+    }
+}
+
+static void archiveValue(const String& channel, float value) {
+    if (historyCycleOpen) {
+        historyArchive.record(channel.c_str(), value);
+    }
+}
+
+// Identifiers, not measurements
+static bool isArchivedField(const char* field) {
+    return strcmp(field, "channel") != 0 && strcmp(field, "addr") != 0 &&
+           strcmp(field, "pin") != 0 && strcmp(field, "slave_id") != 0;
+}
+
+static void archiveSensors(JsonObject sensors) {
+    if (!historyCycleOpen) {
+        return;
+    }
+
+    for (JsonPair sensor : sensors) {
+        JsonObject sensorObj = sensor.value().as<JsonObject>();
+        if (sensorObj.isNull()) {
+            continue;
+        }
+
+        String prefix = String(sensor.key().c_str()) + ".";
+        for (JsonPair field : sensorObj) {
+            if (!isArchivedField(field.key().c_str())) {
+                continue;
+            }
+            if (field.value().is<JsonObject>()) {
+                // Nested readings, e.g. i2c / rs485 "data": {"voltage": ...}
+                for (JsonPair item : field.value().as<JsonObject>()) {
+                    if (item.value().is<float>()) {
+                        archiveValue(prefix + item.key().c_str(), item.value().as<float>());
+                    }
+                }
+            } else if (field.value().is<float>()) {
+                archiveValue(prefix + field.key().c_str(), field.value().as<float>());
+            }
+        }
+    }
+}
+
 static void transformArrayToObject(JsonDocument& rawDoc, JsonObject& sensors) {
     // Transform analog array to object with keys: analog_gpio1, analog_gpio2
     if (rawDoc.containsKey("analog")) {
@@ -128,20 +197,17 @@ static void transformArrayToObject(JsonDocument& rawDoc, JsonObject& sensors) {
     }
 }
 
-static void buildRealSensors(JsonDocument& doc) {
+static void buildRealSensors(JsonObject sensors) {
     // Generate RAW I/O telemetry first (array format)
     JsonDocument rawDoc;
     ioManager.generateRawTelemetry(rawDoc);
     
     // Transform to sensors object (key-value format)
-    JsonObject sensors = doc["sensors"].to<JsonObject>();
     transformArrayToObject(rawDoc, sensors);
 }
 
 // NEW: Build RS485 data separately
-static void buildRS485Data(JsonDocument& doc) {
-    JsonObject sensors = doc["sensors"].to<JsonObject>();
-    
+static void buildRS485Data(JsonObject sensors) {
     if (!rs485ConfigMgr.hasConfig()) {
         // No config loaded - just report status
         JsonObject rs485Status = sensors["rs485_status"].to<JsonObject>();
@@ -169,36 +235,44 @@ static void buildRS485Data(JsonDocument& doc) {
             }
             
             Serial.printf("[RS485] Device %d: Reading %d registers...\n", 
-                         device.modbus_address, device.registers.size());
+                         device.modbus_address, device.getRegisters().size());
             
             // Read all configured registers
             JsonObject dataObj = deviceObj["data"].to<JsonObject>();
             
-            for (const auto& reg : device.registers) {
-                String key = reg.label;
-                key.replace(" ", "_");
-                key.toLowerCase();
+            for (const auto& reg : device.getRegisters()) {
+                const char* key = reg.key;
                 
-                if (reg.type == "float32") {
+                if (reg.type == RS485_FLOAT32) {
                     float value = readRS485Float32(device.modbus_address, reg.reg - 1);  // Modbus 1-based to 0-based
                     if (!isnan(value)) {
                         dataObj[key] = serialized(String(value, 2));
                         // Skip unit to save space (units known from config)
                     }
                     
-                } else if (reg.type == "uint32") {
+                } else if (reg.type == RS485_UINT32) {
                     uint32_t value = readRS485Uint32(device.modbus_address, reg.reg - 1);
                     dataObj[key] = value;
                     // Skip unit to save space
                     
-                } else if (reg.type == "uint16") {
+                } else if (reg.type == RS485_INT32) {
+                    int32_t value = (int32_t)readRS485Uint32(device.modbus_address, reg.reg - 1);
+                    dataObj[key] = value;
+                    
+                } else if (reg.type == RS485_UINT16) {
                     uint16_t value = 0;
                     if (readRS485Register(device.modbus_address, reg.reg - 1, 1, &value)) {
                         dataObj[key] = value;
                         // Skip unit to save space
                     }
                     
-                } else if (reg.type == "hex16") {
+                } else if (reg.type == RS485_INT16) {
+                    uint16_t value = 0;
+                    if (readRS485Register(device.modbus_address, reg.reg - 1, 1, &value)) {
+                        dataObj[key] = (int16_t)value;
+                    }
+                    
+                } else if (reg.type == RS485_HEX16) {
                     uint16_t value = 0;
                     if (readRS485Register(device.modbus_address, reg.reg - 1, 1, &value)) {
                         char hexStr[8];
@@ -217,6 +291,7 @@ static void buildRS485Data(JsonDocument& doc) {
 }
 
 static void appendNodeInfo(JsonDocument& doc) {
+    ScopedMetric timer(METRIC_NODE_INFO);
     JsonObject node = doc["node"].to<JsonObject>();
     
     // LTE info (essential)
@@ -235,29 +310,134 @@ static void appendNodeInfo(JsonDocument& doc) {
     conn["lte_reconnects"] = connectionManager.getLteReconnectAttempts();
     conn["mqtt_reconnects"] = connectionManager.getMqttReconnectAttempts();
     conn["publish_fail"] = connectionManager.getPublishFailureCount();
+    conn["liveness_fail"] = connectionManager.getLivenessFailures();
+    conn["ping_ms"] = mqttManager.getLastPingMs();
+    conn["ack_ms"] = mqttManager.getClient().getStats().lastAckMs;
+    conn["echo_ms"] = mqttManager.getLastEchoMs();
+
+    // Cellular data this month
+    JsonObject data = node["data"].to<JsonObject>();
+    data["used_kb"] = dataBudget.getUsed() / 1024;
+    data["projected_kb"] = dataBudget.getProjected() / 1024;
+    data["budget_kb"] = dataBudget.getBudget() / 1024;
+    data["level"] = DataBudget::levelName(dataBudget.getLevel());
+
+    // Both tasks over the last report window
+    JsonObject tasks = node["tasks"].to<JsonObject>();
+    for (const TaskMonitor* monitor : { &acqMonitor, &commsMonitor }) {
+        const TaskMonitor::Report& report = monitor->getLast();
+        JsonObject task = tasks[monitor->getName()].to<JsonObject>();
+        task["core"] = monitor->getCore();
+        task["stack_free"] = report.stackFree;
+        task["load_pct"] = report.loadPct;
+        task["max_pass_ms"] = report.maxPassMs;
+        task["max_late_ms"] = report.maxLateMs;
+    }
+}
+
+// Bytes [up, down] per transport and per topic for one month
+static void appendDataUsage(JsonObject usage, const DataBudget::Month& month) {
+    static const char* const TRANSPORT_NAMES[DATA_TRANSPORT_COUNT] = { "mqtt", "tcp", "probe" };
+
+    usage["month"] = month.period;
+    usage["total"] = DataBudget::total(month);
+
+    JsonObject transports = usage["transport"].to<JsonObject>();
+    for (uint8_t t = 0; t < DATA_TRANSPORT_COUNT; t++) {
+        JsonArray bytes = transports[TRANSPORT_NAMES[t]].to<JsonArray>();
+        bytes.add(month.bytes[t][DATA_UP]);
+        bytes.add(month.bytes[t][DATA_DOWN]);
+    }
+
+    JsonObject topics = usage["topics"].to<JsonObject>();
+    for (uint8_t i = 0; i < DATA_BUDGET_TOPICS && month.topics[i].key[0] != '\0'; i++) {
+        JsonArray bytes = topics[month.topics[i].key].to<JsonArray>();
+        bytes.add(month.topics[i].bytes[DATA_UP]);
+        bytes.add(month.topics[i].bytes[DATA_DOWN]);
+    }
+    if (month.otherBytes[DATA_UP] != 0 || month.otherBytes[DATA_DOWN] != 0) {
+        JsonArray bytes = topics["other"].to<JsonArray>();
+        bytes.add(month.otherBytes[DATA_UP]);
+        bytes.add(month.otherBytes[DATA_DOWN]);
+    }
+}
+
+// ============================================================================
+// ACQUISITION (core 1)
+// ============================================================================
+
+bool acquireSample(SensorSample& sample) {
+    ScopedMetric timer(METRIC_ACQ_PASS);
+    sample.takenAt = millis();
+    
+    JsonDocument doc;
+    
+    // Basic sensors (analog, adc16, i2c, digital)
+    buildRealSensors(doc["basic"].to<JsonObject>());
+    
+    // RS485 only when there is something to read
+    if (rs485ConfigMgr.hasConfig() && rs485ConfigMgr.getOnlineCount() > 0) {
+        buildRS485Data(doc["rs485"].to<JsonObject>());
+    }
+    
+    ScopedMetric encode(METRIC_JSON_ENCODE);
+    size_t length = measureJson(doc);
+    if (length >= sizeof(sample.json)) {
+        // Keep the basic sensors, lose only this pass's RS485 readings
+        Serial.printf("[Acq] ⚠️ Sample too large (%u bytes), RS485 readings dropped\n", (unsigned)length);
+        countMetric(COUNTER_SAMPLE_RS485_DROP);
+        doc.remove("rs485");
+        if (measureJson(doc) >= sizeof(sample.json)) {
+            return false;
+        }
+    }
+    sample.length = serializeJson(doc, sample.json, sizeof(sample.json));
+    return true;
 }
 
 // ============================================================================
-// FULL TELEMETRY
+// FULL TELEMETRY (core 0)
 // ============================================================================
 
-void sendFullTelemetry() {
+// Compact telemetry (data budget over): readings only, node info when the
+// node_info job asks for it
+static bool nodeInfoDue = true;
+
+void requestNodeInfo() {
+    nodeInfoDue = true;
+}
+
+// Header fields and readings of one message; node info is appended by the
+// caller (it asks the modem)
+static void buildTelemetryMessage(JsonDocument& doc, JsonObject sensors, const String& timestamp,
+                                  bool compact) {
+    doc["device_id"] = DEVICE_ID;
+    doc["timestamp"] = timestamp;
+    if (!compact) {
+        doc["firmware"] = "esp32s3-multisensor-v2.1";
+    }
+    doc["sensors"] = sensors;
+}
+
+static void publishTelemetry(JsonObject basic, JsonObject rs485, const String& timestamp) {
     if (!mqttManager.isConnected()) {
         Serial.println("[Telemetry] MQTT not ready. Skipping publish.");
         return;
     }
+    ScopedMetric timer(METRIC_TELEMETRY);
+
+    bool compact = dataBudget.isCompact();
+    bool withNodeInfo = !compact || nodeInfoDue;
+    nodeInfoDue = false;
 
     // ========== MESSAGE 1: BASIC SENSORS + NODE INFO ==========
     JsonDocument doc1;
-    doc1["device_id"] = DEVICE_ID;
-    doc1["timestamp"] = timeManager.getTimestamp();
-    doc1["firmware"] = "esp32s3-multisensor-v2.1";
-
-    // Basic sensors (analog, adc16, i2c, digital)
-    buildRealSensors(doc1);
+    buildTelemetryMessage(doc1, basic, timestamp, compact);   // Analog, adc16, i2c, digital
     
     // Node info
-    appendNodeInfo(doc1);
+    if (withNodeInfo) {
+        appendNodeInfo(doc1);
+    }
 
     Serial.println("\n========== BASIC SENSORS TELEMETRY ==========");
     serializeJsonPretty(doc1, Serial);
@@ -276,17 +456,14 @@ void sendFullTelemetry() {
     }
 
     // ========== MESSAGE 2: RS485 DATA ==========
-    if (rs485ConfigMgr.hasConfig() && rs485ConfigMgr.getOnlineCount() > 0) {
+    if (!rs485.isNull()) {
         JsonDocument doc2;
-        doc2["device_id"] = DEVICE_ID;
-        doc2["timestamp"] = timeManager.getTimestamp();
-        doc2["firmware"] = "esp32s3-multisensor-v2.1";
-        
-        // RS485 data only
-        buildRS485Data(doc2);
+        buildTelemetryMessage(doc2, rs485, timestamp, compact);   // RS485 data only
         
         // Add node info (same as basic sensors)
-        appendNodeInfo(doc2);
+        if (withNodeInfo) {
+            appendNodeInfo(doc2);
+        }
 
         Serial.println("\n========== RS485 TELEMETRY ==========");
         serializeJsonPretty(doc2, Serial);
@@ -312,16 +489,116 @@ void sendFullTelemetry() {
     Serial.println("======================================\n");
 }
 
+// Every sample goes to the history archive; `publish` also sends it
+void processSample(const SensorSample& sample, bool publish) {
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, sample.json, sample.length);
+    if (error) {
+        Serial.printf("[Telemetry] ❌ Bad sample: %s\n", error.c_str());
+        return;
+    }
+
+    // Time of the reading, not of this pass: samples queued behind a modem
+    // stall keep their own timestamps
+    unsigned long unixTime = timeManager.getUnixTime() - (millis() - sample.takenAt) / 1000;
+
+    beginHistoryCycle(unixTime);
+    archiveSensors(doc["basic"]);
+    archiveSensors(doc["rs485"]);
+
+    if (publish) {
+        publishTelemetry(doc["basic"], doc["rs485"], timeManager.getTimestamp(unixTime));
+    }
+
+    commitHistoryCycle();
+}
+
+// processSample() + publishTelemetry() without the I/O, for the host bench
+// (bench/pipeline_bench.cpp): parse the sample, build both messages and
+// serialize them as MQTTManager::publish() does. No node info, no history.
+size_t encodeTelemetry(const SensorSample& sample, unsigned long unixTime, String& basicOut, String& rs485Out) {
+    JsonDocument doc;
+    if (deserializeJson(doc, sample.json, sample.length)) {
+        return 0;
+    }
+    String timestamp = timeManager.getTimestamp(unixTime);
+
+    JsonDocument doc1;
+    buildTelemetryMessage(doc1, doc["basic"], timestamp, false);
+    basicOut = "";
+    serializeJson(doc1, basicOut);
+
+    rs485Out = "";
+    JsonObject rs485 = doc["rs485"];
+    if (!rs485.isNull()) {
+        JsonDocument doc2;
+        buildTelemetryMessage(doc2, rs485, timestamp, false);
+        serializeJson(doc2, rs485Out);
+    }
+    return basicOut.length() + rs485Out.length();
+}
+
 // ============================================================================
 // BOOT NOTIFICATION
 // ============================================================================
 
+// Boot phases in ms since ESP32 reset (0 = not reached), to track
+// time-to-first-publish across the fleet
+static void appendBootTimes(JsonDocument& doc, unsigned long publishAt) {
+    const ModemBootTimes& times = lteManager.getBootTimes();
+    JsonObject boot = doc["boot_ms"].to<JsonObject>();
+    boot["modem_on"] = times.powerOn;
+    boot["rdy"] = times.rdy;
+    boot["cpin_ready"] = times.cpinReady;
+    boot["pb_done"] = times.pbDone;
+    boot["at_ready"] = times.atReady;
+    boot["modem_ready"] = times.ready;
+    boot["network"] = times.network;
+    boot["gprs"] = times.gprs;
+    boot["first_publish"] = publishAt;
+}
+
+// Reached phases as {name: [start ms, duration ms]}
+static void appendBootPhases(JsonObject out, const BootProfiler::Phase* phases) {
+    for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (phases[i].endMs == 0) {
+            continue;
+        }
+        JsonArray phase = out[BootProfiler::phaseName(i)].to<JsonArray>();
+        phase.add(phases[i].startMs);
+        phase.add(phases[i].endMs - phases[i].startMs);
+    }
+}
+
+// This boot so far; with `withPrevious` also the boot before the last
+// non-power-on reset (how far it got, how long it ran)
+static void appendBootTimeline(JsonObject boot, bool withPrevious) {
+    boot["count"] = bootProfiler.getBootCount();
+    boot["reason"] = BootProfiler::resetReasonName(bootProfiler.getResetReason());
+
+    BootProfiler::Phase phases[BOOT_PHASE_COUNT];
+    for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+        phases[i] = bootProfiler.getPhase((BootPhase)i);
+    }
+    appendBootPhases(boot["phases"].to<JsonObject>(), phases);
+
+    const BootProfiler::Summary& prev = bootProfiler.getPrevious();
+    if (withPrevious && prev.valid) {
+        JsonObject previous = boot["prev"].to<JsonObject>();
+        previous["reason"] = BootProfiler::resetReasonName(prev.resetReason);
+        previous["uptime_s"] = prev.uptimeS;
+        appendBootPhases(previous["phases"].to<JsonObject>(), prev.phases);
+    }
+}
+
 void sendBootNotification() {
     if (!mqttManager.isConnected()) {
         Serial.println("[Boot] MQTT not ready. Boot notification skipped.");
         return;
     }
 
+    unsigned long publishAt = millis();
+
     JsonDocument doc;
     doc["device_id"] = DEVICE_ID;
     doc["timestamp"] = timeManager.getTimestamp();
@@ -330,6 +607,9 @@ void sendBootNotification() {
 
     // Add node info
     appendNodeInfo(doc);
+    appendBootTimes(doc, publishAt);
+    appendBootTimeline(doc["boot"].to<JsonObject>(), true);
+    appendDataUsage(doc["data_usage"].to<JsonObject>(), dataBudget.getMonth());
 
     String topic = String(MQTT_TOPIC) + "/" + DEVICE_ID + "/boot";
     Serial.print("[Boot] Publishing boot event to ");
@@ -339,7 +619,8 @@ void sendBootNotification() {
     connectionManager.notifyPublishResult(ok);
 
     if (ok) {
-        Serial.println("[Boot] ✅ Notification sent");
+        Serial.printf("[Boot] ✅ Notification sent (first publish at %lu ms, modem ready at %lu ms)\n",
+                      publishAt, lteManager.getBootTimes().ready);
         
         // Subscribe to command topic for relay control
         String cmdTopic = String(MQTT_TOPIC) + "/" + DEVICE_ID + "/command";
@@ -356,3 +637,228 @@ void sendBootNotification() {
         Serial.println("[Boot] ❌ Failed to send notification");
     }
 }
+
+// Follow-up to the boot event once the first telemetry is out: config and
+// telemetry phases finish after the boot event has gone
+void sendBootTimeline() {
+    JsonDocument doc;
+    doc["device_id"] = DEVICE_ID;
+    doc["timestamp"] = timeManager.getTimestamp();
+    doc["event"] = "boot_timeline";
+    appendBootTimeline(doc["boot"].to<JsonObject>(), false);
+
+    String topic = String(MQTT_TOPIC) + "/" + DEVICE_ID + "/boot";
+    if (mqttManager.publish(topic.c_str(), doc)) {
+        Serial.println("[Boot] ✅ Boot timeline sent");
+    } else {
+        Serial.println("[Boot] ❌ Boot timeline failed");
+    }
+}
+
+// ============================================================================
+// DATA USAGE
+// ============================================================================
+
+void sendDataUsage() {
+    JsonDocument doc;
+    doc["device_id"] = DEVICE_ID;
+    doc["timestamp"] = timeManager.getTimestamp();
+    doc["budget"] = dataBudget.getBudget();
+    doc["projected"] = dataBudget.getProjected();
+    doc["level"] = DataBudget::levelName(dataBudget.getLevel());
+    appendDataUsage(doc["current"].to<JsonObject>(), dataBudget.getMonth());
+    appendDataUsage(doc["previous"].to<JsonObject>(), dataBudget.getPreviousMonth());
+
+    String topic = String(MQTT_TOPIC) + "/" + DEVICE_ID + "/data_usage";
+    if (mqttManager.publish(topic.c_str(), doc)) {
+        Serial.println("[Data] ✅ Usage report sent");
+    } else {
+        Serial.println("[Data] ❌ Usage report failed");
+    }
+}
+
+// ============================================================================
+// METRICS
+// ============================================================================
+
+// Stage latencies since the last snapshot. Held back while the data budget
+// is over: the window then simply covers more time.
+void sendMetrics() {
+    if (!mqttManager.isConnected() || dataBudget.isCompact()) {
+        return;
+    }
+
+    JsonDocument doc;
+    doc["device_id"] = DEVICE_ID;
+    doc["timestamp"] = timeManager.getTimestamp();
+    if (!snapshotMetrics(doc["metrics"].to<JsonObject>(), millis())) {
+        return;
+    }
+
+    String topic = String(MQTT_TOPIC) + "/" + DEVICE_ID + "/metrics";
+    if (mqttManager.publish(topic.c_str(), doc)) {
+        Serial.printf("[Metrics] ✅ Snapshot sent (%u bytes)\n", (unsigned)measureJson(doc));
+    } else {
+        Serial.println("[Metrics] ❌ Snapshot failed");
+    }
+}
+
+// ============================================================================
+// HISTORY ARCHIVE
+// ============================================================================
+
+static char historyRequestId[40] = "";
+static HistoryTier historyTier = HISTORY_RAW;
+static uint16_t historyBatchSize = HISTORY_BATCH_RECORDS;
+static uint16_t historyBatchSeq = 0;
+static uint32_t historyIndexReads = 0;
+static uint32_t historyBlocksRead = 0;
+static HistoryRecord historyBatch[HISTORY_BATCH_RECORDS];  // Static: keeps 1 KB off the loop stack
+
+static String historyTopic() {
+    return String(MQTT_TOPIC) + "/" + DEVICE_ID + "/history";
+}
+
+static void publishHistoryError(const char* error) {
+    JsonDocument doc;
+    doc["device_id"] = DEVICE_ID;
+    doc["request_id"] = historyRequestId;
+    doc["error"] = error;
+    doc["done"] = true;
+
+    mqttManager.publish(historyTopic().c_str(), doc);
+    Serial.printf("[History] ❌ Query rejected: %s\n", error);
+}
+
+void startHistoryQuery(JsonDocument& cmd) {
+    const char* requestId = cmd["request_id"] | "";
+    strncpy(historyRequestId, requestId, sizeof(historyRequestId) - 1);
+    historyRequestId[sizeof(historyRequestId) - 1] = '\0';
+
+    if (!historyArchive.isOpen()) {
+        publishHistoryError("archive_unavailable");
+        return;
+    }
+    if (!timeManager.isSynced()) {
+        publishHistoryError("time_not_synced");
+        return;
+    }
+
+    uint32_t now = timeManager.getUnixTime();
+    HistoryArchive::Query query;
+    query.to = cmd["to"] | now;
+    query.from = cmd["from"] | (query.to > 3600 ? query.to - 3600 : 0);
+
+    // "raw" / "minute" / "hour", otherwise the finest tier still holding `from`
+    const char* tierName = cmd["tier"] | "auto";
+    if (!HistoryArchive::parseTier(tierName, query.tier)) {
+        query.tier = historyArchive.tierFor(query.from, now);
+    }
+
+    // Nothing older than the tier's retention exists
+    uint32_t oldest = now > HistoryArchive::retention(query.tier) ? now - HistoryArchive::retention(query.tier) : 0;
+    if (query.from < oldest) {
+        query.from = oldest;
+    }
+
+    query.channelMask = 0;
+    JsonArray channels = cmd["channels"];
+    for (JsonVariant name : channels) {
+        int id = historyArchive.findChannel(name | "");
+        if (id >= 0) {
+            query.channelMask |= 1UL << id;
+        }
+    }
+    if (channels.size() > 0 && query.channelMask == 0) {
+        publishHistoryError("unknown_channels");
+        return;
+    }
+
+    historyBatchSize = constrain((int)(cmd["batch"] | HISTORY_BATCH_RECORDS), 1, HISTORY_BATCH_RECORDS);
+
+    if (historyArchive.isQueryActive()) {
+        Serial.println("[History] ⚠️ Previous query replaced");
+    }
+    if (!historyArchive.startQuery(query)) {
+        publishHistoryError("bad_range");
+        return;
+    }
+
+    historyTier = query.tier;
+    historyBatchSeq = 0;
+    historyIndexReads = historyArchive.getStats().indexReads;
+    historyBlocksRead = historyArchive.getStats().blocksRead;
+
+    Serial.printf("[History] Query %s: %s %lu..%lu\n", historyRequestId,
+                  HistoryArchive::tierName(query.tier),
+                  (unsigned long)query.from, (unsigned long)query.to);
+}
+
+void serviceHistoryQuery() {
+    // Next batch only once the window has room: batches must not pile up
+    // in the outbox behind live telemetry
+    if (!historyArchive.isQueryActive() || !mqttManager.canPublish()) {
+        return;
+    }
+
+    size_t count = historyArchive.nextBatch(historyBatch, historyBatchSize);
+    bool done = !historyArchive.isQueryActive();
+    bool raw = historyTier == HISTORY_RAW;
+
+    JsonDocument doc;
+    doc["device_id"] = DEVICE_ID;
+    doc["request_id"] = historyRequestId;
+    doc["seq"] = historyBatchSeq;
+    doc["tier"] = HistoryArchive::tierName(historyTier);
+
+    // Channel names once, rows refer to them by index
+    if (historyBatchSeq == 0) {
+        JsonArray names = doc["channels"].to<JsonArray>();
+        for (uint16_t i = 0; i < historyArchive.getChannelCount(); i++) {
+            names.add(historyArchive.getChannelName(i));
+        }
+    }
+
+    JsonArray fields = doc["fields"].to<JsonArray>();
+    fields.add("ts");
+    fields.add("ch");
+    if (raw) {
+        fields.add("value");
+    } else {
+        fields.add("mean");
+        fields.add("min");
+        fields.add("max");
+        fields.add("n");
+    }
+
+    JsonArray rows = doc["rows"].to<JsonArray>();
+    for (size_t i = 0; i < count; i++) {
+        const HistoryRecord& rec = historyBatch[i];
+        JsonArray row = rows.add<JsonArray>();
+        row.add(rec.timestamp);
+        row.add(rec.channel);
+        row.add(rec.mean);
+        if (!raw) {
+            row.add(rec.min);
+            row.add(rec.max);
+            row.add(rec.count);
+        }
+    }
+    doc["done"] = done;
+
+    if (!mqttManager.publish(historyTopic().c_str(), doc)) {
+        // Batches are not replayable; the server re-requests from its last row
+        Serial.println("[History] ❌ Batch publish failed, query aborted");
+        historyArchive.cancelQuery();
+        return;
+    }
+
+    historyBatchSeq++;
+
+    if (done) {
+        Serial.printf("[History] ✅ Query %s done: %u batches, %lu index reads, %lu blocks read\n",
+                      historyRequestId, historyBatchSeq,
+                      (unsigned long)(historyArchive.getStats().indexReads - historyIndexReads),
+                      (unsigned long)(historyArchive.getStats().blocksRead - historyBlocksRead));
+    }
+}
@@ -208,9 +208,13 @@ String TimeManager::getISO8601() {
 }
 
 String TimeManager::getTimestamp() {
-    time_t now = getUnixTime();
+    return getTimestamp(getUnixTime());
+}
+
+String TimeManager::getTimestamp(unsigned long unixTime) {
+    time_t at = unixTime;
     struct tm timeinfo;
-    localtime_r(&now, &timeinfo);
+    localtime_r(&at, &timeinfo);
 
     char buffer[20];
     strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &timeinfo);
@@ -0,0 +1,396 @@
+#include "tls_transport.h"
+#include "queue_record.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ============================================================================
+// TLS TRANSPORT IMPLEMENTATION
+// ============================================================================
+
+#define SESSION_FILE_MAGIC      0x53534C54UL    // "TLSS"
+#define CLOCK_VALID_AFTER       1700000000UL    // Before this the clock is not set yet
+
+namespace {
+    struct SessionHeader {
+        uint32_t magic;
+        uint32_t length;
+        uint32_t crc;           // Over the serialized session
+    };
+}
+
+TlsTransport::TlsTransport(MqttTransport& lowerTransport) : lower(lowerTransport) {
+    clock = nullptr;
+    handshakeTimeoutMs = 0;
+    configured = false;
+    active = false;
+    established = false;
+    resumed = false;
+    broken = false;
+    offered = false;
+    handshakeStart = 0;
+    bytesUp = 0;
+    bytesDown = 0;
+    serverName[0] = '\0';
+    sessionPath[0] = '\0';
+    session = nullptr;
+    sessionLen = 0;
+    memset(&stats, 0, sizeof(stats));
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_x509_crt_init(&ca);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_ssl_init(&ssl);
+}
+
+TlsTransport::~TlsTransport() {
+    mbedtls_ssl_free(&ssl);
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_x509_crt_free(&ca);
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    free(session);
+}
+
+bool TlsTransport::begin(const char* caPem, const char* name, const char* path,
+                         ClockFn millisClock, uint32_t timeoutMs) {
+    if (configured) {
+        return true;
+    }
+    clock = millisClock;
+    handshakeTimeoutMs = timeoutMs;
+    snprintf(serverName, sizeof(serverName), "%s", name ? name : "");
+    snprintf(sessionPath, sizeof(sessionPath), "%s", path ? path : "");
+
+    int ret = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy,
+                                    (const unsigned char*)"mqtt-tls", 8);
+    if (ret == 0) {
+        ret = mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret == 0 && caPem != nullptr) {
+        ret = mbedtls_x509_crt_parse(&ca, (const unsigned char*)caPem, strlen(caPem) + 1);
+    }
+    if (ret != 0) {
+        stats.lastError = ret;
+        return false;
+    }
+
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_min_version(&conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+    if (caPem != nullptr) {
+        mbedtls_ssl_conf_ca_chain(&conf, &ca, nullptr);
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+        mbedtls_ssl_conf_verify(&conf, verifyCallback, this);
+    } else {
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+    }
+
+    session = (uint8_t*)malloc(TLS_SESSION_MAX);
+    if (session == nullptr) {
+        return false;
+    }
+    if (sessionPath[0] != '\0') {
+        loadSession();
+    }
+
+    configured = true;
+    return true;
+}
+
+// ========================================
+// Handshake
+// ========================================
+
+bool TlsTransport::startHandshake() {
+    if (!configured) {
+        return false;
+    }
+    reset();
+
+    int ret = mbedtls_ssl_setup(&ssl, &conf);
+    if (ret == 0 && serverName[0] != '\0') {
+        ret = mbedtls_ssl_set_hostname(&ssl, serverName);
+    }
+    if (ret != 0) {
+        stats.lastError = ret;
+        return false;
+    }
+    mbedtls_ssl_set_bio(&ssl, this, sendCallback, recvCallback, nullptr);
+
+    offered = false;
+    if (sessionLen > 0) {
+        mbedtls_ssl_session cached;
+        mbedtls_ssl_session_init(&cached);
+        if (mbedtls_ssl_session_load(&cached, session, sessionLen) == 0 &&
+            mbedtls_ssl_set_session(&ssl, &cached) == 0) {
+            offered = true;
+        } else {
+            forgetSession();    // Other mbedTLS build or damaged
+        }
+        mbedtls_ssl_session_free(&cached);
+    }
+
+    active = true;
+    handshakeStart = now();
+    bytesUp = 0;
+    bytesDown = 0;
+    return true;
+}
+
+TlsTransport::HandshakeResult TlsTransport::pollHandshake() {
+    if (!active) {
+        return TLS_FAILED;
+    }
+    if (established) {
+        return TLS_DONE;
+    }
+
+    while (ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        int before = ssl.state;
+        int ret = mbedtls_ssl_handshake_step(&ssl);
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            break;
+        }
+        if (ret != 0) {
+            stats.lastError = ret;
+            stats.failed++;
+            if (offered) {
+                forgetSession();    // Do not keep offering what may have caused it
+            }
+            reset();
+            return TLS_FAILED;
+        }
+
+        // A broker that accepts the session goes from ServerHello straight
+        // to ChangeCipherSpec: no certificate, no key exchange
+        if (before == MBEDTLS_SSL_SERVER_HELLO && ssl.state == MBEDTLS_SSL_SERVER_CHANGE_CIPHER_SPEC) {
+            resumed = true;
+        }
+    }
+
+    if (ssl.state == MBEDTLS_SSL_HANDSHAKE_OVER) {
+        finishHandshake();
+        return TLS_DONE;
+    }
+
+    if (now() - handshakeStart >= handshakeTimeoutMs) {
+        stats.lastError = MBEDTLS_ERR_SSL_TIMEOUT;
+        stats.failed++;
+        reset();
+        return TLS_FAILED;
+    }
+    return TLS_PENDING;
+}
+
+void TlsTransport::finishHandshake() {
+    established = true;
+    stats.handshakes++;
+    if (resumed) {
+        stats.resumed++;
+    }
+    stats.lastHandshakeMs = now() - handshakeStart;
+    stats.lastBytesUp = bytesUp;
+    stats.lastBytesDown = bytesDown;
+    stats.lastError = 0;
+    keepSession();
+}
+
+void TlsTransport::reset() {
+    if (active) {
+        mbedtls_ssl_free(&ssl);
+        mbedtls_ssl_init(&ssl);
+    }
+    active = false;
+    established = false;
+    resumed = false;
+    broken = false;
+}
+
+// ========================================
+// Session cache
+// ========================================
+
+void TlsTransport::keepSession() {
+    mbedtls_ssl_session current;
+    mbedtls_ssl_session_init(&current);
+
+    size_t len = 0;
+    uint8_t* blob = nullptr;
+    if (mbedtls_ssl_get_session(&ssl, &current) == 0 &&
+        mbedtls_ssl_session_save(&current, nullptr, 0, &len) == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL &&
+        len <= TLS_SESSION_MAX) {
+        blob = (uint8_t*)malloc(len);
+    }
+
+    // Only rewritten when it changed: a resumed session without a new
+    // ticket is the one already stored
+    if (blob != nullptr && mbedtls_ssl_session_save(&current, blob, len, &len) == 0 &&
+        (len != sessionLen || memcmp(blob, session, len) != 0)) {
+        memcpy(session, blob, len);
+        sessionLen = len;
+        if (sessionPath[0] != '\0') {
+            saveSession();
+        }
+    }
+
+    free(blob);
+    mbedtls_ssl_session_free(&current);
+}
+
+void TlsTransport::forgetSession() {
+    sessionLen = 0;
+    if (sessionPath[0] != '\0') {
+        remove(sessionPath);
+    }
+}
+
+bool TlsTransport::loadSession() {
+    FILE* f = fopen(sessionPath, "rb");
+    if (f == nullptr) {
+        return false;
+    }
+
+    SessionHeader header;
+    bool ok = fread(&header, 1, sizeof(header), f) == sizeof(header) &&
+              header.magic == SESSION_FILE_MAGIC && header.length <= TLS_SESSION_MAX &&
+              fread(session, 1, header.length, f) == header.length &&
+              queueCrc32(0, session, header.length) == header.crc;
+    fclose(f);
+
+    sessionLen = ok ? header.length : 0;
+    return ok;
+}
+
+bool TlsTransport::saveSession() {
+    SessionHeader header;
+    header.magic = SESSION_FILE_MAGIC;
+    header.length = sessionLen;
+    header.crc = queueCrc32(0, session, sessionLen);
+
+    char tmpPath[TLS_PATH_MAX + 4];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", sessionPath);
+
+    FILE* f = fopen(tmpPath, "wb");
+    if (f == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(&header, 1, sizeof(header), f) == sizeof(header) &&
+              fwrite(session, 1, sessionLen, f) == sessionLen;
+    ok = fclose(f) == 0 && ok;
+
+    if (ok && rename(tmpPath, sessionPath) != 0) {
+        remove(sessionPath);
+        ok = rename(tmpPath, sessionPath) == 0;
+    }
+    return ok;
+}
+
+// ========================================
+// MqttTransport
+// ========================================
+
+bool TlsTransport::connected() {
+    return established && !broken &&
+           (lower.connected() || mbedtls_ssl_get_bytes_avail(&ssl) > 0);
+}
+
+int TlsTransport::available() {
+    if (!established || broken) {
+        return 0;
+    }
+
+    // Decrypt the next record once its bytes are in
+    size_t n = mbedtls_ssl_get_bytes_avail(&ssl);
+    if (n == 0 && lower.available() > 0) {
+        int ret = mbedtls_ssl_read(&ssl, nullptr, 0);
+        if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            broken = true;      // close_notify, bad record MAC, ...
+            stats.lastError = ret;
+            return 0;
+        }
+        n = mbedtls_ssl_get_bytes_avail(&ssl);
+    }
+    return (int)n;
+}
+
+int TlsTransport::read(uint8_t* buf, size_t len) {
+    if (!established || broken) {
+        return 0;
+    }
+
+    int ret = mbedtls_ssl_read(&ssl, buf, len);
+    if (ret > 0) {
+        return ret;
+    }
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        broken = true;
+        stats.lastError = ret;
+    }
+    return 0;
+}
+
+size_t TlsTransport::write(const uint8_t* buf, size_t len) {
+    if (!established || broken) {
+        return 0;
+    }
+
+    // One record per packet, so still one CIPSEND per MQTT packet
+    size_t written = 0;
+    while (written < len) {
+        int ret = mbedtls_ssl_write(&ssl, buf + written, len - written);
+        if (ret <= 0) {
+            if (ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+                broken = true;
+                stats.lastError = ret;
+            }
+            break;
+        }
+        written += ret;
+    }
+    return written;
+}
+
+// ========================================
+// mbedTLS callbacks
+// ========================================
+
+int TlsTransport::sendCallback(void* context, const unsigned char* buf, size_t len) {
+    TlsTransport* self = static_cast<TlsTransport*>(context);
+    size_t n = self->lower.write(buf, len);
+    if (n == 0) {
+        return self->lower.connected() ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_SSL_CONN_EOF;
+    }
+    if (!self->established) {
+        self->bytesUp += n;
+    }
+    return (int)n;
+}
+
+int TlsTransport::recvCallback(void* context, unsigned char* buf, size_t len) {
+    TlsTransport* self = static_cast<TlsTransport*>(context);
+    if (self->lower.available() <= 0) {
+        return self->lower.connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_SSL_CONN_EOF;
+    }
+
+    int n = self->lower.read(buf, len);
+    if (n <= 0) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    if (!self->established) {
+        self->bytesDown += n;
+    }
+    return n;
+}
+
+int TlsTransport::verifyCallback(void*, mbedtls_x509_crt*, int, uint32_t* flags) {
+    // Right after boot the clock may not be set yet: the chain and name are
+    // still checked, the validity dates only once time is known
+    if (time(nullptr) < (time_t)CLOCK_VALID_AFTER) {
+        *flags &= ~(MBEDTLS_X509_BADCERT_FUTURE | MBEDTLS_X509_BADCERT_EXPIRED);
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include "topic_router.h"
+#include <string.h>
+
+// ============================================================================
+// TOPIC ROUTER IMPLEMENTATION
+// ============================================================================
+
+TopicRouter::TopicRouter() {
+    routeCount = 0;
+}
+
+bool TopicRouter::add(const char* topic, Handler handler) {
+    size_t length = strlen(topic);
+    if (length == 0 || length >= TOPIC_ROUTER_TOPIC_LEN || handler == nullptr) {
+        return false;
+    }
+
+    Route* route = const_cast<Route*>(find(topic, length));
+    if (route == nullptr) {
+        if (routeCount >= TOPIC_ROUTER_MAX_ROUTES) {
+            return false;
+        }
+        route = &routes[routeCount++];
+        memcpy(route->topic, topic, length + 1);
+        route->length = (uint8_t)length;
+    }
+    route->handler = handler;
+    return true;
+}
+
+bool TopicRouter::dispatch(const char* topic, const uint8_t* payload, size_t length) const {
+    const Route* route = find(topic, strlen(topic));
+    if (route == nullptr) {
+        return false;
+    }
+    route->handler(payload, length);
+    return true;
+}
+
+const TopicRouter::Route* TopicRouter::find(const char* topic, size_t length) const {
+    for (uint8_t i = 0; i < routeCount; i++) {
+        if (routes[i].length == length && memcmp(routes[i].topic, topic, length) == 0) {
+            return &routes[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,313 @@
+#include "write_coalescer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_system.h>
+#endif
+
+// ============================================================================
+// WRITE COALESCER IMPLEMENTATION
+// ============================================================================
+
+WriteCoalescer* WriteCoalescer::instances[COALESCER_MAX_INSTANCES] = { nullptr };
+
+WriteCoalescer::WriteCoalescer() {
+    buffer = nullptr;
+    capacity = 0;
+    staged = 0;
+    retained = 0;
+    recordStart = 0;
+    blockSize = 0;
+    maxAgeMs = 0;
+    fileSize = 0;
+    oldestStagedAt = 0;
+    sink = nullptr;
+    sinkContext = nullptr;
+    millisFn = nullptr;
+    microsFn = nullptr;
+    memset(&stats, 0, sizeof(stats));
+}
+
+WriteCoalescer::~WriteCoalescer() {
+    end();
+}
+
+// ========================================
+// Lifecycle
+// ========================================
+
+bool WriteCoalescer::begin(size_t block, size_t cap, uint32_t maxAge,
+                           FlushSink sinkFn, void* context,
+                           ClockFn millisClock, ClockFn microsClock,
+                           uint32_t currentFileSize) {
+    end();
+
+    if (block == 0 || sinkFn == nullptr || millisClock == nullptr) {
+        return false;
+    }
+
+    // Capacity must hold at least one full block plus a record straddling it
+    if (cap < block * 2) {
+        cap = block * 2;
+    }
+
+    buffer = (uint8_t*)malloc(cap);
+    if (buffer == nullptr) {
+        return false;
+    }
+
+    capacity = cap;
+    blockSize = block;
+    maxAgeMs = maxAge;
+    sink = sinkFn;
+    sinkContext = context;
+    millisFn = millisClock;
+    microsFn = microsClock;
+    fileSize = currentFileSize;
+    staged = 0;
+    retained = 0;
+    recordStart = 0;
+
+    registerInstance();
+    return true;
+}
+
+void WriteCoalescer::end() {
+    if (buffer == nullptr) {
+        return;
+    }
+
+    flush(FLUSH_EXPLICIT);
+    unregisterInstance();
+
+    free(buffer);
+    buffer = nullptr;
+    capacity = 0;
+    staged = 0;
+    retained = 0;
+}
+
+void WriteCoalescer::discard(uint32_t size) {
+    staged = 0;
+    retained = 0;
+    recordStart = 0;
+    fileSize = size;
+}
+
+void WriteCoalescer::resetFileSize(uint32_t size) {
+    fileSize = size;
+}
+
+void WriteCoalescer::dropStagedTail(size_t len) {
+    staged = len < staged ? staged - len : 0;
+}
+
+// ========================================
+// Staging
+// ========================================
+
+bool WriteCoalescer::append(const uint8_t* data, size_t len) {
+    if (buffer == nullptr) {
+        return false;
+    }
+
+    startRecord();
+    if (!stage(data, len)) {
+        return false;
+    }
+
+    stats.recordsStaged++;
+    return true;
+}
+
+bool WriteCoalescer::append(const uint8_t* head, size_t headLen, const uint8_t* data, size_t len) {
+    if (buffer == nullptr) {
+        return false;
+    }
+
+    startRecord();
+    if (!stage(head, headLen) || !stage(data, len)) {
+        return false;
+    }
+
+    stats.recordsStaged++;
+    return true;
+}
+
+bool WriteCoalescer::stage(const uint8_t* data, size_t len) {
+    stats.bytesStaged += len;
+
+    while (len > 0) {
+        if (staged == 0) {
+            oldestStagedAt = millisFn();
+        }
+
+        // The retained head is only kept while there is room for it
+        if (retained > 0 && retained + staged == capacity) {
+            dropRetained();
+        }
+
+        size_t room = capacity - retained - staged;
+        size_t chunk = len < room ? len : room;
+        memcpy(buffer + retained + staged, data, chunk);
+        staged += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (staged >= blockSize) {
+            size_t aligned = alignedFlushLength();
+            if (aligned > 0 && !writeOut(aligned, FLUSH_SIZE)) {
+                return false;
+            }
+        }
+
+        // Record larger than the free space and nothing aligned to hand out
+        if (len > 0 && retained + staged == capacity && !flush(FLUSH_SIZE)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void WriteCoalescer::poll() {
+    if (buffer == nullptr || staged == 0 || maxAgeMs == 0) {
+        return;
+    }
+
+    if (millisFn() - oldestStagedAt >= maxAgeMs) {
+        flush(FLUSH_AGE);
+    }
+}
+
+bool WriteCoalescer::flush(FlushReason reason) {
+    if (buffer == nullptr || staged == 0) {
+        return true;
+    }
+    return writeOut(staged, reason);
+}
+
+// ========================================
+// Helpers
+// ========================================
+
+size_t WriteCoalescer::alignedFlushLength() const {
+    // Fill the partially written tail block first, then whole blocks, so
+    // every size-triggered write ends on an absolute block boundary.
+    uint32_t end = fileSize + staged;
+    uint32_t alignedEnd = end - (end % blockSize);
+    if (alignedEnd <= fileSize) {
+        return 0;
+    }
+    return alignedEnd - fileSize;
+}
+
+void WriteCoalescer::startRecord() {
+    recordStart = retained + staged;
+}
+
+void WriteCoalescer::dropRetained() {
+    memmove(buffer, buffer + retained, staged);
+    recordStart = recordStart > retained ? recordStart - retained : 0;
+    retained = 0;
+}
+
+bool WriteCoalescer::writeOut(size_t len, FlushReason reason) {
+    unsigned long startUs = microsFn ? microsFn() : 0;
+    size_t written = sink(sinkContext, buffer + retained, len);
+    if (microsFn) {
+        uint32_t elapsed = microsFn() - startUs;
+        stats.flushMicros += elapsed;
+        if (elapsed > stats.maxFlushMicros) {
+            stats.maxFlushMicros = elapsed;
+        }
+    }
+
+    stats.sinkWrites++;
+    stats.flushes[reason]++;
+
+    if (written > 0) {
+        uint32_t firstBlock = fileSize / blockSize;
+        uint32_t lastBlock = (fileSize + written + blockSize - 1) / blockSize;
+        stats.bytesProgrammed += (uint64_t)(lastBlock - firstBlock) * blockSize;
+        stats.bytesWritten += written;
+        fileSize += written;
+
+        staged -= written;
+        retained += written;
+        if (staged > 0) {
+            // Remaining bytes were staged after the flushed ones
+            oldestStagedAt = millisFn();
+        }
+    }
+
+    if (written != len) {
+        // Keep everything: the records cut by a short write must stay
+        // recoverable from getPendingData()
+        stats.sinkFailures++;
+        return false;
+    }
+
+    // Keep only the written head of a record the flush cut in two
+    size_t boundary = retained;
+    size_t keepFrom = staged > 0 && recordStart < boundary ? recordStart : boundary;
+    memmove(buffer, buffer + keepFrom, retained + staged - keepFrom);
+    retained -= keepFrom;
+    recordStart = recordStart > keepFrom ? recordStart - keepFrom : 0;
+    return true;
+}
+
+uint32_t WriteCoalescer::getWriteAmplificationX100() const {
+    if (stats.bytesWritten == 0) {
+        return 0;
+    }
+    return (uint32_t)((stats.bytesProgrammed * 100) / stats.bytesWritten);
+}
+
+uint32_t WriteCoalescer::getThroughputBps() const {
+    if (stats.flushMicros == 0) {
+        return 0;
+    }
+    return (uint32_t)((stats.bytesWritten * 1000000ULL) / stats.flushMicros);
+}
+
+// ========================================
+// Restart / brown-out hook
+// ========================================
+
+void WriteCoalescer::flushAllInstances() {
+    for (uint8_t i = 0; i < COALESCER_MAX_INSTANCES; i++) {
+        if (instances[i] != nullptr) {
+            instances[i]->flush(FLUSH_SHUTDOWN);
+        }
+    }
+}
+
+void WriteCoalescer::registerInstance() {
+    #ifdef ESP_PLATFORM
+    // Runs from esp_restart() (ESP.restart(), watchdog paths) before the
+    // CPU resets. A real brown-out resets without warning, which is what
+    // the durability window bounds.
+    static bool hookInstalled = false;
+    if (!hookInstalled) {
+        esp_register_shutdown_handler(&WriteCoalescer::flushAllInstances);
+        hookInstalled = true;
+    }
+    #endif
+
+    for (uint8_t i = 0; i < COALESCER_MAX_INSTANCES; i++) {
+        if (instances[i] == nullptr || instances[i] == this) {
+            instances[i] = this;
+            return;
+        }
+    }
+}
+
+void WriteCoalescer::unregisterInstance() {
+    for (uint8_t i = 0; i < COALESCER_MAX_INSTANCES; i++) {
+        if (instances[i] == this) {
+            instances[i] = nullptr;
+        }
+    }
+}
@@ -8,6 +8,21 @@ import { LogLabel } from '../../common/enums';
 import { Node, NodeUnpairedDevice, Sensor, SensorCatalog } from '../../entities/existing';
 import { Owner } from '../../entities/existing/owner.entity';
 
+/**
+ * CRC-32 (IEEE, as zlib) of the config JSON - the hash the device keeps
+ * with its cached config and sends back in get_config
+ */
+function configHash(json: string): string {
+    let crc = 0xffffffff;
+    for (const byte of Buffer.from(json, 'utf8')) {
+        crc ^= byte;
+        for (let bit = 0; bit < 8; bit++) {
+            crc = crc & 1 ? (crc >>> 1) ^ 0xedb88320 : crc >>> 1;
+        }
+    }
+    return ((crc ^ 0xffffffff) >>> 0).toString(16).padStart(8, '0');
+}
+
 @Injectable()
 export class MqttService implements OnModuleInit, OnModuleDestroy {
     private readonly logger = new Logger(MqttService.name);
@@ -394,7 +409,9 @@ export class MqttService implements OnModuleInit, OnModuleDestroy {
     /**
      * Handle config request from device
      * Topic: get_config/{device_id}
-     * Response: stream_config/{device_id}
+     * Payload: "request", or {"hash":"<crc32>"} from a device with a cached config
+     * Response: stream_config/{device_id} - config JSON, null, or "unchanged"
+     *           when the device's hash matches the current config
      */
     private async handleConfigRequest(topic: string, message: Buffer): Promise<void> {
         try {
@@ -409,6 +426,22 @@ export class MqttService implements OnModuleInit, OnModuleDestroy {
             const messageStr = message.toString();
             this.logger.log(`🔧 Config request from device: ${deviceId} (payload: "${messageStr}")`);
 
+            // Conditional request: hash of the config the device already runs,
+            // and the register maps built into its firmware ("device_type@version")
+            let cachedHash: string | undefined;
+            const builtinProfiles = new Set<string>();
+            try {
+                const request = JSON.parse(messageStr);
+                if (typeof request?.hash === 'string') {
+                    cachedHash = request.hash.toLowerCase();
+                }
+                if (Array.isArray(request?.profiles)) {
+                    request.profiles.forEach((p: unknown) => typeof p === 'string' && builtinProfiles.add(p));
+                }
+            } catch {
+                // Plain "request"
+            }
+
             // Check if device exists in database
             const node = await this.nodeRepository.findOne({
                 where: [
@@ -427,7 +460,7 @@ export class MqttService implements OnModuleInit, OnModuleDestroy {
                 this.logger.log(`✅ Device ${deviceId} found - fetching RS485 configs from sensor catalogs`);
                 
                 // Get configs from database (sensor_catalogs.default_channels_json)
-                config = await this.getRS485ConfigFromDatabase(node.idNode);
+                config = await this.getRS485ConfigFromDatabase(node.idNode, builtinProfiles);
                 
                 if (!config || config.length === 0) {
                     this.logger.warn(`⚠️  No sensor configs found for device ${deviceId}`);
@@ -437,11 +470,15 @@ export class MqttService implements OnModuleInit, OnModuleDestroy {
 
             // Publish response to stream_config/{device_id} (unified topic for pull & push)
             const responseTopic = `stream_config/${deviceId}`;
-            const responsePayload = config === null ? 'null' : JSON.stringify(config);
+            const configJson = config === null ? 'null' : JSON.stringify(config);
+            const unchanged = config !== null && cachedHash === configHash(configJson);
+            const responsePayload = unchanged ? '"unchanged"' : configJson;
 
             await this.publish(responseTopic, responsePayload);
 
-            this.logger.log(`📤 Config sent via stream_config: ${responseTopic}`);
+            this.logger.log(unchanged
+                ? `📤 Config unchanged (${cachedHash}) via stream_config: ${responseTopic}`
+                : `📤 Config sent via stream_config: ${responseTopic}`);
             
             // Log to database
             await this.iotLogService.create({
@@ -450,7 +487,7 @@ export class MqttService implements OnModuleInit, OnModuleDestroy {
                 payload: config || { status: 'no_config' },
                 deviceId: node ? deviceId : undefined,
                 timestamp: new Date(),
-                notes: `Config ${config ? 'sent' : 'not found'} for device ${deviceId}`,
+                notes: `Config ${unchanged ? 'unchanged' : config ? 'sent' : 'not found'} for device ${deviceId}`,
             });
 
         } catch (error) {
@@ -525,7 +562,7 @@ export class MqttService implements OnModuleInit, OnModuleDestroy {
      * Get RS485 config from database (sensor_catalogs.default_channels_json)
      * Returns array of configs (one per sensor attached to the node)
      */
-    private async getRS485ConfigFromDatabase(idNode: string): Promise<any[] | null> {
+    private async getRS485ConfigFromDatabase(idNode: string, builtinProfiles = new Set<string>()): Promise<any[] | null> {
         try {
             // Get all sensors for this node
             const sensors = await this.sensorRepository.find({
@@ -568,6 +605,20 @@ export class MqttService implements OnModuleInit, OnModuleDestroy {
                     : [catalog.defaultChannelsJson];
 
                 for (const channelConfig of channelConfigs) {
+                    // Register map compiled into the firmware: name it instead of sending it
+                    const version = channelConfig.version ?? 1;
+                    if (builtinProfiles.has(`${channelConfig.device_type}@${version}`)) {
+                        configs.push({
+                            profile: channelConfig.device_type,
+                            version,
+                            modbus_address: channelConfig.modbus_address,
+                            baud_rate: channelConfig.baud_rate,
+                        });
+
+                        this.logger.log(`✅ Built-in profile for sensor: ${sensor.label} (${channelConfig.device_type} v${version})`);
+                        continue;
+                    }
+
                     configs.push({
                         sensor_id: sensor.idSensor,
                         sensor_label: sensor.label,